@@ -0,0 +1,79 @@
+/*
+    sfz::File parser benchmark
+
+    Measures how long it takes to parse a large .sfz file. The file is
+    generated by the benchmark itself and covers the usual ingredients of
+    real world sfz instruments: #define'd variables, #include'd files,
+    comments, group and region headers with lots of opcodes, including cc
+    and eg/lfo opcodes. Sample files are not accessed by the parser, so no
+    actual samples are required.
+
+    Copyright (C) 2020 Christian Schoenebeck <cuse@users.sf.net>
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+#include "../src/engines/sfz/sfz.h"
+
+#define REGIONS     20000
+#define RUNS        20
+
+static void writeInstrument(const char* dir) {
+    char path[1024];
+
+    snprintf(path, sizeof(path), "%s/sfzparse_common.sfz", dir);
+    FILE* f = fopen(path, "w");
+    if (!f) { perror(path); exit(-1); }
+    fprintf(f, "// shared envelope and filter settings\n");
+    fprintf(f, "ampeg_attack=0.001 ampeg_decay=0.4 ampeg_sustain=$SUSTAIN ampeg_release=0.8\n");
+    fprintf(f, "fil_type=lpf_2p cutoff=8000 resonance=2 fil_veltrack=2400\n");
+    fclose(f);
+
+    snprintf(path, sizeof(path), "%s/sfzparse.sfz", dir);
+    f = fopen(path, "w");
+    if (!f) { perror(path); exit(-1); }
+    fprintf(f, "// generated by the sfzparse benchmark\n");
+    fprintf(f, "#define $SUSTAIN 70\n#define $VOLCC 7\n\n");
+    for (int i = 0; i < REGIONS; i++) {
+        const int key = i % 128;
+        const int layer = (i / 128) % 8;
+        if (key == 0) {
+            fprintf(f, "\n<group> lovel=%d hivel=%d amp_veltrack=80 volume=-3 // layer %d\n",
+                    layer * 16 + 1, layer * 16 + 16, layer);
+            fprintf(f, "#include \"sfzparse_common.sfz\"\n");
+            fprintf(f, "volume_oncc$VOLCC=6 cutoff_cc74=2400 pitchlfo_freq=5.5 pitchlfo_depthcc1=25\n");
+        }
+        fprintf(f, "<region> sample=samples/layer%d/note%03d.wav lokey=%d hikey=%d pitch_keycenter=%d\n",
+                layer, key, key, key, key);
+        fprintf(f, "  tune=%d offset=%d loop_mode=loop_continuous loop_start=%d loop_end=%d\n",
+                (i % 21) - 10, i % 64, 1000 + i, 50000 + i);
+        fprintf(f, "  eg1_time1=0.1 eg1_level1=1 eg1_time2=0.5 eg1_level2=0.3 eg1_sustain=2 eg1_amplitude=100\n");
+        fprintf(f, "  lfo1_freq=3 lfo1_wave=1 lfo1_volume=2 xfin_locc1=0 xfin_hicc1=64 seq_length=1\n");
+    }
+    fclose(f);
+}
+
+int main(int argc, char** argv) {
+    const char* dir = (argc > 1) ? argv[1] : "/tmp";
+    writeInstrument(dir);
+
+    char path[1024];
+    snprintf(path, sizeof(path), "%s/sfzparse.sfz", dir);
+    printf("Parsing %s (%d regions) %d times ...\n", path, REGIONS, RUNS);
+    fflush(stdout);
+
+    clock_t start = clock();
+    for (int i = 0; i < RUNS; i++) {
+        try {
+            sfz::File file(path);
+        } catch (LinuxSampler::Exception& e) {
+            fprintf(stderr, "Parsing failed: %s\n", e.Message().c_str());
+            return -1;
+        }
+    }
+    const double ms = double(clock() - start) * 1000.0 / CLOCKS_PER_SEC;
+    printf("%.3f ms per file\n", ms / RUNS);
+    return 0;
+}
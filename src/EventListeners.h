@@ -31,6 +31,7 @@ namespace LinuxSampler {
     class SamplerChannel;
     class MidiInputDevice;
     class MidiInputPort;
+    struct disk_stream_statistics_t;
 
     template<class L>
     class ListenerList {
@@ -303,6 +304,21 @@ namespace LinuxSampler {
             virtual void BufferFillChanged(int ChannelId, String FillData) = 0;
     };
 
+    /**
+     * This class is used as a listener, which is periodically notified
+     * about the disk streaming statistics of a particular sampler channel.
+     */
+    class DiskStatisticsListener {
+        public:
+            /**
+             * Invoked periodically with the latest disk streaming
+             * statistics of the engine used on the specified sampler channel.
+             * @param ChannelId The numerical ID of the sampler channel.
+             * @param Statistics The disk streaming statistics of the channel's engine.
+             */
+            virtual void DiskStatisticsChanged(int ChannelId, const disk_stream_statistics_t& Statistics) = 0;
+    };
+
     /**
      * This class is used as a listener, which is notified
      * when the total number of active streams is changed.
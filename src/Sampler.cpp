@@ -28,6 +28,7 @@
 #include "common/global_private.h"
 #include "engines/EngineFactory.h"
 #include "engines/EngineChannelFactory.h"
+#include "engines/common/StreamBlockCache.h"
 #include "plugins/InstrumentEditorFactory.h"
 #include "drivers/audio/AudioOutputDeviceFactory.h"
 #include "drivers/midi/MidiInputDeviceFactory.h"
@@ -506,6 +507,20 @@ namespace LinuxSampler {
         }
     }
 
+    void Sampler::AddDiskStatisticsListener(DiskStatisticsListener* l) {
+        llDiskStatisticsListeners.AddListener(l);
+    }
+
+    void Sampler::RemoveDiskStatisticsListener(DiskStatisticsListener* l) {
+        llDiskStatisticsListeners.RemoveListener(l);
+    }
+
+    void Sampler::fireDiskStatisticsChanged(int ChannelId, const disk_stream_statistics_t& Statistics) {
+        for (int i = 0; i < llDiskStatisticsListeners.GetListenerCount(); i++) {
+            llDiskStatisticsListeners.GetListener(i)->DiskStatisticsChanged(ChannelId, Statistics);
+        }
+    }
+
     void Sampler::AddTotalStreamCountListener(TotalStreamCountListener* l) {
         llTotalStreamCountListeners.AddListener(l);
     }
@@ -819,6 +834,22 @@ namespace LinuxSampler {
         }
     }
 
+    size_t Sampler::GetGlobalStreamCacheSize() {
+        return StreamBlockCache::GetBudget();
+    }
+
+    void Sampler::SetGlobalStreamCacheSize(size_t bytes) {
+        StreamBlockCache::SetBudget(bytes);
+    }
+
+    uint64_t Sampler::GetGlobalInstrumentMemoryBudget() {
+        return InstrumentManager::GetMemoryBudget();
+    }
+
+    void Sampler::SetGlobalInstrumentMemoryBudget(uint64_t bytes) {
+        InstrumentManager::SetMemoryBudget(bytes);
+    }
+
     void Sampler::Reset() {
         // delete sampler channels
         try {
@@ -868,9 +899,10 @@ namespace LinuxSampler {
     void Sampler::fireStatistics() {
         static const LSCPEvent::event_t eventsArr[] = {
             LSCPEvent::event_voice_count, LSCPEvent::event_stream_count,
-            LSCPEvent::event_buffer_fill, LSCPEvent::event_total_voice_count
+            LSCPEvent::event_buffer_fill, LSCPEvent::event_total_voice_count,
+            LSCPEvent::event_disk_statistics
         };
-        static const std::list<LSCPEvent::event_t> events(eventsArr, eventsArr + 4);
+        static const std::list<LSCPEvent::event_t> events(eventsArr, eventsArr + 5);
 
         if (LSCPServer::EventSubscribers(events))
         {
@@ -886,6 +918,8 @@ namespace LinuxSampler {
                 fireVoiceCountChanged(iter->first, pEngineChannel->GetVoiceCount());
                 fireStreamCountChanged(iter->first, pEngineChannel->GetDiskStreamCount());
                 fireBufferFillChanged(iter->first, pEngine->DiskStreamBufferFillPercentage());
+                if (pEngine->DiskStreamSupported())
+                    fireDiskStatisticsChanged(iter->first, pEngine->DiskStreamStatistics());
             }
 
             fireTotalStreamCountChanged(GetDiskStreamCount());
@@ -594,6 +594,42 @@ namespace LinuxSampler {
              */
             void SetGlobalMaxStreams(int n) throw (Exception);
 
+            /**
+             * Returns the RAM budget (in bytes) of the block cache shared by
+             * all disk streams of all sampler engine instances.
+             *
+             * @see SetGlobalStreamCacheSize()
+             */
+            size_t GetGlobalStreamCacheSize();
+
+            /**
+             * Sets the RAM budget of the block cache shared by all disk
+             * streams. This cache avoids reading the same sample data again
+             * from disk if the same sample is streamed by several voices.
+             * A value of zero disables the cache.
+             *
+             * @param bytes - new maximum size of the cache in bytes
+             */
+            void SetGlobalStreamCacheSize(size_t bytes);
+
+            /**
+             * Returns the RAM budget (in bytes) for the cached sample data
+             * of all loaded instruments, 0 means unlimited.
+             *
+             * @see SetGlobalInstrumentMemoryBudget()
+             */
+            uint64_t GetGlobalInstrumentMemoryBudget();
+
+            /**
+             * Sets the RAM budget for the cached sample data of all loaded
+             * instruments. Whenever it is exceeded, the least recently used
+             * instruments with load mode ON_DEMAND_HOLD which are not used
+             * by any sampler channel are freed.
+             *
+             * @param bytes - new memory budget in bytes, 0 for no limit
+             */
+            void SetGlobalInstrumentMemoryBudget(uint64_t bytes);
+
             /**
              * Reset the whole sampler. Destroy all engines, sampler
              * channels, MIDI input devices and audio output devices.
@@ -694,6 +730,26 @@ namespace LinuxSampler {
              */
             void fireBufferFillChanged(int ChannelId, String FillData);
 
+            /**
+             * Registers the specified listener to be periodically
+             * notified about the disk streaming statistics of each
+             * sampler channel.
+             */
+            void AddDiskStatisticsListener(DiskStatisticsListener* l);
+
+            /**
+             * Removes the specified listener.
+             */
+            void RemoveDiskStatisticsListener(DiskStatisticsListener* l);
+
+            /**
+             * Notifies listeners about the latest disk streaming statistics
+             * of the specified sampler channel.
+             * @param ChannelId The numerical ID of the sampler channel.
+             * @param Statistics The disk streaming statistics of the channel's engine.
+             */
+            void fireDiskStatisticsChanged(int ChannelId, const disk_stream_statistics_t& Statistics);
+
             /**
              * Registers the specified listener to be notified
              * when total number of active voices is changed.
@@ -840,6 +896,7 @@ namespace LinuxSampler {
             ListenerList<VoiceCountListener*> llVoiceCountListeners;
             ListenerList<StreamCountListener*> llStreamCountListeners;
             ListenerList<BufferFillListener*> llBufferFillListeners;
+            ListenerList<DiskStatisticsListener*> llDiskStatisticsListeners;
             ListenerList<TotalStreamCountListener*> llTotalStreamCountListeners;
             ListenerList<TotalVoiceCountListener*> llTotalVoiceCountListeners;
             ListenerList<FxSendCountListener*> llFxSendCountListeners;
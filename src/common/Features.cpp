@@ -23,6 +23,8 @@
 
 #include "Features.h"
 
+#include <thread>
+
 #if CONFIG_ASM && ARCH_X86
 bool Features::bMMX(false);
 bool Features::bSSE(false);
@@ -91,3 +93,11 @@ String Features::featuresAsString() {
     #endif // CONFIG_ASM && ARCH_X86
     return sFeatures;
 }
+
+/**
+ * Returns the amount of CPU cores available to the sampler, at least 1.
+ */
+int Features::processorCount() {
+    const int n = int(std::thread::hardware_concurrency());
+    return (n > 0) ? n : 1;
+}
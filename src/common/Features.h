@@ -34,6 +34,7 @@ class Features {
         static void   detect();
         static bool   enableDenormalsAreZeroMode();
         static String featuresAsString();
+        static int    processorCount();
 
         #if CONFIG_ASM && ARCH_X86
         inline static bool supportsMMX() { return bMMX; }
@@ -0,0 +1,288 @@
+/*
+ * Copyright (c) 2020 Christian Schoenebeck
+ *
+ * http://www.linuxsampler.org
+ *
+ * This file is part of LinuxSampler and released under the same terms.
+ * See README file for details.
+ */
+
+#include "HugePages.h"
+
+#if CONFIG_HUGE_PAGES
+
+#include <sys/mman.h>
+#include <stdio.h>
+#include <iostream>
+
+namespace LinuxSampler {
+
+    Mutex                     HugePages::HugePagesMutex;
+    HugePages::MappingMap     HugePages::Mappings;
+    std::set<uint8_t*>        HugePages::FreeLists[FREE_LISTS];
+    std::map<void*,size_t>    HugePages::HeapBuffers;
+    uint64_t                  HugePages::HeapBytes = 0;
+
+    /**
+     * Maps @a Bytes (rounded up to the huge page size) of anonymous memory,
+     * preferably with explicit huge pages, otherwise aligned to the huge
+     * page size and advised to be backed by transparent huge pages.
+     */
+    uint8_t* HugePages::MapRegion(size_t& Bytes, bool& bHugeTLB) {
+        Bytes = (Bytes + HUGE_PAGE_SIZE - 1) / HUGE_PAGE_SIZE * HUGE_PAGE_SIZE;
+        void* p;
+        #ifdef MAP_HUGETLB
+        p = mmap(NULL, Bytes, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB, -1, 0);
+        if (p != MAP_FAILED) {
+            bHugeTLB = true;
+            return (uint8_t*) p;
+        }
+        #endif
+        bHugeTLB = false;
+
+        // over-allocate and trim, to get a mapping aligned to huge pages
+        p = mmap(NULL, Bytes + HUGE_PAGE_SIZE, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+        if (p == MAP_FAILED) return NULL;
+        uint8_t* pBegin = (uint8_t*) p;
+        const size_t head = (HUGE_PAGE_SIZE - size_t(pBegin) % HUGE_PAGE_SIZE) % HUGE_PAGE_SIZE;
+        if (head) munmap(pBegin, head);
+        munmap(pBegin + head + Bytes, HUGE_PAGE_SIZE - head);
+        pBegin += head;
+        #ifdef MADV_HUGEPAGE
+        madvise(pBegin, Bytes, MADV_HUGEPAGE);
+        #endif
+        return pBegin;
+    }
+
+    /// Returns the mapping which contains address @a p, or Mappings.end().
+    HugePages::MappingMap::iterator HugePages::FindMapping(const void* p) {
+        MappingMap::iterator it = Mappings.upper_bound((uint8_t*)p);
+        if (it == Mappings.begin()) return Mappings.end();
+        --it;
+        if ((const uint8_t*)p >= it->first + it->second.Size) return Mappings.end();
+        return it;
+    }
+
+    /**
+     * Returns the free list for free ranges of @a Bytes size: free list i
+     * holds the ranges of at least 2^i and less than 2^(i+1) times
+     * ALIGNMENT bytes.
+     */
+    int HugePages::FreeList(size_t Bytes) {
+        int i = 0;
+        for (size_t n = Bytes / ALIGNMENT; n > 1 && i < FREE_LISTS - 1; n >>= 1) i++;
+        return i;
+    }
+
+    /// Adds a free range to the given arena and to the respective free list.
+    void HugePages::AddFreeRange(MappingMap::iterator Arena, size_t Offset, size_t Bytes) {
+        Arena->second.FreeRanges[Offset] = Bytes;
+        FreeLists[FreeList(Bytes)].insert(Arena->first + Offset);
+    }
+
+    /// Removes a free range from the given arena and from its free list.
+    void HugePages::RemoveFreeRange(MappingMap::iterator Arena, RangeMap::iterator Range) {
+        FreeLists[FreeList(Range->second)].erase(Arena->first + Range->first);
+        Arena->second.FreeRanges.erase(Range);
+    }
+
+    uint8_t* HugePages::Map(size_t Bytes) {
+        if (!Bytes) return NULL;
+        bool bHugeTLB;
+        uint8_t* pRegion = MapRegion(Bytes, bHugeTLB);
+        if (!pRegion) return NULL;
+        LockGuard lock(HugePagesMutex);
+        mapping_t& mapping = Mappings[pRegion];
+        mapping.Size     = Bytes;
+        mapping.bHugeTLB = bHugeTLB;
+        mapping.bArena   = false;
+        mapping.Usage    = Bytes;
+        dmsg(2,("HugePages: mapped %lu bytes (%s)\n", (unsigned long) Bytes, bHugeTLB ? "explicit" : "transparent"));
+        return pRegion;
+    }
+
+    void HugePages::Unmap(void* pRegion) {
+        if (!pRegion) return;
+        LockGuard lock(HugePagesMutex);
+        MappingMap::iterator it = Mappings.find((uint8_t*)pRegion);
+        if (it == Mappings.end() || it->second.bArena) {
+            std::cerr << "HugePages: attempt to unmap unknown region! Please report this!\n" << std::flush;
+            return;
+        }
+        munmap(it->first, it->second.Size);
+        Mappings.erase(it);
+    }
+
+    int8_t* HugePages::Allocate(size_t Bytes) {
+        Bytes = (Bytes + ALIGNMENT - 1) / ALIGNMENT * ALIGNMENT;
+        if (!Bytes) Bytes = ALIGNMENT;
+
+        // large buffers get their own mapping, to not fragment the arenas
+        if (Bytes > ARENA_SIZE / 4) {
+            uint8_t* p = Map(Bytes);
+            if (p) return (int8_t*) p;
+        } else {
+            LockGuard lock(HugePagesMutex);
+            // good fit: a few ranges of the requested size class might be
+            // large enough, any range of a larger size class is
+            MappingMap::iterator bestArena = Mappings.end();
+            RangeMap::iterator best;
+            const int requested = FreeList(Bytes);
+            std::set<uint8_t*>::iterator r = FreeLists[requested].begin();
+            for (int i = 0; i < FIT_PROBES && r != FreeLists[requested].end(); ++i, ++r) {
+                MappingMap::iterator arena = FindMapping(*r);
+                RangeMap::iterator range = arena->second.FreeRanges.find(size_t(*r - arena->first));
+                if (range->second >= Bytes) {
+                    bestArena = arena;
+                    best = range;
+                    break;
+                }
+            }
+            for (int i = requested + 1; bestArena == Mappings.end() && i < FREE_LISTS; i++) {
+                if (FreeLists[i].empty()) continue;
+                uint8_t* p = *FreeLists[i].begin();
+                bestArena = FindMapping(p);
+                best = bestArena->second.FreeRanges.find(size_t(p - bestArena->first));
+            }
+            if (bestArena == Mappings.end()) { // all arenas exhausted, map a new one
+                size_t size = ARENA_SIZE;
+                bool bHugeTLB;
+                uint8_t* pArena = MapRegion(size, bHugeTLB);
+                if (pArena) {
+                    bestArena = Mappings.insert(std::make_pair(pArena, mapping_t())).first;
+                    mapping_t& arena = bestArena->second;
+                    arena.Size     = size;
+                    arena.bHugeTLB = bHugeTLB;
+                    arena.bArena   = true;
+                    arena.Usage    = 0;
+                    AddFreeRange(bestArena, 0, size);
+                    best = arena.FreeRanges.begin();
+                    dmsg(2,("HugePages: new arena (%s)\n", bHugeTLB ? "explicit" : "transparent"));
+                }
+            }
+            if (bestArena != Mappings.end()) {
+                mapping_t& arena = bestArena->second;
+                const size_t offset = best->first;
+                const size_t left   = best->second - Bytes;
+                RemoveFreeRange(bestArena, best);
+                if (left) AddFreeRange(bestArena, offset + Bytes, left);
+                arena.UsedRanges[offset] = Bytes;
+                arena.Usage += Bytes;
+                return (int8_t*) (bestArena->first + offset);
+            }
+        }
+
+        // no huge page backed memory available at all
+        int8_t* p = new int8_t[Bytes];
+        LockGuard lock(HugePagesMutex);
+        HeapBuffers[p] = Bytes;
+        HeapBytes += Bytes;
+        return p;
+    }
+
+    void HugePages::Free(void* pBuffer) {
+        if (!pBuffer) return;
+        LockGuard lock(HugePagesMutex);
+        MappingMap::iterator it = FindMapping(pBuffer);
+        if (it == Mappings.end()) {
+            std::map<void*,size_t>::iterator heap = HeapBuffers.find(pBuffer);
+            if (heap == HeapBuffers.end()) {
+                std::cerr << "HugePages: attempt to free unknown buffer! Please report this!\n" << std::flush;
+                return;
+            }
+            HeapBytes -= heap->second;
+            HeapBuffers.erase(heap);
+            delete[] (int8_t*) pBuffer;
+            return;
+        }
+        mapping_t& mapping = it->second;
+        if (!mapping.bArena) { // dedicated mapping of a large buffer
+            munmap(it->first, mapping.Size);
+            Mappings.erase(it);
+            return;
+        }
+
+        size_t offset = size_t((uint8_t*)pBuffer - it->first);
+        RangeMap::iterator used = mapping.UsedRanges.find(offset);
+        if (used == mapping.UsedRanges.end()) {
+            std::cerr << "HugePages: attempt to free unknown buffer! Please report this!\n" << std::flush;
+            return;
+        }
+        size_t bytes = used->second;
+        mapping.UsedRanges.erase(used);
+        mapping.Usage -= bytes;
+        if (!mapping.Usage) { // give unused arenas back to the system
+            while (!mapping.FreeRanges.empty())
+                RemoveFreeRange(it, mapping.FreeRanges.begin());
+            munmap(it->first, mapping.Size);
+            Mappings.erase(it);
+            return;
+        }
+
+        // coalesce with the following free range
+        RangeMap::iterator next = mapping.FreeRanges.lower_bound(offset);
+        if (next != mapping.FreeRanges.end() && next->first == offset + bytes) {
+            bytes += next->second;
+            RemoveFreeRange(it, next);
+            next = mapping.FreeRanges.lower_bound(offset);
+        }
+        // coalesce with the preceding free range
+        if (next != mapping.FreeRanges.begin()) {
+            RangeMap::iterator prev = next;
+            --prev;
+            if (prev->first + prev->second == offset) {
+                offset = prev->first;
+                bytes += prev->second;
+                RemoveFreeRange(it, prev);
+            }
+        }
+        AddFreeRange(it, offset, bytes);
+    }
+
+    HugePages::statistics_t HugePages::GetStatistics() {
+        statistics_t stats;
+        stats.Bytes         = 0;
+        stats.HugePageBytes = 0;
+        // begin and size of all transparent huge page mappings
+        std::map<uint8_t*,size_t> transparent;
+        {
+            LockGuard lock(HugePagesMutex);
+            stats.HeapBytes = HeapBytes;
+            for (MappingMap::iterator it = Mappings.begin(); it != Mappings.end(); ++it) {
+                stats.Bytes += it->second.Size;
+                if (it->second.bHugeTLB) stats.HugePageBytes += it->second.Size;
+                else transparent[it->first] = it->second.Size;
+            }
+        }
+        if (transparent.empty()) return stats;
+
+        // whether transparent huge pages were actually used is only known
+        // by the kernel, so sum up "AnonHugePages" of all memory areas
+        // which consist of our transparent huge page mappings (reading the
+        // file takes a while, so without blocking Allocate() and Free())
+        FILE* f = fopen("/proc/self/smaps", "r");
+        if (!f) return stats;
+        char line[256];
+        bool bOurs = false;
+        while (fgets(line, sizeof(line), f)) {
+            unsigned long begin, end;
+            unsigned long kb;
+            if (sscanf(line, "%lx-%lx ", &begin, &end) == 2) {
+                // the kernel might have merged adjacent mappings of ours
+                bOurs = true;
+                for (uint8_t* p = (uint8_t*) begin; bOurs && p < (uint8_t*) end; ) {
+                    std::map<uint8_t*,size_t>::iterator it = transparent.find(p);
+                    bOurs = it != transparent.end();
+                    if (bOurs) p += it->second;
+                }
+            } else if (bOurs && sscanf(line, "AnonHugePages: %lu kB", &kb) == 1) {
+                stats.HugePageBytes += uint64_t(kb) * 1024;
+            }
+        }
+        fclose(f);
+        return stats;
+    }
+
+} // namespace LinuxSampler
+
+#endif // CONFIG_HUGE_PAGES
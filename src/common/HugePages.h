@@ -0,0 +1,118 @@
+/*
+ * Copyright (c) 2020 Christian Schoenebeck
+ *
+ * http://www.linuxsampler.org
+ *
+ * This file is part of LinuxSampler and released under the same terms.
+ * See README file for details.
+ */
+
+#ifndef LS_HUGEPAGES_H
+#define LS_HUGEPAGES_H
+
+#include "global_private.h"
+
+#if CONFIG_HUGE_PAGES
+
+#include "Mutex.h"
+#include <map>
+#include <set>
+#include <stddef.h>
+
+namespace LinuxSampler {
+
+    /** @brief Huge page backed memory for sample data.
+     *
+     * Voices read from sample RAM caches and disk stream buffers scattered
+     * over gigabytes of memory, which causes a lot of TLB misses with
+     * regular 4 kB pages. Memory allocated by this class is backed by huge
+     * pages instead: explicit huge pages (@c MAP_HUGETLB) if the system
+     * reserved some, otherwise transparent huge pages are requested for
+     * the memory (@c MADV_HUGEPAGE). If neither is possible, regular pages
+     * or the heap are used as fallback, so allocations never fail because
+     * of this class.
+     *
+     * Map() provides large memory regions (i.e. the disk threads' stream
+     * buffer slabs), Allocate() small buffers (i.e. RAM caches of
+     * samples), which are carved out of shared huge page backed arenas.
+     *
+     * This class is thread safe, but it may block and it calls the system,
+     * so it must not be used by audio threads.
+     */
+    class HugePages {
+        public:
+            /// Memory usage statistics.
+            struct statistics_t {
+                uint64_t Bytes;         ///< Memory currently mapped by this class in bytes.
+                uint64_t HugePageBytes; ///< Part of it actually backed by huge pages in bytes.
+                uint64_t HeapBytes;     ///< Memory which had to be allocated from the heap instead in bytes.
+            };
+
+            /**
+             * Maps a memory region of (at least) @a Bytes size, aligned to
+             * the huge page size.
+             *
+             * @returns the region or NULL if no memory could be mapped
+             */
+            static uint8_t* Map(size_t Bytes);
+
+            /// Unmaps a region previously returned by Map().
+            static void Unmap(void* pRegion);
+
+            /**
+             * Returns a buffer of (at least) @a Bytes size, aligned to
+             * cache lines. If no huge page backed memory can be mapped,
+             * the buffer is allocated from the heap instead.
+             */
+            static int8_t* Allocate(size_t Bytes);
+
+            /// Returns a buffer previously obtained by Allocate().
+            static void Free(void* pBuffer);
+
+            /**
+             * Returns the current memory usage. Which part of the memory
+             * requested as transparent huge pages actually landed on huge
+             * pages is determined by asking the system, so this is not
+             * cheap.
+             */
+            static statistics_t GetStatistics();
+
+        private:
+            enum {
+                HUGE_PAGE_SIZE = 2 * 1024 * 1024,  ///< Huge page size assumed for alignment.
+                ARENA_SIZE     = 32 * 1024 * 1024, ///< Size of the arenas Allocate() carves buffers out of.
+                ALIGNMENT      = 64,               ///< Buffers are aligned to cache lines.
+                FREE_LISTS     = 20,               ///< Amount of free lists, enough for ARENA_SIZE / ALIGNMENT.
+                FIT_PROBES     = 8                 ///< Max. free ranges checked in the free list of the requested size.
+            };
+
+            typedef std::map<size_t,size_t> RangeMap; ///< Maps offset (in bytes) within an arena to size (in bytes).
+
+            struct mapping_t {
+                size_t Size;
+                bool   bHugeTLB; ///< Explicit huge pages, otherwise transparent huge pages were requested.
+                bool   bArena;   ///< Whether Allocate() carves buffers out of this mapping.
+                size_t Usage;    ///< Amount of bytes handed out (arenas only).
+                RangeMap FreeRanges; ///< Arenas only.
+                RangeMap UsedRanges; ///< Arenas only.
+            };
+            typedef std::map<uint8_t*,mapping_t> MappingMap; ///< Maps begin of a mapping to the mapping.
+
+            static Mutex                    HugePagesMutex; ///< Protects all attributes below.
+            static MappingMap               Mappings;
+            static std::set<uint8_t*>       FreeLists[FREE_LISTS]; ///< Free ranges of all arenas by size class (see FreeList()).
+            static std::map<void*,size_t>   HeapBuffers; ///< Fallback buffers allocated from the heap and their sizes.
+            static uint64_t                 HeapBytes;
+
+            static uint8_t* MapRegion(size_t& Bytes, bool& bHugeTLB);
+            static MappingMap::iterator FindMapping(const void* p);
+            static int FreeList(size_t Bytes);
+            static void AddFreeRange(MappingMap::iterator Arena, size_t Offset, size_t Bytes);
+            static void RemoveFreeRange(MappingMap::iterator Arena, RangeMap::iterator Range);
+    };
+
+} // namespace LinuxSampler
+
+#endif // CONFIG_HUGE_PAGES
+
+#endif // LS_HUGEPAGES_H
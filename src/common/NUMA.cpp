@@ -0,0 +1,121 @@
+/*
+ * Copyright (c) 2020 Christian Schoenebeck
+ *
+ * http://www.linuxsampler.org
+ *
+ * This file is part of LinuxSampler and released under the same terms.
+ * See README file for details.
+ */
+
+#include "NUMA.h"
+
+#if CONFIG_NUMA
+
+#include <numa.h>
+#include <numaif.h>
+#include <sched.h>
+#include <vector>
+
+namespace LinuxSampler {
+
+    enum {
+        MAX_NODES  = 1024, ///< Nodes supported by BindThread()'s node mask.
+        MOVE_BATCH = 1024  ///< Pages migrated by MoveMemory() with one system call.
+    };
+
+    struct NUMA::topology_t {
+        bool                   bAvailable;
+        int                    Nodes;
+        std::vector<cpu_set_t> NodeCpus; ///< CPUs of each node.
+        cpu_set_t              AllCpus;
+        size_t                 PageSize;
+    };
+
+    /**
+     * Determines the nodes and their CPUs. Called only once, on first use of
+     * this class. BindThread() and MoveMemory() are only called with valid
+     * nodes after IsAvailable() returned true, so this never happens in an
+     * audio thread.
+     */
+    NUMA::topology_t NUMA::Probe() {
+        topology_t topology;
+        topology.bAvailable = false;
+        topology.Nodes      = 1;
+        topology.PageSize   = 4096;
+        CPU_ZERO(&topology.AllCpus);
+        if (numa_available() < 0 || numa_max_node() < 1 || numa_max_node() >= MAX_NODES)
+            return topology;
+
+        topology.Nodes    = numa_max_node() + 1;
+        topology.PageSize = numa_pagesize();
+        topology.NodeCpus.resize(topology.Nodes);
+        struct bitmask* cpus = numa_allocate_cpumask();
+        for (int node = 0; node < topology.Nodes; ++node) {
+            cpu_set_t& set = topology.NodeCpus[node];
+            CPU_ZERO(&set);
+            if (numa_node_to_cpus(node, cpus) < 0) continue;
+            for (unsigned int cpu = 0; cpu < cpus->size && cpu < CPU_SETSIZE; ++cpu) {
+                if (!numa_bitmask_isbitset(cpus, cpu)) continue;
+                CPU_SET(cpu, &set);
+                CPU_SET(cpu, &topology.AllCpus);
+            }
+            dmsg(1,("NUMA: node %d has %d CPUs\n", node, CPU_COUNT(&set)));
+        }
+        numa_free_cpumask(cpus);
+        topology.bAvailable = true;
+        return topology;
+    }
+
+    const NUMA::topology_t& NUMA::Topology() {
+        static const topology_t topology = Probe();
+        return topology;
+    }
+
+    bool NUMA::IsAvailable() {
+        return Topology().bAvailable;
+    }
+
+    int NUMA::NodeCount() {
+        return Topology().Nodes;
+    }
+
+    bool NUMA::BindThread(int Node) {
+        const topology_t& topology = Topology();
+        if (!topology.bAvailable || Node >= topology.Nodes) return false;
+        const cpu_set_t& cpus = (Node < 0) ? topology.AllCpus : topology.NodeCpus[Node];
+        if (!CPU_COUNT(&cpus) || sched_setaffinity(0, sizeof(cpu_set_t), &cpus)) return false;
+        if (Node < 0) return !set_mempolicy(MPOL_DEFAULT, NULL, 0);
+        const int bits = 8 * sizeof(unsigned long);
+        unsigned long mask[MAX_NODES / bits] = {};
+        mask[Node / bits] = 1UL << (Node % bits);
+        return !set_mempolicy(MPOL_PREFERRED, mask, MAX_NODES + 1);
+    }
+
+    size_t NUMA::MoveMemory(const void* pBlock, size_t Bytes, int Node) {
+        const topology_t& topology = Topology();
+        if (!topology.bAvailable || !pBlock || !Bytes || Node < 0 || Node >= topology.Nodes)
+            return 0;
+        const size_t pageSize = topology.PageSize;
+        char* pPage = (char*) pBlock - size_t(pBlock) % pageSize;
+        const char* pEnd = (const char*) pBlock + Bytes;
+        void* pages[MOVE_BATCH];
+        int nodes[MOVE_BATCH];
+        int status[MOVE_BATCH];
+        size_t bytes = 0;
+        while (pPage < pEnd) {
+            unsigned long count = 0;
+            for (; count < MOVE_BATCH && pPage < pEnd; ++count, pPage += pageSize) {
+                pages[count] = pPage;
+                nodes[count] = Node;
+            }
+            if (numa_move_pages(0, count, pages, nodes, status, MPOL_MF_MOVE) < 0)
+                break; // i.e. not permitted, leave the rest alone as well
+            for (unsigned long i = 0; i < count; ++i)
+                if (status[i] == Node) bytes += pageSize;
+        }
+        return (bytes < Bytes) ? bytes : Bytes;
+    }
+
+} // namespace LinuxSampler
+
+#endif // CONFIG_NUMA
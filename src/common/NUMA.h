@@ -0,0 +1,78 @@
+/*
+ * Copyright (c) 2020 Christian Schoenebeck
+ *
+ * http://www.linuxsampler.org
+ *
+ * This file is part of LinuxSampler and released under the same terms.
+ * See README file for details.
+ */
+
+#ifndef LS_NUMA_H
+#define LS_NUMA_H
+
+#include "global_private.h"
+
+#if CONFIG_NUMA
+
+#include <stddef.h>
+
+namespace LinuxSampler {
+
+    /** @brief Placement of threads and memory on NUMA nodes.
+     *
+     * On machines with several NUMA nodes (i.e. multi socket machines),
+     * accessing memory attached to another node than the one of the
+     * accessing CPU has a considerably higher latency. That is why each
+     * audio output device is assigned to one NUMA node, and its audio
+     * thread, the voices and disk threads of its engines and the RAM caches
+     * of the instruments loaded on its sampler channels are placed on that
+     * node with the methods of this class.
+     *
+     * If the system only has one node, or if libnuma is not usable, all
+     * methods do nothing.
+     */
+    class NUMA {
+        public:
+            /// Whether the system has more than one NUMA node.
+            static bool IsAvailable();
+
+            /// Amount of NUMA nodes of the system (1 if IsAvailable() is false).
+            static int NodeCount();
+
+            /**
+             * Binds the calling thread to the CPUs of NUMA node @a Node and
+             * lets it allocate new memory from that node. Passing -1 removes
+             * the binding again.
+             *
+             * As it calls the system and might move the thread to another
+             * CPU, audio threads should only call it once when being
+             * started.
+             *
+             * @returns false if the thread could not be bound
+             */
+            static bool BindThread(int Node);
+
+            /**
+             * Migrates the pages of the given memory block to NUMA node
+             * @a Node. Pages which were not touched yet are left alone, they
+             * are allocated on the node of the thread touching them first.
+             * Since whole pages are migrated, data sharing pages with the
+             * block is migrated as well.
+             *
+             * @returns amount of bytes of the block residing on @a Node
+             *          afterwards
+             */
+            static size_t MoveMemory(const void* pBlock, size_t Bytes, int Node);
+
+        private:
+            struct topology_t;
+
+            static topology_t Probe();
+            static const topology_t& Topology();
+    };
+
+} // namespace LinuxSampler
+
+#endif // CONFIG_NUMA
+
+#endif // LS_NUMA_H
@@ -27,12 +27,26 @@
 #include <set>
 #include <map>
 #include <vector>
+#include <atomic>
+#include <condition_variable>
+#include <stdint.h>
 
 #include "Exception.h"
 #include "Mutex.h"
 
 namespace LinuxSampler {
 
+/**
+ * Returns a new, ever increasing number on each call. ResourceManager uses
+ * it to record when a resource was used the last time, it is shared by all
+ * ResourceManager instances so that the usage of resources of different
+ * managers can be compared.
+ */
+inline uint64_t ResourceUseTick() {
+    static std::atomic<uint64_t> tick(0);
+    return ++tick;
+}
+
 /** @brief Interface class for Resource Consumers.
  *
  * Interface class for consumer classes which use a resource managed
@@ -73,6 +87,30 @@ class ResourceConsumer {
          */
         virtual void ResourceUpdated(T_res* pOldResource, T_res* pNewResource, void* pUpdateArg) = 0;
 
+        /**
+         * Will be called by the ResourceManager instead of
+         * ResourceToBeUpdated() and ResourceUpdated() if the updated
+         * resource was created while the old one still existed (see
+         * ResourceManager::Recreate()). The consumer could use the old
+         * resource until now and has to switch over to the new one before
+         * returning, the old resource is destroyed afterwards. The default
+         * implementation simply calls ResourceToBeUpdated() and
+         * ResourceUpdated() in a row.
+         *
+         * Unlike the other methods, this one is called without the lock of
+         * the ResourceManager being held, so the consumer might have
+         * handed back @a pOldResource concurrently, in which case it has
+         * to ignore the call.
+         *
+         * @param pOldResource - resource to be destroyed
+         * @param pNewResource - resource replacing @a pOldResource
+         */
+        virtual void ResourceReplaced(T_res* pOldResource, T_res* pNewResource) {
+            void* pUpdateArg = NULL;
+            ResourceToBeUpdated(pOldResource, pUpdateArg);
+            ResourceUpdated(pOldResource, pNewResource, pUpdateArg);
+        }
+
         /**
          * Might be called by the ResourceManager periodically during an
          * update / creation of a resource to inform the consumer about the
@@ -100,6 +138,16 @@ class ResourceConsumer {
  * be called in a realtime context due to this! Alternatively one can 
  * call the respective methods with bLock = false, in that case thread
  * safety mechanisms will be omitted - use with care !
+ *
+ * Resources are created (and recreated by Update()) without holding the
+ * lock of this class, so creating a resource which takes a long time
+ * (i.e. loading a huge instrument) neither blocks the creation of other
+ * resources nor any other call of this class. Consumers borrowing a
+ * resource which is currently being created by another thread wait for
+ * that creation to complete. Create() implementations therefore have to
+ * protect data they share with other resources by themselves. For the
+ * same reason none of the methods which might create a resource may be
+ * called with bLock = true while the calling thread holds Lock().
  */
 template<class T_key, class T_res>
 class ResourceManager {
@@ -123,10 +171,107 @@ class ResourceManager {
             ConsumerSet consumers; ///< list of all consumers who currently use the resource
             void*       lifearg;   ///< optional pointer the descendant might use to store informations about a created resource
             void*       entryarg;  ///< optional pointer the descendant might use to store informations about an entry
+            uint64_t    lastuse;   ///< ResourceUseTick() of the last time the resource was borrowed or handed back
+            bool        creating;  ///< resource is currently being created (or updated) by some thread, with ResourceEntriesMutex unlocked
+            bool        prefetched; ///< resource was created by Prefetch() and has not been borrowed since
+            T_res*      replaced;  ///< resource currently being replaced by Update(), consumers might still hand it back meanwhile
         };
         typedef std::map<T_key, resource_entry_t> ResourceMap;
         ResourceMap ResourceEntries;
         Mutex       ResourceEntriesMutex; // Mutex for protecting the ResourceEntries map
+        std::condition_variable_any ResourceCreated; // signalled whenever a resource creation completed (or failed)
+
+        // lets std::condition_variable_any wait on ResourceEntriesMutex
+        struct EntriesLock {
+            Mutex& mutex;
+            EntriesLock(Mutex& m) : mutex(m) {}
+            void lock()   { mutex.Lock(); }
+            void unlock() { mutex.Unlock(); }
+        };
+
+        /**
+         * Returns the entry of the resource given by \a Key, after
+         * waiting for another thread to complete creating that resource
+         * (if it is currently being created). ResourceEntriesMutex must be
+         * locked by the caller (exactly once if \a bLock is true).
+         *
+         * @throws Exception if the resource is being created by another
+         *         thread and \a bLock is false (waiting would dead lock)
+         */
+        typename ResourceMap::iterator WaitForEntry(T_key Key, bool bLock) {
+            typename ResourceMap::iterator iterEntry = ResourceEntries.find(Key);
+            while (iterEntry != ResourceEntries.end() && iterEntry->second.creating) {
+                if (!bLock)
+                    throw Exception("ResourceManager: resource is being created by another thread");
+                EntriesLock lock(ResourceEntriesMutex);
+                ResourceCreated.wait(lock);
+                iterEntry = ResourceEntries.find(Key);
+            }
+            return iterEntry;
+        }
+
+        /**
+         * Whether the resource of the given entry is currently created, not
+         * used by any consumer and merely kept for later use, that is
+         * either due to a life-time strategy of ON_DEMAND_HOLD or because
+         * it was created by Prefetch().
+         */
+        static bool IsEvictable(const resource_entry_t& entry) {
+            if (!entry.resource || entry.creating || !entry.consumers.empty()) return false;
+            return entry.mode == ON_DEMAND_HOLD || (entry.mode == ON_DEMAND && entry.prefetched);
+        }
+
+        /**
+         * Removes the given entry and destroys its resource, if the entry
+         * is not needed anymore: its resource has a life-time strategy of
+         * ON_DEMAND, is not used by any consumer, is neither being created
+         * nor was it prefetched, and the entry has no custom data.
+         * ResourceEntriesMutex must be locked by the caller.
+         *
+         * @returns true if the entry was removed
+         */
+        bool RemoveIfUnused(typename ResourceMap::iterator iterEntry) {
+            resource_entry_t& entry = iterEntry->second;
+            if (entry.mode != ON_DEMAND || entry.entryarg || !entry.consumers.empty() ||
+                entry.creating || entry.prefetched) return false;
+            T_res* resource = entry.resource;
+            void* arg       = entry.lifearg;
+            ResourceEntries.erase(iterEntry);
+            if (resource) Destroy(resource, arg);
+            return true;
+        }
+
+        /**
+         * Creates the resource of the given entry by calling Create(). If
+         * \a bLock is true, ResourceEntriesMutex (which must be locked by
+         * the caller) is unlocked meanwhile, the entry is marked as being
+         * created, so it is neither removed nor created again by other
+         * threads meanwhile. If Create() throws, the exception is passed on
+         * with ResourceEntriesMutex unlocked (if \a bLock is true) and the
+         * entry is removed if \a bRemoveOnFailure is true.
+         */
+        void CreateResource(typename ResourceMap::iterator iterEntry, ResourceConsumer<T_res>* pConsumer, bool bRemoveOnFailure, bool bLock) {
+            resource_entry_t& entry = iterEntry->second;
+            void* lifearg = entry.lifearg;
+            entry.creating = true;
+            if (bLock) ResourceEntriesMutex.Unlock();
+            T_res* resource;
+            try {
+                resource = Create(entry.key, pConsumer, lifearg);
+            } catch (...) {
+                if (bLock) ResourceEntriesMutex.Lock();
+                entry.creating = false;
+                if (bRemoveOnFailure) ResourceEntries.erase(iterEntry);
+                ResourceCreated.notify_all();
+                if (bLock) ResourceEntriesMutex.Unlock();
+                throw; // rethrow the same exception
+            }
+            if (bLock) ResourceEntriesMutex.Lock();
+            entry.resource = resource;
+            entry.lifearg  = lifearg;
+            entry.creating = false;
+            ResourceCreated.notify_all();
+        }
 
     public:
         /**
@@ -201,7 +346,7 @@ class ResourceManager {
         T_res* Borrow(T_key Key, ResourceConsumer<T_res>* pConsumer, bool bLock = true) {
             if (bLock) ResourceEntriesMutex.Lock();
             // search for an entry for this resource
-            typename ResourceMap::iterator iterEntry = ResourceEntries.find(Key);
+            typename ResourceMap::iterator iterEntry = WaitForEntry(Key, bLock);
             if (iterEntry == ResourceEntries.end()) { // entry doesn't exist yet
                 // already create an entry for the resource
                 resource_entry_t entry;
@@ -210,39 +355,28 @@ class ResourceManager {
                 entry.mode     = ON_DEMAND; // default mode
                 entry.lifearg  = NULL;
                 entry.entryarg = NULL;
+                entry.lastuse  = ResourceUseTick();
+                entry.creating = false;
+                entry.prefetched = false;
+                entry.replaced = NULL;
                 entry.consumers.insert(pConsumer);
-                ResourceEntries[Key] = entry;
-                try {
-                    // actually create the resource
-                    entry.resource = Create(Key, pConsumer, entry.lifearg);
-                } catch (...) {
-                    // creating the resource failed, so remove the entry
-                    ResourceEntries.erase(Key);
-                    if (bLock) ResourceEntriesMutex.Unlock();
-                    // rethrow the same exception
-                    throw;
-                }
-                // now update the entry with the created resource
-                ResourceEntries[Key] = entry;
-                OnBorrow(entry.resource, pConsumer, entry.lifearg);
-                if (bLock) ResourceEntriesMutex.Unlock();
-                return entry.resource;
-            } else { // entry already exists
-                resource_entry_t& entry = iterEntry->second;
-                if (!entry.resource) { // create resource if not created already
-                    try {
-                        entry.resource = Create(Key, pConsumer, entry.lifearg);
-                    } catch (...) {
-                        entry.resource = NULL;
-                        if (bLock) ResourceEntriesMutex.Unlock();
-                        throw; // rethrow the same exception
-                    }
-                }
-                entry.consumers.insert(pConsumer);
-                OnBorrow(entry.resource, pConsumer, entry.lifearg);
-                if (bLock) ResourceEntriesMutex.Unlock();
-                return entry.resource;
+                iterEntry = ResourceEntries.insert(std::make_pair(Key, entry)).first;
+                // actually create the resource (removing the entry on failure)
+                CreateResource(iterEntry, pConsumer, true, bLock);
+            } else if (!iterEntry->second.resource) { // create resource if not created already
+                CreateResource(iterEntry, pConsumer, false, bLock);
             }
+            resource_entry_t& entry = iterEntry->second;
+            entry.consumers.insert(pConsumer);
+            entry.lastuse = ResourceUseTick();
+            entry.prefetched = false; // from now on it's subject to its life-time strategy
+            T_res* resource = entry.resource;
+            void* arg       = entry.lifearg;
+            if (bLock) ResourceEntriesMutex.Unlock();
+            // the consumer is registered already, so the resource won't be
+            // destroyed meanwhile, and OnBorrow() might update the resource
+            OnBorrow(resource, pConsumer, arg);
+            return resource;
         }
 
         /**
@@ -256,29 +390,27 @@ class ResourceManager {
          * @param pConsumer - identifier of the consumer who borrowed the
          *                    resource
          * @param bLock     - use thread safety mechanisms
+         * @returns false if \a pResource is not managed by this instance
          */
-        void HandBack(T_res* pResource, ResourceConsumer<T_res>* pConsumer, bool bLock = true) {
+        bool HandBack(T_res* pResource, ResourceConsumer<T_res>* pConsumer, bool bLock = true) {
             if (bLock) ResourceEntriesMutex.Lock();
             // search for the entry associated with the given resource
             typename ResourceMap::iterator iter = ResourceEntries.begin();
             typename ResourceMap::iterator end  = ResourceEntries.end();
             for (; iter != end; iter++) {
-                if (iter->second.resource == pResource) { // found entry for resource
+                if (iter->second.resource == pResource || (pResource && iter->second.replaced == pResource)) { // found entry for resource
                     resource_entry_t& entry = iter->second;
                     entry.consumers.erase(pConsumer);
-                    // remove entry if necessary
-                    if (entry.mode == ON_DEMAND && !entry.entryarg && entry.consumers.empty()) {
-                        T_res* resource = entry.resource;
-                        void* arg       = entry.lifearg;
-                        ResourceEntries.erase(iter);
-                        // destroy resource if necessary
-                        if (resource) Destroy(resource, arg);
-                    }
+                    entry.lastuse = ResourceUseTick();
+                    // remove entry if necessary (if the resource is being
+                    // created meanwhile, that's done once it is created)
+                    RemoveIfUnused(iter);
                     if (bLock) ResourceEntriesMutex.Unlock();
-                    return;
+                    return true;
                 }
             }
             if (bLock) ResourceEntriesMutex.Unlock();
+            return false;
         }
 
         /**
@@ -288,6 +420,14 @@ class ResourceManager {
          * and finally the consumers will be informed once the update was
          * completed, so they can continue to use the resource.
          *
+         * If the descendant is able to create the updated resource while
+         * the old one still exists (see Recreate()), the consumers keep
+         * using the old resource meanwhile instead. They are informed
+         * with ResourceConsumer::ResourceReplaced() once the new resource
+         * is ready, and the old resource is destroyed afterwards, both
+         * after the lock of this class was released. If recreating the
+         * resource fails, the old resource is left untouched.
+         *
          * @param pResource - resource to be updated
          * @param pConsumer - consumer who requested the update
          * @param bLock     - use thread safety mechanisms
@@ -299,6 +439,54 @@ class ResourceManager {
             for (; iter != end; iter++) {
                 if (iter->second.resource == pResource) {
                     resource_entry_t& entry = iter->second;
+                    if (entry.creating) break; // already being updated by another thread
+                    // try to create the new resource side by side to the old one
+                    T_res* pOldResource = entry.resource;
+                    void*  pOldArg      = entry.lifearg;
+                    void*  pNewArg      = NULL;
+                    T_res* pNewResource;
+                    entry.creating = true;
+                    if (bLock) ResourceEntriesMutex.Unlock();
+                    try {
+                        pNewResource = Recreate(entry.key, pConsumer, pOldResource, pOldArg, pNewArg);
+                    } catch (...) {
+                        if (bLock) ResourceEntriesMutex.Lock();
+                        entry.creating = false;
+                        ResourceCreated.notify_all();
+                        RemoveIfUnused(iter); // all consumers might have left meanwhile
+                        if (bLock) ResourceEntriesMutex.Unlock();
+                        throw; // rethrow the same exception
+                    }
+                    if (bLock) ResourceEntriesMutex.Lock();
+                    entry.creating = false;
+                    if (pNewResource) {
+                        entry.resource = pNewResource;
+                        entry.lifearg  = pNewArg;
+                        entry.replaced = pOldResource;
+                        ResourceCreated.notify_all();
+                        // consumers switch over with the lock released, as
+                        // they lock their own mutexes meanwhile, which they
+                        // might also hold while calling HandBack()
+                        const T_key key = entry.key;
+                        ConsumerSet consumers = entry.consumers;
+                        if (bLock) ResourceEntriesMutex.Unlock();
+                        typename ConsumerSet::iterator iterCons = consumers.begin();
+                        typename ConsumerSet::iterator endCons  = consumers.end();
+                        for (; iterCons != endCons; iterCons++) {
+                            if (*iterCons == pConsumer) continue;
+                            (*iterCons)->ResourceReplaced(pOldResource, pNewResource);
+                        }
+                        if (bLock) ResourceEntriesMutex.Lock();
+                        iter = ResourceEntries.find(key);
+                        if (iter != ResourceEntries.end() && iter->second.replaced == pOldResource) {
+                            iter->second.replaced = NULL;
+                            // all consumers might have left meanwhile
+                            RemoveIfUnused(iter);
+                        }
+                        if (bLock) ResourceEntriesMutex.Unlock();
+                        Destroy(pOldResource, pOldArg);
+                        return;
+                    }
                     // inform all consumers about pending update
                     std::map<ResourceConsumer<T_res>*,void*> updateargs;
                     typename ConsumerSet::iterator iterCons = entry.consumers.begin();
@@ -309,10 +497,21 @@ class ResourceManager {
                         (*iterCons)->ResourceToBeUpdated(entry.resource, updatearg);
                         if (updatearg) updateargs[*iterCons] = updatearg;
                     }
-                    // update resource
-                    T_res* pOldResource = entry.resource;
+                    // update resource (the old one can't be borrowed anymore meanwhile)
                     Destroy(entry.resource, entry.lifearg);
-                    entry.resource = Create(entry.key, pConsumer, entry.lifearg);
+                    entry.resource = NULL;
+                    entry.lifearg  = NULL;
+                    entry.replaced = pOldResource;
+                    try {
+                        CreateResource(iter, pConsumer, false, bLock);
+                    } catch (...) {
+                        if (bLock) ResourceEntriesMutex.Lock();
+                        entry.replaced = NULL;
+                        RemoveIfUnused(iter); // all consumers might have left meanwhile
+                        if (bLock) ResourceEntriesMutex.Unlock();
+                        throw;
+                    }
+                    entry.replaced = NULL;
                     // inform all consumers about update completed
                     iterCons = entry.consumers.begin();
                     endCons  = entry.consumers.end();
@@ -322,6 +521,8 @@ class ResourceManager {
                         void* updatearg = (iterArg != updateargs.end()) ? iterArg->second : NULL;
                         (*iterCons)->ResourceUpdated(pOldResource, entry.resource, updatearg);
                     }
+                    // all consumers might have left meanwhile
+                    RemoveIfUnused(iter);
                     if (bLock) ResourceEntriesMutex.Unlock();
                     return;
                 }
@@ -329,6 +530,37 @@ class ResourceManager {
             if (bLock) ResourceEntriesMutex.Unlock();
         }
 
+        /**
+         * Replaces the resource of the entry given by \a Key by
+         * \a pNewResource, which the caller created by other means while
+         * the current resource still existed. Consumers are not informed
+         * about the replacement and the replaced resource is not
+         * destroyed, the caller has to take care of both.
+         *
+         * @param Key          - ID of the resource
+         * @param pNewResource - resource to be put in place
+         * @param pNewArg      - Create() argument of \a pNewResource
+         * @param pOldArg      - (output) Create() argument of the replaced
+         *                       resource
+         * @param bLock        - use thread safety mechanisms
+         * @returns the replaced resource or NULL if there is no created
+         *          resource with such a key
+         */
+        T_res* Replace(T_key Key, T_res* pNewResource, void* pNewArg, void*& pOldArg, bool bLock = true) {
+            if (bLock) ResourceEntriesMutex.Lock();
+            typename ResourceMap::iterator iterEntry = WaitForEntry(Key, bLock);
+            T_res* pOldResource = NULL;
+            if (iterEntry != ResourceEntries.end() && iterEntry->second.resource) {
+                resource_entry_t& entry = iterEntry->second;
+                pOldResource   = entry.resource;
+                pOldArg        = entry.lifearg;
+                entry.resource = pNewResource;
+                entry.lifearg  = pNewArg;
+            }
+            if (bLock) ResourceEntriesMutex.Unlock();
+            return pOldResource;
+        }
+
         /**
          * Returns the life-time strategy of the given resource.
          *
@@ -364,7 +596,7 @@ class ResourceManager {
 
             if (bLock) ResourceEntriesMutex.Lock();
             // search for an entry for this resource
-            typename ResourceMap::iterator iterEntry = ResourceEntries.find(Key);
+            typename ResourceMap::iterator iterEntry = WaitForEntry(Key, bLock);
             resource_entry_t* pEntry = NULL;
             if (iterEntry == ResourceEntries.end()) { // resource entry doesn't exist
                 if (Mode == ON_DEMAND) {
@@ -372,12 +604,17 @@ class ResourceManager {
                     return; // we don't create an entry for the default value
                 }
                 // create an entry for the resource
-                pEntry = &ResourceEntries[Key];
+                iterEntry = ResourceEntries.insert(std::make_pair(Key, resource_entry_t())).first;
+                pEntry = &iterEntry->second;
                 pEntry->key      = Key;
                 pEntry->resource = NULL;
                 pEntry->mode     = Mode;
                 pEntry->lifearg  = NULL;
                 pEntry->entryarg = NULL;
+                pEntry->lastuse  = ResourceUseTick();
+                pEntry->creating = false;
+                pEntry->prefetched = false;
+                pEntry->replaced = NULL;
             } else { // resource entry exists
                 pEntry = &iterEntry->second;
                 // remove entry if necessary
@@ -394,20 +631,150 @@ class ResourceManager {
                 pEntry->mode = Mode; // apply new mode
             }
 
-            // already create the resource if necessary
-            if (pEntry->mode == PERSISTENT && !pEntry->resource) {
-                try {
-                    // actually create the resource
-                    pEntry->resource = Create(Key, NULL /*no consumer yet*/, pEntry->lifearg);
-                } catch (...) {
-                    // creating the resource failed, so skip it for now
-                    pEntry->resource = NULL;
+            // already create the resource if necessary (on failure the
+            // exception is passed on, the resource is skipped for now)
+            if (pEntry->mode == PERSISTENT && !pEntry->resource)
+                CreateResource(iterEntry, NULL /*no consumer yet*/, false, bLock);
+            if (bLock) ResourceEntriesMutex.Unlock();
+        }
+
+        /**
+         * Creates the resource given by \a Key in advance, without any
+         * consumer, because it is likely to be borrowed soon. If the
+         * resource has the default life-time strategy ON_DEMAND, it is kept
+         * like an ON_DEMAND_HOLD resource until it is borrowed for the
+         * first time (from then on it is destroyed as usual once not needed
+         * anymore) or until it is destroyed by Evict(). Does nothing if the
+         * resource is already created.
+         *
+         * @param Key   - ID of resource
+         * @param bLock - use thread safety mechanisms
+         * @returns true if the resource was created by this call
+         * @throws Exception if the resource could not be created
+         */
+        bool Prefetch(T_key Key, bool bLock = true) {
+            if (bLock) ResourceEntriesMutex.Lock();
+            typename ResourceMap::iterator iterEntry = WaitForEntry(Key, bLock);
+            if (iterEntry != ResourceEntries.end() && iterEntry->second.resource) {
+                if (bLock) ResourceEntriesMutex.Unlock();
+                return false; // already created
+            }
+            bool bNewEntry = false;
+            if (iterEntry == ResourceEntries.end()) {
+                resource_entry_t entry;
+                entry.key      = Key;
+                entry.resource = NULL;
+                entry.mode     = ON_DEMAND; // default mode
+                entry.lifearg  = NULL;
+                entry.entryarg = NULL;
+                entry.lastuse  = ResourceUseTick();
+                entry.creating = false;
+                entry.prefetched = false;
+                entry.replaced = NULL;
+                iterEntry = ResourceEntries.insert(std::make_pair(Key, entry)).first;
+                bNewEntry = true;
+            }
+            // mark it before creating, so that neither a HandBack() nor a
+            // SetCustomData() call meanwhile removes the entry
+            iterEntry->second.prefetched = (iterEntry->second.mode == ON_DEMAND);
+            try {
+                CreateResource(iterEntry, NULL /*no consumer yet*/, bNewEntry, bLock);
+            } catch (...) {
+                if (!bNewEntry) { // entry was kept, it's not prefetched though
+                    if (bLock) ResourceEntriesMutex.Lock();
+                    iterEntry->second.prefetched = false;
                     if (bLock) ResourceEntriesMutex.Unlock();
-                    // rethrow the same exception
-                    throw;
+                }
+                throw;
+            }
+            iterEntry->second.lastuse = ResourceUseTick();
+            if (bLock) ResourceEntriesMutex.Unlock();
+            return true;
+        }
+
+        /**
+         * Destroys the resource given by \a Key if it was created by
+         * Prefetch() and has not been borrowed since, i.e. because the
+         * prediction that it would be needed soon turned out to be wrong.
+         *
+         * @param Key   - ID of resource
+         * @param bLock - use thread safety mechanisms
+         * @returns true if the resource was destroyed
+         */
+        bool DiscardPrefetched(T_key Key, bool bLock = true) {
+            if (bLock) ResourceEntriesMutex.Lock();
+            typename ResourceMap::iterator iterEntry = ResourceEntries.find(Key);
+            const bool bDiscard = iterEntry != ResourceEntries.end() &&
+                                  iterEntry->second.prefetched &&
+                                  IsEvictable(iterEntry->second);
+            if (bDiscard) Evict(Key, false);
+            if (bLock) ResourceEntriesMutex.Unlock();
+            return bDiscard;
+        }
+
+        /**
+         * Searches the least recently used resource which is currently
+         * created, is not used by any consumer and which has either a
+         * life-time strategy of ON_DEMAND_HOLD or was created by
+         * Prefetch(), that is a resource which could be destroyed by
+         * calling Evict() without affecting anybody.
+         *
+         * @param Key     - (output) ID of that resource
+         * @param LastUse - (output) ResourceUseTick() of the last time that
+         *                  resource was borrowed or handed back
+         * @param bLock   - use thread safety mechanisms
+         * @returns false if there is no such resource
+         */
+        bool LeastRecentlyUsedHeld(T_key& Key, uint64_t& LastUse, bool bLock = true) {
+            if (bLock) ResourceEntriesMutex.Lock();
+            bool found = false;
+            typename ResourceMap::iterator iter = ResourceEntries.begin();
+            typename ResourceMap::iterator end  = ResourceEntries.end();
+            for (; iter != end; ++iter) {
+                const resource_entry_t& entry = iter->second;
+                if (!IsEvictable(entry)) continue;
+                if (!found || entry.lastuse < LastUse) {
+                    Key     = entry.key;
+                    LastUse = entry.lastuse;
+                    found   = true;
                 }
             }
             if (bLock) ResourceEntriesMutex.Unlock();
+            return found;
+        }
+
+        /**
+         * Destroys the resource given by \a Key if it has a life-time
+         * strategy of ON_DEMAND_HOLD (or was created by Prefetch()) and is
+         * currently not used by any consumer. The entry of an
+         * ON_DEMAND_HOLD resource (and thus its life-time strategy) is
+         * kept, so the resource will simply be created again the next time
+         * it is borrowed.
+         *
+         * @param Key   - ID of resource
+         * @param bLock - use thread safety mechanisms
+         * @returns true if the resource was destroyed
+         */
+        bool Evict(T_key Key, bool bLock = true) {
+            if (bLock) ResourceEntriesMutex.Lock();
+            typename ResourceMap::iterator iterEntry = ResourceEntries.find(Key);
+            if (iterEntry == ResourceEntries.end() || !IsEvictable(iterEntry->second)) {
+                if (bLock) ResourceEntriesMutex.Unlock();
+                return false;
+            }
+            resource_entry_t& entry = iterEntry->second;
+            T_res* resource = entry.resource;
+            void* arg       = entry.lifearg;
+            if (entry.mode == ON_DEMAND && !entry.entryarg) {
+                ResourceEntries.erase(iterEntry);
+            } else {
+                entry.resource   = NULL;
+                entry.lifearg    = NULL;
+                entry.prefetched = false;
+            }
+            Destroy(resource, arg);
+            if (bLock) ResourceEntriesMutex.Unlock();
+            return true;
         }
 
         /**
@@ -463,6 +830,10 @@ class ResourceManager {
                     pEntry->mode     = ON_DEMAND;
                     pEntry->lifearg  = NULL;
                     pEntry->entryarg = pData; // set custom data
+                    pEntry->lastuse  = ResourceUseTick();
+                    pEntry->creating = false;
+                    pEntry->prefetched = false;
+                pEntry->replaced = NULL;
                 } else { // entry exists, so just update its custom data
                     iterEntry->second.entryarg = pData;
                 }
@@ -473,7 +844,7 @@ class ResourceManager {
                 }
                 // entry exists, remove it if necessary
                 resource_entry_t* pEntry = &iterEntry->second;
-                if (pEntry->mode == ON_DEMAND && pEntry->consumers.empty()) {
+                if (pEntry->mode == ON_DEMAND && pEntry->consumers.empty() && !pEntry->creating && !pEntry->prefetched) {
                     ResourceEntries.erase(iterEntry);
                 } else iterEntry->second.entryarg = NULL;
             }
@@ -537,19 +908,46 @@ class ResourceManager {
          */
         virtual void Destroy(T_res* pResource, void* pArg) = 0;
 
+        /**
+         * May be implemented by the descendant to create the updated
+         * version of resource \a pOldResource on Update(), while
+         * \a pOldResource still exists and is still used by its consumers,
+         * i.e. to take over unchanged parts of it. \a pOldResource is
+         * destroyed with Destroy() once all consumers switched over to the
+         * new resource. Like Create(), this method is called without the
+         * lock of this class being held.
+         *
+         * The default implementation returns NULL, in which case Update()
+         * informs the consumers, destroys \a pOldResource and calls
+         * Create() instead.
+         *
+         * @param Key          - identifier of the resource
+         * @param pConsumer    - consumer who requested the update
+         * @param pOldResource - resource to be updated
+         * @param pOldArg      - Create() argument of \a pOldResource
+         * @param pArg         - like the argument of Create()
+         * @returns pointer to new resource or NULL if the resource can't
+         *          be recreated side by side
+         */
+        virtual T_res* Recreate(T_key Key, ResourceConsumer<T_res>* pConsumer, T_res* pOldResource, void* pOldArg, void*& pArg) {
+            return NULL;
+        }
+
         /**
          * Has to be implemented by the descendant to react when a consumer
          * borrows a resource (no matter if freshly created or an already
          * created one). Of course reacting is optional, but the descendant
-         * at least has to provide a method with empty body.
+         * at least has to provide a method with empty body. If Borrow() was
+         * called with bLock = true, this method is called after the lock of
+         * this class was released again, so the descendant may i.e. call
+         * Update() from here.
          *
          * @param pResource - pointer to the resource
          * @param pConsumer - identifier of the consumer who borrows the
          *                    resource
          * @param pArg      - pointer the descendant might have used when
          *                    Create() was called to store informations
-         *                    about the resource, this information can be
-         *                    updated by the descendant here
+         *                    about the resource
          */
         virtual void OnBorrow(T_res* pResource, ResourceConsumer<T_res>* pConsumer, void*& pArg) = 0;
 
@@ -565,7 +963,8 @@ class ResourceManager {
          *                    process as value between 0.0 and 1.0
          */
         void DispatchResourceProgressEvent(T_key Key, float fProgress) {
-            // no Mutex here, since Create() is already protected
+            // Create() is called with the mutex unlocked
+            LockGuard lock(ResourceEntriesMutex);
             typename ResourceMap::iterator iterEntry = ResourceEntries.find(Key);
             if (iterEntry != ResourceEntries.end()) {
                 resource_entry_t& entry = iterEntry->second;
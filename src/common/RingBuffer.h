@@ -68,10 +68,40 @@ class RingBuffer
 {
 public:
     RingBuffer (int sz, int wrap_elements = DEFAULT_WRAP_ELEMENTS) :
-        write_ptr(0), read_ptr(0)
+        write_ptr(0), read_ptr(0), owns_buf(true)
     {
         _allocBuffer(sz, wrap_elements);
     }
+
+    /**
+     * Creates a RingBuffer which uses the memory given by @a storage
+     * instead of allocating its own. The memory must be large enough for
+     * storage_size(sz, wrap_elements) elements, remains owned by the caller
+     * and must stay valid for the whole life time of this RingBuffer.
+     *
+     * @param storage - memory to be used by this RingBuffer
+     * @param sz - size (amount of elements)
+     * @param wrap_elements - amount of wrap elements beyond buffer end
+     */
+    RingBuffer (T* storage, int sz, int wrap_elements) :
+        write_ptr(0), read_ptr(0), owns_buf(false)
+    {
+        _calcSize(sz, wrap_elements);
+        buf = storage;
+    }
+
+    /**
+     * Returns the amount of elements a RingBuffer with the given size
+     * and amount of wrap elements actually occupies in memory.
+     */
+    static int storage_size(int sz, int wrap_elements) {
+        sz += wrap_elements;
+        int power_of_two;
+        for (power_of_two = 1;
+             1<<power_of_two < sz;
+             power_of_two++);
+        return (1<<power_of_two) + wrap_elements;
+    }
     
     /**
      * Resize this ring buffer to the given size. This operation
@@ -89,13 +119,14 @@ public:
         if (wrap_elements == -1)
             wrap_elements = this->wrap_elements;
         
-        delete [] buf;
+        if (owns_buf) delete [] buf;
+        owns_buf = true;
         
         _allocBuffer(sz, wrap_elements);
     }
 
     virtual ~RingBuffer() {
-            delete [] buf;
+            if (owns_buf) delete [] buf;
     }
 
     /**
@@ -442,6 +473,7 @@ public:
     atomic<int> write_ptr;
     atomic<int> read_ptr;
     int size_mask;
+    bool owns_buf; ///< Whether @c buf was allocated by this RingBuffer (and hence must be freed by it).
 
     /**
      * Copies \a n amount of elements from the buffer given by
@@ -449,21 +481,18 @@ public:
      */
     inline static void copy(T* pDst, T* pSrc, int n);
     
-    void _allocBuffer(int sz, int wrap_elements) {
+    void _calcSize(int sz, int wrap_elements) {
         this->wrap_elements = wrap_elements;
             
         // the write-with-wrap functions need wrap_elements extra
         // space in the buffer to be able to copy the wrap space
-        sz += wrap_elements;
-
-        int power_of_two;
-        for (power_of_two = 1;
-             1<<power_of_two < sz;
-             power_of_two++);
-
-        size = 1<<power_of_two;
+        size = storage_size(sz, wrap_elements) - wrap_elements;
         size_mask = size;
         size_mask -= 1;
+    }
+
+    void _allocBuffer(int sz, int wrap_elements) {
+        _calcSize(sz, wrap_elements);
         buf = new T[size + wrap_elements];   
     }
 
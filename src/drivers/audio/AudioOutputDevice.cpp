@@ -25,6 +25,7 @@
 #include "AudioOutputDevice.h"
 #include "../../common/global_private.h"
 #include "../../common/IDGenerator.h"
+#include "../../common/NUMA.h"
 
 namespace LinuxSampler {
 
@@ -178,12 +179,85 @@ namespace LinuxSampler {
 
 
 
+// *************** ParameterNumaNode ***************
+// *
+
+    AudioOutputDevice::ParameterNumaNode::ParameterNumaNode() : DeviceCreationParameterInt() {
+        InitWithDefault();
+    }
+
+    AudioOutputDevice::ParameterNumaNode::ParameterNumaNode(String s) : DeviceCreationParameterInt(s) {
+    }
+
+    String AudioOutputDevice::ParameterNumaNode::Description() {
+        return "NUMA node of audio thread, voices and sample data (-1: automatic)";
+    }
+
+    bool AudioOutputDevice::ParameterNumaNode::Fix() {
+        return false;
+    }
+
+    bool AudioOutputDevice::ParameterNumaNode::Mandatory() {
+        return false;
+    }
+
+    std::map<String,DeviceCreationParameter*> AudioOutputDevice::ParameterNumaNode::DependsAsParameters() {
+        return std::map<String,DeviceCreationParameter*>();
+    }
+
+    optional<int> AudioOutputDevice::ParameterNumaNode::DefaultAsInt(std::map<String,String> Parameters) {
+        return -1;
+    }
+
+    optional<int> AudioOutputDevice::ParameterNumaNode::RangeMinAsInt(std::map<String,String> Parameters) {
+        return -1;
+    }
+
+    optional<int> AudioOutputDevice::ParameterNumaNode::RangeMaxAsInt(std::map<String,String> Parameters) {
+        #if CONFIG_NUMA
+        return NUMA::NodeCount() - 1;
+        #else
+        return 0;
+        #endif
+    }
+
+    std::vector<int> AudioOutputDevice::ParameterNumaNode::PossibilitiesAsInt(std::map<String,String> Parameters) {
+        return std::vector<int>();
+    }
+
+    int AudioOutputDevice::ParameterNumaNode::ValueAsInt() {
+        // report the node actually chosen, not -1
+        return (pDevice) ? ((AudioOutputDevice*)pDevice)->NumaNode()
+                         : DeviceCreationParameterInt::ValueAsInt();
+    }
+
+    void AudioOutputDevice::ParameterNumaNode::OnSetValue(int i) throw (Exception) {
+        ((AudioOutputDevice*)pDevice)->SetNumaNode(i);
+    }
+
+    String AudioOutputDevice::ParameterNumaNode::Name() {
+        return "NUMA_NODE";
+    }
+
+
+
 // *************** AudioOutputDevice ***************
 // *
 
     AudioOutputDevice::AudioOutputDevice(std::map<String,DeviceCreationParameter*> DriverParameters)
-        : EnginesReader(Engines) {
+        : EnginesReader(Engines), iNumaNode(-1) {
         this->Parameters = DriverParameters;
+        #if CONFIG_NUMA
+        // only drivers offering the NUMA_NODE parameter are bound to a node,
+        // so i.e. plugin hosts stay in control of their audio threads
+        if (Parameters.count("NUMA_NODE") && NUMA::IsAvailable()) {
+            const int node = ((DeviceCreationParameterInt*)Parameters["NUMA_NODE"])->ValueAsInt();
+            if (node >= NUMA::NodeCount())
+                throw AudioOutputException("Invalid NUMA node " + ToString(node));
+            iNumaNode = (node < 0) ? LeastUsedNumaNode() : node;
+            dmsg(1,("AudioOutputDevice: placed on NUMA node %d%s\n", int(iNumaNode), (node < 0) ? " (automatic)" : ""));
+        }
+        #endif
         EffectChainIDs = new IDGenerator();
     }
 
@@ -281,6 +355,60 @@ namespace LinuxSampler {
         return Parameters;
     }
 
+    int AudioOutputDevice::NumaNode() const {
+        return iNumaNode.load(memory_order_relaxed);
+    }
+
+    void AudioOutputDevice::SetNumaNode(int Node) throw (Exception) {
+        #if CONFIG_NUMA
+        if (!Parameters.count("NUMA_NODE") || !NUMA::IsAvailable()) return;
+        if (Node >= NUMA::NodeCount())
+            throw Exception("Invalid NUMA node " + ToString(Node));
+        const bool bAutomatic = (Node < 0);
+        if (bAutomatic) Node = LeastUsedNumaNode();
+        if (Node == NumaNode()) return;
+        // the audio thread binds itself to the node when being started
+        const bool bPlaying = IsPlaying();
+        if (bPlaying) Stop();
+        iNumaNode.store(Node, memory_order_relaxed);
+        dmsg(1,("AudioOutputDevice: moved to NUMA node %d%s\n", Node, bAutomatic ? " (automatic)" : ""));
+        // the engines move their voices, disk threads and instruments when
+        // being connected
+        ReconnectAll();
+        if (bPlaying) Play();
+        #endif
+    }
+
+    /**
+     * Returns the NUMA node with the least other audio output devices
+     * assigned to it, so the audio threads of several devices are spread
+     * over all nodes.
+     */
+    int AudioOutputDevice::LeastUsedNumaNode() {
+        #if CONFIG_NUMA
+        std::vector<int> devices(NUMA::NodeCount(), 0);
+        std::map<uint, AudioOutputDevice*> all = AudioOutputDeviceFactory::Devices();
+        for (std::map<uint, AudioOutputDevice*>::iterator it = all.begin(); it != all.end(); ++it) {
+            if (!it->second || it->second == this) continue;
+            const int node = it->second->NumaNode();
+            if (node >= 0 && node < int(devices.size())) devices[node]++;
+        }
+        int best = 0;
+        for (int node = 1; node < int(devices.size()); ++node)
+            if (devices[node] < devices[best]) best = node;
+        return best;
+        #else
+        return -1;
+        #endif
+    }
+
+    void AudioOutputDevice::BindAudioThread() {
+        #if CONFIG_NUMA
+        const int node = NumaNode();
+        if (node >= 0) NUMA::BindThread(node);
+        #endif
+    }
+
     EffectChain* AudioOutputDevice::AddSendEffectChain() {
         EffectChain* pChain = new EffectChain(this, EffectChainIDs->create());
         vEffectChains.push_back(pChain);
@@ -31,6 +31,7 @@
 
 #include "../../common/global.h"
 #include "../../common/Exception.h"
+#include "../../common/lsatomic.h"
 #include "../Device.h"
 #include "../DeviceParameter.h"
 #include "../../engines/Engine.h"
@@ -116,6 +117,31 @@ namespace LinuxSampler {
                     static String Name();
             };
 
+            /** Device Parameter 'NUMA_NODE'
+             *
+             * NUMA node the audio thread of the device, the voices and disk
+             * threads of its engines and the cached sample data of the
+             * instruments loaded on its sampler channels are placed on. By
+             * default (-1) the node with the least audio output devices is
+             * chosen. Only has an effect on systems with several NUMA nodes.
+             */
+            class ParameterNumaNode : public DeviceCreationParameterInt {
+                public:
+                    ParameterNumaNode();
+                    ParameterNumaNode(String s);
+                    virtual String Description() OVERRIDE;
+                    virtual bool   Fix() OVERRIDE;
+                    virtual bool   Mandatory() OVERRIDE;
+                    virtual std::map<String,DeviceCreationParameter*> DependsAsParameters() OVERRIDE;
+                    virtual optional<int>    DefaultAsInt(std::map<String,String> Parameters) OVERRIDE;
+                    virtual optional<int>    RangeMinAsInt(std::map<String,String> Parameters) OVERRIDE;
+                    virtual optional<int>    RangeMaxAsInt(std::map<String,String> Parameters) OVERRIDE;
+                    virtual std::vector<int> PossibilitiesAsInt(std::map<String,String> Parameters) OVERRIDE;
+                    virtual int              ValueAsInt() OVERRIDE;
+                    virtual void             OnSetValue(int i) throw (Exception) OVERRIDE;
+                    static String Name();
+            };
+
 
 
             /////////////////////////////////////////////////////////////////
@@ -275,6 +301,26 @@ namespace LinuxSampler {
              */
             std::map<String,DeviceCreationParameter*> DeviceParameters();
 
+            /**
+             * Returns the NUMA node this audio output device is assigned
+             * to, or -1 if it is not bound to any node (i.e. because the
+             * system only has one node, or because the driver does not
+             * offer the 'NUMA_NODE' parameter).
+             */
+            int NumaNode() const;
+
+            /**
+             * Assigns this audio output device to NUMA node @a Node, or to
+             * the node with the least audio output devices if -1. A playing
+             * device is stopped and restarted, so its audio thread binds
+             * itself to the new node, and the connected engines are
+             * reconnected to move their voices, disk threads and the sample
+             * data of their instruments over as well.
+             *
+             * @throws Exception - if @a Node is not a valid NUMA node
+             */
+            void SetNumaNode(int Node) throw (Exception);
+
             /**
              * Add a chain of send effects to this AudioOutputDevice.
              * You actually have to add effects to that chain afterwards.
@@ -363,8 +409,22 @@ namespace LinuxSampler {
              */
             int RenderSilence(uint Samples);
 
+            /**
+             * Should be called once at the start of the audio thread by
+             * AudioOutputDevice descendants which own their audio thread
+             * and offer the 'NUMA_NODE' parameter, to bind the thread to
+             * the device's NUMA node. Drivers whose audio thread is owned
+             * by somebody else (i.e. the JACK server or a plugin host) must
+             * neither call this method nor offer that parameter.
+             */
+            void BindAudioThread();
+
             friend class AudioOutputDeviceFactory; // allow AudioOutputDeviceFactory class to destroy audio devices
 
+        private:
+            atomic<int> iNumaNode; ///< NUMA node the device is assigned to, or -1.
+
+            int LeastUsedNumaNode();
     };
 
     /**
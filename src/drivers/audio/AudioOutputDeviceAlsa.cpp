@@ -748,6 +748,8 @@ namespace LinuxSampler {
         Thread::setNameOfCaller("AlsaAudio");
         #endif
 
+        BindAudioThread();
+
         while (true) {
             TestCancel();
 
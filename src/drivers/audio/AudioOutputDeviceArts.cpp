@@ -174,6 +174,8 @@ namespace LinuxSampler {
         Thread::setNameOfCaller("ArtsAudio");
         #endif
 
+        BindAudioThread();
+
         while (true) {
             TestCancel();
 
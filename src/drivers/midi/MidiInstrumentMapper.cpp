@@ -20,6 +20,8 @@
 
 #include "MidiInstrumentMapper.h"
 
+#include <algorithm>
+
 #include "../../common/global_private.h"
 #include "../../common/Mutex.h"
 #include "../../engines/EngineFactory.h"
@@ -46,6 +48,7 @@ namespace LinuxSampler {
     class MidiInstrumentMap : public std::map<midi_prog_index_t,private_entry_t> {
         public:
             String name;
+            std::vector<midi_prog_index_t> setlist;
     };
 
     // here we store all maps
@@ -59,6 +62,7 @@ namespace LinuxSampler {
     ListenerList<MidiInstrumentMapCountListener*> MidiInstrumentMapper::llMidiInstrumentMapCountListeners;
     ListenerList<MidiInstrumentMapInfoListener*> MidiInstrumentMapper::llMidiInstrumentMapInfoListeners;
     int MidiInstrumentMapper::DefaultMap;
+    int MidiInstrumentMapper::PrefetchCount = CONFIG_PROGRAM_PREFETCH;
     
     void MidiInstrumentMapper::AddMidiInstrumentCountListener(MidiInstrumentCountListener* l) {
         llMidiInstrumentCountListeners.AddListener(l);
@@ -464,4 +468,101 @@ namespace LinuxSampler {
         return result;
     }
 
+    void MidiInstrumentMapper::SetSetlist(int Map, const std::vector<midi_prog_index_t>& Setlist) throw (Exception) {
+        {
+            LockGuard lock(midiMapsMutex);
+            std::map<int,MidiInstrumentMap>::iterator iterMap = midiMaps.find(Map);
+            if (iterMap == midiMaps.end()) {
+                throw Exception("There is no MIDI instrument map " + ToString(Map));
+            }
+            iterMap->second.setlist = Setlist;
+        }
+        fireMidiInstrumentMapInfoChanged(Map);
+    }
+
+    std::vector<midi_prog_index_t> MidiInstrumentMapper::GetSetlist(int Map) throw (Exception) {
+        LockGuard lock(midiMapsMutex);
+        std::map<int,MidiInstrumentMap>::iterator iterMap = midiMaps.find(Map);
+        if (iterMap == midiMaps.end()) {
+            throw Exception("There is no MIDI instrument map " + ToString(Map));
+        }
+        return iterMap->second.setlist;
+    }
+
+    void MidiInstrumentMapper::SetPrefetchCount(int Entries) {
+        LockGuard lock(midiMapsMutex);
+        PrefetchCount = (Entries > 0) ? Entries : 0;
+    }
+
+    int MidiInstrumentMapper::GetPrefetchCount() {
+        LockGuard lock(midiMapsMutex);
+        return PrefetchCount;
+    }
+
+    static MidiInstrumentMapper::entry_t prefetchEntry(const private_entry_t& e) {
+        MidiInstrumentMapper::entry_t entry;
+        entry.EngineName      = e.EngineName;
+        entry.InstrumentFile  = e.InstrumentFile;
+        entry.InstrumentIndex = e.InstrumentIndex;
+        entry.LoadMode        = MidiInstrumentMapper::DONTCARE;
+        entry.Volume          = e.Volume;
+        entry.Name            = e.Name;
+        return entry;
+    }
+
+    static bool sameInstrument(const private_entry_t& a, const private_entry_t& b) {
+        return a.InstrumentIndex == b.InstrumentIndex && a.InstrumentFile == b.InstrumentFile;
+    }
+
+    /**
+     * Returns the entries whose instruments should be loaded in advance after
+     * the entry at \a Index was selected by a MIDI program change: the
+     * PrefetchCount neighbouring entries before and after it (nearest ones
+     * first) followed by the next PrefetchCount entries of the map's setlist
+     * (the ones following the selected entry if it is part of the setlist,
+     * the first ones otherwise). Entries referring to the same instrument as
+     * the selected entry or an earlier result are left out.
+     */
+    std::vector<MidiInstrumentMapper::entry_t> MidiInstrumentMapper::PrefetchEntries(int Map, midi_prog_index_t Index) {
+        std::vector<entry_t> result;
+        std::vector<const private_entry_t*> picked;
+        LockGuard lock(midiMapsMutex);
+
+        std::map<int,MidiInstrumentMap>::iterator iterMap = midiMaps.find(Map);
+        if (iterMap == midiMaps.end()) return result;
+        MidiInstrumentMap& map = iterMap->second;
+        MidiInstrumentMap::iterator iterEntry = map.find(Index);
+        if (iterEntry == map.end()) return result;
+        picked.push_back(&iterEntry->second);
+
+        std::vector<const private_entry_t*> candidates;
+        MidiInstrumentMap::iterator next = iterEntry;
+        MidiInstrumentMap::iterator prev = iterEntry;
+        for (int i = 0; i < PrefetchCount; i++) {
+            if (next != map.end() && ++next != map.end())
+                candidates.push_back(&next->second);
+            if (prev != map.begin())
+                candidates.push_back(&(--prev)->second);
+        }
+        std::vector<midi_prog_index_t>::iterator position =
+            std::find(map.setlist.begin(), map.setlist.end(), Index);
+        position = (position == map.setlist.end()) ? map.setlist.begin() : position + 1;
+        for (int i = 0; i < PrefetchCount && position != map.setlist.end(); ++position) {
+            MidiInstrumentMap::iterator it = map.find(*position);
+            if (it == map.end()) continue;
+            candidates.push_back(&it->second);
+            i++;
+        }
+
+        for (size_t i = 0; i < candidates.size(); i++) {
+            bool bDuplicate = false;
+            for (size_t k = 0; k < picked.size() && !bDuplicate; k++)
+                bDuplicate = sameInstrument(*candidates[i], *picked[k]);
+            if (bDuplicate) continue;
+            picked.push_back(candidates[i]);
+            result.push_back(prefetchEntry(*candidates[i]));
+        }
+        return result;
+    }
+
 } // namespace LinuxSampler
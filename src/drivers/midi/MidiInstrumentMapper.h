@@ -255,6 +255,57 @@ namespace LinuxSampler {
 	     */
 	    static void SetDefaultMap(int MapId);
 
+            /**
+             * Assigns a setlist to the given map, that is the entries
+             * which are likely to be selected by MIDI program changes
+             * during a performance (e.g. the sounds of the next songs).
+             * Whenever a program change selected an entry of the map, the
+             * instruments of the next setlist entries after that one are
+             * loaded in advance (as many as set by SetPrefetchCount()). The
+             * setlist may refer to entries which do not exist (yet), those
+             * are simply ignored.
+             *
+             * @param Map - map index
+             * @param Setlist - indices of the setlist entries, in the order
+             *                  they are going to be used (empty for none)
+             * @throws Exception - if the given map does not exist
+             */
+            static void SetSetlist(int Map, const std::vector<midi_prog_index_t>& Setlist) throw (Exception);
+
+            /**
+             * Returns the setlist assigned to the given map by
+             * SetSetlist().
+             *
+             * @param Map - map index
+             * @throws Exception - if the given map does not exist
+             */
+            static std::vector<midi_prog_index_t> GetSetlist(int Map) throw (Exception);
+
+            /**
+             * Sets how many neighbouring entries (in order of MIDI bank and
+             * program) before and after the entry selected by a MIDI
+             * program change shall be loaded in advance, so that switching
+             * to them later on is instant. Those instruments are loaded in
+             * the background with low priority and only as long as the
+             * instrument memory budget (see
+             * InstrumentManager::SetMemoryBudget()) is not exhausted.
+             * The same amount of the following setlist entries (see
+             * SetSetlist()) is loaded in advance as well. Prefetched
+             * instruments are freed again once the next program change of
+             * the same channel did not select them, or first when the
+             * memory budget is exceeded.
+             *
+             * @param Entries - amount of entries on each side, 0 disables
+             *                  prefetching
+             */
+            static void SetPrefetchCount(int Entries);
+
+            /**
+             * Returns the amount of neighbouring entries loaded in advance
+             * as set by SetPrefetchCount().
+             */
+            static int GetPrefetchCount();
+
         protected:
             /**
              * Notifies listeners that the number of MIDI instruments
@@ -285,6 +336,7 @@ namespace LinuxSampler {
             static void fireMidiInstrumentMapInfoChanged(int MapId);
 
             static optional<entry_t> GetEntry(int Map, midi_prog_index_t Index); // shall only be used by EngineChannel ATM (see source comment)
+            static std::vector<entry_t> PrefetchEntries(int Map, midi_prog_index_t Index); // shall only be used by EngineChannel ATM (see source comment)
             friend class EngineChannel; // allow EngineChannel to access GetEntry()
             friend class AbstractEngineChannel; // allow AbstractEngineChannel to access GetEntry()
 
@@ -302,6 +354,7 @@ namespace LinuxSampler {
             static ListenerList<MidiInstrumentMapInfoListener*> llMidiInstrumentMapInfoListeners;
             
             static int DefaultMap;
+            static int PrefetchCount;
     };
 
 } // namespace LinuxSampler
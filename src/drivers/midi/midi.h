@@ -63,6 +63,10 @@ namespace LinuxSampler {
         bool operator< (const midi_prog_index_t& other) const {
             return memcmp(this, &other, sizeof(midi_prog_index_t)) < 0;
         }
+
+        bool operator== (const midi_prog_index_t& other) const {
+            return memcmp(this, &other, sizeof(midi_prog_index_t)) == 0;
+        }
     };
 
     inline bool isValidMidiChan(const midi_chan_t& ch) {
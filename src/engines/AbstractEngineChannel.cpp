@@ -214,6 +214,25 @@ namespace LinuxSampler {
         return GetAudioOutputDevice();
     }
 
+    /**
+     * Moves the cached sample data of the instrument currently loaded on
+     * this engine channel to the NUMA node of the channel's audio output
+     * device, if the device was assigned to a node. Samples shared with
+     * instruments of channels on other devices end up on the node of the
+     * channel which moved them last.
+     */
+    void AbstractEngineChannel::MoveInstrumentToNumaNode() {
+        AudioOutputDevice* pDevice = GetAudioOutputDeviceSafe();
+        if (!pDevice || pDevice->NumaNode() < 0 || InstrumentFile.empty()) return;
+        InstrumentManager::instrument_id_t id;
+        id.FileName = InstrumentFile;
+        id.Index    = InstrumentIdx;
+        const uint64_t bytes = pEngine->GetInstrumentManager()->MoveToNumaNode(id, pDevice->NumaNode());
+        if (bytes)
+            dmsg(1,("EngineChannel: %llu kB of sample data of '%s' (%d) placed on NUMA node %d\n",
+                    (unsigned long long) bytes / 1024, InstrumentFile.c_str(), InstrumentIdx, pDevice->NumaNode()));
+    }
+
     void AbstractEngineChannel::SetOutputChannel(uint EngineAudioChannel, uint AudioDeviceChannel) {
         if (!pEngine || !pEngine->pAudioOutputDevice) throw AudioOutputException("No audio output device connected yet.");
 
@@ -1284,6 +1303,20 @@ namespace LinuxSampler {
             //TODO: we should switch the engine type here
             InstrumentManager::LoadInstrumentInBackground(id, this);
             Volume(mapping->Volume);
+            // load the instruments likely to be selected next in advance
+            InstrumentManager* pManager = GetEngine()->GetInstrumentManager();
+            if (pManager) {
+                std::vector<InstrumentManager::instrument_id_t> ids;
+                std::vector<MidiInstrumentMapper::entry_t> entries =
+                    MidiInstrumentMapper::PrefetchEntries(midiMap, midiIndex);
+                for (size_t i = 0; i < entries.size(); i++) {
+                    // (the engine type is not switched above, so stick to this engine's instruments)
+                    if (entries[i].EngineName != GetEngine()->EngineName()) continue;
+                    InstrumentManager::instrument_id_t pid = { entries[i].InstrumentFile, entries[i].InstrumentIndex };
+                    ids.push_back(pid);
+                }
+                pManager->PrefetchInstrumentsInBackground(ids, this);
+            }
         } else {
             dmsg(1, ("\nNo instrument mapping found on channel #%d, midi map #%d", static_cast<int>(iEngineIndexSelf), midiMap));
         }
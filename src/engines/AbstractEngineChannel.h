@@ -120,6 +120,7 @@ namespace LinuxSampler {
             virtual void UnloadInstrument() = 0;
 
             AudioOutputDevice* GetAudioOutputDeviceSafe();
+            void MoveInstrumentToNumaNode();
 
             script_callback_id_t GetScriptCallbackID(const ScriptEvent* e) const {
                 return pScript->pEvents->getID(e);
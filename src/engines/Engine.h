@@ -32,6 +32,28 @@ namespace LinuxSampler {
     // just symbol prototyping
     class MidiInputPort;
 
+    /** @brief Disk streaming statistics of a sampler engine.
+     *
+     * All counters are accumulated since the engine's disk thread was
+     * created, so clients interested in a certain period of time have to
+     * calculate the difference between two snapshots.
+     */
+    struct disk_stream_statistics_t {
+        enum {
+            READ_LATENCY_BUCKETS = 16, ///< Amount of buckets of the read latency histogram.
+            MIN_FILL_BUCKETS     = 10  ///< Amount of buckets of the minimum buffer fill histogram.
+        };
+        uint64_t Reads;           ///< Amount of stream refills performed so far.
+        uint64_t BytesRead;       ///< Amount of bytes read by all stream refills so far.
+        uint     BytesPerSecond;  ///< Amount of bytes read within the latest full second.
+        uint     MaxReadLatency;  ///< Longest duration of a single stream refill so far (in microseconds).
+        uint64_t ReadLatency[READ_LATENCY_BUCKETS]; ///< Histogram of stream refill durations: bucket i counts refills which took less than 64 << i microseconds (the last bucket counts all slower ones).
+        uint64_t MinFill[MIN_FILL_BUCKETS]; ///< Histogram of the lowest buffer fill each finished stream reached while its voice was reading from it: bucket i counts streams whose buffer fill dropped to [i * 10, i * 10 + 10) percent (the last bucket includes 100%).
+        uint64_t LateStreams;     ///< Amount of voices whose disk stream was not launched in time.
+        uint64_t Underruns;       ///< Amount of audio fragments voices rendered silence while waiting for their disk stream.
+        uint64_t KilledStreams;   ///< Amount of voices killed because their disk stream was not launched in time at all.
+    };
+
     /** @brief LinuxSampler Sampler Engine Interface
      *
      * Abstract base interface class for all LinuxSampler engines which
@@ -68,6 +90,7 @@ namespace LinuxSampler {
             virtual void   SetMaxDiskStreams(int iStreams) throw (Exception) = 0;
             virtual String DiskStreamBufferFillBytes() = 0;
             virtual String DiskStreamBufferFillPercentage() = 0;
+            virtual disk_stream_statistics_t DiskStreamStatistics() = 0;
             virtual String Description() = 0;
             virtual String Version() = 0;
             virtual String EngineName() = 0;
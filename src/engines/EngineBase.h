@@ -32,6 +32,7 @@
 #include "common/MidiKeyboardManager.h"
 #include "InstrumentManager.h"
 #include "../common/global_private.h"
+#include "../common/NUMA.h"
 
 // a bit headroom over CONFIG_MAX_VOICES to avoid minor complications i.e. under voice stealing conditions
 #define MAX_NOTES_HEADROOM  3
@@ -303,6 +304,10 @@ namespace LinuxSampler {
                 }
                 pNotePool->clear();
 
+                #if CONFIG_NUMA
+                MoveVoicesToNumaNode();
+                #endif
+
                 PostSetMaxVoices(iVoices);
                 ResumeAll();
             }
@@ -310,6 +315,21 @@ namespace LinuxSampler {
             /** Called after the new max number of voices is set and before resuming the engine. */
             virtual void PostSetMaxVoices(int iVoices) { }
 
+            #if CONFIG_NUMA
+            /**
+             * Moves the voices and notes of this engine to the NUMA node of
+             * its audio output device, if the device was assigned to a node.
+             */
+            void MoveVoicesToNumaNode() {
+                const int node = (pAudioOutputDevice) ? pAudioOutputDevice->NumaNode() : -1;
+                if (node < 0) return;
+                const size_t bytes =
+                    NUMA::MoveMemory(pVoicePool->data, pVoicePool->poolSize() * sizeof(V), node) +
+                    NUMA::MoveMemory(pNotePool->data, pNotePool->poolSize() * sizeof(Note<V>), node);
+                dmsg(1,("EngineBase: %lu kB of voices and notes placed on NUMA node %d\n", (unsigned long) bytes / 1024, node));
+            }
+            #endif
+
             virtual uint DiskStreamCount() OVERRIDE { return (pDiskThread) ? pDiskThread->GetActiveStreamCount() : 0; }
             virtual uint DiskStreamCountMax() OVERRIDE { return (pDiskThread) ? pDiskThread->ActiveStreamCountMax : 0; }
             virtual int  MaxDiskStreams() OVERRIDE { return iMaxDiskStreams; }
@@ -331,6 +351,9 @@ namespace LinuxSampler {
 
             virtual String DiskStreamBufferFillBytes() OVERRIDE { return (pDiskThread) ? pDiskThread->GetBufferFillBytes() : ""; }
             virtual String DiskStreamBufferFillPercentage() OVERRIDE { return (pDiskThread) ? pDiskThread->GetBufferFillPercentage() : ""; }
+            virtual disk_stream_statistics_t DiskStreamStatistics() OVERRIDE {
+                return (pDiskThread) ? pDiskThread->GetStatistics() : disk_stream_statistics_t();
+            }
             virtual InstrumentManager* GetInstrumentManager() OVERRIDE { return &instruments; }
 
             /**
@@ -402,6 +425,17 @@ namespace LinuxSampler {
                 // update event generator
                 pEventGenerator->SetSampleRate(pAudioOut->SampleRate());
 
+                #if CONFIG_NUMA
+                // place the voices, the disk thread and the instruments of
+                // all engine channels on the NUMA node of the audio device
+                if (pAudioOutputDevice->NumaNode() >= 0) {
+                    MoveVoicesToNumaNode();
+                    pDiskThread->SetNumaNode(pAudioOutputDevice->NumaNode());
+                    for (int i = 0; i < engineChannels.size(); i++)
+                        static_cast<EngineChannelBase<V, R, I>*>(engineChannels[i])->MoveInstrumentToNumaNode();
+                }
+                #endif
+
                 dmsg(1,("Starting disk thread..."));
                 pDiskThread->StartThread();
                 dmsg(1,("OK\n"));
@@ -2349,6 +2383,31 @@ namespace LinuxSampler {
                 }
             }
 
+            /**
+             * Called on note-on events for each release trigger region which
+             * will probably be triggered on the note's note-off. If the
+             * region's sample is too long for its RAM cache, the disk thread
+             * is asked to warm up the part of the sample a release voice will
+             * stream right after the RAM cache, so that the release voice's
+             * disk stream does not have to compete with all other disk
+             * streams at note-off (i.e. on fast passages with large release
+             * sample pianos). A new note-on on the same key supersedes the
+             * prefetch of the previous one, if it was not processed yet.
+             *
+             * @param pChannel - engine channel on which the note-on occurred on
+             * @param pRegion - (dimension) region of the expected release voice
+             * @param CachedFrames - size of the sample's RAM cache in sample points
+             * @param TotalFrames - total length of the sample in sample points
+             * @param iKey - MIDI key of the note-on
+             */
+            void PrefetchReleaseTriggerRegion(EngineChannelBase<V, R, I>* pChannel, R* pRegion, long CachedFrames, long TotalFrames, int iKey) {
+                if (!pDiskThread || CachedFrames >= TotalFrames) return; // RAM only sample
+                // same start position as calculated by AbstractVoice::Trigger()
+                const long maxFramesPerCycle = long(MaxSamplesPerCycle) << CONFIG_MAX_PITCH;
+                const unsigned long offset = (CachedFrames > maxFramesPerCycle) ? CachedFrames - maxFramesPerCycle : 0;
+                pDiskThread->OrderPrefetch(pRegion, offset, &pChannel->pMIDIKeyInfo[iKey]);
+            }
+
             /**
              * Called on "kill note" events, which currently only happens on
              * built-in real-time instrument script function fade_out(). This
@@ -25,6 +25,9 @@
 
 #include "InstrumentManagerThread.h"
 #include "../common/Mutex.h"
+#include "../common/global_private.h"
+
+#include <set>
 
 namespace LinuxSampler {
 
@@ -44,8 +47,134 @@ namespace LinuxSampler {
         thread.StartSettingMode(this, ID, Mode);
     }
 
+    void InstrumentManager::PrefetchInstrumentsInBackground(const std::vector<instrument_id_t>& IDs, EngineChannel* pEngineChannel) {
+        LockGuard lock(loaderMutex);
+        thread.StartPrefetching(this, IDs, pEngineChannel);
+    }
+
     void InstrumentManager::StopBackgroundThread() {
         thread.StopThread();
     }
 
+    // the instrument managers are static objects of the engines, so the
+    // following are created on first use, to be independent of the order
+    // of static initialization
+
+    // all instrument managers, which share the memory budget
+    static std::set<InstrumentManager*>& managers() {
+        static std::set<InstrumentManager*> s;
+        return s;
+    }
+
+    // protects the memory budget attributes and the set of managers
+    static Mutex& budgetMutex() {
+        static Mutex m;
+        return m;
+    }
+
+    // serializes EnforceMemoryBudget() calls
+    static Mutex& enforceMutex() {
+        static Mutex m;
+        return m;
+    }
+
+    static uint64_t memoryBudget = uint64_t(CONFIG_INSTRUMENT_MEMORY_BUDGET) * 1024 * 1024;
+    static uint     evictions    = 0;
+
+    InstrumentManager::InstrumentManager() {
+        LockGuard lock(budgetMutex());
+        managers().insert(this);
+    }
+
+    InstrumentManager::~InstrumentManager() {
+        LockGuard lock(budgetMutex());
+        managers().erase(this);
+    }
+
+    void InstrumentManager::SetMemoryBudget(uint64_t Bytes) {
+        {
+            LockGuard lock(budgetMutex());
+            memoryBudget = Bytes;
+        }
+        EnforceMemoryBudget();
+    }
+
+    uint64_t InstrumentManager::GetMemoryBudget() {
+        LockGuard lock(budgetMutex());
+        return memoryBudget;
+    }
+
+    uint InstrumentManager::GetEvictionCount() {
+        LockGuard lock(budgetMutex());
+        return evictions;
+    }
+
+    static std::vector<InstrumentManager*> allManagers() {
+        LockGuard lock(budgetMutex());
+        return std::vector<InstrumentManager*>(managers().begin(), managers().end());
+    }
+
+    static uint64_t memoryUsage(const std::vector<InstrumentManager*>& mgrs) {
+        uint64_t bytes = 0;
+        for (size_t i = 0; i < mgrs.size(); i++)
+            bytes += mgrs[i]->GetTotalMemoryUsage();
+        return bytes;
+    }
+
+    uint64_t InstrumentManager::GetGlobalMemoryUsage() {
+        return memoryUsage(allManagers());
+    }
+
+    int InstrumentManager::ReloadInstruments(const String& File) {
+        int count = 0;
+        std::vector<InstrumentManager*> mgrs = allManagers();
+        for (size_t i = 0; i < mgrs.size(); i++) {
+            std::vector<instrument_id_t> IDs = mgrs[i]->Instruments();
+            for (size_t j = 0; j < IDs.size(); j++)
+                if (IDs[j].FileName == File && mgrs[i]->ReloadInstrument(IDs[j]))
+                    count++;
+        }
+        if (count) EnforceMemoryBudget();
+        return count;
+    }
+
+    void InstrumentManager::EnforceMemoryBudget() {
+        const uint64_t budget = GetMemoryBudget();
+        if (!budget) return;
+
+        // the managers are only locked one at a time here, so this does not
+        // interfere with the locks held while loading instruments
+        LockGuard lock(enforceMutex());
+        std::vector<InstrumentManager*> mgrs = allManagers();
+        uint64_t usage = memoryUsage(mgrs);
+        while (usage > budget) {
+            InstrumentManager* pOldest = NULL;
+            instrument_id_t oldestID;
+            uint64_t oldestUse = 0;
+            for (size_t i = 0; i < mgrs.size(); i++) {
+                instrument_id_t id;
+                uint64_t lastUse;
+                if (!mgrs[i]->GetLeastRecentlyUsedHeldInstrument(id, lastUse)) continue;
+                if (!pOldest || lastUse < oldestUse) {
+                    pOldest   = mgrs[i];
+                    oldestID  = id;
+                    oldestUse = lastUse;
+                }
+            }
+            if (!pOldest) break; // nothing left that could be freed
+            dmsg(1,("InstrumentManager: memory budget exceeded, freeing instrument ('%s',%d)\n",
+                    oldestID.FileName.c_str(), oldestID.Index));
+            if (!pOldest->EvictInstrument(oldestID)) break;
+            {
+                LockGuard lock(budgetMutex());
+                evictions++;
+            }
+            usage = memoryUsage(mgrs);
+        }
+        if (usage > budget) {
+            dmsg(1,("InstrumentManager: memory budget exceeded by instruments in use (%lld of %lld bytes)\n",
+                    (long long)usage, (long long)budget));
+        }
+    }
+
 } // namespace LinuxSampler
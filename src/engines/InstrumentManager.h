@@ -89,7 +89,8 @@ namespace LinuxSampler {
                 uint8_t KeySwitchBindings[128];
             };
 
-            virtual ~InstrumentManager() {}
+            InstrumentManager();
+            virtual ~InstrumentManager();
 
             /**
              * Returns all managed instruments.
@@ -131,6 +132,71 @@ namespace LinuxSampler {
              */
             static void LoadInstrumentInBackground(instrument_id_t ID, EngineChannel* pEngineChannel);
 
+            /**
+             * Loads the given instruments in advance in a separate thread,
+             * without assigning them to any engine channel, because they are
+             * likely to be loaded on @a pEngineChannel soon. The instruments
+             * are loaded one by one in the given order, only while no other
+             * background task is waiting and only as long as the memory
+             * budget is not exhausted. Instruments which are still waiting
+             * from a previous call for the same engine channel are dropped.
+             *
+             * @param IDs - instruments to be loaded, most likely used first
+             * @param pEngineChannel - engine channel the instruments are
+             *                         expected to be loaded on
+             */
+            void PrefetchInstrumentsInBackground(const std::vector<instrument_id_t>& IDs, EngineChannel* pEngineChannel);
+
+            /**
+             * Loads the given instrument in advance, without assigning it to
+             * any engine channel. An instrument with life-time strategy
+             * @c ON_DEMAND loaded this way is kept like an @c ON_DEMAND_HOLD
+             * instrument until it is used for the first time, so it is
+             * freed first when the memory budget is exceeded. Does nothing
+             * if the memory budget is already exhausted.
+             *
+             * This method has to be implemented by the descendant.
+             *
+             * @returns true if the instrument was loaded by this call
+             */
+            virtual bool PrefetchInstrument(const instrument_id_t& ID) = 0;
+
+            /**
+             * Frees the given instrument again if it was loaded by
+             * PrefetchInstrument() and has not been used since, because it
+             * is not expected to be needed anymore.
+             *
+             * This method has to be implemented by the descendant.
+             *
+             * @returns true if the instrument was freed
+             */
+            virtual bool DiscardPrefetchedInstrument(const instrument_id_t& ID) = 0;
+
+            /**
+             * Reloads the given instrument from its file, if it is currently
+             * loaded, i.e. after the file was modified on disk. Depending on
+             * the instrument format, sampler channels either keep playing
+             * the old instrument while the new one is loaded and unchanged
+             * samples are taken over from the old instrument, or the
+             * instrument is completely loaded again with playback stopped
+             * meanwhile.
+             *
+             * This method has to be implemented by the descendant.
+             *
+             * @returns false if the instrument is currently not loaded
+             */
+            virtual bool ReloadInstrument(const instrument_id_t& ID) = 0;
+
+            /**
+             * Reloads all currently loaded instruments of the given
+             * instrument file by all instrument managers (see
+             * ReloadInstrument()).
+             *
+             * @param File - instrument file
+             * @returns amount of instruments reloaded
+             */
+            static int ReloadInstruments(const String& File);
+
             /**
              * Stops the background thread that has been started by
              * LoadInstrumentInBackground.
@@ -207,6 +273,104 @@ namespace LinuxSampler {
              *         provided instrument file is not supported
              */
             virtual instrument_info_t GetInstrumentInfo(instrument_id_t ID) throw (InstrumentManagerException) = 0;
+
+            /**
+             * Returns the amount of RAM (in bytes) currently occupied by the
+             * cached sample data of the given instrument, or 0 if the
+             * instrument is currently not loaded. Samples the instrument
+             * shares with other instruments are included.
+             *
+             * This method has to be implemented by the descendant.
+             */
+            virtual uint64_t GetMemoryUsage(const instrument_id_t& ID) = 0;
+
+            /**
+             * Returns the amount of RAM (in bytes) currently occupied by the
+             * cached sample data of all instruments loaded by this instrument
+             * manager (shared samples are only counted once).
+             *
+             * This method has to be implemented by the descendant.
+             */
+            virtual uint64_t GetTotalMemoryUsage() = 0;
+
+            /**
+             * Moves the cached sample data of the given instrument to NUMA
+             * node @a Node, i.e. the node of the audio output device of
+             * the sampler channel the instrument was just loaded on. The
+             * instrument should be in use by the caller. Samples shared with
+             * other instruments are moved as well. Does nothing if NUMA
+             * support is disabled.
+             *
+             * This method has to be implemented by the descendant.
+             *
+             * @returns amount of bytes of the instrument's sample data
+             *          residing on @a Node afterwards
+             */
+            virtual uint64_t MoveToNumaNode(const instrument_id_t& ID, int Node) = 0;
+
+            /**
+             * Limits the RAM occupied by cached sample data of all instrument
+             * managers to @a Bytes. Whenever that budget is exceeded, the
+             * least recently used instruments with a life-time strategy of
+             * @c ON_DEMAND_HOLD which are currently not used by any sampler
+             * channel are freed until the sample data fits into the budget
+             * again. Instruments in use and @c PERSISTENT instruments are
+             * never freed, so the budget might still be exceeded by those.
+             *
+             * @param Bytes - memory budget, or 0 for no limit
+             */
+            static void SetMemoryBudget(uint64_t Bytes);
+
+            /**
+             * Returns the current memory budget (in bytes) set with
+             * SetMemoryBudget(), 0 means no limit.
+             */
+            static uint64_t GetMemoryBudget();
+
+            /**
+             * Returns the RAM (in bytes) occupied by cached sample data of
+             * all instrument managers.
+             */
+            static uint64_t GetGlobalMemoryUsage();
+
+            /**
+             * Returns how many instruments were freed so far due to the
+             * memory budget being exceeded.
+             */
+            static uint GetEvictionCount();
+
+            /**
+             * Frees least recently used @c ON_DEMAND_HOLD instruments until
+             * the memory budget is no longer exceeded. Called after an
+             * instrument was loaded. Must not be called while any instrument
+             * manager is locked by the calling thread.
+             */
+            static void EnforceMemoryBudget();
+
+        protected:
+            /**
+             * Returns the least recently used instrument with a life-time
+             * strategy of @c ON_DEMAND_HOLD which is currently loaded, but
+             * not used by anybody.
+             *
+             * This method has to be implemented by the descendant.
+             *
+             * @param ID - (output) the instrument
+             * @param LastUse - (output) ResourceUseTick() of the last time
+             *                  the instrument was used
+             * @returns false if there is no such instrument
+             */
+            virtual bool GetLeastRecentlyUsedHeldInstrument(instrument_id_t& ID, uint64_t& LastUse) = 0;
+
+            /**
+             * Frees the given @c ON_DEMAND_HOLD instrument if it is not used
+             * by anybody. It will be loaded again when needed.
+             *
+             * This method has to be implemented by the descendant.
+             *
+             * @returns true if the instrument was freed
+             */
+            virtual bool EvictInstrument(const instrument_id_t& ID) = 0;
     };
 
 }
@@ -30,6 +30,7 @@
 #include "../drivers/audio/AudioOutputDeviceFactory.h"
 #include "AbstractEngine.h"
 #include "AbstractEngineChannel.h"
+#include "../common/NUMA.h"
 
 // We need to know the maximum number of sample points which are going to
 // be processed for each render cycle of the audio output driver, to know
@@ -56,7 +57,10 @@ namespace LinuxSampler {
             typedef ResourceConsumer<I> InstrumentConsumer;
 
             InstrumentManagerBase() : AbstractInstrumentManager() { }
-            virtual ~InstrumentManagerBase() { }
+            virtual ~InstrumentManagerBase() {
+                for (typename std::map<String, Mutex*>::iterator it = FileLoadMutexes.begin(); it != FileLoadMutexes.end(); ++it)
+                    delete it->second;
+            }
 
             virtual InstrumentEditor* LaunchInstrumentEditor(EngineChannel* pEngineChannel, instrument_id_t ID, void* pUserData = NULL) throw (InstrumentManagerException) OVERRIDE {
                  throw InstrumentManagerException(
@@ -84,12 +88,24 @@ namespace LinuxSampler {
                 InstrumentConsumer*  pConsumer,
                 RTList<R*>*          pRegionsInUse
             ) {
+                LockGuard lock(RegionInfoMutex);
+                RetainRegions(pRegionsInUse);
+                this->HandBack(pResource, pConsumer, true);
+            }
+
+            /**
+             * Keeps the given regions (and their samples) of an instrument
+             * alive beyond the instrument's destruction, until they are
+             * given back with HandBackRegion(). Used for the regions still
+             * played by voices when a consumer switches over to a reloaded
+             * instrument (see ResourceConsumer::ResourceReplaced()).
+             */
+            void RetainRegions(RTList<R*>* pRegionsInUse) {
                 LockGuard lock(RegionInfoMutex);
                 for (typename RTList<R*>::Iterator i = pRegionsInUse->first() ; i != pRegionsInUse->end() ; i++) {
                     RegionInfo[*i].refCount++;
                     SampleRefCount[(*i)->pSample]++;
                 }
-                this->HandBack(pResource, pConsumer, true);
             }
 
             /**
@@ -124,6 +140,76 @@ namespace LinuxSampler {
             virtual void SetMode(const InstrumentManager::instrument_id_t& ID, InstrumentManager::mode_t Mode) OVERRIDE {
                 dmsg(2,("InstrumentManagerBase: setting mode for %s (Index=%d) to %d\n",ID.FileName.c_str(),ID.Index,Mode));
                 this->SetAvailabilityMode(ID, static_cast<typename ResourceManager<instrument_id_t, I>::mode_t>(Mode));
+                // a PERSISTENT instrument might just have been loaded
+                InstrumentManager::EnforceMemoryBudget();
+            }
+
+            virtual bool PrefetchInstrument(const InstrumentManager::instrument_id_t& ID) OVERRIDE {
+                const uint64_t budget = InstrumentManager::GetMemoryBudget();
+                if (budget && InstrumentManager::GetGlobalMemoryUsage() >= budget)
+                    return false; // no room left for speculative loads
+                dmsg(2,("InstrumentManagerBase: prefetching %s (Index=%d)\n",ID.FileName.c_str(),ID.Index));
+                if (!this->Prefetch(ID)) return false; // already loaded
+                InstrumentManager::EnforceMemoryBudget();
+                return true;
+            }
+
+            virtual bool DiscardPrefetchedInstrument(const InstrumentManager::instrument_id_t& ID) OVERRIDE {
+                // same lock order as HandBackInstrument(), Destroy() might need RegionInfo
+                LockGuard lock(RegionInfoMutex);
+                return this->DiscardPrefetched(ID);
+            }
+
+            virtual bool ReloadInstrument(const InstrumentManager::instrument_id_t& ID) OVERRIDE {
+                I* pInstrument = this->Resource(ID);
+                if (!pInstrument) return false;
+                dmsg(1,("InstrumentManagerBase: reloading %s (Index=%d)\n",ID.FileName.c_str(),ID.Index));
+                this->Update(pInstrument, NULL);
+                return true;
+            }
+
+            virtual uint64_t GetMemoryUsage(const InstrumentManager::instrument_id_t& ID) OVERRIDE {
+                std::set<S*> samples;
+                this->Lock();
+                I* pInstrument = this->Resource(ID, false/*don't lock again*/);
+                if (pInstrument) CollectSamples(pInstrument, samples);
+                const uint64_t bytes = SampleMemoryUsage(samples);
+                this->Unlock();
+                return bytes;
+            }
+
+            virtual uint64_t GetTotalMemoryUsage() OVERRIDE {
+                std::set<S*> samples;
+                this->Lock();
+                std::vector<I*> instruments = this->Resources(false/*don't lock again*/);
+                for (size_t i = 0; i < instruments.size(); i++)
+                    CollectSamples(instruments[i], samples);
+                const uint64_t bytes = SampleMemoryUsage(samples);
+                this->Unlock();
+                return bytes;
+            }
+
+            virtual uint64_t MoveToNumaNode(const InstrumentManager::instrument_id_t& ID, int Node) OVERRIDE {
+                #if CONFIG_NUMA
+                // the RAM caches are only collected with the manager locked,
+                // the caller uses the instrument, so they stay alive while
+                // being moved
+                std::set<S*> samples;
+                std::map<const void*, size_t> buffers;
+                this->Lock();
+                I* pInstrument = this->Resource(ID, false/*don't lock again*/);
+                if (pInstrument) CollectSamples(pInstrument, samples);
+                for (typename std::set<S*>::const_iterator it = samples.begin(); it != samples.end(); ++it)
+                    if ((*it)->GetCache().pStart)
+                        buffers[(*it)->GetCache().pStart] = (*it)->GetCache().Size + (*it)->GetCache().NullExtensionSize;
+                this->Unlock();
+                uint64_t bytes = 0;
+                for (std::map<const void*, size_t>::const_iterator it = buffers.begin(); it != buffers.end(); ++it)
+                    bytes += NUMA::MoveMemory(it->first, it->second, Node);
+                return bytes;
+                #else
+                return 0;
+                #endif
             }
 
     protected:
@@ -171,6 +257,24 @@ namespace LinuxSampler {
                 return pDevice ? pDevice->MaxSamplesPerCycle() : DefaultMaxSamplesPerCycle();
             }
 
+            /**
+             * Instruments are created without the instrument manager being
+             * locked, so instruments can be loaded concurrently. Instruments
+             * of the same instrument file however share the file's data
+             * structures (and samples), so the descendant's Create()
+             * implementation has to lock the mutex returned by this method
+             * for the instrument's file while loading the instrument.
+             *
+             * @param File - file name of the instrument file (or any other
+             *               name for data shared by several instrument files)
+             */
+            Mutex& FileLoadMutex(const String& File) {
+                LockGuard lock(FileLoadMutexesMutex);
+                Mutex*& pMutex = FileLoadMutexes[File];
+                if (!pMutex) pMutex = new Mutex;
+                return *pMutex;
+            }
+
             Mutex RegionInfoMutex; ///< protects the RegionInfo and SampleRefCount maps from concurrent access by the instrument loader and disk threads
             std::map< R*, region_info_t> RegionInfo; ///< contains dimension regions that are still in use but belong to released instrument
             std::map< S*, int> SampleRefCount; ///< contains samples that are still in use but belong to a released instrument
@@ -178,6 +282,37 @@ namespace LinuxSampler {
             virtual void DeleteRegionIfNotUsed(R* pRegion, region_info_t* pRegInfo) = 0;
             virtual void DeleteSampleIfNotUsed(S* pSample, region_info_t* pRegInfo) = 0;
 
+            /**
+             * Has to be implemented by the descendant to add all samples
+             * referenced by the given instrument to @a samples. Used for
+             * the memory accounting, the instrument manager is locked while
+             * this method is called.
+             */
+            virtual void CollectSamples(I* pInstrument, std::set<S*>& samples) = 0;
+
+            // RAM occupied by the cached sample data of the given samples
+            // (RAM caches shared by several samples are only counted once)
+            static uint64_t SampleMemoryUsage(const std::set<S*>& samples) {
+                uint64_t bytes = 0;
+                std::set<const void*> buffers;
+                for (typename std::set<S*>::const_iterator it = samples.begin(); it != samples.end(); ++it) {
+                    if (!buffers.insert((*it)->GetCache().pStart).second) continue;
+                    bytes += (*it)->GetCache().Size + (*it)->GetCache().NullExtensionSize;
+                }
+                return bytes;
+            }
+
+            // implementation of derived abstract methods from 'InstrumentManager'
+            virtual bool GetLeastRecentlyUsedHeldInstrument(InstrumentManager::instrument_id_t& ID, uint64_t& LastUse) OVERRIDE {
+                return this->LeastRecentlyUsedHeld(ID, LastUse);
+            }
+
+            virtual bool EvictInstrument(const InstrumentManager::instrument_id_t& ID) OVERRIDE {
+                // same lock order as HandBackInstrument(), Destroy() might need RegionInfo
+                LockGuard lock(RegionInfoMutex);
+                return this->Evict(ID);
+            }
+
             void SetKeyBindings(uint8_t* bindingsArray, int low, int high, int undefined = -1) {
                 if (low == undefined || high == undefined) return;
                 if (low < 0 || low > 127 || high < 0 || high > 127 || low > high) {
@@ -241,6 +376,10 @@ namespace LinuxSampler {
                     this->Update(pResource, pConsumer);
                 }
             }
+
+    private:
+            Mutex                   FileLoadMutexesMutex; ///< protects the FileLoadMutexes map
+            std::map<String, Mutex*> FileLoadMutexes;     ///< see FileLoadMutex()
     };
 
 } // namespace LinuxSampler
@@ -20,17 +20,28 @@
 
 #include "InstrumentManagerThread.h"
 
+#include <algorithm>
+
 #include "../common/global_private.h"
+#include "../common/Features.h"
 #include "EngineChannelFactory.h"
+#include "common/PreloadSnapshot.h"
 
 namespace LinuxSampler {
 
     InstrumentManagerThread::InstrumentManagerThread() : Thread(true, false, 0, -4) {
         eventHandler.pThread = this;
+        runningCommands = 0;
+        modeCommandRunning = false;
+        prefetchRunning = false;
     }
 
     InstrumentManagerThread::~InstrumentManagerThread() {
         Thread::StopThread();
+        for (size_t i = 0; i < loaders.size(); i++) {
+            loaders[i]->StopThread();
+            delete loaders[i];
+        }
     }
 
     /**
@@ -65,6 +76,7 @@ namespace LinuxSampler {
         }
 
         StartThread(); // ensure thread is running
+        StartLoaderThreads();
         conditionJobsLeft.Set(true); // wake up thread
     }
 
@@ -96,12 +108,181 @@ namespace LinuxSampler {
         conditionJobsLeft.Set(true); // wake up thread
     }
 
+    /**
+     * @brief Order loading instruments in advance.
+     *
+     * The instruments will be loaded in the background (in the given order)
+     * by the instrument manager, without being assigned to any engine
+     * channel, but only while no other commands are waiting. Instruments
+     * still waiting to be loaded in advance for the same engine channel by
+     * an earlier call are dropped, since they are likely not needed anymore.
+     * For the same reason instruments already loaded in advance by an
+     * earlier call, which are neither in @a IDs nor used by anybody
+     * meanwhile, are freed again.
+     *
+     * @param pManager       - InstrumentManager which shall load the instruments
+     * @param IDs            - instruments to be loaded
+     * @param pEngineChannel - engine channel the instruments will likely be
+     *                         loaded on later on
+     */
+    void InstrumentManagerThread::StartPrefetching(InstrumentManager* pManager, const std::vector<InstrumentManager::instrument_id_t>& IDs, EngineChannel* pEngineChannel) {
+        {
+            LockGuard lock(mutex);
+            for (std::list<command_t>::iterator it = queue.begin(); it != queue.end(); ) {
+                if (it->type == command_t::PREFETCH && it->pEngineChannel == pEngineChannel)
+                    it = queue.erase(it);
+                else
+                    ++it;
+            }
+            DiscardPrefetched(pEngineChannel, IDs);
+            for (size_t i = 0; i < IDs.size(); i++) {
+                command_t cmd;
+                cmd.type           = command_t::PREFETCH;
+                cmd.pEngineChannel = pEngineChannel;
+                cmd.pManager       = pManager;
+                cmd.instrumentId   = IDs[i];
+                queue.push_back(cmd);
+            }
+        }
+        StartThread(); // ensure thread is running
+        conditionJobsLeft.Set(true); // wake up thread
+    }
+
+    /**
+     * Orders freeing the instruments loaded in advance for the given engine
+     * channel so far, except of those in @a KeptIDs. @c mutex must be locked
+     * by the caller.
+     */
+    void InstrumentManagerThread::DiscardPrefetched(EngineChannel* pEngineChannel, const std::vector<InstrumentManager::instrument_id_t>& KeptIDs) {
+        std::map<EngineChannel*, std::vector<command_t> >::iterator itChannel = prefetched.find(pEngineChannel);
+        if (itChannel == prefetched.end()) return;
+        std::vector<command_t> kept;
+        for (size_t i = 0; i < itChannel->second.size(); i++) {
+            command_t cmd = itChannel->second[i];
+            if (std::find(KeptIDs.begin(), KeptIDs.end(), cmd.instrumentId) != KeptIDs.end()) {
+                kept.push_back(cmd);
+                continue;
+            }
+            cmd.type = command_t::DISCARD;
+            queue.push_front(cmd);
+        }
+        if (kept.empty()) prefetched.erase(itChannel);
+        else itChannel->second = kept;
+    }
+
+    /**
+     * Max. amount of instruments being loaded concurrently, that is
+     * CONFIG_INSTRUMENT_LOADER_THREADS, or the amount of CPU cores (at most
+     * 4) if configured as auto.
+     */
+    int InstrumentManagerThread::LoaderThreadCount() {
+        if (CONFIG_INSTRUMENT_LOADER_THREADS >= 0) return CONFIG_INSTRUMENT_LOADER_THREADS;
+        return std::min(Features::processorCount(), 4);
+    }
+
+    /// Starts the additional loader threads (if not running already).
+    void InstrumentManagerThread::StartLoaderThreads() {
+        LockGuard lock(mutex);
+        while (int(loaders.size()) + 1 < LoaderThreadCount()) {
+            LoaderThread* pLoader = new LoaderThread(this);
+            loaders.push_back(pLoader);
+            pLoader->StartThread();
+        }
+    }
+
+    /**
+     * Takes the next command from the queue which may be executed now, that
+     * is the oldest command for an engine channel no other command is being
+     * executed for at the moment. An INSTR_MODE command is only executed
+     * while no other command is running, and no command behind it is taken
+     * before it. A PREFETCH command is only taken if no other command could be
+     * taken instead, and only while no other PREFETCH command is running.
+     * DISCARD commands are always taken immediately. @c mutex must be locked
+     * by the caller.
+     *
+     * @returns false if there is no such command at the moment
+     */
+    bool InstrumentManagerThread::TakeCommand(command_t& cmd) {
+        if (modeCommandRunning) return false;
+        std::list<command_t>::iterator prefetch = queue.end();
+        for (std::list<command_t>::iterator it = queue.begin(); it != queue.end(); ++it) {
+            if (it->type == command_t::INSTR_MODE) {
+                if (runningCommands) return false;
+                modeCommandRunning = true;
+            } else if (it->type == command_t::DIRECT_LOAD) {
+                if (busyChannels.count(it->pEngineChannel)) continue;
+                busyChannels.insert(it->pEngineChannel);
+                EngineChannelFactory::SetDeleteEnabled(it->pEngineChannel, false);
+            } else if (it->type == command_t::PREFETCH) {
+                if (prefetch == queue.end()) prefetch = it;
+                continue;
+            }
+            cmd = *it;
+            queue.erase(it);
+            runningCommands++;
+            return true;
+        }
+        if (prefetch == queue.end() || prefetchRunning) return false;
+        prefetchRunning = true;
+        cmd = *prefetch;
+        queue.erase(prefetch);
+        runningCommands++;
+        return true;
+    }
+
+    /// Must be called after @a cmd was executed, @c mutex must be locked by the caller.
+    void InstrumentManagerThread::FinishCommand(const command_t& cmd) {
+        if (cmd.type == command_t::INSTR_MODE) {
+            modeCommandRunning = false;
+        } else if (cmd.type == command_t::DIRECT_LOAD) {
+            busyChannels.erase(cmd.pEngineChannel);
+            EngineChannelFactory::SetDeleteEnabled(cmd.pEngineChannel, true);
+        } else if (cmd.type == command_t::PREFETCH) {
+            prefetchRunning = false;
+        }
+        runningCommands--;
+    }
+
+    void InstrumentManagerThread::ExecuteCommand(command_t& cmd) {
+        try {
+            switch (cmd.type) {
+                case command_t::DIRECT_LOAD:
+                    cmd.pEngineChannel->PrepareLoadInstrument(cmd.instrumentId.FileName.c_str(), cmd.instrumentId.Index);
+                    cmd.pEngineChannel->LoadInstrument();
+                    break;
+                case command_t::INSTR_MODE:
+                    cmd.pManager->SetMode(cmd.instrumentId, cmd.mode);
+                    break;
+                case command_t::PREFETCH:
+                    if (cmd.pManager->PrefetchInstrument(cmd.instrumentId)) {
+                        LockGuard lock(mutex);
+                        prefetched[cmd.pEngineChannel].push_back(cmd);
+                    }
+                    break;
+                case command_t::DISCARD:
+                    if (cmd.pManager->DiscardPrefetchedInstrument(cmd.instrumentId))
+                        dmsg(2,("InstrumentManagerThread: discarded prefetched '%s' (Index=%d)\n", cmd.instrumentId.FileName.c_str(), cmd.instrumentId.Index));
+                    break;
+                default:
+                    std::cerr << "InstrumentManagerThread: unknown command - BUG!\n" << std::flush;
+            }
+        } catch (Exception& e) {
+            e.PrintMessage();
+        } catch (...) {
+            std::cerr << "InstrumentManagerThread: some exception occured, could not finish task\n" << std::flush;
+        }
+    }
+
     // Entry point for the task thread.
     int InstrumentManagerThread::Main() {
         #if DEBUG
         Thread::setNameOfCaller("InstrumentMngr");
         #endif
+        return ProcessCommands();
+    }
 
+    /// Executes commands until the calling thread is stopped, called by this thread and all loader threads.
+    int InstrumentManagerThread::ProcessCommands() {
         while (true) {
 
             TestCancel();
@@ -116,40 +297,26 @@ namespace LinuxSampler {
                 // grab a new command from the queue
                 {
                     LockGuard lock(mutex);
-                    if (queue.empty()) break;
+                    if (!TakeCommand(cmd)) break;
+                }
+                // let another thread pick up the next command meanwhile
+                conditionJobsLeft.Set(true);
 
-                    cmd = queue.front();
-                    queue.pop_front();
+                ExecuteCommand(cmd);
 
-                    if (cmd.type == command_t::DIRECT_LOAD) {
-                        EngineChannelFactory::SetDeleteEnabled(cmd.pEngineChannel, false);
-                    }
+                bool bIdle;
+                {
+                    LockGuard lock(mutex);
+                    FinishCommand(cmd);
+                    bIdle = queue.empty() && !runningCommands;
                 }
+                // commands of the same engine channel might be executable now
+                conditionJobsLeft.Set(true);
 
-                try {
-                    switch (cmd.type) {
-                        case command_t::DIRECT_LOAD:
-                            cmd.pEngineChannel->PrepareLoadInstrument(cmd.instrumentId.FileName.c_str(), cmd.instrumentId.Index);
-                            cmd.pEngineChannel->LoadInstrument();
-                            EngineChannelFactory::SetDeleteEnabled(cmd.pEngineChannel, true);
-                            break;
-                        case command_t::INSTR_MODE:
-                            cmd.pManager->SetMode(cmd.instrumentId, cmd.mode);
-                            break;
-                        default:
-                            std::cerr << "InstrumentManagerThread: unknown command - BUG!\n" << std::flush;
-                    }
-                } catch (Exception e) {
-                    e.PrintMessage();
-                    if (cmd.type == command_t::DIRECT_LOAD) {
-                        EngineChannelFactory::SetDeleteEnabled(cmd.pEngineChannel, true);
-                    }
-                } catch (...) {
-                    std::cerr << "InstrumentManagerThread: some exception occured, could not finish task\n" << std::flush;
-                    if (cmd.type == command_t::DIRECT_LOAD) {
-                        EngineChannelFactory::SetDeleteEnabled(cmd.pEngineChannel, true);
-                    }
-                }
+                #if CONFIG_PRELOAD_SNAPSHOT
+                // all instruments loaded, so update the snapshot (if required)
+                if (bIdle) PreloadSnapshot::SaveIfModified();
+                #endif
             }
 
             // now allow thread being cancelled again
@@ -159,30 +326,47 @@ namespace LinuxSampler {
             // nothing left to do, sleep until new jobs arrive
             conditionJobsLeft.WaitIf(false);
             // reset flag
-            conditionJobsLeft.Set(false);
+            conditionJobsLeft.PreLockedSet(false);
             // unlock condition object so it can be turned again by other thread
             conditionJobsLeft.Unlock();
         }
         return 0;
     }
 
+    InstrumentManagerThread::LoaderThread::LoaderThread(InstrumentManagerThread* pParent) :
+        Thread(true, false, 0, -4), pParent(pParent)
+    {
+    }
+
+    int InstrumentManagerThread::LoaderThread::Main() {
+        #if DEBUG
+        Thread::setNameOfCaller("InstrumentLoader");
+        #endif
+        return pParent->ProcessCommands();
+    }
+
     void InstrumentManagerThread::EventHandler::ChannelToBeRemoved(SamplerChannel* pChannel) {
         /*
            Removing from the queue an eventual scheduled loading of an instrument
            to a sampler channel which is going to be removed.
         */
-        LockGuard lock(pThread->mutex);
-        std::list<command_t>::iterator it;
-        for (it = pThread->queue.begin(); it != pThread->queue.end();){
-            if ((*it).type != command_t::DIRECT_LOAD) { ++it; continue; }
-            if ((*it).pEngineChannel == pChannel->GetEngineChannel()) {
-                it = pThread->queue.erase(it);
-                // we don't break here because the same engine channel could
-                // occur more than once in the queue, so don't make optimizations
-            } else {
-                ++it;
+        {
+            LockGuard lock(pThread->mutex);
+            std::list<command_t>::iterator it;
+            for (it = pThread->queue.begin(); it != pThread->queue.end();){
+                if ((*it).type == command_t::INSTR_MODE || (*it).type == command_t::DISCARD) { ++it; continue; }
+                if ((*it).pEngineChannel == pChannel->GetEngineChannel()) {
+                    it = pThread->queue.erase(it);
+                    // we don't break here because the same engine channel could
+                    // occur more than once in the queue, so don't make optimizations
+                } else {
+                    ++it;
+                }
             }
-        } 
+            // instruments loaded in advance for it are not needed anymore either
+            pThread->DiscardPrefetched(pChannel->GetEngineChannel(), std::vector<InstrumentManager::instrument_id_t>());
+        }
+        pThread->conditionJobsLeft.Set(true); // wake up thread
     }
 
 #if defined(__APPLE__) && !defined(__x86_64__)
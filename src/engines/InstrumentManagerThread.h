@@ -30,6 +30,9 @@
 #include "InstrumentManager.h"
 
 #include <list>
+#include <map>
+#include <set>
+#include <vector>
 
 namespace LinuxSampler {
 
@@ -39,6 +42,17 @@ namespace LinuxSampler {
      * the InstrumentManager in the background, that is in a separate thread
      * without blocking the calling thread. This class is thus not exported
      * to the API.
+     *
+     * Instruments of different engine channels are loaded concurrently by
+     * this thread and up to LoaderThreadCount() - 1 additional
+     * loader threads, so recalling a session with many channels does not
+     * take the sum of all instrument load times. Commands of the same
+     * engine channel are still executed one after another in the order
+     * they were scheduled, and mode changes are never executed concurrently
+     * with any other command. Instruments ordered to be loaded in advance
+     * (prefetched) are loaded one at a time and only while no other command
+     * is waiting. They are freed again (if still unused) once the engine
+     * channel they were loaded for orders other instruments in advance.
      */
     class InstrumentManagerThread : public Thread {
         friend class EventHandler;
@@ -47,6 +61,7 @@ namespace LinuxSampler {
             InstrumentManagerThread();
             void StartNewLoad(String Filename, uint uiInstrumentIndex, EngineChannel* pEngineChannel);
             void StartSettingMode(InstrumentManager* pManager, const InstrumentManager::instrument_id_t& ID, InstrumentManager::mode_t Mode);
+            void StartPrefetching(InstrumentManager* pManager, const std::vector<InstrumentManager::instrument_id_t>& IDs, EngineChannel* pEngineChannel);
             virtual ~InstrumentManagerThread();
 #if (defined(__APPLE__) && !defined(__x86_64__)) || defined(WIN32)
             int StopThread();
@@ -55,20 +70,45 @@ namespace LinuxSampler {
             struct command_t {
                 enum cmd_type_t {
                     DIRECT_LOAD, ///< command was created by a StartNewLoad() call
-                    INSTR_MODE   ///< command was created by a StartSettingMode() call
+                    INSTR_MODE,  ///< command was created by a StartSettingMode() call
+                    PREFETCH,    ///< command was created by a StartPrefetching() call
+                    DISCARD      ///< command was created by a StartPrefetching() call superseding an earlier one
                 } type;
-                EngineChannel*                     pEngineChannel; ///< only for DIRECT_LOAD commands
-                InstrumentManager*                 pManager;     ///< only for INSTR_MODE commands
-                InstrumentManager::instrument_id_t instrumentId; ///< for both DIRECT_LOAD and INSTR_MODE
+                EngineChannel*                     pEngineChannel; ///< for DIRECT_LOAD, PREFETCH and DISCARD commands (the latter two never dereference it)
+                InstrumentManager*                 pManager;     ///< for INSTR_MODE, PREFETCH and DISCARD commands
+                InstrumentManager::instrument_id_t instrumentId; ///< for all commands
                 InstrumentManager::mode_t          mode;         ///< only for INSTR_MODE commands
             };
 
+            /// Additional thread executing commands concurrently to the InstrumentManagerThread.
+            class LoaderThread : public Thread {
+                public:
+                    LoaderThread(InstrumentManagerThread* pParent);
+                protected:
+                    int Main() OVERRIDE;
+                private:
+                    InstrumentManagerThread* pParent;
+            };
+
             // Instance variables.
             std::list<command_t> queue; ///< queue with commands for loading new instruments.
             Mutex                mutex; ///< for making the queue thread safe 
             Condition            conditionJobsLeft; ///< synchronizer to block this thread until a new job arrives
+            std::set<EngineChannel*> busyChannels; ///< engine channels a command is currently executed for (protected by @c mutex)
+            int                  runningCommands; ///< amount of commands currently being executed (protected by @c mutex)
+            bool                 modeCommandRunning; ///< whether an INSTR_MODE command is currently being executed (protected by @c mutex)
+            bool                 prefetchRunning; ///< whether a PREFETCH command is currently being executed (protected by @c mutex)
+            std::map<EngineChannel*, std::vector<command_t> > prefetched; ///< executed PREFETCH commands which actually loaded their instrument, for each engine channel (protected by @c mutex)
+            std::vector<LoaderThread*> loaders; ///< additional loader threads
 
             int Main(); ///< Implementation of virtual method from class Thread.
+            int ProcessCommands();
+            bool TakeCommand(command_t& cmd);
+            void FinishCommand(const command_t& cmd);
+            void ExecuteCommand(command_t& cmd);
+            void StartLoaderThreads();
+            static int LoaderThreadCount();
+            void DiscardPrefetched(EngineChannel* pEngineChannel, const std::vector<InstrumentManager::instrument_id_t>& KeptIDs);
         private:
             class EventHandler : public ChannelCountAdapter {
                 public:
@@ -173,6 +173,10 @@ namespace LinuxSampler {
 
         SetSampleStartOffset();
 
+        // (calculated before ordering a disk stream, since the stream's
+        // buffer size depends on the pitch)
+        Pitch = CalculatePitchInfo(PitchBend);
+
         if (DiskVoice) { // voice to be streamed from disk
             if (cachedsamples > (GetEngine()->MaxSamplesPerCycle << CONFIG_MAX_PITCH)) {
                 //TODO: this calculation is too pessimistic
@@ -190,6 +194,9 @@ namespace LinuxSampler {
             RAMLoop = (SmplInfo.HasLoops && (SmplInfo.LoopStart + SmplInfo.LoopLength) <= MaxRAMPos);
 
             if (OrderNewStream()) return -1;
+            // nothing of the sample is in RAM (yet, see CONFIG_LAZY_PRELOAD),
+            // so wait for the disk stream right from the start
+            if (!cachedsamples) PlaybackState = playback_state_wait;
             dmsg(4,("Disk voice launched (cached samples: %ld, total Samples: %d, MaxRAMPos: %lu, RAMLooping: %s)\n", cachedsamples, SmplInfo.TotalFrameCount, MaxRAMPos, (RAMLoop) ? "yes" : "no"));
         }
         else { // RAM only voice
@@ -205,7 +212,6 @@ namespace LinuxSampler {
             loop.uiSize        = SmplInfo.LoopLength;
         }
 
-        Pitch = CalculatePitchInfo(PitchBend);
         NotePitch.setCurveOnly(pNote ? pNote->Override.PitchCurve : DEFAULT_FADE_CURVE);
         NotePitch.setCurrentValue(pNote ? pNote->Override.Pitch.Value : 1.0f);
         NotePitch.setFinal(pNote ? pNote->Override.Pitch.Final : false);
@@ -0,0 +1,125 @@
+/*
+ * Copyright (c) 2020 Christian Schoenebeck
+ *
+ * http://www.linuxsampler.org
+ *
+ * This file is part of LinuxSampler and released under the same terms.
+ * See README file for details.
+ */
+
+#include "DirectSampleReader.h"
+
+#if CONFIG_DIRECT_IO_STREAMING
+
+#include <sys/types.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+
+namespace LinuxSampler {
+
+    DirectSampleReader::DirectSampleReader() :
+        fd(-1), DataOffset(0), DataSize(0), FrameSize(0)
+    {
+    }
+
+    DirectSampleReader::~DirectSampleReader() {
+        Close();
+    }
+
+    bool DirectSampleReader::Open(const String& File, uint64_t DataOffset, size_t DataSize, int FrameSize) {
+        Close();
+        if (!DataSize || FrameSize <= 0) return false;
+
+        const int fd = open(File.c_str(), O_RDONLY | O_DIRECT);
+        if (fd < 0) {
+            dmsg(1,("DirectSampleReader: could not open '%s' for direct I/O: %s\n", File.c_str(), strerror(errno)));
+            return false;
+        }
+        struct stat st;
+        if (fstat(fd, &st) || uint64_t(st.st_size) < DataOffset + DataSize) {
+            dmsg(1,("DirectSampleReader: '%s' is smaller than expected\n", File.c_str()));
+            close(fd);
+            return false;
+        }
+
+        this->DataOffset = DataOffset;
+        this->DataSize   = DataSize;
+        this->FrameSize  = FrameSize;
+        this->fd         = fd; // set last, marks the object as opened
+        return true;
+    }
+
+    void DirectSampleReader::Close() {
+        if (fd < 0) return;
+        close(fd);
+        fd = -1;
+        DataOffset = 0;
+        DataSize   = 0;
+        FrameSize  = 0;
+    }
+
+    namespace {
+        // aligned bounce buffer of the calling thread, freed on thread exit
+        struct BounceBuffer {
+            uint8_t* pData;
+            BounceBuffer() : pData(NULL) {}
+            ~BounceBuffer() { free(pData); }
+        };
+    }
+
+    uint8_t* DirectSampleReader::GetBounceBuffer() {
+        static thread_local BounceBuffer buffer;
+        if (!buffer.pData) {
+            void* p = NULL;
+            if (posix_memalign(&p, ALIGNMENT, BOUNCE_SIZE)) return NULL;
+            buffer.pData = (uint8_t*) p;
+        }
+        return buffer.pData;
+    }
+
+    long DirectSampleReader::Read(unsigned long FrameOffset, uint8_t* pDst, long FrameCount) {
+        if (fd < 0) return -1;
+        const uint64_t offset = uint64_t(FrameOffset) * FrameSize;
+        if (offset >= DataSize || FrameCount <= 0) return 0;
+        uint64_t bytes = uint64_t(FrameCount) * FrameSize;
+        if (offset + bytes > DataSize) bytes = DataSize - offset;
+
+        uint8_t* pBounce = GetBounceBuffer();
+        if (!pBounce) return -1;
+
+        const uint64_t begin = DataOffset + offset;
+        const uint64_t end   = begin + bytes;
+        uint64_t pos = begin - begin % ALIGNMENT;
+        uint64_t copied = 0;
+        while (pos < end) {
+            uint64_t n = end - pos;
+            n = (n + ALIGNMENT - 1) / ALIGNMENT * ALIGNMENT;
+            if (n > BOUNCE_SIZE) n = BOUNCE_SIZE;
+            const ssize_t r = pread(fd, pBounce, size_t(n), off_t(pos));
+            if (r < 0) {
+                if (errno == EINTR) continue;
+                dmsg(1,("DirectSampleReader: read error: %s\n", strerror(errno)));
+                return copied ? long(copied / FrameSize) : -1;
+            }
+            if (!r) break; // end of file
+            // copy the part of the aligned block which was actually requested
+            const uint64_t from = (pos < begin) ? begin - pos : 0;
+            uint64_t to = uint64_t(r);
+            if (pos + to > end) to = end - pos;
+            if (to > from) {
+                memcpy(pDst + copied, pBounce + from, size_t(to - from));
+                copied += to - from;
+            }
+            pos += uint64_t(r);
+            if (uint64_t(r) < n) break; // end of file
+        }
+        return long(copied / FrameSize);
+    }
+
+} // namespace LinuxSampler
+
+#endif // CONFIG_DIRECT_IO_STREAMING
@@ -0,0 +1,95 @@
+/*
+ * Copyright (c) 2020 Christian Schoenebeck
+ *
+ * http://www.linuxsampler.org
+ *
+ * This file is part of LinuxSampler and released under the same terms.
+ * See README file for details.
+ */
+
+#ifndef LS_DIRECTSAMPLEREADER_H
+#define LS_DIRECTSAMPLEREADER_H
+
+#include "../../common/global_private.h"
+
+#if CONFIG_DIRECT_IO_STREAMING
+
+#include <stddef.h>
+
+namespace LinuxSampler {
+
+    /** @brief Reads uncompressed sample wave data bypassing the page cache.
+     *
+     * Opens a sample file with @c O_DIRECT, so sample data streamed from
+     * disk is neither kept in nor evicting anything from the system's page
+     * cache. Sample libraries are usually far larger than RAM, so streaming
+     * them through the page cache just pushes out the sampler's own data
+     * (and the data of other processes) without ever being reused. Data that
+     * is worth keeping is cached by the sampler itself instead, in the
+     * StreamBlockCache with its bounded RAM budget.
+     *
+     * Direct I/O requires file offset, size and memory address of each read
+     * to be aligned to the device's block size, so the data is read into an
+     * aligned bounce buffer (one per reading thread) first and the requested
+     * part is copied from there.
+     *
+     * Only useful for uncompressed sample data which is stored in the file
+     * in exactly the format the synthesis code expects (that is 16 bit or
+     * 24 bit little endian PCM). It is the caller's responsibility to check
+     * that condition before calling Open().
+     *
+     * Read() may be called by several disk threads concurrently, all other
+     * methods must only be called while no disk thread reads from the object.
+     */
+    class DirectSampleReader {
+        public:
+            DirectSampleReader();
+            virtual ~DirectSampleReader();
+
+            /**
+             * Opens the file @a File for direct reading of the @a DataSize
+             * bytes of wave data starting at byte position @a DataOffset. An
+             * already opened file of this object is closed before.
+             *
+             * @param FrameSize - size of one sample point (frame) in bytes
+             * @returns true on success, false if the file could not be opened
+             *          for direct I/O (the object remains closed in this case)
+             */
+            bool Open(const String& File, uint64_t DataOffset, size_t DataSize, int FrameSize);
+
+            /// Closes the file (if open).
+            void Close();
+
+            inline bool IsOpen() const { return fd >= 0; }
+
+            /**
+             * Reads @a FrameCount sample points starting at sample point
+             * @a FrameOffset into @a pDst. This will block on disk I/O, so
+             * only call this from a disk thread.
+             *
+             * @returns amount of sample points read, which is only smaller
+             *          than @a FrameCount at the end of the sample data, or
+             *          -1 on error, in which case the caller should read the
+             *          data the ordinary way instead
+             */
+            long Read(unsigned long FrameOffset, uint8_t* pDst, long FrameCount);
+
+        private:
+            enum {
+                ALIGNMENT   = 4096,      ///< Satisfies the alignment requirements of virtually all block devices.
+                BOUNCE_SIZE = 256 * 1024 ///< Size of each reading thread's bounce buffer in bytes.
+            };
+
+            int      fd;
+            uint64_t DataOffset;
+            size_t   DataSize;
+            int      FrameSize;
+
+            static uint8_t* GetBounceBuffer();
+    };
+
+} // namespace LinuxSampler
+
+#endif // CONFIG_DIRECT_IO_STREAMING
+
+#endif // LS_DIRECTSAMPLEREADER_H
@@ -0,0 +1,85 @@
+/*
+ * Copyright (c) 2020 Christian Schoenebeck
+ *
+ * http://www.linuxsampler.org
+ *
+ * This file is part of LinuxSampler and released under the same terms.
+ * See README file for details.
+ */
+
+#include "DiskStatistics.h"
+
+#include <chrono>
+#include <string.h>
+
+namespace LinuxSampler {
+
+    DiskStatistics::DiskStatistics() :
+        BytesReadAtSecondStart(0), SecondStart(Now()),
+        LastLateStreams(0), LastUnderruns(0), LastKilledStreams(0)
+    {
+        memset(&Recorded, 0, sizeof(Recorded));
+        memset(&Published, 0, sizeof(Published));
+        atomic_set(&LateStreams, 0);
+        atomic_set(&Underruns, 0);
+        atomic_set(&KilledStreams, 0);
+    }
+
+    uint64_t DiskStatistics::Now() {
+        return std::chrono::duration_cast<std::chrono::microseconds>(
+            std::chrono::steady_clock::now().time_since_epoch()
+        ).count();
+    }
+
+    void DiskStatistics::RecordRead(uint64_t Microseconds, uint64_t Bytes) {
+        Recorded.Reads++;
+        Recorded.BytesRead += Bytes;
+        if (Microseconds > Recorded.MaxReadLatency)
+            Recorded.MaxReadLatency = uint(Microseconds);
+        int bucket = 0;
+        while (bucket < disk_stream_statistics_t::READ_LATENCY_BUCKETS - 1 &&
+               Microseconds >= (uint64_t(64) << bucket)) bucket++;
+        Recorded.ReadLatency[bucket]++;
+    }
+
+    void DiskStatistics::RecordMinFill(int Percentage) {
+        int bucket = Percentage / 10;
+        if (bucket < 0) bucket = 0;
+        if (bucket >= disk_stream_statistics_t::MIN_FILL_BUCKETS)
+            bucket = disk_stream_statistics_t::MIN_FILL_BUCKETS - 1;
+        Recorded.MinFill[bucket]++;
+    }
+
+    /**
+     * Adds the increments of the (wrapping) counter the voices report to
+     * since the previous call to the 64 bit counter @a Total.
+     */
+    void DiskStatistics::Accumulate(atomic_t& Counter, uint& Last, uint64_t& Total) {
+        const uint current = uint(atomic_read(&Counter));
+        Total += uint(current - Last);
+        Last = current;
+    }
+
+    void DiskStatistics::Update() {
+        const uint64_t now = Now();
+        if (now - SecondStart >= 1000000) {
+            Recorded.BytesPerSecond = uint(
+                (Recorded.BytesRead - BytesReadAtSecondStart) * 1000000 / (now - SecondStart)
+            );
+            BytesReadAtSecondStart = Recorded.BytesRead;
+            SecondStart = now;
+        }
+        Accumulate(LateStreams, LastLateStreams, Recorded.LateStreams);
+        Accumulate(Underruns, LastUnderruns, Recorded.Underruns);
+        Accumulate(KilledStreams, LastKilledStreams, Recorded.KilledStreams);
+
+        LockGuard lock(PublishedMutex);
+        Published = Recorded;
+    }
+
+    disk_stream_statistics_t DiskStatistics::Get() {
+        LockGuard lock(PublishedMutex);
+        return Published;
+    }
+
+} // namespace LinuxSampler
@@ -0,0 +1,79 @@
+/*
+ * Copyright (c) 2020 Christian Schoenebeck
+ *
+ * http://www.linuxsampler.org
+ *
+ * This file is part of LinuxSampler and released under the same terms.
+ * See README file for details.
+ */
+
+#ifndef LS_DISKSTATISTICS_H
+#define LS_DISKSTATISTICS_H
+
+#include "../../common/global.h"
+#include "../../common/Mutex.h"
+#include "../../common/atomic.h"
+#include "../Engine.h"
+
+namespace LinuxSampler {
+
+    /** @brief Collects disk streaming statistics of one disk thread.
+     *
+     * The disk thread records the duration and size of each stream refill
+     * and the lowest buffer fill each stream reached. It accumulates them
+     * privately and publishes a snapshot once per disk thread cycle by
+     * calling Update(), so that other threads (i.e. the LSCP server) can
+     * retrieve consistent statistics by calling Get() at any time without
+     * ever interrupting the disk thread for longer than copying the
+     * snapshot.
+     *
+     * The Report*() methods are called by voices and are real-time safe.
+     */
+    class DiskStatistics {
+        public:
+            DiskStatistics();
+
+            // disk thread only
+
+            /// Records one stream refill of @a Bytes size which took @a Microseconds.
+            void RecordRead(uint64_t Microseconds, uint64_t Bytes);
+
+            /// Records the lowest buffer fill (in percent) a finished stream reached.
+            void RecordMinFill(int Percentage);
+
+            /// Publishes the statistics recorded so far, called once per disk thread cycle.
+            void Update();
+
+            // real-time safe, called by voices (audio thread)
+
+            void ReportLateStream() { atomic_inc(&LateStreams); }
+            void ReportUnderrun()   { atomic_inc(&Underruns); }
+            void ReportKill()       { atomic_inc(&KilledStreams); }
+
+            // any thread
+
+            /// Returns the latest published statistics.
+            disk_stream_statistics_t Get();
+
+            /// Current time of a monotonic clock in microseconds.
+            static uint64_t Now();
+
+        private:
+            disk_stream_statistics_t Recorded;  ///< Accumulated by the disk thread.
+            disk_stream_statistics_t Published; ///< Snapshot of @c Recorded for all other threads.
+            Mutex                    PublishedMutex; ///< Protects @c Published.
+            uint64_t                 BytesReadAtSecondStart;
+            uint64_t                 SecondStart; ///< Begin of the current bytes per second measurement period (in microseconds).
+            atomic_t                 LateStreams;   ///< Wraps around, accumulated by Update() into @c Recorded.
+            atomic_t                 Underruns;     ///< Wraps around, accumulated by Update() into @c Recorded.
+            atomic_t                 KilledStreams; ///< Wraps around, accumulated by Update() into @c Recorded.
+            uint                     LastLateStreams; ///< Value of @c LateStreams at the previous Update() call.
+            uint                     LastUnderruns;
+            uint                     LastKilledStreams;
+
+            static void Accumulate(atomic_t& Counter, uint& Last, uint64_t& Total);
+    };
+
+} // namespace LinuxSampler
+
+#endif // LS_DISKSTATISTICS_H
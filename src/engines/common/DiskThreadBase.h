@@ -29,12 +29,17 @@
 #include <map>
 
 #include "StreamBase.h"
+#include "StreamBufferSlab.h"
+#include "DiskStatistics.h"
+#include "StreamDecoderPool.h"
 #include "../EngineChannel.h"
 #include "../InstrumentManagerBase.h"
 
 #include "../../common/global_private.h"
 
 #include "../../common/Thread.h"
+#include "../../common/NUMA.h"
+#include "../../common/lsatomic.h"
 #include "../../common/RingBuffer.h"
 #include "../../common/atomic.h"
 
@@ -54,6 +59,13 @@ namespace LinuxSampler {
     template <class R /* Resource */, class IM /* Instrument Manager */>
     class DiskThreadBase : public Thread {
         private:
+            // Private Constants
+            enum {
+                PREFETCH_QUEUE_SIZE   = 128, ///< Max. amount of pending prefetch commands.
+                PREFETCH_PER_RUN      = 16,  ///< Max. amount of prefetch commands processed in each loop run.
+                PREFETCH_HISTORY_SIZE = 64   ///< Amount of recently processed prefetch commands remembered.
+            };
+
             // Private Types
             struct create_command_t {
                 Stream::OrderID_t    OrderID;
@@ -62,6 +74,7 @@ namespace LinuxSampler {
                 R*                   pRegion;
                 unsigned long        SampleOffset;
                 bool                 DoLoop;
+                float                Pitch;
             };
             struct delete_command_t {
                 Stream*           pStream;
@@ -69,6 +82,11 @@ namespace LinuxSampler {
                 Stream::OrderID_t OrderID;
                 bool              bNotify;
             };
+            struct prefetch_command_t {
+                R*                   pRegion;
+                unsigned long        SampleOffset;
+                const void*          pKey; ///< Identifies the MIDI key the prefetch was ordered for (never dereferenced).
+            };
             struct program_change_command_t {
                 uint32_t Program;
                 EngineChannel* pEngineChannel;
@@ -82,9 +100,16 @@ namespace LinuxSampler {
             RingBuffer<Stream::Handle,false>    DeletionNotificationQueue;          ///< In case the original sender requested a notification for its stream deletion order, this queue will receive the handle of the respective stream once actually be deleted by the disk thread.
             RingBuffer<R*,false>*               DeleteRegionQueue;          ///< Contains dimension regions that are not used anymore and should be handed back to the instrument resource manager
             RingBuffer<program_change_command_t,false> ProgramChangeQueue;          ///< Contains requests for MIDI program change
+            RingBuffer<prefetch_command_t,false> PrefetchQueue;                     ///< Contains requests for warming up the beginning of disk streams which will probably be ordered soon
+            prefetch_command_t             RecentPrefetches[PREFETCH_HISTORY_SIZE]; ///< The latest processed prefetch commands, to avoid warming up the same sample part again and again.
+            int                            RecentPrefetchIndex;
             unsigned int                   RefillStreamsPerRun;                    ///< How many streams should be refilled in each loop run
             Stream**                       pStreams; ///< Contains all disk streams (whether used or unused)
             Stream**                       pCreatedStreams; ///< This is where the voice (audio thread) picks up it's meanwhile hopefully created disk stream.
+            StreamBufferSlab*              pBufferSlab; ///< Memory the ring buffers of all launched disk streams are taken from.
+            uint8_t*                       pSilence; ///< Zeroed memory voices may read from while they are waiting for their disk stream.
+            DiskStatistics                 Statistics; ///< Read latencies, throughput, buffer fills and late streams of this disk thread.
+            std::vector<StreamDecoderPool::job_t> RefillJobs; ///< Refills of the current disk thread cycle.
             static Stream*                 SLOT_RESERVED;                          ///< This value is used to mark an entry in pCreatedStreams[] as reserved.
 
             // Methods
@@ -103,7 +128,11 @@ namespace LinuxSampler {
                     std::cerr << ") - report if this happens, this is a bug!\n" << std::flush;
                     return;
                 }
+                // in case the sweep in Main() didn't catch it yet
+                RecordMinFill(newstream);
+                ReleaseBuffer(newstream);
                 LaunchStream(newstream, Command.hStream, Command.pStreamRef, Command.pRegion, Command.SampleOffset, Command.DoLoop);
+                if (!newstream->IsMapped()) AssignBuffer(newstream, Command);
                 dmsg(4,("new Stream launched by disk thread (OrderID:%d,StreamHandle:%d)\n", Command.OrderID, Command.hStream));
                 if (pCreatedStreams[Command.OrderID] != SLOT_RESERVED) {
                     std::cerr << "DiskThread: Slot " << Command.OrderID << " already occupied! Please report this!\n" << std::flush;
@@ -163,15 +192,138 @@ namespace LinuxSampler {
                         // size to CONFIG_STREAM_MAX_REFILL_SIZE which is by default 65536 samples = 256KBytes
                         if (writespace > CONFIG_STREAM_MAX_REFILL_SIZE) capped_writespace = CONFIG_STREAM_MAX_REFILL_SIZE;
 
+                        StreamDecoderPool::job_t job;
+                        job.pStream      = pStreams[i];
                         // adjust the amount to read in order to ensure that the buffer wraps correctly
-                        int read_amount = pStreams[i]->AdjustWriteSpaceToAvoidBoundary(writespace, capped_writespace);
-                        // if we wasn't able to refill one of the stream buffers by more than
-                        // CONFIG_STREAM_MIN_REFILL_SIZE we'll send the disk thread to sleep later
-                        if (pStreams[i]->ReadAhead(read_amount) > CONFIG_STREAM_MIN_REFILL_SIZE) this->IsIdle = false;
+                        job.ReadAmount   = pStreams[i]->AdjustWriteSpaceToAvoidBoundary(writespace, capped_writespace);
+                        job.pSource      = pStreams[i]->GetReadSource();
+                        job.Decode       = pStreams[i]->IsCompressed();
+                        job.Read         = 0;
+                        job.Microseconds = 0;
+                        RefillJobs.push_back(job);
+                    }
+                }
+                if (RefillJobs.empty()) return;
+
+                // compressed streams are decoded in parallel by the decoder
+                // pool, while this thread reads the uncompressed ones
+                StreamDecoderPool::Run(&RefillJobs[0], int(RefillJobs.size()));
+
+                for (size_t i = 0; i < RefillJobs.size(); i++) {
+                    const StreamDecoderPool::job_t& job = RefillJobs[i];
+                    Statistics.RecordRead(job.Microseconds, uint64_t(job.Read) * job.pStream->SampleInfo.BytesPerSample);
+                    // if we wasn't able to refill one of the stream buffers by more than
+                    // CONFIG_STREAM_MIN_REFILL_SIZE we'll send the disk thread to sleep later
+                    if (job.Read > CONFIG_STREAM_MIN_REFILL_SIZE) this->IsIdle = false;
+                }
+                RefillJobs.clear();
+            }
+
+            /**
+             * Attaches a ring buffer to the freshly launched stream
+             * @a pStream, sized according to the stream's sample format,
+             * channel count and expected pitch. Compared to the worst case
+             * buffer size (CONFIG_STREAM_BUFFER_SIZE sample points of 24 bit
+             * stereo) this saves a lot of memory for the common cases, and
+             * short one-shot samples only get the buffer they actually need.
+             *
+             * The pitch is only known at note-on, but may rise afterwards
+             * (pitch bend, pitch LFO, pitch EG), which drains the buffer
+             * faster. So the buffer is sized for the note-on pitch raised by
+             * CONFIG_STREAM_PITCH_HEADROOM octaves, at most for the maximum
+             * pitch a voice can reach (CONFIG_MAX_PITCH).
+             *
+             * If the slab is exhausted, the buffer is allocated from the heap
+             * instead (see StreamBufferSlab::Allocate()). That is acceptable
+             * here, since the disk thread is not a real-time thread, and it
+             * is better than not launching the stream at all. Such overflows
+             * are counted by the slab and indicate that the slab size
+             * (CONFIG_STREAM_SLAB_SIZE) is too small for the workload.
+             */
+            void AssignBuffer(Stream* pStream, const create_command_t& Command) {
+                const Stream::SampleDescription& info = pStream->SampleInfo;
+
+                // faster playback consumes the buffer faster
+                float pitch = Command.Pitch;
+                if (!(pitch >= 0.5f)) pitch = 0.5f; // also catches NaN
+                pitch *= float(1 << CONFIG_STREAM_PITCH_HEADROOM);
+                if (pitch > float(1 << CONFIG_MAX_PITCH)) pitch = float(1 << CONFIG_MAX_PITCH);
+
+                // CONFIG_STREAM_BUFFER_SIZE reflects the buffer needed by a
+                // stereo sample played at its original pitch
+                long words = long(float(CONFIG_STREAM_BUFFER_SIZE / 2) * info.ChannelsPerFrame * pitch);
+                if (words < CONFIG_STREAM_MAX_REFILL_SIZE) words = CONFIG_STREAM_MAX_REFILL_SIZE;
+
+                // a non-looped stream never needs more than the rest of its
+                // sample plus the silence added at its end
+                if (!Command.DoLoop && Command.SampleOffset < (unsigned long) info.TotalSampleCount) {
+                    const long left = long(info.TotalSampleCount - Command.SampleOffset) * info.ChannelsPerFrame + pStream->BufferWrapElements + 1;
+                    if (left < words) words = left;
+                }
+
+                int bytes = int(words * info.BytesPerSample);
+                if (bytes > CONFIG_STREAM_BUFFER_SIZE * 3) bytes = CONFIG_STREAM_BUFFER_SIZE * 3;
+
+                pStream->AttachBuffer(pBufferSlab->Allocate(pStream->GetBufferStorageSize(bytes)), bytes);
+            }
+
+            /**
+             * Processes pending prefetch commands. The latest prefetch order
+             * for a MIDI key supersedes all older pending ones for the same
+             * key (i.e. when the key was retriggered meanwhile). Sample parts
+             * warmed up very recently are skipped.
+             */
+            void ProcessPrefetchCommands() {
+                prefetch_command_t cmds[PREFETCH_PER_RUN];
+                int n = 0;
+                while (n < PREFETCH_PER_RUN && PrefetchQueue.read_space() > 0) {
+                    prefetch_command_t cmd;
+                    PrefetchQueue.pop(&cmd);
+                    int i = 0;
+                    for (; i < n && cmds[i].pKey != cmd.pKey; i++);
+                    cmds[i] = cmd;
+                    if (i == n) n++;
+                }
+                for (int i = 0; i < n; i++) {
+                    bool recent = false;
+                    for (int k = 0; k < PREFETCH_HISTORY_SIZE && !recent; k++) {
+                        recent = RecentPrefetches[k].pRegion == cmds[i].pRegion &&
+                                 RecentPrefetches[k].SampleOffset == cmds[i].SampleOffset;
                     }
+                    if (recent) continue;
+                    PrefetchStream(cmds[i].pRegion, cmds[i].SampleOffset);
+                    RecentPrefetches[RecentPrefetchIndex] = cmds[i];
+                    RecentPrefetchIndex = (RecentPrefetchIndex + 1) % PREFETCH_HISTORY_SIZE;
+                    this->IsIdle = false;
                 }
             }
 
+            /**
+             * Drops all pending prefetch commands and forgets about recently
+             * processed ones. Must be called before handing back regions,
+             * because prefetch commands might refer to them.
+             */
+            void ClearPrefetchCommands() {
+                while (PrefetchQueue.read_space() > 0) {
+                    prefetch_command_t cmd;
+                    PrefetchQueue.pop(&cmd);
+                }
+                memset(RecentPrefetches, 0, sizeof(RecentPrefetches));
+            }
+
+            /// Adds the lowest buffer fill of a stream no longer in use to the statistics.
+            void RecordMinFill(Stream* pStream) {
+                if (pStream->MinFillPercentage < 0) return; // voice never read from it
+                Statistics.RecordMinFill(pStream->MinFillPercentage);
+                pStream->MinFillPercentage = -1;
+            }
+
+            /// Hands back the ring buffer memory of a stream no longer in use to the slab.
+            void ReleaseBuffer(Stream* pStream) {
+                if (pStream->pBufferStorage)
+                    pBufferSlab->Free(pStream->DetachBuffer());
+            }
+
             Stream::Handle CreateHandle() {
                 static uint32_t counter = 1;
                 if (counter == 0xffffffff) counter = 1; // we use '0' as 'invalid handle' only, so we skip 0
@@ -193,14 +345,21 @@ namespace LinuxSampler {
             }
 
             atomic_t ActiveStreamCount;
+            atomic<int> iNumaNode;      ///< NUMA node this thread is assigned to, or -1.
+            int         iBoundNumaNode; ///< NUMA node this thread is currently bound to (only accessed by the disk thread).
         public:
             // Methods
             DiskThreadBase(int MaxStreams, uint BufferWrapElements, IM* pInstruments) :
                 Thread(true, false, 1, -2),
                 DeletionNotificationQueue(4*MaxStreams),
                 ProgramChangeQueue(512),
+                PrefetchQueue(PREFETCH_QUEUE_SIZE),
+                RecentPrefetchIndex(0),
+                iNumaNode(-1),
+                iBoundNumaNode(-1),
                 pInstruments(pInstruments)
             {
+                memset(RecentPrefetches, 0, sizeof(RecentPrefetches));
                 CreationQueue       = new RingBuffer<create_command_t,false>(4*MaxStreams);
                 DeletionQueue       = new RingBuffer<delete_command_t,false>(4*MaxStreams);
                 GhostQueue          = new RingBuffer<delete_command_t,false>(MaxStreams);
@@ -209,6 +368,19 @@ namespace LinuxSampler {
                 pCreatedStreams     = new Stream*[MaxStreams + 1];
                 Streams             = MaxStreams;
                 RefillStreamsPerRun = CONFIG_REFILL_STREAMS_PER_RUN;
+                RefillJobs.reserve(RefillStreamsPerRun);
+                StreamDecoderPool::Acquire();
+                // by default the slab provides as much memory as the former
+                // fixed buffers of all streams (24 bit worst case) occupied
+                pBufferSlab         = new StreamBufferSlab(
+                    size_t(MaxStreams) *
+                    RingBuffer<uint8_t,false>::storage_size(CONFIG_STREAM_BUFFER_SIZE * 3, BufferWrapElements * 3) /
+                    100 * CONFIG_STREAM_SLAB_SIZE
+                );
+                // enough silence for one audio fragment at max. pitch (and
+                // 24 bit stereo samples)
+                pSilence            = new uint8_t[BufferWrapElements * 3];
+                memset(pSilence, 0, BufferWrapElements * 3);
 
                 for (int i = 1; i <= MaxStreams; i++) {
                     pCreatedStreams[i] = NULL;
@@ -218,14 +390,20 @@ namespace LinuxSampler {
 
             virtual ~DiskThreadBase() {
                 for (int i = 0; i < Streams; i++) {
-                    if (pStreams[i]) delete pStreams[i];
+                    if (pStreams[i]) {
+                        ReleaseBuffer(pStreams[i]);
+                        delete pStreams[i];
+                    }
                 }
+                if (pBufferSlab) delete pBufferSlab;
+                if (pSilence) delete[] pSilence;
                 if (CreationQueue) delete CreationQueue;
                 if (DeletionQueue) delete DeletionQueue;
                 if (GhostQueue)    delete GhostQueue;
                 if (DeleteRegionQueue) delete DeleteRegionQueue;
                 if (pStreams)        delete[] pStreams;
                 if (pCreatedStreams) delete[] pCreatedStreams;
+                StreamDecoderPool::Release();
             }
 
 
@@ -254,6 +432,7 @@ namespace LinuxSampler {
                 DeletionNotificationQueue.init();
 
                 // make sure that all DimensionRegions are released
+                ClearPrefetchCommands();
                 while (DeleteRegionQueue->read_space() > 0) {
                     R* pRgn;
                     DeleteRegionQueue->pop(&pRgn);
@@ -288,7 +467,8 @@ namespace LinuxSampler {
                 std::stringstream ss;
                 for (uint i = 0; i < this->Streams; i++) {
                     if (pStreams[i]->GetState() == Stream::state_unused) continue;
-                    uint bufferfill = (uint) ((float) pStreams[i]->GetReadSpace() / (float) CONFIG_STREAM_BUFFER_SIZE * 100);
+                    const int buffersize = pStreams[i]->GetBufferSize();
+                    uint bufferfill = (buffersize) ? (uint) ((float) pStreams[i]->GetReadSpace() / (float) buffersize * 100) : 0;
                     uint streamid   = (uint) pStreams[i]->GetHandle();
                     if (!streamid) continue;
 
@@ -304,8 +484,11 @@ namespace LinuxSampler {
             /**
              * Returns -1 if command queue or pickup pool is full, 0 on success (will be
              * called by audio thread within the voice class).
+             *
+             * @param Pitch - expected playback pitch (as frequency ratio), used
+             *                to size the stream's buffer
              */
-            int OrderNewStream(Stream::reference_t* pStreamRef, R* pRegion, unsigned long SampleOffset, bool DoLoop) {
+            int OrderNewStream(Stream::reference_t* pStreamRef, R* pRegion, unsigned long SampleOffset, bool DoLoop, float Pitch = 1.0f) {
                 dmsg(4,("Disk Thread: new stream ordered\n"));
                 if (CreationQueue->write_space() < 1) {
                     dmsg(1,("DiskThread: Order queue full!\n"));
@@ -330,6 +513,7 @@ namespace LinuxSampler {
                 cmd.pRegion      = pRegion;
                 cmd.SampleOffset = SampleOffset;
                 cmd.DoLoop       = DoLoop;
+                cmd.Pitch        = Pitch;
 
                 CreationQueue->push(&cmd);
                 return 0;
@@ -381,6 +565,35 @@ namespace LinuxSampler {
                 return 0;
             }
 
+            /**
+             * Tell the disk thread to warm up the part of the sample of
+             * @a pRegion which a disk stream launched at @a SampleOffset
+             * would read first. This is used to prefetch samples which will
+             * probably be triggered soon (i.e. release trigger samples), so
+             * that their disk streams are launched and filled quickly then.
+             * Any older pending prefetch order for the same MIDI key is
+             * superseded by this one. (Called by audio thread.)
+             *
+             * @param pRegion      - region whose sample shall be warmed up
+             * @param SampleOffset - sample position (in sample points) the
+             *                       stream would be launched at
+             * @param pKey         - identifies the MIDI key the prefetch is
+             *                       ordered for
+             * @returns 0 on success, -1 if the prefetch queue is full
+             */
+            int OrderPrefetch(R* pRegion, unsigned long SampleOffset, const void* pKey) {
+                if (PrefetchQueue.write_space() < 1) {
+                    dmsg(4,("DiskThread: Prefetch queue full!\n"));
+                    return -1;
+                }
+                prefetch_command_t cmd;
+                cmd.pRegion      = pRegion;
+                cmd.SampleOffset = SampleOffset;
+                cmd.pKey         = pKey;
+                PrefetchQueue.push(&cmd);
+                return 0;
+            }
+
             /**
              * Tell the disk thread to do a program change on the specified
              * EngineChannel.
@@ -440,12 +653,46 @@ namespace LinuxSampler {
                 } else return Stream::INVALID_HANDLE; // no notification received yet
             }
 
+            /**
+             * Returns silence (sample data of value zero) for the voice
+             * (audio thread) to read from while its ordered disk stream was
+             * not launched yet. Sufficient for one audio fragment at max.
+             * pitch.
+             */
+            uint8_t* GetSilence() { return pSilence; }
+
+            /// Called by the voice (audio thread) when it starts waiting for its disk stream.
+            void ReportLateStream() { Statistics.ReportLateStream(); }
+
+            /// Called by the voice (audio thread) for each audio fragment it had to wait for its disk stream.
+            void ReportLateStreamUnderrun() { Statistics.ReportUnderrun(); }
+
+            /// Called by the voice (audio thread) if it gave up waiting for its disk stream.
+            void ReportLateStreamKill() { Statistics.ReportKill(); }
+
+            /// Returns the disk streaming statistics (as of the latest disk thread cycle).
+            disk_stream_statistics_t GetStatistics() { return Statistics.Get(); }
+
             // the number of streams currently in usage
             // printed on the console the main thread (along with the active voice count)
             uint GetActiveStreamCount() { return atomic_read(&ActiveStreamCount); }
             void SetActiveStreamCount(uint Streams) { atomic_set(&ActiveStreamCount, Streams); }
             int ActiveStreamCountMax;
 
+            /**
+             * Assigns this disk thread to NUMA node @a Node (-1 for none).
+             * The thread binds itself to the node with its next run, so the
+             * stream buffers it fills land on that node, and the stream
+             * buffer slab (which might already be populated, i.e. if the
+             * memory is locked) is moved to the node right away.
+             *
+             * @returns amount of bytes of the slab residing on @a Node
+             */
+            size_t SetNumaNode(int Node) {
+                iNumaNode.store(Node, memory_order_relaxed);
+                return (Node >= 0) ? pBufferSlab->MoveToNumaNode(Node) : 0;
+            }
+
         protected:
             IM* pInstruments;   ///< The instrument resource manager of the engine that is using this disk thread. Used by the dimension region deletion feature.
 
@@ -467,6 +714,14 @@ namespace LinuxSampler {
 
                     IsIdle = true; // will be set to false if a stream got filled
 
+                    #if CONFIG_NUMA
+                    // (re)bind this thread once it was assigned to a node
+                    if (iNumaNode.load(memory_order_relaxed) != iBoundNumaNode) {
+                        iBoundNumaNode = iNumaNode.load(memory_order_relaxed);
+                        NUMA::BindThread(iBoundNumaNode);
+                    }
+                    #endif
+
                     // prevent disk thread from being cancelled
                     // (e.g. to prevent deadlocks while holding mutex lock(s))
                     pushCancelable(false);
@@ -505,6 +760,8 @@ namespace LinuxSampler {
 
                     // release DimensionRegions that belong to instruments
                     // that are no longer loaded
+                    if (DeleteRegionQueue->read_space() > 0)
+                        ClearPrefetchCommands(); // they might refer to those regions
                     while (DeleteRegionQueue->read_space() > 0) {
                         R* pRgn;
                         DeleteRegionQueue->pop(&pRgn);
@@ -532,12 +789,29 @@ namespace LinuxSampler {
 
                     RefillStreams(); // refill the most empty streams
 
+                    // warm up streams which will probably be ordered soon
+                    // (with less priority than refilling the active streams)
+                    ProcessPrefetchCommands();
+
+                    #if CONFIG_LAZY_PRELOAD
+                    // preload samples of lazily loaded instruments, one per
+                    // run, so refilling the streams is not delayed by it
+                    if (CacheLazySample()) IsIdle = false;
+                    #endif
+
                     int streamsInUsage = 0;
                     for (int i = Streams - 1; i >= 0; i--) {
-                        if (pStreams[i]->GetState() != Stream::state_unused) streamsInUsage++;
+                        if (pStreams[i]->GetState() != Stream::state_unused) {
+                            streamsInUsage++;
+                            continue;
+                        }
+                        // stream was killed or reached its end
+                        RecordMinFill(pStreams[i]);
+                        ReleaseBuffer(pStreams[i]);
                     }
                     SetActiveStreamCount(streamsInUsage);
                     if (streamsInUsage > ActiveStreamCountMax) ActiveStreamCountMax = streamsInUsage;
+                    Statistics.Update();
 
                     // now allow disk thread being cancelled again
                     // (since all mutexes are now unlocked and data structures
@@ -570,6 +844,22 @@ namespace LinuxSampler {
                 bool                  DoLoop
             ) = 0;
 
+            /**
+             * Warms up the beginning of a disk stream for @a pRgn launched at
+             * @a SampleOffset, without launching a stream (see OrderPrefetch()).
+             * Does nothing by default.
+             */
+            virtual void PrefetchStream(R* pRgn, unsigned long SampleOffset) { }
+
+            /**
+             * Preloads the initial sample points of the next sample whose
+             * preloading was deferred by the instrument manager (see
+             * @c CONFIG_LAZY_PRELOAD). Does nothing by default.
+             *
+             * @returns true if a sample was preloaded
+             */
+            virtual bool CacheLazySample() { return false; }
+
             friend class Stream;
     };
 } // namespace LinuxSampler
@@ -0,0 +1,154 @@
+/*
+ * Copyright (c) 2020 Christian Schoenebeck
+ *
+ * http://www.linuxsampler.org
+ *
+ * This file is part of LinuxSampler and released under the same terms.
+ * See README file for details.
+ */
+
+#include "MappedSample.h"
+
+#if CONFIG_MMAP_STREAMING
+
+#include <sys/types.h>
+#include <sys/stat.h>
+#include <sys/mman.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <string.h>
+#include <errno.h>
+
+#ifndef MAP_ANONYMOUS
+# define MAP_ANONYMOUS MAP_ANON
+#endif
+
+namespace LinuxSampler {
+
+    MappedSample::MappedSample() :
+        RefCount(1), pBase(NULL), BaseSize(0), pData(NULL), Size(0), NullExtensionSize(0)
+    {
+    }
+
+    MappedSample::~MappedSample() {
+        Unmap();
+    }
+
+    void MappedSample::Retain() {
+        RefCount.fetch_add(1, std::memory_order_relaxed);
+    }
+
+    void MappedSample::Release() {
+        if (RefCount.fetch_sub(1, std::memory_order_acq_rel) == 1)
+            delete this;
+    }
+
+    size_t MappedSample::PageSize() {
+        static const size_t pageSize = (size_t) sysconf(_SC_PAGESIZE);
+        return pageSize;
+    }
+
+    bool MappedSample::Map(const String& File, uint64_t DataOffset, size_t DataSize, size_t NullExtensionSize) {
+        Unmap();
+        if (!DataSize) return false;
+
+        const int fd = open(File.c_str(), O_RDONLY);
+        if (fd < 0) {
+            dmsg(1,("MappedSample: could not open '%s': %s\n", File.c_str(), strerror(errno)));
+            return false;
+        }
+        struct stat st;
+        if (fstat(fd, &st) || uint64_t(st.st_size) < DataOffset + DataSize) {
+            dmsg(1,("MappedSample: '%s' is smaller than expected\n", File.c_str()));
+            close(fd);
+            return false;
+        }
+
+        const size_t   pageSize      = PageSize();
+        const uint64_t alignedOffset = DataOffset - DataOffset % pageSize;
+        const size_t   head          = size_t(DataOffset - alignedOffset);
+        const size_t   fileBytes     = head + DataSize;
+        const size_t   length        = (fileBytes + NullExtensionSize + pageSize - 1) / pageSize * pageSize;
+
+        // reserve the whole address range with zero filled anonymous memory
+        // first, the sample data is then mapped over it, so that everything
+        // behind the sample data reads as silence
+        uint8_t* base = (uint8_t*) mmap(NULL, length, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+        if (base == MAP_FAILED) {
+            dmsg(1,("MappedSample: could not reserve %lu bytes: %s\n", (unsigned long) length, strerror(errno)));
+            close(fd);
+            return false;
+        }
+
+        // map all complete pages of the sample data directly from the file
+        const size_t mappedBytes = fileBytes - fileBytes % pageSize;
+        if (mappedBytes &&
+            mmap(base, mappedBytes, PROT_READ, MAP_PRIVATE | MAP_FIXED, fd, off_t(alignedOffset)) == MAP_FAILED)
+        {
+            dmsg(1,("MappedSample: could not map '%s': %s\n", File.c_str(), strerror(errno)));
+            munmap(base, length);
+            close(fd);
+            return false;
+        }
+
+        // the last, incomplete page is copied instead, otherwise it would
+        // expose whatever follows the sample data in the file where the null
+        // extension is expected
+        const size_t tailBytes = fileBytes - mappedBytes;
+        if (tailBytes &&
+            pread(fd, base + mappedBytes, tailBytes, off_t(alignedOffset + mappedBytes)) != ssize_t(tailBytes))
+        {
+            dmsg(1,("MappedSample: could not read '%s': %s\n", File.c_str(), strerror(errno)));
+            munmap(base, length);
+            close(fd);
+            return false;
+        }
+        if (length > mappedBytes)
+            mprotect(base + mappedBytes, length - mappedBytes, PROT_READ);
+
+        // the mapping remains valid after closing the file descriptor
+        close(fd);
+
+        pBase    = base;
+        BaseSize = length;
+        pData    = base + head;
+        Size     = DataSize;
+        this->NullExtensionSize = length - fileBytes;
+        return true;
+    }
+
+    void MappedSample::Unmap() {
+        if (!pBase) return;
+        munmap(pBase, BaseSize);
+        pBase    = NULL;
+        BaseSize = 0;
+        pData    = NULL;
+        Size     = 0;
+        NullExtensionSize = 0;
+    }
+
+    void MappedSample::Prefetch(size_t Offset, size_t Bytes) {
+        if (!pData || Offset >= Size) return;
+        if (Offset + Bytes > Size) Bytes = Size - Offset;
+        const size_t pageSize = PageSize();
+        uint8_t* begin = pData + Offset;
+        uint8_t* alignedBegin = begin - size_t(begin - pBase) % pageSize;
+        madvise(alignedBegin, Bytes + size_t(begin - alignedBegin), MADV_WILLNEED);
+    }
+
+    void MappedSample::Prefault(size_t Offset, size_t Bytes) {
+        if (!pData || Offset >= Size) return;
+        if (Offset + Bytes > Size) Bytes = Size - Offset;
+        const size_t pageSize = PageSize();
+        const volatile uint8_t* p   = pData + Offset;
+        const volatile uint8_t* end = p + Bytes;
+        uint8_t sum = 0;
+        for (; p < end; p += pageSize) sum += *p;
+        // also touch the last page, which might have been skipped above
+        sum += *(end - 1);
+        (void) sum;
+    }
+
+} // namespace LinuxSampler
+
+#endif // CONFIG_MMAP_STREAMING
@@ -0,0 +1,119 @@
+/*
+ * Copyright (c) 2020 Christian Schoenebeck
+ *
+ * http://www.linuxsampler.org
+ *
+ * This file is part of LinuxSampler and released under the same terms.
+ * See README file for details.
+ */
+
+#ifndef LS_MAPPEDSAMPLE_H
+#define LS_MAPPEDSAMPLE_H
+
+#include "../../common/global_private.h"
+
+#if CONFIG_MMAP_STREAMING
+
+#include <stddef.h>
+#include <atomic>
+
+namespace LinuxSampler {
+
+    /** @brief Read-only memory mapping of uncompressed sample wave data.
+     *
+     * Maps the raw (uncompressed) wave data of one sample file region
+     * read-only into the address space, so disk streams can be served
+     * directly from the page cache without copying the data into a stream's
+     * ring buffer first. The mapping is always followed by a zero filled
+     * null extension of the requested size, which is required by the
+     * interpolators reading past the end of the sample data (the same way
+     * as with the RAM caches of samples).
+     *
+     * Mapping is only useful for uncompressed sample data which is stored
+     * in the file in exactly the format the synthesis code expects (that is
+     * 16 bit or 24 bit little endian PCM). It is the caller's
+     * responsibility to check that condition before calling Map().
+     *
+     * All methods except Prefetch() and Prefault() must only be called by
+     * non real-time threads, since they might block on system calls.
+     *
+     * Objects are reference counted, since disk streams might still be
+     * reading a mapping while its owner already drops it (i.e. because the
+     * instrument was unloaded). The owner holds the initial reference, each
+     * stream playing from the mapping holds another one (see Retain() and
+     * Release()). So objects must be created with @c new and must never be
+     * deleted directly. Likewise Map() must only be called before the object
+     * was shared with other threads.
+     */
+    class MappedSample {
+        public:
+            MappedSample();
+
+            /// Adds a reference to this mapping.
+            void Retain();
+
+            /**
+             * Drops a reference to this mapping. The last one unmaps the
+             * sample data and deletes this object.
+             */
+            void Release();
+
+            /**
+             * Maps @a DataSize bytes of the file @a File, starting at byte
+             * position @a DataOffset, and appends @a NullExtensionSize bytes
+             * of silence behind them. An already existing mapping of this
+             * object is released before.
+             *
+             * @returns true on success, false if the file could not be mapped
+             *          (the object remains unmapped in this case)
+             */
+            bool Map(const String& File, uint64_t DataOffset, size_t DataSize, size_t NullExtensionSize);
+
+            /// Releases the mapping (if any).
+            void Unmap();
+
+            inline bool IsMapped() const { return pData; }
+
+            /// Start of the mapped sample data.
+            inline uint8_t* GetData() const { return pData; }
+
+            /// Size of the mapped sample data in bytes (without null extension).
+            inline size_t GetSize() const { return Size; }
+
+            /// Size of the silence appended after the sample data in bytes.
+            inline size_t GetNullExtensionSize() const { return NullExtensionSize; }
+
+            /**
+             * Tells the kernel that the given data range will be accessed
+             * soon (@c MADV_WILLNEED), so it can start reading it from disk
+             * asynchronously. Does not block.
+             */
+            void Prefetch(size_t Offset, size_t Bytes);
+
+            /**
+             * Touches each page of the given data range, so that all of them
+             * are resident in memory after this call returns. This will block
+             * on page faults, so only call this from the disk thread.
+             */
+            void Prefault(size_t Offset, size_t Bytes);
+
+            /// Page size of the system in bytes.
+            static size_t PageSize();
+
+        protected:
+            virtual ~MappedSample();
+
+        private:
+            std::atomic<int> RefCount;  ///< Owner and streams currently holding a reference.
+            uint8_t* pBase;             ///< Start of the whole mapped address range (page aligned).
+            size_t   BaseSize;          ///< Size of the whole mapped address range in bytes.
+            uint8_t* pData;             ///< Start of the sample data within the mapped address range.
+            size_t   Size;
+            size_t   NullExtensionSize;
+    };
+
+} // namespace LinuxSampler
+
+#endif // CONFIG_MMAP_STREAMING
+
+#endif // LS_MAPPEDSAMPLE_H
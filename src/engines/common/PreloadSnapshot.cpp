@@ -0,0 +1,376 @@
+/*
+ * Copyright (c) 2020 Christian Schoenebeck
+ *
+ * http://www.linuxsampler.org
+ *
+ * This file is part of LinuxSampler and released under the same terms.
+ * See README file for details.
+ */
+
+#include "PreloadSnapshot.h"
+
+#if CONFIG_PRELOAD_SNAPSHOT
+
+#include <sys/types.h>
+#include <sys/stat.h>
+#include <sys/mman.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <errno.h>
+#include <string.h>
+
+namespace LinuxSampler {
+
+    Mutex                                                          PreloadSnapshot::SnapshotMutex;
+    String                                                         PreloadSnapshot::File;
+    uint8_t*                                                       PreloadSnapshot::pMap = NULL;
+    size_t                                                         PreloadSnapshot::MapSize = 0;
+    std::map<PreloadSnapshot::key_t,PreloadSnapshot::entry_t>      PreloadSnapshot::Entries;
+    bool                                                           PreloadSnapshot::bModified = false;
+    std::map<String,PreloadSnapshot::source_stat_t>                PreloadSnapshot::LoadedSources;
+    Mutex                                                          PreloadSnapshot::ProvidersMutex;
+    std::set<PreloadSnapshot::Provider*>                           PreloadSnapshot::Providers;
+    Mutex                                                          PreloadSnapshot::SaveMutex;
+
+    static const char SNAPSHOT_MAGIC[8] = { 'L', 'S', 'P', 'R', 'E', 'L', 'O', 'D' };
+    static const uint32_t SNAPSHOT_VERSION = 1;
+    static const uint32_t INVALID_SOURCE = 0xffffffff;
+
+    struct snapshot_header_t {
+        char     Magic[8];
+        uint32_t Version;
+        uint32_t Reserved;
+        uint64_t IndexOffset;
+        uint64_t IndexSize;
+    };
+
+    // sequentially parses the index of a mapped snapshot file
+    class IndexReader {
+    public:
+        IndexReader(const uint8_t* pData, uint64_t Size) : pData(pData), Size(Size), Pos(0), bError(false) {}
+
+        template<class T> T Get() {
+            T value = T();
+            if (Size - Pos < sizeof(T)) bError = true;
+            if (bError) return value;
+            memcpy(&value, pData + Pos, sizeof(T));
+            Pos += sizeof(T);
+            return value;
+        }
+
+        String GetString() {
+            const uint32_t len = Get<uint32_t>();
+            if (Size - Pos < len) bError = true;
+            if (bError) return String();
+            String s((const char*) pData + Pos, len);
+            Pos += len;
+            return s;
+        }
+
+        bool Failed() const { return bError; }
+
+    private:
+        const uint8_t* pData;
+        uint64_t       Size;
+        uint64_t       Pos;
+        bool           bError;
+    };
+
+    template<class T>
+    static void WriteValue(FILE* hFile, const T& value, bool& bError) {
+        if (fwrite(&value, sizeof(T), 1, hFile) != 1) bError = true;
+    }
+
+    uint64_t PreloadSnapshot::Checksum(const void* pData, uint64_t Size) {
+        const uint64_t prime = 1099511628211ULL;
+        uint64_t hash = 14695981039346656037ULL;
+        const uint8_t* p = (const uint8_t*) pData;
+        // word wise to keep up with memcpy() speed, the rest byte wise
+        for (; Size >= sizeof(uint64_t); Size -= sizeof(uint64_t), p += sizeof(uint64_t)) {
+            uint64_t word;
+            memcpy(&word, p, sizeof(word));
+            hash = (hash ^ word) * prime;
+        }
+        for (; Size; --Size, ++p) hash = (hash ^ *p) * prime;
+        return hash;
+    }
+
+    void PreloadSnapshot::SetFile(const String& File) {
+        LockGuard lock(SnapshotMutex);
+        Unmap();
+        PreloadSnapshot::File = File;
+        Map();
+    }
+
+    bool PreloadSnapshot::IsEnabled() {
+        LockGuard lock(SnapshotMutex);
+        return !File.empty();
+    }
+
+    /// Maps the snapshot file and reads its index. SnapshotMutex must be locked by the caller.
+    void PreloadSnapshot::Map() {
+        if (File.empty()) return;
+        const int fd = open(File.c_str(), O_RDONLY);
+        if (fd < 0) {
+            dmsg(1,("No preload snapshot '%s' yet.\n", File.c_str()));
+            return;
+        }
+        struct stat st;
+        if (fstat(fd, &st) || size_t(st.st_size) < sizeof(snapshot_header_t)) {
+            close(fd);
+            return;
+        }
+        void* p = mmap(NULL, size_t(st.st_size), PROT_READ, MAP_SHARED, fd, 0);
+        close(fd);
+        if (p == MAP_FAILED) {
+            std::cerr << "Could not map preload snapshot '" << File << "': " << strerror(errno) << std::endl << std::flush;
+            return;
+        }
+        pMap    = (uint8_t*) p;
+        MapSize = size_t(st.st_size);
+
+        snapshot_header_t header;
+        memcpy(&header, pMap, sizeof(header));
+        if (memcmp(header.Magic, SNAPSHOT_MAGIC, sizeof(SNAPSHOT_MAGIC)) ||
+            header.Version != SNAPSHOT_VERSION ||
+            header.IndexOffset > MapSize || header.IndexSize > MapSize - header.IndexOffset)
+        {
+            std::cerr << "Ignoring invalid preload snapshot '" << File << "'." << std::endl << std::flush;
+            Unmap();
+            return;
+        }
+
+        // let the system read the whole snapshot ahead in one go
+        madvise(pMap, MapSize, MADV_WILLNEED);
+
+        IndexReader index(pMap + header.IndexOffset, header.IndexSize);
+        std::vector<String> sources;
+        std::vector<bool> valid;
+        const uint32_t sourceCount = index.Get<uint32_t>();
+        for (uint32_t i = 0; i < sourceCount && !index.Failed(); i++) {
+            const String source = index.GetString();
+            const int64_t mtime = index.Get<int64_t>();
+            const uint64_t size = index.Get<uint64_t>();
+            // ignore all data of instrument files changed since then
+            struct stat st;
+            const bool bValid = !stat(source.c_str(), &st) &&
+                                int64_t(st.st_mtime) == mtime && uint64_t(st.st_size) == size;
+            if (!bValid) dmsg(1,("Preload snapshot of '%s' is outdated.\n", source.c_str()));
+            sources.push_back(source);
+            valid.push_back(bValid);
+        }
+        const uint64_t entryCount = index.Get<uint64_t>();
+        for (uint64_t i = 0; i < entryCount && !index.Failed(); i++) {
+            const uint32_t source = index.Get<uint32_t>();
+            key_t key;
+            entry_t entry;
+            key.SampleID     = index.Get<uint64_t>();
+            entry.DataOffset = index.Get<uint64_t>();
+            entry.Size       = index.Get<uint64_t>();
+            entry.Checksum   = index.Get<uint64_t>();
+            if (index.Failed() || source >= sources.size() || !valid[source]) continue;
+            if (entry.DataOffset > header.IndexOffset || entry.Size > header.IndexOffset - entry.DataOffset) continue;
+            key.File = sources[source];
+            Entries[key] = entry;
+        }
+        if (index.Failed())
+            std::cerr << "Preload snapshot '" << File << "' is truncated." << std::endl << std::flush;
+        dmsg(1,("Preload snapshot '%s' provides %d samples.\n", File.c_str(), int(Entries.size())));
+    }
+
+    /// SnapshotMutex must be locked by the caller.
+    void PreloadSnapshot::Unmap() {
+        if (pMap) munmap(pMap, MapSize);
+        pMap    = NULL;
+        MapSize = 0;
+        Entries.clear();
+    }
+
+    bool PreloadSnapshot::Contains(const String& SourceFile, uint64_t SampleID, uint64_t Size) {
+        LockGuard lock(SnapshotMutex);
+        key_t key;
+        key.File     = SourceFile;
+        key.SampleID = SampleID;
+        std::map<key_t,entry_t>::iterator it = Entries.find(key);
+        return it != Entries.end() && it->second.Size == Size;
+    }
+
+    bool PreloadSnapshot::Read(const String& SourceFile, uint64_t SampleID, void* pDest, uint64_t Size) {
+        LockGuard lock(SnapshotMutex);
+        if (!pMap) return false;
+        key_t key;
+        key.File     = SourceFile;
+        key.SampleID = SampleID;
+        std::map<key_t,entry_t>::iterator it = Entries.find(key);
+        if (it == Entries.end() || it->second.Size != Size) return false;
+        memcpy(pDest, pMap + it->second.DataOffset, size_t(Size));
+        if (Checksum(pDest, Size) != it->second.Checksum) {
+            std::cerr << "Preload snapshot data of sample " << SampleID << " of '"
+                      << SourceFile << "' is corrupt." << std::endl << std::flush;
+            Entries.erase(it);
+            return false;
+        }
+        return true;
+    }
+
+    void PreloadSnapshot::AddProvider(Provider* pProvider) {
+        LockGuard lock(ProvidersMutex);
+        Providers.insert(pProvider);
+    }
+
+    void PreloadSnapshot::SourceLoaded(const String& SourceFile) {
+        struct stat st;
+        const bool bStat = !stat(SourceFile.c_str(), &st);
+        LockGuard lock(SnapshotMutex);
+        if (File.empty()) return;
+        if (!bStat) {
+            LoadedSources.erase(SourceFile);
+            return;
+        }
+        source_stat_t& source = LoadedSources[SourceFile];
+        source.ModificationTime = int64_t(st.st_mtime);
+        source.Size             = uint64_t(st.st_size);
+    }
+
+    bool PreloadSnapshot::GetLoadedSource(const String& SourceFile, source_stat_t& stat) {
+        LockGuard lock(SnapshotMutex);
+        std::map<String,source_stat_t>::iterator it = LoadedSources.find(SourceFile);
+        if (it == LoadedSources.end()) return false;
+        stat = it->second;
+        return true;
+    }
+
+    void PreloadSnapshot::SetModified() {
+        LockGuard lock(SnapshotMutex);
+        if (!File.empty()) bModified = true;
+    }
+
+    void PreloadSnapshot::SaveIfModified() {
+        String file;
+        {
+            LockGuard lock(SnapshotMutex);
+            if (!bModified || File.empty()) return;
+            bModified = false;
+            file = File;
+        }
+        // providers are never removed, but they might be added meanwhile by
+        // instrument managers holding their own locks, so don't block them
+        std::set<Provider*> providers;
+        {
+            LockGuard lock(ProvidersMutex);
+            providers = Providers;
+        }
+        LockGuard lock(SaveMutex);
+        Writer writer;
+        if (!writer.Open(file)) return;
+        for (std::set<Provider*>::iterator it = providers.begin(); it != providers.end(); ++it)
+            (*it)->WritePreloadSnapshot(writer);
+        if (writer.Close()) dmsg(1,("Preload snapshot '%s' written.\n", file.c_str()));
+    }
+
+    PreloadSnapshot::Writer::Writer() : hFile(NULL), Offset(0), bError(false) {
+    }
+
+    PreloadSnapshot::Writer::~Writer() {
+        if (!hFile) return;
+        // not closed, so discard the incomplete snapshot
+        fclose(hFile);
+        unlink(TempFile.c_str());
+    }
+
+    bool PreloadSnapshot::Writer::Open(const String& File) {
+        this->File = File;
+        TempFile   = File + ".tmp";
+        hFile = fopen(TempFile.c_str(), "wb");
+        if (!hFile) {
+            std::cerr << "Could not create preload snapshot '" << TempFile << "': " << strerror(errno) << std::endl << std::flush;
+            return false;
+        }
+        // the header is written again by Close() once the index position is known
+        snapshot_header_t header = {};
+        WriteValue(hFile, header, bError);
+        Offset = sizeof(header);
+        return !bError;
+    }
+
+    void PreloadSnapshot::Writer::Add(const String& SourceFile, uint64_t SampleID, const void* pData, uint64_t Size) {
+        if (!hFile || bError || !Size) return;
+
+        std::map<String,uint32_t>::iterator it = SourceIndex.find(SourceFile);
+        if (it == SourceIndex.end()) {
+            uint32_t index = INVALID_SOURCE;
+            // the file might have been modified since the data was loaded
+            // from it, so its state at that time is stored
+            source_stat_t stat;
+            if (GetLoadedSource(SourceFile, stat)) {
+                source_t source;
+                source.File             = SourceFile;
+                source.ModificationTime = stat.ModificationTime;
+                source.Size             = stat.Size;
+                index = uint32_t(Sources.size());
+                Sources.push_back(source);
+            }
+            it = SourceIndex.insert(std::make_pair(SourceFile, index)).first;
+        }
+        if (it->second == INVALID_SOURCE) return;
+
+        if (fwrite(pData, 1, size_t(Size), hFile) != size_t(Size)) {
+            bError = true;
+            return;
+        }
+        entry_t entry;
+        entry.Source     = it->second;
+        entry.SampleID   = SampleID;
+        entry.DataOffset = Offset;
+        entry.Size       = Size;
+        entry.Checksum   = Checksum(pData, Size);
+        Entries.push_back(entry);
+        Offset += Size;
+    }
+
+    bool PreloadSnapshot::Writer::Close() {
+        if (!hFile) return false;
+
+        snapshot_header_t header = {};
+        memcpy(header.Magic, SNAPSHOT_MAGIC, sizeof(SNAPSHOT_MAGIC));
+        header.Version     = SNAPSHOT_VERSION;
+        header.IndexOffset = Offset;
+
+        WriteValue(hFile, uint32_t(Sources.size()), bError);
+        for (size_t i = 0; i < Sources.size(); i++) {
+            WriteValue(hFile, uint32_t(Sources[i].File.size()), bError);
+            if (fwrite(Sources[i].File.data(), 1, Sources[i].File.size(), hFile) != Sources[i].File.size())
+                bError = true;
+            WriteValue(hFile, Sources[i].ModificationTime, bError);
+            WriteValue(hFile, Sources[i].Size, bError);
+        }
+        WriteValue(hFile, uint64_t(Entries.size()), bError);
+        for (size_t i = 0; i < Entries.size(); i++) {
+            WriteValue(hFile, Entries[i].Source, bError);
+            WriteValue(hFile, Entries[i].SampleID, bError);
+            WriteValue(hFile, Entries[i].DataOffset, bError);
+            WriteValue(hFile, Entries[i].Size, bError);
+            WriteValue(hFile, Entries[i].Checksum, bError);
+        }
+        header.IndexSize = sizeof(uint32_t) + sizeof(uint64_t) + Entries.size() * (sizeof(uint32_t) + 4 * sizeof(uint64_t));
+        for (size_t i = 0; i < Sources.size(); i++)
+            header.IndexSize += sizeof(uint32_t) + Sources[i].File.size() + sizeof(int64_t) + sizeof(uint64_t);
+
+        if (fseek(hFile, 0, SEEK_SET)) bError = true;
+        WriteValue(hFile, header, bError);
+        if (fflush(hFile) || fsync(fileno(hFile))) bError = true;
+        if (fclose(hFile)) bError = true;
+        hFile = NULL;
+
+        // only replace the previous snapshot by a complete one
+        if (bError || rename(TempFile.c_str(), File.c_str())) {
+            std::cerr << "Could not write preload snapshot '" << File << "': " << strerror(errno) << std::endl << std::flush;
+            unlink(TempFile.c_str());
+            return false;
+        }
+        return true;
+    }
+
+} // namespace LinuxSampler
+
+#endif // CONFIG_PRELOAD_SNAPSHOT
@@ -0,0 +1,197 @@
+/*
+ * Copyright (c) 2020 Christian Schoenebeck
+ *
+ * http://www.linuxsampler.org
+ *
+ * This file is part of LinuxSampler and released under the same terms.
+ * See README file for details.
+ */
+
+#ifndef LS_PRELOADSNAPSHOT_H
+#define LS_PRELOADSNAPSHOT_H
+
+#include "../../common/global_private.h"
+
+#if CONFIG_PRELOAD_SNAPSHOT
+
+#include "../../common/Mutex.h"
+#include <stdio.h>
+#include <map>
+#include <set>
+#include <vector>
+
+namespace LinuxSampler {
+
+    /** @brief Persistent snapshot of the preloaded sample data of a session.
+     *
+     * When an instrument is loaded, the initial sample points of each of
+     * its samples are read into RAM (see @c CONFIG_PRELOAD_SAMPLES), which
+     * requires a small read for each sample, scattered all over large
+     * instrument files. The preload snapshot file stores the preloaded data
+     * of all samples of all loaded instruments contiguously in one file
+     * instead, so when the sampler is restarted with the same instruments
+     * (i.e. after a crash), their preload data is copied from the memory
+     * mapped snapshot file, which the system reads ahead in one sequential
+     * pass.
+     *
+     * The snapshot file is written whenever the instrument manager thread
+     * went idle after any sample had to be preloaded from its instrument
+     * file. It consists of a header, the preload data of all samples stored
+     * one after another and an index at the end. Each index entry refers to
+     * one sample by the name of its instrument file and an ID of the sample
+     * which is unique within that file. Along with the index, the
+     * modification time and size each instrument file had when it was
+     * loaded are stored (see SourceLoaded()). Entries of instrument files
+     * whose modification time or size differ on startup are ignored, as
+     * well as entries whose data does not match the stored checksum; those
+     * samples are simply preloaded from their instrument file as usual.
+     *
+     * Snapshots are only meant to be used on the same machine they were
+     * written on, data is stored in native byte order.
+     */
+    class PreloadSnapshot {
+        public:
+            /// Writes the preload data of samples to a new snapshot file.
+            class Writer {
+                public:
+                    Writer();
+                    ~Writer();
+
+                    /**
+                     * Starts writing a new snapshot which replaces the
+                     * snapshot file @a File once Close() succeeded.
+                     */
+                    bool Open(const String& File);
+
+                    /**
+                     * Appends the preload data @a pData of @a Size bytes of
+                     * the sample with ID @a SampleID of instrument file
+                     * @a SourceFile. Ignored if SourceLoaded() was not
+                     * called for @a SourceFile.
+                     */
+                    void Add(const String& SourceFile, uint64_t SampleID, const void* pData, uint64_t Size);
+
+                    /// Writes the index and replaces the previous snapshot file by the new one.
+                    bool Close();
+
+                private:
+                    struct source_t {
+                        String   File;
+                        int64_t  ModificationTime;
+                        uint64_t Size;
+                    };
+                    struct entry_t {
+                        uint32_t Source;
+                        uint64_t SampleID;
+                        uint64_t DataOffset;
+                        uint64_t Size;
+                        uint64_t Checksum;
+                    };
+
+                    String                         File;
+                    String                         TempFile;
+                    FILE*                          hFile;
+                    uint64_t                       Offset;
+                    bool                           bError;
+                    std::vector<source_t>          Sources;
+                    std::map<String,uint32_t>      SourceIndex; ///< Maps file name to index in Sources (or 0xffffffff if the file could not be stat'ed).
+                    std::vector<entry_t>           Entries;
+            };
+
+            /// Implemented by instrument managers whose preloaded sample data shall be stored in the snapshot.
+            class Provider {
+                public:
+                    virtual ~Provider() {}
+
+                    /// Adds the preload data of all samples currently preloaded by this instrument manager to @a writer.
+                    virtual void WritePreloadSnapshot(Writer& writer) = 0;
+            };
+
+            /**
+             * Enables the preload snapshot with the snapshot file @a File
+             * and maps the existing snapshot file (if any). Should be called
+             * once on startup, before any instrument is loaded.
+             */
+            static void SetFile(const String& File);
+
+            /// Whether a snapshot file was set with SetFile().
+            static bool IsEnabled();
+
+            /// Whether the snapshot provides @a Size bytes of preload data for sample @a SampleID of instrument file @a SourceFile.
+            static bool Contains(const String& SourceFile, uint64_t SampleID, uint64_t Size);
+
+            /**
+             * Copies the @a Size bytes of preload data stored for sample
+             * @a SampleID of instrument file @a SourceFile to @a pDest.
+             *
+             * @returns false if there is no valid snapshot data of exactly
+             *          that size for that sample (@a pDest is undefined then)
+             */
+            static bool Read(const String& SourceFile, uint64_t SampleID, void* pDest, uint64_t Size);
+
+            /**
+             * Registers @a pProvider to be asked for its preload data when
+             * the snapshot is written. The provider must exist until the
+             * process terminates (as the engines' instrument managers do).
+             */
+            static void AddProvider(Provider* pProvider);
+
+            /**
+             * Has to be called by instrument managers right before they open
+             * the instrument file @a SourceFile, to remember its modification
+             * time and size. The snapshot data of that file is stored with
+             * these, since the data might stem from an older version of the
+             * file if it is modified while it is loaded.
+             */
+            static void SourceLoaded(const String& SourceFile);
+
+            /// To be called when sample data was preloaded which is not part of the snapshot yet.
+            static void SetModified();
+
+            /// Writes a new snapshot file if SetModified() was called since it was written the last time.
+            static void SaveIfModified();
+
+            /// FNV-1a based checksum of the given data.
+            static uint64_t Checksum(const void* pData, uint64_t Size);
+
+        private:
+            struct key_t {
+                String   File;
+                uint64_t SampleID;
+
+                bool operator<(const key_t& other) const {
+                    if (SampleID != other.SampleID) return SampleID < other.SampleID;
+                    return File < other.File;
+                }
+            };
+            struct entry_t {
+                uint64_t DataOffset;
+                uint64_t Size;
+                uint64_t Checksum;
+            };
+            struct source_stat_t {
+                int64_t  ModificationTime;
+                uint64_t Size;
+            };
+
+            static Mutex                     SnapshotMutex; ///< Protects File, pMap, MapSize, Entries, bModified and LoadedSources.
+            static String                    File;
+            static uint8_t*                  pMap;
+            static size_t                    MapSize;
+            static std::map<key_t,entry_t>   Entries;
+            static bool                      bModified;
+            static std::map<String,source_stat_t> LoadedSources; ///< Modification time and size of instrument files when they were loaded.
+            static Mutex                     ProvidersMutex; ///< Protects Providers.
+            static std::set<Provider*>       Providers;
+            static Mutex                     SaveMutex; ///< Locked while writing a snapshot.
+
+            static void Map();
+            static void Unmap();
+            static bool GetLoadedSource(const String& SourceFile, source_stat_t& stat);
+    };
+
+} // namespace LinuxSampler
+
+#endif // CONFIG_PRELOAD_SNAPSHOT
+
+#endif // LS_PRELOADSNAPSHOT_H
@@ -0,0 +1,176 @@
+/*
+ * Copyright (c) 2020 Christian Schoenebeck
+ *
+ * http://www.linuxsampler.org
+ *
+ * This file is part of LinuxSampler and released under the same terms.
+ * See README file for details.
+ */
+
+#include "SampleDataPrefetcher.h"
+#include "../../common/Features.h"
+
+#if HAVE_PREAD
+
+#include <algorithm>
+#include <sys/types.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <errno.h>
+
+namespace LinuxSampler {
+
+    SampleDataPrefetcher::SampleDataPrefetcher() :
+        NextBatch(0), TotalBytes(0), BytesRead(0), FinishedWorkers(0)
+    {
+    }
+
+    void SampleDataPrefetcher::Add(const String& File, uint64_t Offset, uint64_t Size) {
+        if (!Size) return;
+        range_t range;
+        // instruments usually only refer to a few files, so a linear search is fine
+        range.File   = std::find(Files.begin(), Files.end(), File) - Files.begin();
+        range.Offset = Offset;
+        range.Size   = Size;
+        if (range.File == Files.size()) Files.push_back(File);
+        Ranges.push_back(range);
+    }
+
+    int SampleDataPrefetcher::PreloadThreadCount() {
+        if (CONFIG_PRELOAD_THREADS >= 0) return CONFIG_PRELOAD_THREADS;
+        return std::min(Features::processorCount(), 4);
+    }
+
+    void SampleDataPrefetcher::Run(int Threads, progress_callback_t Callback, void* pCustom) {
+        // sort by file position and merge neighbouring ranges to batches
+        std::sort(Ranges.begin(), Ranges.end());
+        Batches.clear();
+        for (size_t i = 0; i < Ranges.size(); i++) {
+            const range_t& r = Ranges[i];
+            if (!Batches.empty()) {
+                range_t& b = Batches.back();
+                const uint64_t end = b.Offset + b.Size;
+                if (b.File == r.File && r.Offset <= end + MERGE_GAP &&
+                    r.Offset + r.Size - b.Offset <= MAX_BATCH_SIZE)
+                {
+                    if (r.Offset + r.Size > end) b.Size = r.Offset + r.Size - b.Offset;
+                    continue;
+                }
+            }
+            Batches.push_back(r);
+        }
+        Ranges.clear();
+
+        NextBatch       = 0;
+        BytesRead       = 0;
+        TotalBytes      = 0;
+        FinishedWorkers = 0;
+        for (size_t i = 0; i < Batches.size(); i++) TotalBytes += Batches[i].Size;
+        if (!TotalBytes) return;
+
+        std::vector<Worker*> workers;
+        for (int i = 1; i < Threads && size_t(i) < Batches.size(); i++) {
+            Worker* pWorker = new Worker(this);
+            pWorker->StartThread();
+            workers.push_back(pWorker);
+        }
+
+        // the calling thread reads as well, reporting progress in between
+        int fd = -1;
+        size_t openedFile = 0;
+        std::vector<uint8_t> buffer;
+        while (true) {
+            range_t batch;
+            float progress;
+            {
+                LockGuard lock(BatchesMutex);
+                progress = float(BytesRead) / float(TotalBytes);
+                if (NextBatch >= Batches.size()) break;
+                batch = Batches[NextBatch++];
+            }
+            if (Callback) Callback(progress, pCustom);
+            ReadBatch(batch, fd, openedFile, buffer);
+        }
+        if (fd >= 0) close(fd);
+
+        // wait for the batches still being read by the workers
+        while (true) {
+            float progress;
+            {
+                LockGuard lock(BatchesMutex);
+                if (FinishedWorkers == workers.size()) break;
+                progress = float(BytesRead) / float(TotalBytes);
+            }
+            if (Callback) Callback(progress, pCustom);
+            usleep(10000);
+        }
+        for (size_t i = 0; i < workers.size(); i++) {
+            workers[i]->StopThread();
+            delete workers[i];
+        }
+        if (Callback) Callback(1.0f, pCustom);
+        Batches.clear();
+    }
+
+    void SampleDataPrefetcher::ProcessBatches() {
+        int fd = -1;
+        size_t openedFile = 0;
+        std::vector<uint8_t> buffer;
+        while (true) {
+            range_t batch;
+            {
+                LockGuard lock(BatchesMutex);
+                if (NextBatch >= Batches.size()) break;
+                batch = Batches[NextBatch++];
+            }
+            ReadBatch(batch, fd, openedFile, buffer);
+        }
+        if (fd >= 0) close(fd);
+    }
+
+    /**
+     * Reads the given batch, using (and if required replacing) the file
+     * descriptor @a fd of the calling thread, which refers to file number
+     * @a openedFile.
+     */
+    void SampleDataPrefetcher::ReadBatch(const range_t& batch, int& fd, size_t& openedFile, std::vector<uint8_t>& buffer) {
+        if (fd < 0 || openedFile != batch.File) {
+            if (fd >= 0) close(fd);
+            fd = open(Files[batch.File].c_str(), O_RDONLY);
+            openedFile = batch.File;
+            if (fd < 0) {
+                dmsg(2,("SampleDataPrefetcher: could not open '%s'\n", Files[batch.File].c_str()));
+            }
+        }
+        if (buffer.size() < READ_SIZE) buffer.resize(READ_SIZE);
+
+        uint64_t done = 0;
+        while (fd >= 0 && done < batch.Size) {
+            size_t n = READ_SIZE;
+            if (batch.Size - done < n) n = size_t(batch.Size - done);
+            const ssize_t r = pread(fd, &buffer[0], n, off_t(batch.Offset + done));
+            if (r < 0 && errno == EINTR) continue;
+            if (r <= 0) break; // error or end of file
+            done += uint64_t(r);
+        }
+
+        LockGuard lock(BatchesMutex);
+        BytesRead += batch.Size; // also count the unread rest, to reach 100%
+    }
+
+    SampleDataPrefetcher::Worker::Worker(SampleDataPrefetcher* pPrefetcher) :
+        Thread(true, false, 0, -4), pPrefetcher(pPrefetcher)
+    {
+    }
+
+    int SampleDataPrefetcher::Worker::Main() {
+        pPrefetcher->ProcessBatches();
+        LockGuard lock(pPrefetcher->BatchesMutex);
+        pPrefetcher->FinishedWorkers++;
+        return 0;
+    }
+
+} // namespace LinuxSampler
+
+#endif // HAVE_PREAD
@@ -0,0 +1,105 @@
+/*
+ * Copyright (c) 2020 Christian Schoenebeck
+ *
+ * http://www.linuxsampler.org
+ *
+ * This file is part of LinuxSampler and released under the same terms.
+ * See README file for details.
+ */
+
+#ifndef LS_SAMPLEDATAPREFETCHER_H
+#define LS_SAMPLEDATAPREFETCHER_H
+
+#include "../../common/global_private.h"
+
+#if HAVE_PREAD
+
+#include "../../common/Mutex.h"
+#include "../../common/Thread.h"
+#include <vector>
+
+namespace LinuxSampler {
+
+    /** @brief Reads sample data into the system's page cache in parallel.
+     *
+     * Caching the initial sample points of thousands of samples one after
+     * another, as done when an instrument is loaded, is dominated by disk
+     * latency: each sample requires a small read somewhere in a large file.
+     * This class collects the file ranges which are about to be read,
+     * sorts them by file offset, merges neighbouring ranges into larger
+     * batches and reads those batches with several threads concurrently.
+     * The subsequent (sequential) caching of the samples then just copies
+     * from the page cache.
+     *
+     * Reading is just an optimization, so errors are silently ignored.
+     */
+    class SampleDataPrefetcher {
+        public:
+            /// Called with the overall progress (0.0 .. 1.0) of Run().
+            typedef void (*progress_callback_t)(float fProgress, void* pCustom);
+
+            SampleDataPrefetcher();
+
+            /// Adds @a Size bytes at byte position @a Offset of file @a File to be read.
+            void Add(const String& File, uint64_t Offset, uint64_t Size);
+
+            /**
+             * Reads all added file ranges with @a Threads threads (including
+             * the calling thread) and returns after all of them were read.
+             * @a Callback (if not NULL) is periodically called by the calling
+             * thread to report the progress.
+             */
+            void Run(int Threads, progress_callback_t Callback = NULL, void* pCustom = NULL);
+
+            /**
+             * Amount of threads to be used for reading the preload data of
+             * instruments, that is CONFIG_PRELOAD_THREADS, or the amount of
+             * CPU cores (at most 4) if configured as auto.
+             */
+            static int PreloadThreadCount();
+
+        private:
+            enum {
+                MERGE_GAP      = 256 * 1024,       ///< Ranges closer to each other than this (in bytes) are read as one batch.
+                MAX_BATCH_SIZE = 8 * 1024 * 1024,  ///< Ranges are not merged to batches larger than this (in bytes).
+                READ_SIZE      = 1024 * 1024       ///< Size of each single read (in bytes).
+            };
+
+            struct range_t {
+                size_t   File; ///< Index in Files.
+                uint64_t Offset;
+                uint64_t Size;
+
+                bool operator<(const range_t& other) const {
+                    if (File != other.File) return File < other.File;
+                    return Offset < other.Offset;
+                }
+            };
+
+            class Worker : public Thread {
+                public:
+                    Worker(SampleDataPrefetcher* pPrefetcher);
+                protected:
+                    int Main() OVERRIDE;
+                private:
+                    SampleDataPrefetcher* pPrefetcher;
+            };
+
+            std::vector<String>  Files;
+            std::vector<range_t> Ranges;
+            std::vector<range_t> Batches;
+            Mutex                BatchesMutex; ///< Protects the attributes below.
+            size_t               NextBatch;
+            uint64_t             TotalBytes;
+            uint64_t             BytesRead;
+            size_t               FinishedWorkers;
+
+            void ProcessBatches();
+            void ReadBatch(const range_t& batch, int& fd, size_t& openedFile, std::vector<uint8_t>& buffer);
+    };
+
+} // namespace LinuxSampler
+
+#endif // HAVE_PREAD
+
+#endif // LS_SAMPLEDATAPREFETCHER_H
@@ -22,10 +22,20 @@
  ***************************************************************************/
 
 #include "SampleFile.h"
+#include "StreamBlockCache.h"
+#include "SharedSampleCache.h"
+#include "SampleFilePool.h"
 #include "../../common/global_private.h"
 #include "../../common/Exception.h"
 
 #include <cstring>
+#include <chrono>
+#include <sys/types.h>
+#include <sys/stat.h>
+#if CONFIG_MMAP_STREAMING || CONFIG_DIRECT_IO_STREAMING || CONFIG_SAMPLE_FILE_POOL_SIZE
+# include <fcntl.h>
+# include <unistd.h>
+#endif
 
 #define CONVERT_BUFFER_SIZE 4096
 
@@ -38,6 +48,10 @@ namespace LinuxSampler {
         this->File      = File;
         this->pSndFile  = NULL;
         pConvertBuffer  = NULL;
+        CacheSource     = StreamBlockCache::NewSource();
+        #if CONFIG_MMAP_STREAMING
+        pMapping        = NULL;
+        #endif
 
         SF_INFO sfInfo;
         sfInfo.format = 0;
@@ -46,6 +60,10 @@ namespace LinuxSampler {
         #if CONFIG_DEVMODE
         std::cout << "Number of opened sample files: " << ++SampleFile_OpenFilesCount << std::endl;
         #endif
+        if (!GetFileStamp(File, Stamp)) memset(&Stamp, 0, sizeof(Stamp));
+        StampTime = std::chrono::duration_cast<std::chrono::nanoseconds>(
+            std::chrono::system_clock::now().time_since_epoch()
+        ).count();
         SampleRate = sfInfo.samplerate;
         ChannelCount = sfInfo.channels;
         Format = sfInfo.format;
@@ -86,6 +104,14 @@ namespace LinuxSampler {
             }
 #endif
         }
+        #if CONFIG_SAMPLE_FILE_POOL_SIZE
+        // uncompressed sample data is read through the shared file pool
+        // instead, so there is no need to keep the sound file open
+        size_t rawDataSize;
+        bRawData = FindRawSampleData(RawDataOffset, rawDataSize);
+        Position = 0;
+        if (bRawData) DontClose = false;
+        #endif
         if(!DontClose) Close();
 
         if (FrameSize == 3 * ChannelCount && (
@@ -99,6 +125,10 @@ namespace LinuxSampler {
     }
 
     SampleFile::~SampleFile() {
+        StreamBlockCache::InvalidateFile(CacheSource);
+        #if CONFIG_MMAP_STREAMING
+        UnmapSampleData();
+        #endif
         Close();
         ReleaseSampleData();
         delete[] pConvertBuffer;
@@ -106,6 +136,9 @@ namespace LinuxSampler {
 
     void SampleFile::Open() {
         if(pSndFile) return; // Already opened
+        #if CONFIG_SAMPLE_FILE_POOL_SIZE
+        if (bRawData) return; // read through SampleFilePool, no need to open
+        #endif
         SF_INFO sfInfo;
         sfInfo.format = 0;
         pSndFile = sf_open(File.c_str(), SFM_READ, &sfInfo);
@@ -124,11 +157,182 @@ namespace LinuxSampler {
         #endif
     }
 
+#if CONFIG_MMAP_STREAMING || CONFIG_DIRECT_IO_STREAMING || CONFIG_SAMPLE_FILE_POOL_SIZE
+    static inline uint32_t readLE32(const uint8_t* p) {
+        return uint32_t(p[0]) | uint32_t(p[1]) << 8 | uint32_t(p[2]) << 16 | uint32_t(p[3]) << 24;
+    }
+
+    /**
+     * Searches the RIFF WAVE file @a File for its "data" chunk.
+     *
+     * @param File - path of the .wav file
+     * @param Offset - (out) byte position of the wave data in the file
+     * @param Size - (out) size of the wave data in bytes
+     * @returns true if the chunk was found
+     */
+    bool SampleFile::FindWaveDataChunk(const String& File, uint64_t& Offset, size_t& Size) {
+        const int fd = open(File.c_str(), O_RDONLY);
+        if (fd < 0) return false;
+        struct stat st;
+        if (fstat(fd, &st)) {
+            close(fd);
+            return false;
+        }
+        const uint64_t fileSize = st.st_size;
+
+        bool found = false;
+        uint8_t hdr[12];
+        if (pread(fd, hdr, 12, 0) == 12 && !memcmp(hdr, "RIFF", 4) && !memcmp(&hdr[8], "WAVE", 4)) {
+            uint64_t pos = 12;
+            while (pos + 8 <= fileSize) {
+                if (pread(fd, hdr, 8, off_t(pos)) != 8) break;
+                const uint64_t ckSize = readLE32(&hdr[4]);
+                if (!memcmp(hdr, "data", 4)) {
+                    Offset = pos + 8;
+                    // clamp in case of a truncated file or bogus chunk size
+                    Size   = size_t((Offset + ckSize <= fileSize) ? ckSize : fileSize - Offset);
+                    found  = true;
+                    break;
+                }
+                pos += 8 + ckSize + (ckSize & 1); // chunks are word aligned
+            }
+        }
+        close(fd);
+        return found;
+    }
+
+    /**
+     * Determines the location of the raw wave data in the file, if that data
+     * can be used by the synthesis code as is (uncompressed 16 or 24 bit
+     * little endian WAV).
+     *
+     * @param Offset - (out) byte position of the wave data in the file
+     * @param Size - (out) size of the wave data in bytes
+     * @returns true if the raw wave data is usable
+     */
+    bool SampleFile::FindRawSampleData(uint64_t& Offset, size_t& Size) {
+        if ((Format & SF_FORMAT_TYPEMASK) != SF_FORMAT_WAV) return false;
+        switch (Format & SF_FORMAT_SUBMASK) {
+#if !WORDS_BIGENDIAN // 16 bit samples would need endian conversion
+            case SF_FORMAT_PCM_16:
+#endif
+            case SF_FORMAT_PCM_24:
+                break;
+            default:
+                return false;
+        }
+        size_t chunkSize;
+        if (!FindWaveDataChunk(File, Offset, chunkSize)) return false;
+        Size = size_t(TotalFrameCount) * FrameSize;
+        return chunkSize >= Size;
+    }
+#endif // CONFIG_MMAP_STREAMING || CONFIG_DIRECT_IO_STREAMING || CONFIG_SAMPLE_FILE_POOL_SIZE
+
+#if CONFIG_MMAP_STREAMING
+    bool SampleFile::MapSampleData(uint NullFramesCount) {
+        LockGuard lock(MappingMutex);
+        if (pMapping && pMapping->GetNullExtensionSize() >= size_t(NullFramesCount) * FrameSize)
+            return true;
+        uint64_t offset;
+        size_t size;
+        if (!FindRawSampleData(offset, size)) return false;
+        // streams might still play from an existing mapping, so it is never
+        // mapped again, but replaced by a new one
+        MappedSample* pNewMapping = new MappedSample;
+        if (!pNewMapping->Map(File, offset, size, size_t(NullFramesCount) * FrameSize)) {
+            pNewMapping->Release();
+            return false;
+        }
+        if (pMapping) pMapping->Release();
+        pMapping = pNewMapping;
+        return true;
+    }
+
+    void SampleFile::UnmapSampleData() {
+        LockGuard lock(MappingMutex);
+        if (pMapping) pMapping->Release();
+        pMapping = NULL;
+    }
+
+    MappedSample* SampleFile::AcquireMapping() {
+        LockGuard lock(MappingMutex);
+        if (pMapping) pMapping->Retain();
+        return pMapping;
+    }
+#endif // CONFIG_MMAP_STREAMING
+
+#if CONFIG_DIRECT_IO_STREAMING
+    bool SampleFile::OpenDirectReader() {
+        if (DirectReader.IsOpen()) return true;
+        uint64_t offset;
+        size_t size;
+        if (!FindRawSampleData(offset, size)) return false;
+        return DirectReader.Open(File, offset, size, FrameSize);
+    }
+
+    void SampleFile::CloseDirectReader() {
+        DirectReader.Close();
+    }
+#endif // CONFIG_DIRECT_IO_STREAMING
+
+    bool SampleFile::IsCompressed() const {
+#if HAVE_DECL_SF_FORMAT_FLAC
+        if ((Format & SF_FORMAT_TYPEMASK) == SF_FORMAT_FLAC) return true;
+#endif
+#if HAVE_DECL_SF_FORMAT_VORBIS
+        if ((Format & SF_FORMAT_SUBMASK) == SF_FORMAT_VORBIS) return true;
+#endif
+        return false;
+    }
+
+    /// Retrieves the current stamp of @a File, returns false on error.
+    bool SampleFile::GetFileStamp(const String& File, file_stamp_t& Stamp) {
+        struct stat st;
+        if (stat(File.c_str(), &st)) return false;
+        Stamp.Device = int64_t(st.st_dev);
+        Stamp.Inode  = int64_t(st.st_ino);
+        Stamp.Size   = int64_t(st.st_size);
+        #if HAVE_STRUCT_STAT_ST_MTIM
+        Stamp.ModificationTime = int64_t(st.st_mtim.tv_sec) * 1000000000 + st.st_mtim.tv_nsec;
+        Stamp.ChangeTime       = int64_t(st.st_ctim.tv_sec) * 1000000000 + st.st_ctim.tv_nsec;
+        #else
+        Stamp.ModificationTime = int64_t(st.st_mtime) * 1000000000;
+        Stamp.ChangeTime       = int64_t(st.st_ctime) * 1000000000;
+        #endif
+        return true;
+    }
+
+    bool SampleFile::IsModified() const {
+        // timestamp granularity of the coarsest file systems (i.e. FAT)
+        const int64_t granularity = int64_t(2) * 1000000000;
+        file_stamp_t now;
+        if (!Stamp.Size || !GetFileStamp(File, now)) return true;
+        if (now.Device != Stamp.Device || now.Inode != Stamp.Inode || now.Size != Stamp.Size ||
+            now.ModificationTime != Stamp.ModificationTime || now.ChangeTime != Stamp.ChangeTime)
+            return true;
+        // "racily clean" file: it was changed just before this object was
+        // created, so a change after its data was read might have left its
+        // timestamps untouched
+        return Stamp.ModificationTime + granularity > StampTime ||
+               Stamp.ChangeTime + granularity > StampTime;
+    }
+
     long SampleFile::SetPos(unsigned long FrameOffset) {
         return SetPos(FrameOffset, SEEK_SET);
     }
 
     long SampleFile::SetPos(unsigned long FrameCount, int Whence) {
+        #if CONFIG_SAMPLE_FILE_POOL_SIZE
+        if (bRawData) {
+            switch (Whence) {
+                case SEEK_CUR: FrameCount += Position; break;
+                case SEEK_END: FrameCount += TotalFrameCount; break;
+            }
+            if (FrameCount > (unsigned long) TotalFrameCount) return -1;
+            Position = FrameCount;
+            return long(Position);
+        }
+        #endif
         if(pSndFile == NULL) {
             std::cerr << "Sample::SetPos() " << File << " not opened" << std::endl;
             return -1;
@@ -138,6 +342,9 @@ namespace LinuxSampler {
     }
 
     long SampleFile::GetPos() {
+        #if CONFIG_SAMPLE_FILE_POOL_SIZE
+        if (bRawData) return long(Position);
+        #endif
         if(pSndFile == NULL) {
             std::cerr << "Sample::GetPos() " << File << " not opened" << std::endl;
             return -1;
@@ -167,15 +374,26 @@ namespace LinuxSampler {
             // Offset the RAM cache
             RAMCacheOffset = Offset;
         }
-        if (RAMCache.pStart) delete[] (int8_t*) RAMCache.pStart;
+        ReleaseSampleData();
         unsigned long allocationsize = (FrameCount + NullFramesCount) * this->FrameSize;
         SetPos(RAMCacheOffset, SEEK_SET); // reset read position to playback start point
-        RAMCache.pStart            = new int8_t[allocationsize];
+#if CONFIG_SAMPLE_CACHE_DEDUP
+        // read into a scratch buffer, the RAM cache is allocated by
+        // SharedSampleCache only if no other sample file has identical data
+        int8_t* pData = SharedSampleCache::GetScratchBuffer(allocationsize);
+#else
+        int8_t* pData = new int8_t[allocationsize];
+#endif
 
-        RAMCache.Size = Read(RAMCache.pStart, FrameCount) * this->FrameSize;
+        RAMCache.Size = Read(pData, FrameCount) * this->FrameSize;
         RAMCache.NullExtensionSize = allocationsize - RAMCache.Size;
         // fill the remaining buffer space with silence samples
-        memset((int8_t*)RAMCache.pStart + RAMCache.Size, 0, RAMCache.NullExtensionSize);
+        memset(pData + RAMCache.Size, 0, RAMCache.NullExtensionSize);
+#if CONFIG_SAMPLE_CACHE_DEDUP
+        RAMCache.pStart = SharedSampleCache::Share(pData, RAMCache.Size, RAMCache.NullExtensionSize);
+#else
+        RAMCache.pStart = pData;
+#endif
         Close();
         return GetCache();
     }
@@ -185,6 +403,22 @@ namespace LinuxSampler {
         
         if (GetPos() + FrameCount > GetTotalFrameCount()) FrameCount = GetTotalFrameCount() - GetPos(); // For the cases where a different sample end is specified (not the end of the file)
 
+#if CONFIG_SAMPLE_FILE_POOL_SIZE
+        if (bRawData) {
+            // position independent read, sharing the file with other samples
+            const ssize_t bytes = SampleFilePool::Read(
+                File, RawDataOffset + uint64_t(Position) * FrameSize,
+                pBuffer, size_t(FrameCount) * FrameSize
+            );
+            if (bytes < 0) {
+                std::cerr << "Sample::Read() " << "Failed to read " << File << std::endl;
+                return 0;
+            }
+            Position += bytes / FrameSize;
+            return bytes / FrameSize;
+        }
+#endif
+
         // ogg and flac files must be read with sf_readf, not
         // sf_read_raw. On big endian machines, sf_readf_short is also
         // used for 16 bit wav files, to get automatic endian
@@ -254,7 +488,11 @@ namespace LinuxSampler {
     }
 
     void SampleFile::ReleaseSampleData() {
+#if CONFIG_SAMPLE_CACHE_DEDUP
+        SharedSampleCache::Release(RAMCache.pStart);
+#else
         if (RAMCache.pStart) delete[] (int8_t*) RAMCache.pStart;
+#endif
         RAMCache.pStart = NULL;
         RAMCache.Size   = 0;
         RAMCache.NullExtensionSize = 0;
@@ -28,6 +28,14 @@
 
 #include <sndfile.h>
 #include "../../common/global.h"
+#include "../../common/global_private.h"
+#if CONFIG_MMAP_STREAMING
+# include "MappedSample.h"
+# include "../../common/Mutex.h"
+#endif
+#if CONFIG_DIRECT_IO_STREAMING
+# include "DirectSampleReader.h"
+#endif
 
 namespace LinuxSampler {
     class SampleFile : public Sample {
@@ -37,6 +45,9 @@ namespace LinuxSampler {
 
             String GetFile() { return File; }
 
+            /// Identifies this opened file in the StreamBlockCache.
+            uint64_t GetCacheSource() { return CacheSource; }
+
             virtual String  GetName() { return File; }
             virtual int     GetSampleRate() { return SampleRate; }
             virtual int     GetChannelCount() { return ChannelCount; }
@@ -66,6 +77,57 @@ namespace LinuxSampler {
             void Open();
             void Close();
 
+            /// Whether reading the sample data requires decoding (FLAC, Ogg Vorbis).
+            bool IsCompressed() const;
+
+            /**
+             * Whether the sample file was modified or replaced on disk since
+             * this object was created, i.e. the sample data cached in RAM
+             * might be outdated. Compares device, inode, size, modification
+             * and inode change time (in nanoseconds if supported). A file
+             * whose timestamps were still within the file system's timestamp
+             * granularity of the point this object was created is always
+             * considered modified, since a change made right afterwards
+             * might not have changed its timestamps at all.
+             */
+            bool IsModified() const;
+
+            #if CONFIG_MMAP_STREAMING
+            /**
+             * Maps the raw wave data of this sample file read-only into
+             * memory, if its format allows playing it directly from the
+             * mapping (uncompressed 16 or 24 bit little endian WAV).
+             *
+             * @param NullFramesCount - amount of silence frames required
+             *                          behind the sample data
+             * @returns true if the sample data is mapped now
+             */
+            bool MapSampleData(uint NullFramesCount);
+            void UnmapSampleData();
+
+            /**
+             * Returns the mapping of the sample data or NULL if not mapped.
+             * The caller gets a reference to the mapping and has to call
+             * MappedSample::Release() when done with it.
+             */
+            MappedSample* AcquireMapping();
+            #endif
+
+            #if CONFIG_DIRECT_IO_STREAMING
+            /**
+             * Opens this sample file for reading its raw wave data with
+             * direct I/O (bypassing the system's page cache), if its format
+             * allows that (uncompressed 16 or 24 bit little endian WAV).
+             *
+             * @returns true if the sample data can be read directly now
+             */
+            bool OpenDirectReader();
+            void CloseDirectReader();
+
+            /// Returns the direct I/O reader of the sample data or NULL if not opened.
+            DirectSampleReader* GetDirectReader() { return DirectReader.IsOpen() ? &DirectReader : NULL; }
+            #endif
+
         private:
             String File;
             int    SampleRate;
@@ -76,6 +138,17 @@ namespace LinuxSampler {
             int    Loops;
             uint   LoopStart;
             uint   LoopEnd;
+            /// Identity and state of a file on disk, see IsModified().
+            struct file_stamp_t {
+                int64_t Device;
+                int64_t Inode;
+                int64_t Size;
+                int64_t ModificationTime; ///< In nanoseconds.
+                int64_t ChangeTime;       ///< Inode change time in nanoseconds.
+            };
+            file_stamp_t Stamp;       ///< Stamp of the file when this object was created.
+            int64_t StampTime;        ///< Wall clock time in nanoseconds when Stamp was taken.
+            uint64_t CacheSource;     ///< See GetCacheSource().
 
             SNDFILE* pSndFile;
 
@@ -83,7 +156,27 @@ namespace LinuxSampler {
 
             int* pConvertBuffer;
 
+            #if CONFIG_MMAP_STREAMING
+            MappedSample* pMapping;   ///< Used for streaming the sample directly from its file (if enabled).
+            Mutex MappingMutex;       ///< Protects 'pMapping', which is acquired by the disk threads.
+            #endif
+            #if CONFIG_DIRECT_IO_STREAMING
+            DirectSampleReader DirectReader; ///< Used for streaming the sample bypassing the page cache (if enabled).
+            #endif
+
+            #if CONFIG_SAMPLE_FILE_POOL_SIZE
+            bool          bRawData;      ///< Whether the sample data is uncompressed and read through the SampleFilePool.
+            uint64_t      RawDataOffset; ///< Byte position of the sample data in the file (if bRawData).
+            unsigned long Position;      ///< Current read position in sample points (if bRawData).
+            #endif
+
             long SetPos(unsigned long FrameCount, int Whence);
+
+            #if CONFIG_MMAP_STREAMING || CONFIG_DIRECT_IO_STREAMING || CONFIG_SAMPLE_FILE_POOL_SIZE
+            bool FindRawSampleData(uint64_t& Offset, size_t& Size);
+            static bool FindWaveDataChunk(const String& File, uint64_t& Offset, size_t& Size);
+            static bool GetFileStamp(const String& File, file_stamp_t& Stamp);
+            #endif
     };
 
     template <class R>
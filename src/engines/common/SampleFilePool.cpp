@@ -0,0 +1,119 @@
+/*
+ * Copyright (c) 2020 Christian Schoenebeck
+ *
+ * http://www.linuxsampler.org
+ *
+ * This file is part of LinuxSampler and released under the same terms.
+ * See README file for details.
+ */
+
+#include "SampleFilePool.h"
+
+#if CONFIG_SAMPLE_FILE_POOL_SIZE
+
+#include <fcntl.h>
+#include <unistd.h>
+#include <errno.h>
+
+namespace LinuxSampler {
+
+    Mutex                    SampleFilePool::FilesMutex;
+    SampleFilePool::FileMap  SampleFilePool::Files;
+    uint64_t                 SampleFilePool::UseCounter = 0;
+    uint64_t                 SampleFilePool::Hits       = 0;
+    uint64_t                 SampleFilePool::Misses     = 0;
+
+    /**
+     * Returns an open file descriptor of @a File, which is pinned until
+     * Release() is called, or -1 if the file cannot be opened.
+     */
+    int SampleFilePool::Acquire(const String& File) {
+        {
+            LockGuard lock(FilesMutex);
+            FileMap::iterator it = Files.find(File);
+            if (it != Files.end()) {
+                it->second.Pins++;
+                it->second.LastUse = ++UseCounter;
+                Hits++;
+                return it->second.fd;
+            }
+            Misses++;
+        }
+
+        // open the file without holding the lock, that might take a while
+        const int fd = open(File.c_str(), O_RDONLY);
+        if (fd < 0) return -1;
+        #if defined(POSIX_FADV_RANDOM)
+        // streams of different samples jump around in the file
+        posix_fadvise(fd, 0, 0, POSIX_FADV_RANDOM);
+        #endif
+
+        LockGuard lock(FilesMutex);
+        std::pair<FileMap::iterator,bool> res = Files.insert(std::make_pair(File, entry_t()));
+        entry_t& entry = res.first->second;
+        if (res.second) {
+            entry.fd   = fd;
+            entry.Pins = 0;
+        } else {
+            close(fd); // another thread opened it meanwhile
+        }
+        entry.Pins++;
+        entry.LastUse = ++UseCounter;
+        const int result = entry.fd;
+        Evict();
+        return result;
+    }
+
+    void SampleFilePool::Release(const String& File) {
+        LockGuard lock(FilesMutex);
+        FileMap::iterator it = Files.find(File);
+        if (it == Files.end() || !it->second.Pins) return;
+        it->second.Pins--;
+        Evict();
+    }
+
+    /// Closes least recently used files while too many are open. FilesMutex must be locked.
+    void SampleFilePool::Evict() {
+        while (Files.size() > CONFIG_SAMPLE_FILE_POOL_SIZE) {
+            FileMap::iterator lru = Files.end();
+            for (FileMap::iterator it = Files.begin(); it != Files.end(); ++it) {
+                if (it->second.Pins) continue;
+                if (lru == Files.end() || it->second.LastUse < lru->second.LastUse)
+                    lru = it;
+            }
+            if (lru == Files.end()) return; // all files are being read from
+            close(lru->second.fd);
+            Files.erase(lru);
+        }
+    }
+
+    ssize_t SampleFilePool::Read(const String& File, uint64_t Offset, void* pDst, size_t Bytes) {
+        const int fd = Acquire(File);
+        if (fd < 0) return -1;
+        size_t total = 0;
+        while (total < Bytes) {
+            const ssize_t n = pread(fd, (uint8_t*)pDst + total, Bytes - total, off_t(Offset + total));
+            if (n < 0 && errno == EINTR) continue;
+            if (n < 0) {
+                Release(File);
+                return -1;
+            }
+            if (!n) break; // end of file
+            total += n;
+        }
+        Release(File);
+        return ssize_t(total);
+    }
+
+    SampleFilePool::statistics_t SampleFilePool::GetStatistics() {
+        LockGuard lock(FilesMutex);
+        statistics_t stats;
+        stats.OpenFiles = Files.size();
+        stats.Hits      = Hits;
+        stats.Misses    = Misses;
+        return stats;
+    }
+
+} // namespace LinuxSampler
+
+#endif // CONFIG_SAMPLE_FILE_POOL_SIZE
@@ -0,0 +1,84 @@
+/*
+ * Copyright (c) 2020 Christian Schoenebeck
+ *
+ * http://www.linuxsampler.org
+ *
+ * This file is part of LinuxSampler and released under the same terms.
+ * See README file for details.
+ */
+
+#ifndef LS_SAMPLEFILEPOOL_H
+#define LS_SAMPLEFILEPOOL_H
+
+#include "../../common/global_private.h"
+
+#if CONFIG_SAMPLE_FILE_POOL_SIZE
+
+#include "../../common/Mutex.h"
+#include <sys/types.h>
+#include <map>
+
+namespace LinuxSampler {
+
+    /** @brief Pool of open sample files shared by all samples.
+     *
+     * Without this pool each sample of an sfz instrument opens its .wav
+     * file with libsndfile whenever a voice starts streaming it, which
+     * means an open() and a parse of the file's headers on the disk thread
+     * for every note, and an own file descriptor per playing sample.
+     *
+     * Uncompressed sample data is read with Read() instead, which reads the
+     * requested range of a file with pread(), so the file position does not
+     * matter and any amount of samples and streams may share one file
+     * descriptor of the same file concurrently. Files are opened on demand
+     * and stay open for subsequent reads; the least recently used files
+     * are closed once more than @c CONFIG_SAMPLE_FILE_POOL_SIZE files are
+     * open. Files currently being read from are never closed.
+     *
+     * This class is thread safe. It may block and call the system, so it
+     * must not be used by audio threads.
+     */
+    class SampleFilePool {
+        public:
+            /// Usage statistics.
+            struct statistics_t {
+                uint64_t OpenFiles; ///< Amount of files currently open.
+                uint64_t Hits;      ///< Reads served by an already open file.
+                uint64_t Misses;    ///< Reads which had to open the file first.
+            };
+
+            /**
+             * Reads @a Bytes bytes at byte position @a Offset of the file
+             * @a File into @a pDst.
+             *
+             * @returns amount of bytes read, which is less than @a Bytes at
+             *          the end of the file, or -1 on error
+             */
+            static ssize_t Read(const String& File, uint64_t Offset, void* pDst, size_t Bytes);
+
+            static statistics_t GetStatistics();
+
+        private:
+            struct entry_t {
+                int      fd;
+                uint     Pins;    ///< Amount of reads currently using @c fd.
+                uint64_t LastUse; ///< Value of UseCounter at the last read.
+            };
+            typedef std::map<String,entry_t> FileMap;
+
+            static Mutex    FilesMutex; ///< Protects all attributes below.
+            static FileMap  Files;
+            static uint64_t UseCounter;
+            static uint64_t Hits;
+            static uint64_t Misses;
+
+            static int  Acquire(const String& File);
+            static void Release(const String& File);
+            static void Evict();
+    };
+
+} // namespace LinuxSampler
+
+#endif // CONFIG_SAMPLE_FILE_POOL_SIZE
+
+#endif // LS_SAMPLEFILEPOOL_H
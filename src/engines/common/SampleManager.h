@@ -28,6 +28,7 @@
 #include <set>
 
 #include "../../common/Exception.h"
+#include "../../common/Mutex.h"
 
 namespace LinuxSampler {
 
@@ -42,6 +43,11 @@ namespace LinuxSampler {
      * actually using a sample" (see bug #308). We might need to revise this
      * design of this class in case new problems appear (e.g. when encountering
      * memory leaks after closing an sfz instrument).
+     *
+     * All methods are thread safe, since instruments are loaded by several
+     * threads concurrently while the disk threads mark samples in use. The
+     * manager's mutex is recursive, so derived classes may lock it around
+     * several calls which have to be executed atomically.
      */
     template <class S /* Sample */, class C /* Sample Consumer */>
     class SampleManager {
@@ -51,11 +57,13 @@ namespace LinuxSampler {
              * Adds the specified sample to the sample manager
              */
             void AddSample(S* pSample) {
+                LockGuard lock(mutex);
                 if (pSample == NULL) return;
                 sampleMap[pSample];
             }
 
             void RemoveSample(S* pSample) throw (Exception) {
+                LockGuard lock(mutex);
                 if (sampleMap.find(pSample) == sampleMap.end()) return;
                 if (!sampleMap[pSample].empty()) {
                     throw Exception("Can't remove. Sample has consumers");
@@ -71,12 +79,14 @@ namespace LinuxSampler {
              * already added as consumer to pSample.
              */
             void AddSampleConsumer(S* pSample, C* pConsumer) {
+                LockGuard lock(mutex);
                 if (pSample == NULL || pConsumer == NULL) return;
                 if(sampleMap[pSample].find(pConsumer) != sampleMap[pSample].end()) return;
                 sampleMap[pSample].insert(pConsumer);
             }
 
             std::vector<C*> GetConsumers(S* pSample) throw (Exception) {
+                LockGuard lock(mutex);
                 if (sampleMap.find(pSample) == sampleMap.end()) {
                     throw Exception("SampleManager::GetConsumers: unknown sample");
                 }
@@ -91,6 +101,7 @@ namespace LinuxSampler {
              * of consumers for the specified sample.
              */
             bool RemoveSampleConsumer(S* pSample, C* pConsumer) throw (Exception) {
+                LockGuard lock(mutex);
                 if (sampleMap.find(pSample) == sampleMap.end()) {
                     throw Exception("SampleManager::RemoveConsumer: unknown sample");
                 }
@@ -108,10 +119,12 @@ namespace LinuxSampler {
              * Determines whether pSample is managed by this sample manager
              */
             bool HasSample(S* pSample) {
+                LockGuard lock(mutex);
                 return sampleMap.find(pSample) != sampleMap.end();
             }
 
             bool HasSampleConsumers(S* pSample) throw (Exception) {
+                LockGuard lock(mutex);
                 if (sampleMap.find(pSample) == sampleMap.end()) {
                     throw Exception("SampleManager::HasConsumers: unknown sample");
                 }
@@ -123,6 +136,7 @@ namespace LinuxSampler {
              * Determines whether pConsumer is consumer of pSample.
              */
             bool IsSampleConsumerOf(S* pSample, C* pConsumer) {
+                LockGuard lock(mutex);
                 if (sampleMap.find(pSample) == sampleMap.end()) {
                     throw Exception("SampleManager::IsSampleConsumerOf: unknown sample");
                 }
@@ -135,6 +149,7 @@ namespace LinuxSampler {
              * Sets that pSample is now in use by pConsumer.
              */
             void SetSampleInUse(S* pSample, C* pConsumer) {
+                LockGuard lock(mutex);
                 verifyPair(pSample, pConsumer, "SampleManager::SetSampleInUse");
 
                 bool inUse = !samplesInUseMap[pSample].empty();
@@ -146,6 +161,7 @@ namespace LinuxSampler {
              * Sets that pSample is now not in use by pConsumer.
              */
             void SetSampleNotInUse(S* pSample, C* pConsumer) {
+                LockGuard lock(mutex);
                 verifyPair(pSample, pConsumer, "SampleManager::SetSampleNotInUse");
 
                 bool inUse = !samplesInUseMap[pSample].empty();
@@ -161,6 +177,7 @@ namespace LinuxSampler {
             }
 
         protected:
+            Mutex mutex; ///< Protects the maps below.
             std::map<S*, std::set<C*> > sampleMap;
             std::map<S*, std::multiset<C*> > samplesInUseMap; // std::multiset as data type fixes bug #308.
 
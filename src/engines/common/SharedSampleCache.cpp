@@ -0,0 +1,126 @@
+/*
+ * Copyright (c) 2020 Christian Schoenebeck
+ *
+ * http://www.linuxsampler.org
+ *
+ * This file is part of LinuxSampler and released under the same terms.
+ * See README file for details.
+ */
+
+#include "SharedSampleCache.h"
+#include "../../common/HugePages.h"
+
+#if CONFIG_SAMPLE_CACHE_DEDUP
+
+#include <string.h>
+
+namespace LinuxSampler {
+
+    Mutex                                       SharedSampleCache::BuffersMutex;
+    SharedSampleCache::ContentMap               SharedSampleCache::Contents;
+    std::map<const void*,SharedSampleCache::entry_t> SharedSampleCache::Buffers;
+    uint64_t                                    SharedSampleCache::References = 0;
+    uint64_t                                    SharedSampleCache::Bytes      = 0;
+    uint64_t                                    SharedSampleCache::SavedBytes = 0;
+
+    // scratch buffers above this size are not kept for the next sample
+    #define MAX_KEPT_SCRATCH_SIZE (4 * 1024 * 1024)
+
+    // amount of 64 bit words of a buffer taken into account by Fingerprint()
+    #define FINGERPRINT_WORDS 1024
+
+    /**
+     * Hashes (at most) FINGERPRINT_WORDS words evenly spread over the
+     * buffer. That's sufficient to tell apart different samples of the same
+     * size in practice, since Share() compares candidates completely anyway.
+     */
+    uint64_t SharedSampleCache::Fingerprint(const int8_t* pData, uint64_t Size) {
+        uint64_t hash = 14695981039346656037ULL; // FNV-1a
+        const uint64_t words = Size / sizeof(uint64_t);
+        const uint64_t step  = (words > FINGERPRINT_WORDS) ? words / FINGERPRINT_WORDS : 1;
+        for (uint64_t i = 0; i < words; i += step) {
+            uint64_t word;
+            memcpy(&word, pData + i * sizeof(uint64_t), sizeof(uint64_t));
+            hash = (hash ^ word) * 1099511628211ULL;
+        }
+        for (uint64_t i = words * sizeof(uint64_t); i < Size; i++)
+            hash = (hash ^ uint8_t(pData[i])) * 1099511628211ULL;
+        return hash;
+    }
+
+    int8_t* SharedSampleCache::Share(const int8_t* pData, uint64_t Size, uint64_t NullExtensionSize) {
+        if (!pData) return NULL;
+        const key_t key = { Fingerprint(pData, Size), Size, NullExtensionSize };
+
+        LockGuard lock(BuffersMutex);
+        std::pair<ContentMap::iterator,ContentMap::iterator> range = Contents.equal_range(key);
+        for (ContentMap::iterator it = range.first; it != range.second; ++it) {
+            if (memcmp(it->second, pData, Size)) continue;
+            entry_t& entry = Buffers[it->second];
+            entry.RefCount++;
+            References++;
+            SavedBytes += Size + NullExtensionSize;
+            dmsg(3,("SharedSampleCache: sharing %llu bytes\n", (long long)Size));
+            return it->second;
+        }
+        // no identical buffer yet, so only now memory is allocated
+        #if CONFIG_HUGE_PAGES
+        // from huge pages, voices read it quite randomly
+        int8_t* pBuffer = HugePages::Allocate(Size + NullExtensionSize);
+        #else
+        int8_t* pBuffer = new int8_t[Size + NullExtensionSize];
+        #endif
+        memcpy(pBuffer, pData, Size + NullExtensionSize);
+        entry_t entry;
+        entry.Content  = Contents.insert(std::make_pair(key, pBuffer));
+        entry.RefCount = 1;
+        Buffers[pBuffer] = entry;
+        References++;
+        Bytes += Size + NullExtensionSize;
+        return pBuffer;
+    }
+
+    int8_t* SharedSampleCache::GetScratchBuffer(size_t Bytes) {
+        static thread_local std::vector<int8_t> buffer;
+        if (buffer.size() > MAX_KEPT_SCRATCH_SIZE && Bytes < buffer.size())
+            std::vector<int8_t>().swap(buffer); // don't keep a huge one forever
+        if (buffer.size() < Bytes) buffer.resize(Bytes);
+        return buffer.empty() ? NULL : &buffer[0];
+    }
+
+    bool SharedSampleCache::Release(const void* pData) {
+        if (!pData) return false;
+        LockGuard lock(BuffersMutex);
+        std::map<const void*,entry_t>::iterator it = Buffers.find(pData);
+        if (it == Buffers.end()) return false;
+        entry_t& entry = it->second;
+        const uint64_t size = entry.Content->first.Size + entry.Content->first.NullExtensionSize;
+        References--;
+        if (--entry.RefCount) {
+            SavedBytes -= size;
+            return true;
+        }
+        Bytes -= size;
+        #if CONFIG_HUGE_PAGES
+        HugePages::Free(entry.Content->second);
+        #else
+        delete[] entry.Content->second;
+        #endif
+        Contents.erase(entry.Content);
+        Buffers.erase(it);
+        return true;
+    }
+
+    SharedSampleCache::statistics_t SharedSampleCache::GetStatistics() {
+        LockGuard lock(BuffersMutex);
+        statistics_t stats;
+        stats.Buffers    = Buffers.size();
+        stats.References = References;
+        stats.Bytes      = Bytes;
+        stats.SavedBytes = SavedBytes;
+        return stats;
+    }
+
+} // namespace LinuxSampler
+
+#endif // CONFIG_SAMPLE_CACHE_DEDUP
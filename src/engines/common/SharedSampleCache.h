@@ -0,0 +1,121 @@
+/*
+ * Copyright (c) 2020 Christian Schoenebeck
+ *
+ * http://www.linuxsampler.org
+ *
+ * This file is part of LinuxSampler and released under the same terms.
+ * See README file for details.
+ */
+
+#ifndef LS_SHAREDSAMPLECACHE_H
+#define LS_SHAREDSAMPLECACHE_H
+
+#include "../../common/global_private.h"
+
+#if CONFIG_SAMPLE_CACHE_DEDUP
+
+#include "../../common/Mutex.h"
+#include <map>
+#include <vector>
+
+namespace LinuxSampler {
+
+    /** @brief RAM cache buffers shared by samples with identical content.
+     *
+     * Sample libraries often contain the very same sample data several
+     * times, i.e. in different instrument files or for different
+     * articulations of an instrument sharing the same sustain layer. Each
+     * of those samples would otherwise occupy its own RAM cache.
+     *
+     * Sampler engines read the data for the RAM cache of a sample into a
+     * scratch buffer and pass it to Share(), which looks up a buffer with
+     * identical content (same sample data, same amount of silence behind
+     * it). Only if there is none, a new buffer is allocated and the data is
+     * copied into it. Buffers are looked up by a fingerprint of their size
+     * and a subset of their data, identical content is always verified by
+     * a complete comparison, so samples with different content are never
+     * merged.
+     *
+     * All buffers returned by Share() are owned by this class, they are
+     * reference counted and must be given back with Release() instead of
+     * being freed directly. They must never be handed over to code which
+     * might free them (i.e. libgig). If huge page support is enabled
+     * (@c CONFIG_HUGE_PAGES), they are allocated from huge pages.
+     *
+     * This class is thread safe, but it may block and allocate memory, so
+     * it must not be used by audio threads.
+     */
+    class SharedSampleCache {
+        public:
+            /// Memory usage statistics.
+            struct statistics_t {
+                uint64_t Buffers;    ///< Current amount of distinct buffers.
+                uint64_t References; ///< Current amount of samples using those buffers.
+                uint64_t Bytes;      ///< RAM occupied by all distinct buffers in bytes.
+                uint64_t SavedBytes; ///< RAM saved by sharing buffers in bytes.
+            };
+
+            /**
+             * Returns a buffer with the content of @a pData, which consists
+             * of @a Size bytes of sample data followed by
+             * @a NullExtensionSize bytes of silence. @a pData is only read,
+             * it still belongs to the caller afterwards.
+             *
+             * @returns a buffer of identical content already used by another
+             *          sample, or a new copy of @a pData, or NULL if
+             *          @a pData is NULL
+             */
+            static int8_t* Share(const int8_t* pData, uint64_t Size, uint64_t NullExtensionSize);
+
+            /**
+             * Gives back a buffer previously returned by Share(). The buffer
+             * is freed when it is not used by any sample anymore.
+             *
+             * @returns false if @a pData is not a buffer of this class (it
+             *          is not touched then)
+             */
+            static bool Release(const void* pData);
+
+            /**
+             * Returns a buffer of at least @a Bytes bytes for reading sample
+             * data before passing it to Share(). The buffer belongs to the
+             * calling thread and stays valid until its next call of this
+             * method.
+             */
+            static int8_t* GetScratchBuffer(size_t Bytes);
+
+            static statistics_t GetStatistics();
+
+        private:
+            struct key_t {
+                uint64_t Fingerprint;
+                uint64_t Size;
+                uint64_t NullExtensionSize;
+
+                bool operator<(const key_t& other) const {
+                    if (Fingerprint != other.Fingerprint) return Fingerprint < other.Fingerprint;
+                    if (Size != other.Size) return Size < other.Size;
+                    return NullExtensionSize < other.NullExtensionSize;
+                }
+            };
+            typedef std::multimap<key_t,int8_t*> ContentMap;
+            struct entry_t {
+                ContentMap::iterator Content; ///< Entry of the buffer in Contents.
+                uint                 RefCount;
+            };
+
+            static Mutex                        BuffersMutex; ///< Protects all attributes below.
+            static ContentMap                   Contents;
+            static std::map<const void*,entry_t> Buffers;     ///< All shared buffers by address.
+            static uint64_t                     References;
+            static uint64_t                     Bytes;
+            static uint64_t                     SavedBytes;
+
+            static uint64_t Fingerprint(const int8_t* pData, uint64_t Size);
+    };
+
+} // namespace LinuxSampler
+
+#endif // CONFIG_SAMPLE_CACHE_DEDUP
+
+#endif // LS_SHAREDSAMPLECACHE_H
@@ -25,9 +25,13 @@
 #ifndef __LS_STREAM_H__
 #define __LS_STREAM_H__
 
-#include "../../common/global.h"
+#include "../../common/global_private.h"
 #include "../../common/RingBuffer.h"
 #include "Sample.h"
+#if CONFIG_MMAP_STREAMING
+# include "MappedSample.h"
+# include "../../common/lsatomic.h"
+#endif
 
 namespace LinuxSampler {
 
@@ -37,6 +41,17 @@ namespace LinuxSampler {
      * thread safe refilling the stream's buffer with one thread (disk
      * thread) and actual use / extraction of the audio data from the
      * stream's buffer with another thread (audio thread).
+     *
+     * A stream does not own a ring buffer while it is unused. The disk
+     * thread attaches a buffer sized for the respective sample when it
+     * launches the stream and takes the buffer back once the stream became
+     * unused again (see StreamBufferSlab).
+     *
+     * If memory mapped streaming is enabled (@c CONFIG_MMAP_STREAMING) a
+     * stream might alternatively be launched on a MappedSample. In that case
+     * the ring buffer is bypassed entirely: the audio thread reads the sample
+     * data directly from the mapping, and the disk thread merely ensures
+     * the pages ahead of the current read position are resident in memory.
      */
     class Stream {
         public:
@@ -70,7 +85,18 @@ namespace LinuxSampler {
                 this->hThis                  = 0;
                 this->PlaybackState.position = 0;
                 this->PlaybackState.reverse  = false;
-                this->pRingBuffer            = new RingBuffer<uint8_t,false>(BufferSize * 3, BufferWrapElements * 3);
+                this->pRingBuffer            = NULL;
+                this->pBufferStorage         = NULL;
+                this->BufferWrapElements     = BufferWrapElements;
+                this->MinFillPercentage      = -1;
+                #if CONFIG_MMAP_STREAMING
+                this->pMapping               = NULL;
+                this->pMappedData            = NULL;
+                this->MappedEndPos           = 0;
+                this->MappedWindowSize       = BufferSize;
+                this->MappedReadPos.store(0);
+                this->MappedFillPos.store(0);
+                #endif
                 UnusedStreams++;
                 TotalStreams++;
             }
@@ -79,14 +105,26 @@ namespace LinuxSampler {
 
             // Methods
             inline int GetReadSpace() {
+                #if CONFIG_MMAP_STREAMING
+                if (pMappedData)
+                    return (State != state_unused) ? MappedFillPos.load(memory_order_acquire) - MappedReadPos.load(memory_order_relaxed) : 0;
+                #endif
                 return (pRingBuffer && State != state_unused) ? pRingBuffer->read_space() / SampleInfo.BytesPerSample : 0;
             }
 
             inline int GetWriteSpace() {
+                #if CONFIG_MMAP_STREAMING
+                if (pMappedData)
+                    return (State == state_active) ? GetMappedWriteSpace() : 0;
+                #endif
                 return (pRingBuffer && State == state_active) ? pRingBuffer->write_space() / SampleInfo.BytesPerSample : 0;
             }
 
             inline int GetWriteSpaceToEnd() {
+                #if CONFIG_MMAP_STREAMING
+                if (pMappedData)
+                    return (State == state_active) ? GetMappedWriteSpace() : 0;
+                #endif
                 return (pRingBuffer && State == state_active) ? pRingBuffer->write_space_to_end_with_wrap() / SampleInfo.BytesPerSample : 0;
             }
 
@@ -94,18 +132,38 @@ namespace LinuxSampler {
             // within the buffer (needed for interpolation) getting filled only partially
             // for more infos see the docs in ringbuffer.h at adjust_write_space_to_avoid_boundary()
             inline int AdjustWriteSpaceToAvoidBoundary(int cnt, int capped_cnt) {
+              #if CONFIG_MMAP_STREAMING
+              if (pMappedData) return capped_cnt; // a mapping has no buffer boundary
+              #endif
               return pRingBuffer->adjust_write_space_to_avoid_boundary (cnt * SampleInfo.BytesPerSample, capped_cnt * SampleInfo.BytesPerSample) / SampleInfo.BytesPerSample;
             }
 
             // gets the current read_ptr within the ringbuffer
             inline uint8_t* GetReadPtr(void) {
+                #if CONFIG_MMAP_STREAMING
+                if (pMappedData)
+                    return pMappedData + MappedReadPos.load(memory_order_relaxed) * SampleInfo.BytesPerSample;
+                #endif
                 return pRingBuffer->get_read_ptr();
             }
 
             inline void IncrementReadPos(uint Count)  {
+                #if CONFIG_MMAP_STREAMING
+                if (pMappedData) {
+                    const int readPos   = MappedReadPos.load(memory_order_relaxed);
+                    const uint leftspace = MappedFillPos.load(memory_order_acquire) - readPos;
+                    MappedReadPos.store(readPos + (int)Min(Count, leftspace), memory_order_release);
+                    if (State == state_active) TrackFill(int(leftspace - Min(Count, leftspace)));
+                    if (State == state_end && Count >= leftspace) {
+                        Reset(); // quit relation between consumer (voice) and stream and reset stream right after
+                    }
+                    return;
+                }
+                #endif
                 Count *= SampleInfo.BytesPerSample;
                 uint leftspace = pRingBuffer->read_space();
                 pRingBuffer->increment_read_ptr((int)Min(Count, leftspace));
+                if (State == state_active) TrackFill(int(leftspace - Min(Count, leftspace)) / SampleInfo.BytesPerSample);
                 if (State == state_end && Count >= leftspace) {
                     Reset(); // quit relation between consumer (voice) and stream and reset stream right after
                 }
@@ -114,6 +172,24 @@ namespace LinuxSampler {
             virtual int  ReadAhead(unsigned long SampleCount) = 0;
             virtual void WriteSilence(unsigned long SilenceSampleWords) = 0;
 
+            /**
+             * Identifies the decoder state (e.g. the file handle) this stream
+             * is read through while it is active. Streams returning the same
+             * read source are never refilled concurrently.
+             */
+            virtual const void* GetReadSource() { return this; }
+
+            /// Whether refilling this active stream requires decoding compressed sample data.
+            virtual bool IsCompressed() { return false; }
+
+            /// Capacity of the stream's buffer in sample words (0 if no buffer is attached).
+            inline int GetBufferSize() {
+                #if CONFIG_MMAP_STREAMING
+                if (pMappedData) return MappedWindowSize;
+                #endif
+                return (pRingBuffer) ? pRingBuffer->size / SampleInfo.BytesPerSample : 0;
+            }
+
             // Static Method
             inline static uint       GetUnusedStreams() { return UnusedStreams; }
 
@@ -122,11 +198,22 @@ namespace LinuxSampler {
         protected:
             // Attributes
             RingBuffer<uint8_t,false>*  pRingBuffer;
+            uint8_t*                    pBufferStorage;     ///< Memory used by pRingBuffer, owned by the disk thread's StreamBufferSlab.
+            uint                        BufferWrapElements; ///< Amount of wrap space sample words required by the interpolator.
             SampleDescription           SampleInfo;
             Sample::PlaybackState       PlaybackState;
             reference_t*                pExportReference;
             state_t                     State;
             Handle                      hThis;
+            #if CONFIG_MMAP_STREAMING
+            MappedSample*               pMapping;         ///< Mapping the stream currently plays from, NULL if the stream uses its ring buffer.
+            uint8_t*                    pMappedData;      ///< Position within the mapping where the stream started playback.
+            atomic<int>                 MappedReadPos;    ///< Read position (in sample words) relative to pMappedData, only advanced by the audio thread.
+            atomic<int>                 MappedFillPos;    ///< Amount of sample words (relative to pMappedData) made resident by the disk thread so far.
+            int                         MappedEndPos;     ///< Amount of sample words (relative to pMappedData) until the end of the sample.
+            int                         MappedWindowSize; ///< Maximum amount of sample words to be kept resident ahead of the read position.
+            #endif
+            int                         MinFillPercentage; ///< Lowest buffer fill (in percent) reached since the consumer started reading, -1 if it did not read yet.
 
             // Static Attributes
             static uint UnusedStreams; //< Reflects how many stream objects of all stream instances are currently not in use.
@@ -146,10 +233,68 @@ namespace LinuxSampler {
             virtual long Read(uint8_t* pBuf, long SamplesToRead) = 0;
             virtual void Reset() = 0;
 
+            inline bool IsMapped() {
+                #if CONFIG_MMAP_STREAMING
+                return pMappedData;
+                #else
+                return false;
+                #endif
+            }
+
+            /**
+             * Called by disk thread right after launching the stream to
+             * let the stream use @a pStorage for its ring buffer of
+             * @a Bytes size (plus wrap space). The memory must provide
+             * GetBufferStorageSize(Bytes) bytes.
+             */
+            void AttachBuffer(uint8_t* pStorage, int Bytes) {
+                pBufferStorage = pStorage;
+                pRingBuffer    = new RingBuffer<uint8_t,false>(pStorage, Bytes, GetBufferWrapBytes());
+            }
+
+            /**
+             * Called by disk thread when the stream is no longer in use.
+             * Returns the memory previously given by AttachBuffer().
+             */
+            uint8_t* DetachBuffer() {
+                uint8_t* pStorage = pBufferStorage;
+                if (pRingBuffer) delete pRingBuffer;
+                pRingBuffer    = NULL;
+                pBufferStorage = NULL;
+                return pStorage;
+            }
+
+            /// Amount of memory in bytes a ring buffer of @a Bytes size actually requires.
+            inline int GetBufferStorageSize(int Bytes) {
+                return RingBuffer<uint8_t,false>::storage_size(Bytes, GetBufferWrapBytes());
+            }
+
+            inline int GetBufferWrapBytes() {
+                return int(BufferWrapElements) * SampleInfo.BytesPerSample;
+            }
+
         private:
 
             // Methods
             inline long Min(long a, long b) { return (a < b) ? a : b; }
+
+            /// Called by the audio thread with the buffer fill (in sample words) left after reading.
+            inline void TrackFill(int ReadSpace) {
+                const int size = GetBufferSize();
+                if (!size) return;
+                const int percentage = int(int64_t(ReadSpace) * 100 / size);
+                if (MinFillPercentage < 0 || percentage < MinFillPercentage)
+                    MinFillPercentage = percentage;
+            }
+
+            #if CONFIG_MMAP_STREAMING
+            inline int GetMappedWriteSpace() {
+                const int resident = MappedFillPos.load(memory_order_relaxed) - MappedReadPos.load(memory_order_acquire);
+                const int left     = MappedEndPos - MappedFillPos.load(memory_order_relaxed);
+                const int space    = MappedWindowSize - resident;
+                return (space < left) ? space : left;
+            }
+            #endif
     };
 } // namespace LinuxSampler
 
@@ -50,7 +50,7 @@ namespace LinuxSampler {
 
             virtual ~StreamBase() {
                 Reset();
-                if (pRingBuffer) delete pRingBuffer;
+                if (pRingBuffer) delete pRingBuffer; // its memory is freed by the disk thread's slab
         	UnusedStreams--;
         	TotalStreams--;
             }
@@ -60,6 +60,9 @@ namespace LinuxSampler {
                 if (this->State == state_unused) return -1;
                 if (this->State == state_end)    return  0;
                 if (!SampleCount)                return  0;
+                #if CONFIG_MMAP_STREAMING
+                if (pMappedData) return ReadAheadMapped(SampleCount);
+                #endif
                 if (!pRingBuffer->write_space()) return  0;
 
                 long samplestoread = SampleCount / SampleInfo.ChannelsPerFrame;
@@ -74,6 +77,17 @@ namespace LinuxSampler {
             }
 
             virtual void WriteSilence(unsigned long SilenceSampleWords) {
+                #if CONFIG_MMAP_STREAMING
+                if (pMappedData) {
+                    // the mapping's null extension already is the silence,
+                    // so just make it readable (without exceeding it)
+                    const int fill    = MappedFillPos.load(memory_order_relaxed);
+                    const int maxFill = MappedEndPos + int(pMapping->GetNullExtensionSize() / SampleInfo.BytesPerSample);
+                    const int n       = (int(SilenceSampleWords) < maxFill - fill) ? int(SilenceSampleWords) : maxFill - fill;
+                    if (n > 0) MappedFillPos.store(fill + n, memory_order_release);
+                    return;
+                }
+                #endif
                 memset(pRingBuffer->get_write_ptr(), 0, SilenceSampleWords * SampleInfo.BytesPerSample);
                 pRingBuffer->increment_write_ptr_with_wrap(int(SilenceSampleWords * SampleInfo.BytesPerSample));
             }
@@ -99,6 +113,36 @@ namespace LinuxSampler {
                 SetState(state_active);
             }
 
+            #if CONFIG_MMAP_STREAMING
+            /**
+             * Called by disk thread right after Launch() to let the stream
+             * play directly from the memory mapped sample data @a pMapping
+             * instead of from its ring buffer. This is only possible if the
+             * mapping covers exactly the sample data of the launched stream
+             * and the stream does not loop. The stream holds a reference to
+             * the mapping from then on, until it is reset.
+             *
+             * @returns true if the stream is now using the mapping, false if
+             *          it remains an ordinary ring buffer based stream
+             */
+            bool PlayFromMapping(MappedSample* pMapping) {
+                if (!pMapping || !pMapping->IsMapped() || DoLoop) return false;
+                if (this->State != state_active) return false;
+                if (pMapping->GetSize() != size_t(SampleInfo.TotalSampleCount) * SampleInfo.FrameSize) return false;
+                if (SampleOffset >= (unsigned long) SampleInfo.TotalSampleCount) return false;
+                pMapping->Retain();
+                this->pMapping     = pMapping;
+                this->pMappedData  = pMapping->GetData() + SampleOffset * SampleInfo.FrameSize;
+                this->MappedEndPos = int(SampleInfo.TotalSampleCount - SampleOffset) * SampleInfo.ChannelsPerFrame;
+                MappedReadPos.store(0);
+                MappedFillPos.store(0, memory_order_release);
+                // let the kernel read the first part ahead asynchronously,
+                // the disk thread will pre-fault it on its next refill cycle
+                pMapping->Prefetch(SampleOffset * SampleInfo.FrameSize, size_t(MappedWindowSize) * SampleInfo.BytesPerSample);
+                return true;
+            }
+            #endif
+
         protected:
             // Attributes
             unsigned long               SampleOffset;
@@ -106,12 +150,20 @@ namespace LinuxSampler {
             bool                        DoLoop;
 
             virtual void Reset() {
+                #if CONFIG_MMAP_STREAMING
+                if (pMapping) pMapping->Release();
+                pMapping                       = NULL;
+                pMappedData                    = NULL;
+                MappedEndPos                   = 0;
+                MappedReadPos.store(0);
+                MappedFillPos.store(0);
+                #endif
                 SampleOffset                   = 0;
                 pRegion                        = NULL;
                 PlaybackState.position         = 0;
                 PlaybackState.reverse          = false;
                 hThis                          = 0;
-                pRingBuffer->init(); // reset ringbuffer
+                if (pRingBuffer) pRingBuffer->init(); // reset ringbuffer (the disk thread will take it back)
                 if (State != state_unused) {
                     // we can't do 'SetPos(state_unused)' here, due to possible race conditions)
                     if (pExportReference) {
@@ -126,7 +178,31 @@ namespace LinuxSampler {
         private:
 
             // Methods
-            
+
+            #if CONFIG_MMAP_STREAMING
+            /// "Refills" a memory mapped stream by pre-faulting the pages ahead of the read position.
+            int ReadAheadMapped(unsigned long SampleCount) {
+                const int fill = MappedFillPos.load(memory_order_relaxed);
+                int words = MappedEndPos - fill;
+                if (long(SampleCount) < words) {
+                    words = int(SampleCount);
+                    words -= words % SampleInfo.ChannelsPerFrame; // keep frames complete
+                }
+                if (words <= 0) return 0;
+
+                const size_t offset = size_t(pMappedData - pMapping->GetData()) + size_t(fill) * SampleInfo.BytesPerSample;
+                const size_t bytes  = size_t(words) * SampleInfo.BytesPerSample;
+                pMapping->Prefault(offset, bytes);
+                // hint the kernel about the subsequent part as well
+                pMapping->Prefetch(offset + bytes, bytes);
+
+                MappedFillPos.store(fill + words, memory_order_release);
+
+                if (fill + words >= MappedEndPos) SetState(state_end);
+
+                return words / SampleInfo.ChannelsPerFrame;
+            }
+            #endif
     };
 } // namespace LinuxSampler
 
@@ -0,0 +1,264 @@
+/*
+ * Copyright (c) 2020 Christian Schoenebeck
+ *
+ * http://www.linuxsampler.org
+ *
+ * This file is part of LinuxSampler and released under the same terms.
+ * See README file for details.
+ */
+
+#include "StreamBlockCache.h"
+#include "../../common/global_private.h"
+
+namespace LinuxSampler {
+
+    Mutex                       StreamBlockCache::BudgetMutex;
+    size_t                      StreamBlockCache::Budget = size_t(CONFIG_DEFAULT_STREAM_CACHE_SIZE) * 1024 * 1024;
+    std::atomic<uint64_t>       StreamBlockCache::LastSource(0);
+    StreamBlockCache::shard_t   StreamBlockCache::Shards[SHARDS];
+
+    /// Amount of blocks shard @a iShard may hold with the given budget.
+    static size_t capacityOfShard(size_t Budget, int iShard, int Shards) {
+        const size_t blocks = Budget / StreamBlockCache::BLOCK_SIZE;
+        return blocks / Shards + (size_t(iShard) < blocks % Shards ? 1 : 0);
+    }
+
+    StreamBlockCache::shard_t::shard_t() :
+        pMostRecent(NULL), pLeastRecent(NULL), pFree(NULL), Allocated(0),
+        Hits(0), Misses(0)
+    {
+        // the blocks themselves are not allocated before the cache is used
+        Capacity = capacityOfShard(Budget, int(this - Shards), SHARDS);
+    }
+
+    StreamBlockCache::shard_t& StreamBlockCache::ShardOf(const key_t& key) {
+        // consecutive blocks of a sample end up in different shards, so
+        // streams of the same sample do not contend for the same lock
+        const size_t h = (size_t(key.Source) * 31 + (size_t(key.pSample) >> 4)) * 31 + key.Block;
+        return Shards[h % SHARDS];
+    }
+
+    /**
+     * Copies up to @a FrameCount sample points from offset @a Offset of the
+     * cached block @a key (if it exists) to @a pDst.
+     *
+     * @returns amount of sample points copied or -1 if the block is not cached
+     */
+    long StreamBlockCache::CopyFromBlock(shard_t& shard, const key_t& key, long Offset, uint8_t* pDst, long FrameCount, int FrameSize) {
+        LockGuard lock(shard.BlocksMutex);
+        if (!shard.Capacity) return -1; // cache disabled
+        BlockMap::iterator it = shard.Blocks.find(key);
+        if (it == shard.Blocks.end()) {
+            shard.Misses++;
+            return -1;
+        }
+        shard.Hits++;
+        block_t* pBlock = it->second;
+        Unlink(shard, pBlock);
+        LinkAsMostRecent(shard, pBlock);
+        long n = pBlock->Frames - Offset;
+        if (n > FrameCount) n = FrameCount;
+        if (n <= 0) return 0;
+        memcpy(pDst, &pBlock->pData[Offset * FrameSize], n * FrameSize);
+        return n;
+    }
+
+    /**
+     * Takes an unused block from the pool of shard @a shard, recycling its
+     * least recently used block if the pool is empty. The returned block is
+     * not part of the cache until it is passed to AddBlock() or
+     * ReturnBlock(). Returns NULL if the cache is disabled.
+     */
+    StreamBlockCache::block_t* StreamBlockCache::TakeBlock(shard_t& shard) {
+        LockGuard lock(shard.BlocksMutex);
+        if (shard.Allocated < shard.Capacity) Reserve(shard);
+        block_t* pBlock = shard.pFree;
+        if (pBlock) {
+            shard.pFree = pBlock->pNext;
+        } else if (shard.pLeastRecent) {
+            pBlock = shard.pLeastRecent;
+            Unlink(shard, pBlock);
+            shard.Blocks.erase(pBlock->key);
+        } else {
+            return NULL; // cache disabled or all blocks are currently being read
+        }
+        pBlock->pPrev = pBlock->pNext = NULL;
+        pBlock->Frames = 0;
+        return pBlock;
+    }
+
+    /// Hands the unused block @a pBlock back to the pool of shard @a shard.
+    void StreamBlockCache::ReturnBlock(shard_t& shard, block_t* pBlock) {
+        LockGuard lock(shard.BlocksMutex);
+        if (shard.Allocated > shard.Capacity) { // cache was shrunk meanwhile
+            FreeBlock(shard, pBlock);
+            return;
+        }
+        pBlock->pNext = shard.pFree;
+        shard.pFree = pBlock;
+    }
+
+    /**
+     * Adds the freshly read block @a pBlock (taken by TakeBlock() before) to
+     * the cache.
+     */
+    void StreamBlockCache::AddBlock(shard_t& shard, const key_t& key, block_t* pBlock, long Frames) {
+        pBlock->key    = key;
+        pBlock->Frames = Frames;
+
+        LockGuard lock(shard.BlocksMutex);
+        if (shard.Allocated > shard.Capacity) { // cache was shrunk meanwhile
+            FreeBlock(shard, pBlock);
+            return;
+        }
+        if (shard.Blocks.count(key)) { // another disk thread was faster meanwhile
+            pBlock->pNext = shard.pFree;
+            shard.pFree = pBlock;
+            return;
+        }
+        shard.Blocks[key] = pBlock;
+        LinkAsMostRecent(shard, pBlock);
+    }
+
+    /// Allocates all blocks of shard @a shard's budget (shard must be locked).
+    void StreamBlockCache::Reserve(shard_t& shard) {
+        while (shard.Allocated < shard.Capacity) {
+            block_t* pBlock = new block_t;
+            pBlock->pData  = new uint8_t[BLOCK_SIZE];
+            pBlock->Frames = 0;
+            pBlock->pPrev  = NULL;
+            pBlock->pNext  = shard.pFree;
+            shard.pFree = pBlock;
+            shard.Allocated++;
+        }
+    }
+
+    void StreamBlockCache::FreeBlock(shard_t& shard, block_t* pBlock) {
+        delete[] pBlock->pData;
+        delete pBlock;
+        shard.Allocated--;
+    }
+
+    void StreamBlockCache::Unlink(shard_t& shard, block_t* pBlock) {
+        if (pBlock->pPrev) pBlock->pPrev->pNext = pBlock->pNext;
+        else               shard.pMostRecent    = pBlock->pNext;
+        if (pBlock->pNext) pBlock->pNext->pPrev = pBlock->pPrev;
+        else               shard.pLeastRecent   = pBlock->pPrev;
+        pBlock->pPrev = pBlock->pNext = NULL;
+    }
+
+    void StreamBlockCache::LinkAsMostRecent(shard_t& shard, block_t* pBlock) {
+        pBlock->pPrev = NULL;
+        pBlock->pNext = shard.pMostRecent;
+        if (shard.pMostRecent) shard.pMostRecent->pPrev = pBlock;
+        shard.pMostRecent = pBlock;
+        if (!shard.pLeastRecent) shard.pLeastRecent = pBlock;
+    }
+
+    /// Drops cached block @a pBlock and hands it back to the pool.
+    void StreamBlockCache::Evict(shard_t& shard, block_t* pBlock) {
+        Unlink(shard, pBlock);
+        shard.Blocks.erase(pBlock->key);
+        pBlock->pNext = shard.pFree;
+        shard.pFree = pBlock;
+    }
+
+    /**
+     * Frees blocks of shard @a shard until it does not exceed its capacity
+     * anymore, unused ones first, then the least recently used ones. Blocks
+     * currently being read are freed when they are handed back.
+     */
+    void StreamBlockCache::Shrink(shard_t& shard) {
+        while (shard.Allocated > shard.Capacity) {
+            if (!shard.pFree) {
+                if (!shard.pLeastRecent) break;
+                Evict(shard, shard.pLeastRecent);
+            }
+            block_t* pBlock = shard.pFree;
+            shard.pFree = pBlock->pNext;
+            FreeBlock(shard, pBlock);
+        }
+    }
+
+    void StreamBlockCache::SetBudget(size_t Bytes) {
+        LockGuard lock(BudgetMutex);
+        Budget = Bytes;
+        for (int i = 0; i < SHARDS; i++) {
+            shard_t& shard = Shards[i];
+            LockGuard shardLock(shard.BlocksMutex);
+            shard.Capacity = capacityOfShard(Bytes, i, SHARDS);
+            Shrink(shard);
+            Reserve(shard);
+        }
+        dmsg(2,("StreamBlockCache: budget set to %lu bytes\n", (unsigned long) Bytes));
+    }
+
+    size_t StreamBlockCache::GetBudget() {
+        LockGuard lock(BudgetMutex);
+        return Budget;
+    }
+
+    StreamBlockCache::statistics_t StreamBlockCache::GetStatistics() {
+        statistics_t stats;
+        stats.Budget = GetBudget();
+        stats.Usage  = 0;
+        stats.Blocks = 0;
+        stats.Hits   = 0;
+        stats.Misses = 0;
+        for (int i = 0; i < SHARDS; i++) {
+            shard_t& shard = Shards[i];
+            LockGuard lock(shard.BlocksMutex);
+            stats.Blocks += shard.Blocks.size();
+            stats.Hits   += shard.Hits;
+            stats.Misses += shard.Misses;
+        }
+        stats.Usage = stats.Blocks * BLOCK_SIZE;
+        return stats;
+    }
+
+    void StreamBlockCache::ResetStatistics() {
+        for (int i = 0; i < SHARDS; i++) {
+            LockGuard lock(Shards[i].BlocksMutex);
+            Shards[i].Hits = Shards[i].Misses = 0;
+        }
+    }
+
+    uint64_t StreamBlockCache::NewSource() {
+        return ++LastSource;
+    }
+
+    /// Drops all cached blocks of the given sample, or of the whole source if @a bWholeFile is true.
+    void StreamBlockCache::Invalidate(uint64_t Source, const void* pSample, bool bWholeFile) {
+        const key_t first = { Source, bWholeFile ? NULL : pSample, 0 };
+        for (int i = 0; i < SHARDS; i++) {
+            shard_t& shard = Shards[i];
+            LockGuard lock(shard.BlocksMutex);
+            BlockMap::iterator it = shard.Blocks.lower_bound(first);
+            while (it != shard.Blocks.end() && it->first.Source == Source &&
+                   (bWholeFile || it->first.pSample == pSample))
+            {
+                block_t* pBlock = it->second;
+                ++it;
+                Evict(shard, pBlock);
+            }
+        }
+    }
+
+    void StreamBlockCache::InvalidateSample(uint64_t Source, const void* pSample) {
+        Invalidate(Source, pSample, false);
+    }
+
+    void StreamBlockCache::InvalidateFile(uint64_t Source) {
+        Invalidate(Source, NULL, true);
+    }
+
+    void StreamBlockCache::Clear() {
+        for (int i = 0; i < SHARDS; i++) {
+            shard_t& shard = Shards[i];
+            LockGuard lock(shard.BlocksMutex);
+            while (shard.pLeastRecent)
+                Evict(shard, shard.pLeastRecent);
+        }
+    }
+
+} // namespace LinuxSampler
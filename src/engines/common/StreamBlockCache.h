@@ -0,0 +1,197 @@
+/*
+ * Copyright (c) 2020 Christian Schoenebeck
+ *
+ * http://www.linuxsampler.org
+ *
+ * This file is part of LinuxSampler and released under the same terms.
+ * See README file for details.
+ */
+
+#ifndef LS_STREAMBLOCKCACHE_H
+#define LS_STREAMBLOCKCACHE_H
+
+#include "../../common/global.h"
+#include "../../common/Mutex.h"
+#include <atomic>
+#include <map>
+#include <string.h>
+
+namespace LinuxSampler {
+
+    /** @brief Block cache shared by all disk streams.
+     *
+     * Caches sample data read by disk streams in fixed size blocks, so that
+     * the same sample being streamed by many voices at the same time (or
+     * shortly after each other, e.g. repeated notes) is only read from disk
+     * (and decompressed) once. The least recently used blocks are evicted
+     * when the cache exceeds its RAM budget. A budget of zero disables the
+     * cache entirely.
+     *
+     * Blocks are identified by source, sample and block index. A source is
+     * an opened file (or anything else the respective sampler engine reads
+     * sample data from) and identified by a number from NewSource(), which
+     * is never handed out twice. The sample is an opaque pointer provided by
+     * the engine, which only has to be unique among the samples of the same
+     * source. So blocks of a freed file can never be mistaken for the ones
+     * of a file allocated at the same address later on, even if the engine
+     * missed to invalidate them. InvalidateSample() / InvalidateFile() only
+     * free the RAM of blocks which will not be used anymore.
+     *
+     * All blocks have the same size in bytes, so the cache preallocates a
+     * pool of blocks for its whole budget and recycles them, instead of
+     * allocating memory on each cache miss. Reads of sample data are always
+     * aligned to whole blocks. To let several disk threads use the cache at
+     * the same time, blocks are distributed over shards, each with its own
+     * lock, LRU list and part of the block pool.
+     *
+     * This class is thread safe, however it may block and allocate memory,
+     * so it must only be used by disk threads, never by audio threads.
+     */
+    class StreamBlockCache {
+        public:
+            /// Size of each cache block in bytes.
+            enum { BLOCK_SIZE = 64 * 1024 };
+
+            /// Cache usage statistics.
+            struct statistics_t {
+                size_t   Budget;   ///< Maximum size of the cache in bytes.
+                size_t   Usage;    ///< Current size of all cached blocks in bytes.
+                size_t   Blocks;   ///< Current amount of cached blocks.
+                uint64_t Hits;     ///< Amount of reads served from the cache.
+                uint64_t Misses;   ///< Amount of reads which had to be read from disk.
+            };
+
+            /// Amount of sample points (frames) per cache block for the given frame size.
+            static long BlockFrames(int FrameSize) { return long(BLOCK_SIZE / FrameSize); }
+
+            /**
+             * Reads @a FrameCount sample points starting at @a FrameOffset
+             * of the given sample into @a pDst, using cached blocks where
+             * possible. Missing blocks are read by calling
+             * @a readFrames(pBuffer, FrameOffset, FrameCount) which must
+             * return the amount of frames actually read and are added to the
+             * cache afterwards.
+             *
+             * @param Source - identifies the file the sample belongs to (see NewSource())
+             * @param pSample - identifies the sample within @a Source
+             * @param FrameSize - size of one sample point (frame) in bytes
+             * @param FrameOffset - position in the sample to read from
+             * @param pDst - destination buffer
+             * @param FrameCount - amount of sample points to read
+             * @param readFrames - reads sample data from the file
+             * @returns amount of sample points actually read, which is only
+             *          smaller than @a FrameCount at the end of the sample
+             */
+            template<class F>
+            static long Read(uint64_t Source, const void* pSample, int FrameSize,
+                             unsigned long FrameOffset, uint8_t* pDst, long FrameCount,
+                             F readFrames)
+            {
+                const long blockFrames = BlockFrames(FrameSize);
+                long total = 0;
+                while (total < FrameCount) {
+                    const unsigned long pos = FrameOffset + total;
+                    const key_t key = { Source, pSample, pos / blockFrames };
+                    const long offsetInBlock = long(pos % blockFrames);
+                    uint8_t* pOut = &pDst[total * FrameSize];
+                    shard_t& shard = ShardOf(key);
+
+                    long n = CopyFromBlock(shard, key, offsetInBlock, pOut, FrameCount - total, FrameSize);
+                    if (n < 0) { // cache miss
+                        block_t* pBlock = TakeBlock(shard);
+                        if (!pBlock) { // cache disabled, read directly
+                            n = readFrames(pOut, pos, FrameCount - total);
+                        } else {
+                            const long frames = readFrames(pBlock->pData, key.Block * blockFrames, blockFrames);
+                            n = (frames > offsetInBlock) ? frames - offsetInBlock : 0;
+                            if (n > FrameCount - total) n = FrameCount - total;
+                            if (n) memcpy(pOut, &pBlock->pData[offsetInBlock * FrameSize], n * FrameSize);
+                            if (frames > 0) AddBlock(shard, key, pBlock, frames);
+                            else            ReturnBlock(shard, pBlock);
+                        }
+                    }
+                    if (n <= 0) break; // end of sample reached
+                    total += n;
+                }
+                return total;
+            }
+
+            /// Returns a new, unique source identifier (never 0).
+            static uint64_t NewSource();
+
+            /// Sets the RAM budget of the cache in bytes (0 disables the cache).
+            static void SetBudget(size_t Bytes);
+            static size_t GetBudget();
+            static statistics_t GetStatistics();
+            static void ResetStatistics();
+
+            /// Drops all cached blocks of the given sample.
+            static void InvalidateSample(uint64_t Source, const void* pSample);
+
+            /// Drops all cached blocks of all samples of the given source.
+            static void InvalidateFile(uint64_t Source);
+
+            /// Drops all cached blocks.
+            static void Clear();
+
+        private:
+            enum { SHARDS = 16 }; ///< Amount of independently locked parts of the cache.
+
+            struct key_t {
+                uint64_t      Source;
+                const void*   pSample;
+                unsigned long Block;
+
+                bool operator<(const key_t& other) const {
+                    if (Source != other.Source) return Source < other.Source;
+                    if (pSample != other.pSample) return pSample < other.pSample;
+                    return Block < other.Block;
+                }
+            };
+
+            struct block_t {
+                key_t    key;
+                uint8_t* pData;    ///< BLOCK_SIZE bytes.
+                long     Frames;   ///< Amount of valid sample points in the block.
+                block_t* pPrev;    ///< Next more recently used block.
+                block_t* pNext;    ///< Next less recently used block (next free block if in the pool).
+            };
+
+            typedef std::map<key_t, block_t*> BlockMap;
+
+            struct shard_t {
+                Mutex    BlocksMutex;   ///< Protects all attributes below.
+                BlockMap Blocks;
+                block_t* pMostRecent;   ///< Head of the LRU list.
+                block_t* pLeastRecent;  ///< Tail of the LRU list.
+                block_t* pFree;         ///< Pool of unused blocks.
+                size_t   Capacity;      ///< Maximum amount of blocks of this shard.
+                size_t   Allocated;     ///< Amount of blocks currently allocated (cached, in the pool or being read).
+                uint64_t Hits;
+                uint64_t Misses;
+
+                shard_t();
+            };
+
+            static Mutex     BudgetMutex; ///< Serializes SetBudget() calls, protects Budget.
+            static size_t    Budget;
+            static shard_t   Shards[SHARDS];
+            static std::atomic<uint64_t> LastSource;
+
+            static shard_t& ShardOf(const key_t& key);
+            static long CopyFromBlock(shard_t& shard, const key_t& key, long Offset, uint8_t* pDst, long FrameCount, int FrameSize);
+            static block_t* TakeBlock(shard_t& shard);
+            static void ReturnBlock(shard_t& shard, block_t* pBlock);
+            static void AddBlock(shard_t& shard, const key_t& key, block_t* pBlock, long Frames);
+            static void Reserve(shard_t& shard);
+            static void FreeBlock(shard_t& shard, block_t* pBlock);
+            static void Unlink(shard_t& shard, block_t* pBlock);
+            static void LinkAsMostRecent(shard_t& shard, block_t* pBlock);
+            static void Evict(shard_t& shard, block_t* pBlock);
+            static void Shrink(shard_t& shard);
+            static void Invalidate(uint64_t Source, const void* pSample, bool bWholeFile);
+    };
+
+} // namespace LinuxSampler
+
+#endif // LS_STREAMBLOCKCACHE_H
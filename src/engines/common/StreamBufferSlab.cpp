@@ -0,0 +1,116 @@
+/*
+ * Copyright (c) 2020 Christian Schoenebeck
+ *
+ * http://www.linuxsampler.org
+ *
+ * This file is part of LinuxSampler and released under the same terms.
+ * See README file for details.
+ */
+
+#include "StreamBufferSlab.h"
+#include "../../common/global_private.h"
+#include "../../common/HugePages.h"
+#include "../../common/NUMA.h"
+
+namespace LinuxSampler {
+
+    StreamBufferSlab::StreamBufferSlab(size_t Size) :
+        bMapped(false), Usage(0), Overflows(0)
+    {
+        this->Size = Size - Size % ALIGNMENT;
+        pMemory = NULL;
+        #if CONFIG_HUGE_PAGES
+        // huge pages are aligned to cache lines anyway
+        pMemory = HugePages::Map(this->Size);
+        bMapped = (pMemory != NULL);
+        #endif
+        if (!pMemory && this->Size) pMemory = new uint8_t[this->Size + ALIGNMENT];
+        pSlab   = pMemory;
+        if (pSlab) {
+            pSlab += (ALIGNMENT - size_t(pSlab) % ALIGNMENT) % ALIGNMENT;
+            FreeRanges[0] = this->Size;
+        }
+        dmsg(2,("StreamBufferSlab: %lu bytes\n", (unsigned long) this->Size));
+    }
+
+    StreamBufferSlab::~StreamBufferSlab() {
+        if (!UsedRanges.empty())
+            dmsg(1,("StreamBufferSlab: %d buffers still in use on destruction\n", (int) UsedRanges.size()));
+        #if CONFIG_HUGE_PAGES
+        if (bMapped) {
+            HugePages::Unmap(pMemory);
+            return;
+        }
+        #endif
+        if (pMemory) delete[] pMemory;
+    }
+
+    uint8_t* StreamBufferSlab::Allocate(size_t Bytes) {
+        Bytes = (Bytes + ALIGNMENT - 1) / ALIGNMENT * ALIGNMENT;
+
+        // best fit, to keep large free ranges for streams which need them
+        RangeMap::iterator best = FreeRanges.end();
+        for (RangeMap::iterator it = FreeRanges.begin(); it != FreeRanges.end(); ++it) {
+            if (it->second < Bytes) continue;
+            if (best == FreeRanges.end() || it->second < best->second) best = it;
+            if (best->second == Bytes) break;
+        }
+        if (best == FreeRanges.end()) {
+            Overflows++;
+            dmsg(2,("StreamBufferSlab: exhausted, allocating %lu bytes from heap\n", (unsigned long) Bytes));
+            return new uint8_t[Bytes];
+        }
+
+        const size_t offset = best->first;
+        const size_t left   = best->second - Bytes;
+        FreeRanges.erase(best);
+        if (left) FreeRanges[offset + Bytes] = left;
+        UsedRanges[offset] = Bytes;
+        Usage += Bytes;
+        return pSlab + offset;
+    }
+
+    void StreamBufferSlab::Free(uint8_t* pBuffer) {
+        if (!pBuffer) return;
+        if (!pSlab || pBuffer < pSlab || pBuffer >= pSlab + Size) { // heap overflow buffer
+            delete[] pBuffer;
+            return;
+        }
+
+        size_t offset = size_t(pBuffer - pSlab);
+        RangeMap::iterator used = UsedRanges.find(offset);
+        if (used == UsedRanges.end()) {
+            std::cerr << "StreamBufferSlab: attempt to free unknown buffer! Please report this!\n" << std::flush;
+            return;
+        }
+        size_t bytes = used->second;
+        UsedRanges.erase(used);
+        Usage -= bytes;
+
+        // coalesce with the following free range
+        RangeMap::iterator next = FreeRanges.lower_bound(offset);
+        if (next != FreeRanges.end() && next->first == offset + bytes) {
+            bytes += next->second;
+            FreeRanges.erase(next++);
+        }
+        // coalesce with the preceding free range
+        if (next != FreeRanges.begin()) {
+            RangeMap::iterator prev = next;
+            --prev;
+            if (prev->first + prev->second == offset) {
+                prev->second += bytes;
+                return;
+            }
+        }
+        FreeRanges[offset] = bytes;
+    }
+
+    size_t StreamBufferSlab::MoveToNumaNode(int Node) {
+        #if CONFIG_NUMA
+        return NUMA::MoveMemory(pSlab, Size, Node);
+        #else
+        return 0;
+        #endif
+    }
+
+} // namespace LinuxSampler
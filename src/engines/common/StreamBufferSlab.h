@@ -0,0 +1,90 @@
+/*
+ * Copyright (c) 2020 Christian Schoenebeck
+ *
+ * http://www.linuxsampler.org
+ *
+ * This file is part of LinuxSampler and released under the same terms.
+ * See README file for details.
+ */
+
+#ifndef LS_STREAMBUFFERSLAB_H
+#define LS_STREAMBUFFERSLAB_H
+
+#include "../../common/global.h"
+#include <map>
+#include <stddef.h>
+
+namespace LinuxSampler {
+
+    /** @brief Memory slab for disk stream ring buffers.
+     *
+     * Instead of allocating a fixed size ring buffer for each disk stream
+     * in advance, the disk thread carves a buffer of appropriate size out
+     * of this slab whenever it launches a stream and returns the buffer to
+     * the slab once the stream is no longer in use. Most streams need far
+     * less than the worst case buffer size (mono samples, 16 bit samples,
+     * low pitched notes, short one-shot samples), so the same amount of
+     * memory serves more concurrent streams this way.
+     *
+     * Buffers are handed out with a best fit strategy and adjacent free
+     * ranges are coalesced when buffers are returned. If the slab is
+     * exhausted, the requested buffer is allocated from the heap instead,
+     * so a stream launch never fails because of the slab.
+     *
+     * If huge page support is enabled (@c CONFIG_HUGE_PAGES), the slab is
+     * backed by huge pages.
+     *
+     * This class is not thread safe, it must exclusively be used by the
+     * disk thread which owns it.
+     */
+    class StreamBufferSlab {
+        public:
+            /// Creates a slab of @a Size bytes.
+            StreamBufferSlab(size_t Size);
+            virtual ~StreamBufferSlab();
+
+            /**
+             * Returns a buffer of (at least) @a Bytes size, either from the
+             * slab or, if the slab is exhausted, from the heap.
+             */
+            uint8_t* Allocate(size_t Bytes);
+
+            /// Returns a buffer previously obtained by Allocate().
+            void Free(uint8_t* pBuffer);
+
+            /// Total size of the slab in bytes.
+            size_t GetSize() const { return Size; }
+
+            /// Amount of bytes of the slab currently handed out to streams.
+            size_t GetUsage() const { return Usage; }
+
+            /// Amount of buffers which had to be allocated from the heap so far.
+            size_t GetOverflows() const { return Overflows; }
+
+            /**
+             * Moves the slab's memory to NUMA node @a Node (if NUMA support
+             * is enabled, @c CONFIG_NUMA). Unlike the other methods, this
+             * may be called by other threads than the disk thread.
+             *
+             * @returns amount of bytes of the slab residing on @a Node
+             */
+            size_t MoveToNumaNode(int Node);
+
+        private:
+            enum { ALIGNMENT = 64 }; ///< Buffers are aligned to cache lines.
+
+            typedef std::map<size_t,size_t> RangeMap; ///< Maps offset (in bytes) within the slab to size (in bytes).
+
+            uint8_t* pMemory;    ///< Memory as allocated, might not be aligned.
+            bool     bMapped;    ///< Whether @c pMemory was obtained from HugePages::Map().
+            uint8_t* pSlab;      ///< Aligned begin of the slab within @c pMemory.
+            size_t   Size;
+            size_t   Usage;
+            size_t   Overflows;
+            RangeMap FreeRanges;
+            RangeMap UsedRanges;
+    };
+
+} // namespace LinuxSampler
+
+#endif // LS_STREAMBUFFERSLAB_H
@@ -0,0 +1,187 @@
+/*
+ * Copyright (c) 2020 Christian Schoenebeck
+ *
+ * http://www.linuxsampler.org
+ *
+ * This file is part of LinuxSampler and released under the same terms.
+ * See README file for details.
+ */
+
+#include "StreamDecoderPool.h"
+#include "DiskStatistics.h"
+#include "../../common/global_private.h"
+#include "../../common/Features.h"
+
+#include <algorithm>
+
+namespace LinuxSampler {
+
+    Condition                                   StreamDecoderPool::WorkAvailable;
+    std::deque<StreamDecoderPool::batch_t*>     StreamDecoderPool::Batches;
+    bool                                        StreamDecoderPool::Quit = false;
+    Mutex                                       StreamDecoderPool::UsersMutex;
+    int                                         StreamDecoderPool::Users = 0;
+    std::vector<StreamDecoderPool::Worker*>     StreamDecoderPool::Workers;
+
+    static thread_local int iWorkerIndex = -1;
+
+    static bool CompareSource(const StreamDecoderPool::job_t& a, const StreamDecoderPool::job_t& b) {
+        return a.pSource < b.pSource;
+    }
+
+    StreamDecoderPool::Worker::Worker(int Index) : Thread(true, false, 1, -2), Index(Index) {
+    }
+
+    int StreamDecoderPool::Worker::Main() {
+        iWorkerIndex = Index;
+        while (true) {
+            WorkAvailable.WaitIf(false); // locks WorkAvailable on return
+            if (Quit) {
+                WorkAvailable.Unlock();
+                return 0;
+            }
+            batch_t* pBatch;
+            group_t group;
+            if (!TakeGroup(pBatch, group)) { // another thread was faster
+                WorkAvailable.PreLockedSet(false);
+                WorkAvailable.Unlock();
+                continue;
+            }
+            WorkAvailable.Unlock();
+            RunGroup(group);
+            FinishGroup(pBatch);
+        }
+    }
+
+    void StreamDecoderPool::Acquire() {
+        LockGuard lock(UsersMutex);
+        if (Users++) return;
+        WorkAvailable.Lock();
+        Quit = false;
+        WorkAvailable.Unlock();
+        for (int i = 0; i < WorkerCount(); i++) {
+            Worker* pWorker = new Worker(i);
+            pWorker->StartThread();
+            Workers.push_back(pWorker);
+        }
+    }
+
+    void StreamDecoderPool::Release() {
+        LockGuard lock(UsersMutex);
+        if (--Users) return;
+        // the last disk thread is gone, so there is no batch in flight
+        WorkAvailable.Lock();
+        Quit = true;
+        WorkAvailable.PreLockedSet(true);
+        WorkAvailable.Unlock();
+        for (size_t i = 0; i < Workers.size(); i++) {
+            Workers[i]->StopThread();
+            delete Workers[i];
+        }
+        Workers.clear();
+    }
+
+    bool StreamDecoderPool::IsWorkerThread() {
+        return iWorkerIndex >= 0;
+    }
+
+    int StreamDecoderPool::WorkerIndex() {
+        return iWorkerIndex;
+    }
+
+    int StreamDecoderPool::WorkerCount() {
+        if (CONFIG_STREAM_DECODE_THREADS >= 0) return CONFIG_STREAM_DECODE_THREADS;
+        return std::min(Features::processorCount() / 2, 4);
+    }
+
+    void StreamDecoderPool::RunGroup(const group_t& group) {
+        for (int i = 0; i < group.Count; i++) {
+            job_t& job = group.pJobs[i];
+            const uint64_t start = DiskStatistics::Now();
+            job.Read = job.pStream->ReadAhead(job.ReadAmount);
+            job.Microseconds = DiskStatistics::Now() - start;
+        }
+    }
+
+    /// Takes the next group of the oldest batch. WorkAvailable must be locked by the caller.
+    bool StreamDecoderPool::TakeGroup(batch_t*& pBatch, group_t& group) {
+        while (!Batches.empty()) {
+            pBatch = Batches.front();
+            if (TakeGroupOf(pBatch, group)) return true;
+            Batches.pop_front();
+        }
+        return false;
+    }
+
+    /// Takes the next group of @a pBatch. WorkAvailable must be locked by the caller.
+    bool StreamDecoderPool::TakeGroupOf(batch_t* pBatch, group_t& group) {
+        if (pBatch->NextGroup >= pBatch->Groups.size()) return false;
+        group = pBatch->Groups[pBatch->NextGroup++];
+        return true;
+    }
+
+    void StreamDecoderPool::FinishGroup(batch_t* pBatch) {
+        WorkAvailable.Lock();
+        const bool bDone = !--pBatch->PendingGroups;
+        WorkAvailable.Unlock();
+        if (bDone) pBatch->Done.Set(true);
+    }
+
+    void StreamDecoderPool::Run(job_t* pJobs, int Count) {
+        // jobs of the same source must be executed by the same thread
+        std::stable_sort(pJobs, pJobs + Count, CompareSource);
+
+        batch_t batch;
+        std::vector<group_t> rawGroups;
+        for (int i = 0; i < Count; ) {
+            group_t group = { &pJobs[i], 0 };
+            bool bDecode = false;
+            for (; i < Count && pJobs[i].pSource == group.pJobs->pSource; i++, group.Count++)
+                bDecode |= pJobs[i].Decode;
+            if (bDecode) batch.Groups.push_back(group);
+            else         rawGroups.push_back(group);
+        }
+
+        // without workers or without parallelism just refill on this thread
+        if (Workers.empty() || batch.Groups.empty() ||
+            (batch.Groups.size() == 1 && rawGroups.empty()))
+        {
+            for (int i = 0; i < Count; ) {
+                group_t group = { &pJobs[i], 0 };
+                for (; i < Count && pJobs[i].pSource == group.pJobs->pSource; i++) group.Count++;
+                RunGroup(group);
+            }
+            return;
+        }
+
+        batch.NextGroup     = 0;
+        batch.PendingGroups = int(batch.Groups.size());
+        WorkAvailable.Lock();
+        Batches.push_back(&batch);
+        WorkAvailable.PreLockedSet(true);
+        WorkAvailable.Unlock();
+
+        // read the uncompressed streams while the workers are decoding
+        for (size_t i = 0; i < rawGroups.size(); i++)
+            RunGroup(rawGroups[i]);
+
+        // then help decoding the remaining groups of this batch
+        while (true) {
+            group_t group;
+            WorkAvailable.Lock();
+            const bool bTaken = TakeGroupOf(&batch, group);
+            if (!bTaken) {
+                std::deque<batch_t*>::iterator it = std::find(Batches.begin(), Batches.end(), &batch);
+                if (it != Batches.end()) Batches.erase(it);
+            }
+            WorkAvailable.Unlock();
+            if (!bTaken) break;
+            RunGroup(group);
+            FinishGroup(&batch);
+        }
+
+        // wait for the groups still being decoded by the workers
+        batch.Done.WaitAndUnlockIf(false);
+    }
+
+} // namespace LinuxSampler
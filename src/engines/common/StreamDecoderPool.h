@@ -0,0 +1,120 @@
+/*
+ * Copyright (c) 2020 Christian Schoenebeck
+ *
+ * http://www.linuxsampler.org
+ *
+ * This file is part of LinuxSampler and released under the same terms.
+ * See README file for details.
+ */
+
+#ifndef LS_STREAMDECODERPOOL_H
+#define LS_STREAMDECODERPOOL_H
+
+#include "../../common/global.h"
+#include "../../common/Mutex.h"
+#include "../../common/Condition.h"
+#include "../../common/Thread.h"
+#include "Stream.h"
+#include <deque>
+#include <vector>
+
+namespace LinuxSampler {
+
+    /** @brief Worker threads refilling disk streams of compressed samples.
+     *
+     * Decoding compressed sample data (i.e. compressed .gig samples, FLAC
+     * or Ogg Vorbis files) is CPU bound, so with many compressed streams a
+     * single disk thread is limited by decoding long before the disk is.
+     * Disk threads therefore hand over the refills of their compressed
+     * streams to this pool, which decodes them in parallel on a set of
+     * worker threads shared by all disk threads, while the disk thread
+     * itself keeps reading the uncompressed streams meanwhile.
+     *
+     * Refills are grouped by their read source (see
+     * Stream::GetReadSource()), all refills of the same group are always
+     * executed sequentially by the same thread, since the underlying
+     * decoder state (file position, decompression state) is not thread
+     * safe. Streams whose decoder state is shared beyond the read source
+     * (like libgig's one file handle per .gig file) must not use it on
+     * worker threads (see IsWorkerThread()).
+     *
+     * The pool must only be used by disk threads, never by audio threads.
+     */
+    class StreamDecoderPool {
+        public:
+            /// One stream refill to be executed.
+            struct job_t {
+                Stream*     pStream;      ///< in: stream to be refilled
+                int         ReadAmount;   ///< in: amount of sample words to read
+                const void* pSource;      ///< in: read source of the stream
+                bool        Decode;       ///< in: whether the refill requires decoding compressed data
+                int         Read;         ///< out: result of Stream::ReadAhead()
+                uint64_t    Microseconds; ///< out: duration of the refill
+            };
+
+            /**
+             * Executes all @a Count refills of @a pJobs and returns after
+             * all of them finished. Refills which require decoding are
+             * executed by the worker threads (and the calling thread once
+             * it has no other work left), all other ones by the calling
+             * thread. Note that this method reorders @a pJobs.
+             */
+            static void Run(job_t* pJobs, int Count);
+
+            /// Must be called by each disk thread when it is created, starts the worker threads if required.
+            static void Acquire();
+
+            /// Must be called by each disk thread when it is destroyed, stops the worker threads with the last one.
+            static void Release();
+
+            /// Whether the calling thread is one of the pool's worker threads.
+            static bool IsWorkerThread();
+
+            /// Index (0 .. WorkerCount() - 1) of the calling worker thread, -1 if it is not one of the pool's worker threads.
+            static int WorkerIndex();
+
+            /**
+             * Amount of worker threads the pool runs while it is used, that
+             * is CONFIG_STREAM_DECODE_THREADS, or half the amount of CPU
+             * cores (at most 4) if configured as auto.
+             */
+            static int WorkerCount();
+
+        private:
+            struct group_t {
+                job_t* pJobs;
+                int    Count;
+            };
+
+            struct batch_t {
+                std::vector<group_t> Groups;
+                size_t               NextGroup;     ///< Index of the next group not yet taken by any thread.
+                int                  PendingGroups; ///< Amount of groups not yet finished.
+                Condition            Done;
+            };
+
+            class Worker : public Thread {
+                public:
+                    Worker(int Index);
+                protected:
+                    int Main() OVERRIDE;
+                private:
+                    int Index;
+            };
+
+            static Condition             WorkAvailable; ///< True while there are groups to be taken. Its mutex protects all static attributes below.
+            static std::deque<batch_t*>  Batches;
+            static bool                  Quit;
+            static Mutex                 UsersMutex;    ///< Protects Users and Workers.
+            static int                   Users;
+            static std::vector<Worker*>  Workers;
+
+            static void RunGroup(const group_t& group);
+            static bool TakeGroup(batch_t*& pBatch, group_t& group);
+            static bool TakeGroupOf(batch_t* pBatch, group_t& group);
+            static void FinishGroup(batch_t* pBatch);
+    };
+
+} // namespace LinuxSampler
+
+#endif // LS_STREAMDECODERPOOL_H
@@ -43,7 +43,8 @@ namespace LinuxSampler {
                 playback_state_end  = 0,
                 playback_state_init = 1,
                 playback_state_ram  = 2,
-                playback_state_disk = 3
+                playback_state_disk = 3,
+                playback_state_wait = 4  ///< Sample not cached in RAM (yet), waiting for the disk stream.
             };
 
             // Type bits. Mostly mutual exclusive, but a voice may both be of one shot type and require a release trigger at the same time.
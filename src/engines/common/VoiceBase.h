@@ -42,6 +42,7 @@ namespace LinuxSampler {
         public:
             D*   pDiskThread;  ///< Pointer to the disk thread, to be able to order a disk stream and later to delete the stream again
             int  RealSampleWordsLeftToRead; ///< Number of samples left to read, not including the silence added for the interpolator
+            uint LateStreamSamples; ///< Amount of sample points this voice already waited for its disk stream to be launched.
 
             VoiceBase(SignalUnitRack* pRack = NULL): AbstractVoice(pRack) {
                 pRegion      = NULL;
@@ -79,6 +80,7 @@ namespace LinuxSampler {
             ) {
                 this->pRegion = pRegion;
                 this->pSample = pRegion->pSample; // sample won't change until the voice is finished
+                this->LateStreamSamples = 0;
 
                 return AbstractVoice::Trigger (
                     pEngineChannel, itNoteOnEvent, PitchBend, VoiceType, iKeyGroup
@@ -87,7 +89,8 @@ namespace LinuxSampler {
 
             virtual int OrderNewStream() {
                 int res = pDiskThread->OrderNewStream (
-                    &DiskStreamRef, pRegion, MaxRAMPos + GetRAMCacheOffset(), !RAMLoop
+                    &DiskStreamRef, pRegion, MaxRAMPos + GetRAMCacheOffset(), !RAMLoop,
+                    float(Pitch.PitchBase * Pitch.PitchBend)
                 );
 
                 if (res < 0) {
@@ -141,20 +144,42 @@ namespace LinuxSampler {
                         }
                         break;
 
+                    case Voice::playback_state_wait:
+                        if (!TakeOrderedStream()) {
+                            // the sample is not cached in RAM yet, so waiting
+                            // for the stream is expected here and neither
+                            // reported nor counted as late stream
+                            LateStreamSamples += Samples;
+                            if (LateStreamSamples > uint64_t(GetEngine()->SampleRate) * CONFIG_STREAM_MAX_WAIT / 1000) {
+                                dmsg(2,("VoiceBase: disk stream of uncached sample not available in time\n"));
+                                KillImmediately();
+                                return;
+                            }
+                            SynthesizeSilence(Samples);
+                            break;
+                        }
+                        this->PlaybackState = Voice::playback_state_disk;
+                        // no break - continue with playback_state_disk
+
                     case Voice::playback_state_disk: {
-                            if (!DiskStreamRef.pStream) {
-                                // check if the disk thread created our ordered disk stream in the meantime
-                                DiskStreamRef.pStream = pDiskThread->AskForCreatedStream(DiskStreamRef.OrderID);
-                                if (!DiskStreamRef.pStream) {
-                                    std::cerr << "Disk stream not available in time!\n" << std::flush;
+                            if (!DiskStreamRef.pStream && !TakeOrderedStream()) {
+                                // the disk thread did not launch our stream in
+                                // time (e.g. due to an I/O spike): rather than
+                                // dropping the note, hold the playback position
+                                // and render silence until the stream arrives,
+                                // unless we already waited for too long
+                                if (!LateStreamSamples) pDiskThread->ReportLateStream();
+                                LateStreamSamples += Samples;
+                                if (LateStreamSamples > uint64_t(GetEngine()->SampleRate) * CONFIG_STREAM_MAX_WAIT / 1000) {
+                                    // no console output from the audio thread,
+                                    // the disk statistics count the kill
+                                    pDiskThread->ReportLateStreamKill();
                                     KillImmediately();
                                     return;
                                 }
-                                DiskStreamRef.pStream->IncrementReadPos(uint(
-                                    SmplInfo.ChannelCount * (int(finalSynthesisParameters.dPos) - MaxRAMPos)
-                                ));
-                                finalSynthesisParameters.dPos -= int(finalSynthesisParameters.dPos);
-                                RealSampleWordsLeftToRead = NO_SILENCE_STREAM_SAMPLES_YET;
+                                pDiskThread->ReportLateStreamUnderrun();
+                                SynthesizeSilence(Samples);
+                                break;
                             }
 
                             const int sampleWordsLeftToRead = DiskStreamRef.pStream->GetReadSpace();
@@ -258,6 +283,36 @@ namespace LinuxSampler {
                 EC* pChannel = static_cast<EC*>(pEngineChannel);
                 itEvent = pChannel->pMIDIKeyInfo[MIDIKey].pEvents->first();
             }
+
+        private:
+            /**
+             * Takes over the disk stream ordered on trigger, if the disk
+             * thread launched it in the meantime.
+             *
+             * @returns false if the stream is not available yet
+             */
+            bool TakeOrderedStream() {
+                DiskStreamRef.pStream = pDiskThread->AskForCreatedStream(DiskStreamRef.OrderID);
+                if (!DiskStreamRef.pStream) return false;
+                DiskStreamRef.pStream->IncrementReadPos(uint(
+                    SmplInfo.ChannelCount * (int(finalSynthesisParameters.dPos) - MaxRAMPos)
+                ));
+                finalSynthesisParameters.dPos -= int(finalSynthesisParameters.dPos);
+                RealSampleWordsLeftToRead = NO_SILENCE_STREAM_SAMPLES_YET;
+                return true;
+            }
+
+            /**
+             * Renders silence while holding the playback position. Still
+             * synthesizes (instead of skipping the fragment), so events and
+             * envelopes are processed as usual.
+             */
+            void SynthesizeSilence(uint Samples) {
+                const double pos = finalSynthesisParameters.dPos;
+                finalSynthesisParameters.dPos = 0;
+                Synthesize(Samples, (sample_t*) pDiskThread->GetSilence(), Delay);
+                finalSynthesisParameters.dPos = pos;
+            }
     };
 } // namespace LinuxSampler
 
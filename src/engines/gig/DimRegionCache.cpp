@@ -0,0 +1,84 @@
+/***************************************************************************
+ *                                                                         *
+ *   LinuxSampler - modular, streaming capable sampler                     *
+ *                                                                         *
+ *   Copyright (C) 2020 Christian Schoenebeck                              *
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ *   This program is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU General Public License for more details.                          *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public License     *
+ *   along with this program; if not, write to the Free Software           *
+ *   Foundation, Inc., 51 Franklin St, Fifth Floor, Boston,                *
+ *   MA  02110-1301  USA                                                   *
+ ***************************************************************************/
+
+#include "DimRegionCache.h"
+
+namespace LinuxSampler { namespace gig {
+
+    DimRegionCache::DimRegionCache() {
+        Reset();
+    }
+
+    void DimRegionCache::Reset() {
+        for (int i = 0; i < 128; i++) Entries[i].pRegion = NULL;
+    }
+
+    int DimRegionCache::GetIndex(int Key, ::gig::Region* pRegion, const uint* DimValues, int Epoch) {
+        uint ZoneValues[8] = { 0 };
+        uint64_t values = 0;
+        int zoneMask = 0, index = 0, bitpos = 0, velbitpos = 0, veldim = -1;
+        for (uint i = 0; i < pRegion->Dimensions; i++) {
+            const ::gig::dimension_def_t& def = pRegion->pDimensionDefinitions[i];
+            const int mask = (1 << def.bits) - 1;
+            if (def.dimension == ::gig::dimension_velocity) {
+                veldim = i;
+                velbitpos = bitpos;
+            } else if (def.split_type == ::gig::split_type_bit) {
+                index |= (DimValues[i] & mask) << bitpos;
+            } else {
+                if (DimValues[i] > 255) // does not fit into the cache entry
+                    return pRegion->GetDimensionRegionIndexByValue(DimValues);
+                ZoneValues[i] = DimValues[i];
+                values = (values << 8) | DimValues[i];
+                zoneMask |= mask << bitpos;
+            }
+            bitpos += def.bits;
+        }
+
+        entry_t& entry = Entries[Key & 127];
+        if (entry.pRegion != pRegion || entry.Epoch != Epoch || entry.Values != values) {
+            // all other dimensions set to their first zone here, they don't
+            // affect the zones of the dimensions we are looking for
+            int zones = pRegion->GetDimensionRegionIndexByValue(ZoneValues);
+            if (zones < 0) // no dimension region with those zones
+                return pRegion->GetDimensionRegionIndexByValue(DimValues);
+            entry.pRegion  = pRegion;
+            entry.Epoch    = Epoch;
+            entry.Values   = values;
+            entry.ZoneBits = zones & zoneMask;
+        }
+        index = (index | entry.ZoneBits) & 255;
+
+        if (veldim >= 0) {
+            // velocity zones may differ between the other dimension zones
+            ::gig::DimensionRegion* pDimRgn = pRegion->pDimensionRegions[index];
+            if (!pDimRgn) return -1;
+            const ::gig::dimension_def_t& def = pRegion->pDimensionDefinitions[veldim];
+            const uint velocity = DimValues[veldim] & 127;
+            const uint8_t bits = (pDimRgn->VelocityTable) ?
+                pDimRgn->VelocityTable[velocity] : uint8_t(velocity / def.zone_size);
+            index = (index | ((bits & ((1 << def.bits) - 1)) << velbitpos)) & 255;
+        }
+        return index;
+    }
+
+}} // namespace LinuxSampler::gig
@@ -0,0 +1,88 @@
+/***************************************************************************
+ *                                                                         *
+ *   LinuxSampler - modular, streaming capable sampler                     *
+ *                                                                         *
+ *   Copyright (C) 2020 Christian Schoenebeck                              *
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ *   This program is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU General Public License for more details.                          *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public License     *
+ *   along with this program; if not, write to the Free Software           *
+ *   Foundation, Inc., 51 Franklin St, Fifth Floor, Boston,                *
+ *   MA  02110-1301  USA                                                   *
+ ***************************************************************************/
+
+#ifndef __LS_GIG_DIMREGIONCACHE_H__
+#define __LS_GIG_DIMREGIONCACHE_H__
+
+#include "../../common/global.h"
+
+#if AC_APPLE_UNIVERSAL_BUILD
+# include <libgig/gig.h>
+#else
+# include <gig.h>
+#endif
+
+namespace LinuxSampler { namespace gig {
+
+    /** @brief Dimension region lookups cached per key.
+     *
+     * Same as ::gig::Region::GetDimensionRegionIndexByValue(), but caches
+     * the zones of the dimensions being split by value ranges (i.e.
+     * controller dimensions) per key. Those require searching the zone
+     * limits of the region's dimension regions, whereas the zones of all
+     * other dimensions (layer, round robin, release trigger, etc.) are
+     * directly given by their dimension values. The velocity zone is
+     * resolved with the velocity table of the dimension region though,
+     * just like libgig does.
+     *
+     * A cache entry is only used if it was made for the same region with
+     * the same values of those dimensions and the same epoch, so a
+     * controller change automatically causes a new lookup on the next
+     * note-on of the key. The caller passes a new epoch whenever regions
+     * were modified (i.e. by an instrument editor).
+     *
+     * Each gig engine channel has its own cache, which is only used by the
+     * audio thread.
+     */
+    class DimRegionCache {
+        public:
+            DimRegionCache();
+
+            /**
+             * Returns the index of the dimension region of @a pRegion
+             * selected by the dimension values @a DimValues, or -1 if
+             * there is no such dimension region.
+             *
+             * @param Key - MIDI key the region was selected for
+             * @param pRegion - region of @a Key
+             * @param DimValues - current values of all dimensions of @a pRegion
+             * @param Epoch - incremented by the caller whenever regions were modified
+             */
+            int GetIndex(int Key, ::gig::Region* pRegion, const uint* DimValues, int Epoch);
+
+            /// Drops all cached lookups (i.e. when the instrument changed).
+            void Reset();
+
+        private:
+            struct entry_t {
+                ::gig::Region* pRegion;   ///< Region of the key the entry was made for, NULL if entry is unused.
+                int            Epoch;     ///< Epoch at the time the entry was made.
+                uint64_t       Values;    ///< Values of the zoned dimensions the entry was made for, one per byte.
+                int            ZoneBits;  ///< Resulting dimension region index bits of the zoned dimensions.
+            };
+
+            entry_t Entries[128];
+    };
+
+}} // namespace LinuxSampler::gig
+
+#endif // __LS_GIG_DIMREGIONCACHE_H__
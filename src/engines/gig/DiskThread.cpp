@@ -24,6 +24,7 @@
 
 #include "DiskThread.h"
 #include "Stream.h"
+#include "../common/StreamBlockCache.h"
 #include "../../common/global_private.h"
 
 namespace LinuxSampler {
@@ -59,6 +60,49 @@ namespace gig {
         Stream* pGigStream = dynamic_cast<Stream*>(pStream);
         if(!pGigStream) throw Exception("Invalid stream type");
         pGigStream->Launch(hStream, pExportReference, pRgn, SampleOffset, DoLoop);
+        pGigStream->ReadCachedAs(pInstruments->GetCacheSource((::gig::File*) pRgn->pSample->GetParent()));
+        #if CONFIG_MMAP_STREAMING
+        if (MappedSample* pMapping = pInstruments->AcquireMappedSample(pRgn->pSample)) {
+            pGigStream->PlayFromMapping(pMapping); // takes its own reference
+            pMapping->Release();
+        }
+        #endif
+        #if CONFIG_DIRECT_IO_STREAMING
+        pGigStream->ReadDirectFrom(pInstruments->GetDirectSampleReader(pRgn->pSample));
+        #endif
     }
+
+    void DiskThread::PrefetchStream(::gig::DimensionRegion* pRgn, unsigned long SampleOffset) {
+        ::gig::Sample* pSample = pRgn->pSample;
+        if (!pSample || SampleOffset >= pSample->SamplesTotal) return;
+        long frames = long(pSample->SamplesTotal - SampleOffset);
+        // only up to the end of the cache block the stream starts in, so
+        // exactly one block is read
+        const long blockFrames = StreamBlockCache::BlockFrames(pSample->FrameSize);
+        const long blockRest = blockFrames - long(SampleOffset % blockFrames);
+        if (frames > blockRest) frames = blockRest;
+        #if CONFIG_MMAP_STREAMING
+        if (MappedSample* pMapping = pInstruments->AcquireMappedSample(pSample)) {
+            pMapping->Prefetch(SampleOffset * pSample->FrameSize, size_t(frames) * pSample->FrameSize);
+            pMapping->Release();
+            return;
+        }
+        #endif
+        // reading the data once puts it into the stream block cache (if
+        // enabled) and into the system's page cache
+        PrefetchBuffer.resize(size_t(frames) * pSample->FrameSize);
+        const uint64_t source = pInstruments->GetCacheSource((::gig::File*) pSample->GetParent());
+        #if CONFIG_DIRECT_IO_STREAMING
+        Stream::ReadCached(source, pSample, &DecompressionBuffer, SampleOffset, &PrefetchBuffer[0], frames, pInstruments->GetDirectSampleReader(pSample));
+        #else
+        Stream::ReadCached(source, pSample, &DecompressionBuffer, SampleOffset, &PrefetchBuffer[0], frames);
+        #endif
+    }
+
+#if CONFIG_LAZY_PRELOAD
+    bool DiskThread::CacheLazySample() {
+        return pInstruments->CacheLazySample(&DecompressionBuffer);
+    }
+#endif
 }} // namespace LinuxSampler::gig
 
@@ -28,6 +28,7 @@
 #include "../InstrumentManagerBase.h"
 #include "../common/DiskThreadBase.h"
 #include "InstrumentResourceManager.h"
+#include <vector>
 
 #if AC_APPLE_UNIVERSAL_BUILD
 # include <libgig/gig.h>
@@ -56,6 +57,15 @@ namespace gig {
                 bool                     DoLoop
             );
 
+            virtual void PrefetchStream(::gig::DimensionRegion* pRgn, unsigned long SampleOffset);
+
+#if CONFIG_LAZY_PRELOAD
+            virtual bool CacheLazySample();
+#endif
+
+        private:
+            std::vector<uint8_t> PrefetchBuffer; ///< Scratch buffer for PrefetchStream().
+
         public:
             DiskThread(int MaxStreams, uint BufferWrapElements, InstrumentResourceManager* pInstruments);
             virtual ~DiskThread();
@@ -232,6 +232,7 @@ namespace LinuxSampler { namespace gig {
         if (HandleKeyGroupConflicts && iLayer == 0) pChannel->HandleKeyGroupConflicts(iKeyGroup, itNoteOnEvent);
 
         Voice::type_t VoiceType = Voice::type_normal;
+        int iReleaseTriggerDim = -1; // index of the release trigger dimension (if any)
 
         // get current dimension values to select the right dimension region
         //TODO: for stolen voices this dimension region selection block is processed twice, this should be changed
@@ -254,6 +255,7 @@ namespace LinuxSampler { namespace gig {
                 case ::gig::dimension_releasetrigger:
                     VoiceType = (ReleaseTriggerVoice) ? Voice::type_release_trigger : (!iLayer) ? Voice::type_release_trigger_required : Voice::type_normal;
                     DimValues[i] = (uint) ReleaseTriggerVoice;
+                    iReleaseTriggerDim = i;
                     break;
                 case ::gig::dimension_keyboard:
                     DimValues[i] = (uint) (pChannel->CurrentKeyDimension * pRegion->pDimensionDefinitions[i].zones);
@@ -352,16 +354,7 @@ namespace LinuxSampler { namespace gig {
         // change has occured between note on and off)
         if (ReleaseTriggerVoice && !(VoiceType & Voice::type_release_trigger)) return Pool<Voice>::Iterator();
 
-        ::gig::DimensionRegion* pDimRgn;
-        if (!itNote->Format.Gig.DimMask) { // normal case ...
-            pDimRgn = pRegion->GetDimensionRegionByValue(DimValues);
-        } else { // some dimension zones were overridden (i.e. by instrument script) ...
-            dmsg(3,("trigger with dim mask=%d val=%d\n", itNote->Format.Gig.DimMask, itNote->Format.Gig.DimBits));
-            int index = pRegion->GetDimensionRegionIndexByValue(DimValues);
-            index &= ~itNote->Format.Gig.DimMask;
-            index |=  itNote->Format.Gig.DimBits & itNote->Format.Gig.DimMask;
-            pDimRgn = pRegion->pDimensionRegions[index & 255];
-        }
+        ::gig::DimensionRegion* pDimRgn = GetDimensionRegion(pChannel, NoteKey, pRegion, DimValues, itNote);
         if (!pDimRgn) return Pool<Voice>::Iterator(); // error (could not resolve dimension region)
 
         // no need to continue if sample is silent
@@ -376,11 +369,62 @@ namespace LinuxSampler { namespace gig {
                 pChannel, pDimRgn, itNoteOnEvent, VoiceType, iLayer,
                 iKeyGroup, ReleaseTriggerVoice, VoiceStealing, itNewVoice
         );
-        if (!res) return itNewVoice;
+        if (!res) {
+            // warm up the release trigger sample this note will most
+            // probably trigger on note-off, with the same dimension values
+            if (iReleaseTriggerDim >= 0 && !ReleaseTriggerVoice) {
+                DimValues[iReleaseTriggerDim] = 1;
+                ::gig::DimensionRegion* pReleaseDimRgn = GetDimensionRegion(pChannel, NoteKey, pRegion, DimValues, itNote);
+                if (pReleaseDimRgn && pReleaseDimRgn->pSample && pReleaseDimRgn->pSample->SamplesTotal) {
+                    ::gig::Sample* pReleaseSample = pReleaseDimRgn->pSample;
+                    PrefetchReleaseTriggerRegion(
+                        pChannel, pReleaseDimRgn, pReleaseSample->GetCache().Size / pReleaseSample->FrameSize,
+                        pReleaseSample->SamplesTotal, MIDIKey
+                    );
+                }
+            }
+            return itNewVoice;
+        }
 
         return Pool<Voice>::Iterator(); // no free voice or error
     }
 
+    /**
+     * Returns the dimension region of @a pRegion selected by the dimension
+     * values @a DimValues, taking dimension zones overridden for the note
+     * @a itNote (i.e. by instrument script) into account.
+     */
+    ::gig::DimensionRegion* Engine::GetDimensionRegion(EngineChannel* pChannel, int Key, ::gig::Region* pRegion, uint* DimValues, NoteIterator& itNote) {
+        int index = GetDimensionRegionIndex(pChannel, Key, pRegion, DimValues);
+        if (!itNote->Format.Gig.DimMask) // normal case ...
+            return (index < 0) ? NULL : pRegion->pDimensionRegions[index & 255];
+        // some dimension zones were overridden (i.e. by instrument script) ...
+        dmsg(3,("trigger with dim mask=%d val=%d\n", itNote->Format.Gig.DimMask, itNote->Format.Gig.DimBits));
+        index &= ~itNote->Format.Gig.DimMask;
+        index |=  itNote->Format.Gig.DimBits & itNote->Format.Gig.DimMask;
+        return pRegion->pDimensionRegions[index & 255];
+    }
+
+    /**
+     * Same as ::gig::Region::GetDimensionRegionIndexByValue(), but using the
+     * dimension region lookups cached per key by engine channel @a pChannel.
+     */
+    int Engine::GetDimensionRegionIndex(EngineChannel* pChannel, int Key, ::gig::Region* pRegion, uint* DimValues) {
+        return pChannel->DimRegions.GetIndex(Key, pRegion, DimValues, atomic_read(&DimRegionCacheEpoch));
+    }
+
+    void Engine::ResumeAll() {
+        // regions might have been modified while the engine was suspended
+        atomic_inc(&DimRegionCacheEpoch);
+        EngineBase<Voice, ::gig::Region, ::gig::DimensionRegion, DiskThread, InstrumentResourceManager, ::gig::Instrument>::ResumeAll();
+    }
+
+    void Engine::Resume(::gig::Region* pRegion) {
+        // the region might have been modified while it was suspended
+        atomic_inc(&DimRegionCacheEpoch);
+        EngineBase<Voice, ::gig::Region, ::gig::DimensionRegion, DiskThread, InstrumentResourceManager, ::gig::Instrument>::Resume(pRegion);
+    }
+
     bool Engine::DiskStreamSupported() {
         return true;
     }
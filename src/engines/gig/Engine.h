@@ -40,7 +40,7 @@ namespace LinuxSampler { namespace gig {
 
     class Engine: public LinuxSampler::EngineBase<Voice, ::gig::Region, ::gig::DimensionRegion, DiskThread, InstrumentResourceManager, ::gig::Instrument> {
         public:
-            Engine() { }
+            Engine() { atomic_set(&DimRegionCacheEpoch, 0); }
             virtual ~Engine() { }
             // implementation of abstract methods derived from class 'LinuxSampler::Engine'
             virtual bool    DiskStreamSupported() OVERRIDE;
@@ -56,6 +56,8 @@ namespace LinuxSampler { namespace gig {
             virtual void ProcessChannelPressure(LinuxSampler::EngineChannel* pEngineChannel, Pool<Event>::Iterator& itChannelPressureEvent) OVERRIDE;
             virtual void ProcessPolyphonicKeyPressure(LinuxSampler::EngineChannel* pEngineChannel, Pool<Event>::Iterator& itNotePressureEvent) OVERRIDE;
             virtual void CreateInstrumentScriptVM() OVERRIDE;
+            virtual void ResumeAll() OVERRIDE;
+            virtual void Resume(::gig::Region* pRegion) OVERRIDE;
             friend class Voice;
 
         protected:
@@ -70,6 +72,9 @@ namespace LinuxSampler { namespace gig {
                 bool                         HandleKeyGroupConflicts
             ) OVERRIDE;
 
+            ::gig::DimensionRegion* GetDimensionRegion(EngineChannel* pChannel, int Key, ::gig::Region* pRegion, uint* DimValues, NoteIterator& itNote);
+            int GetDimensionRegionIndex(EngineChannel* pChannel, int Key, ::gig::Region* pRegion, uint* DimValues);
+
             virtual void TriggerNewVoices (
                 LinuxSampler::EngineChannel*  pEngineChannel,
                 RTList<Event>::Iterator&      itNoteOnEvent,
@@ -80,6 +85,9 @@ namespace LinuxSampler { namespace gig {
                 LinuxSampler::EngineChannel*  pEngineChannel,
                 RTList<Event>::Iterator&      itNoteOffEvent
             ) OVERRIDE;
+
+        private:
+            atomic_t DimRegionCacheEpoch; ///< Incremented whenever the dimension region lookups cached by the engine channels became invalid (i.e. region modified by instrument editor).
     };
 
 }} // namespace LinuxSampler::gig
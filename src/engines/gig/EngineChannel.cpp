@@ -47,6 +47,7 @@ namespace LinuxSampler { namespace gig {
     /** This method is not thread safe! */
     void EngineChannel::ResetInternal(bool bResetEngine) {
         CurrentKeyDimension = 0;
+        DimRegions.Reset();
         EngineChannelBase<Voice, ::gig::DimensionRegion, ::gig::Instrument>::ResetInternal(bResetEngine);
     }
 
@@ -111,6 +112,10 @@ namespace LinuxSampler { namespace gig {
             if (!newInstrument) {
                 throw InstrumentManagerException("resource was not created");
             }
+            // free held instruments if the memory budget is exceeded now
+            InstrumentManager::EnforceMemoryBudget();
+            // move its sample data to the NUMA node of our audio device
+            MoveInstrumentToNumaNode();
 
             if (newInstrument->ScriptSlotCount() > 1) {
                 std::cerr << "WARNING: Executing more than one real-time instrument script slot is not implemented yet!\n";
@@ -144,6 +149,10 @@ namespace LinuxSampler { namespace gig {
         RoundRobinIndex = 0;
         for (int i = 0 ; i < 128 ; i++) pMIDIKeyInfo[i].pRoundRobinIndex = NULL;
 
+        // the new instrument's regions might be allocated where the ones of
+        // an earlier instrument were
+        DimRegions.Reset();
+
         // rebuild ActiveKeyGroups map with key groups of current
         // instrument and set the round robin pointers to use one
         // counter for each region
@@ -30,6 +30,7 @@
 #include "../EngineChannelBase.h"
 #include "../EngineChannelFactory.h"
 #include "Voice.h"
+#include "DimRegionCache.h"
 
 #if AC_APPLE_UNIVERSAL_BUILD
 # include <libgig/gig.h>
@@ -62,6 +63,7 @@ namespace LinuxSampler { namespace gig {
 
             float CurrentKeyDimension;      ///< Current value (0-1.0) for the keyboard dimension, altered by pressing a keyswitching key.
             ::gig::Script* CurrentGigScript; ///< Only used when a script is updated (i.e. by instrument editor), to check whether this engine channel is actually using that specific script reference.
+            DimRegionCache DimRegions;       ///< Cached dimension region lookups by MIDI key.
 
             virtual void ProcessKeySwitchChange(int key) OVERRIDE;
 
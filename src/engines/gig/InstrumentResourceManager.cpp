@@ -23,13 +23,20 @@
  ***************************************************************************/
 
 #include <sstream>
+#include <algorithm>
+#include <string.h>
+#include <math.h>
+#include <atomic>
 
 #include "InstrumentResourceManager.h"
 #include "EngineChannel.h"
 #include "Engine.h"
+#include "Stream.h"
 
 #include "../../common/global_private.h"
 #include "../../plugins/InstrumentEditorFactory.h"
+#include "../common/StreamBlockCache.h"
+#include "../common/SampleDataPrefetcher.h"
 
 namespace LinuxSampler { namespace gig {
 
@@ -385,6 +392,9 @@ namespace LinuxSampler { namespace gig {
         ::gig::File* pCriticalFile = dynamic_cast< ::gig::File*>(pFirstSample->GetParent());
         // completely suspend all engines that use that same file
         SuspendEnginesUsing(pCriticalFile);
+        // the removed samples' addresses might be reused by samples added
+        // later on, so forget everything cached for streaming the file
+        RenewCacheSource(pCriticalFile);
     }
 
     void InstrumentResourceManager::OnSamplesRemoved(InstrumentEditor* pSender) {
@@ -459,6 +469,12 @@ namespace LinuxSampler { namespace gig {
         dmsg(5,("gig::InstrumentResourceManager::OnDataStructureChanged(%s)\n", sStructType.c_str()));
         //TODO: remove code duplication
         if (sStructType == "gig::File") {
+            // the decoder threads' own handles of the file are outdated now
+            Stream::CloseWorkerFiles((::gig::File*) pStruct);
+            Stream::OpenWorkerFiles((::gig::File*) pStruct);
+            // samples might have been added, moved or written, so forget
+            // everything cached for streaming the file
+            RenewCacheSource((::gig::File*) pStruct);
             // resume all previously suspended engines
             ResumeAllEngines();
         } else if (sStructType == "gig::Instrument") {
@@ -468,9 +484,11 @@ namespace LinuxSampler { namespace gig {
             // we're assuming here, that OnDataStructureToBeChanged() with
             // "gig::File" was called previously, so we won't resume anything
             // here, but just re-cache the given sample
-            Lock();
             ::gig::Sample* pSample = (::gig::Sample*) pStruct;
             ::gig::File* pFile = (::gig::File*) pSample->GetParent();
+            // RAM caches are only modified with the file's load mutex locked
+            LockGuard fileLock(FileLoadMutex(pFile->GetFileName()));
+            Lock();
             UncacheInitialSamples(pSample);
             // now re-cache ...
             std::vector< ::gig::Instrument*> instruments =
@@ -540,9 +558,10 @@ namespace LinuxSampler { namespace gig {
     void InstrumentResourceManager::OnSampleReferenceChanged(void* pOldSample, void* pNewSample, InstrumentEditor* pSender) {
         // uncache old sample in case it's not used by anybody anymore
         if (pOldSample) {
-            Lock();
             ::gig::Sample* pSample = (::gig::Sample*) pOldSample;
             ::gig::File* pFile = (::gig::File*) pSample->GetParent();
+            LockGuard fileLock(FileLoadMutex(pFile->GetFileName()));
+            Lock();
             bool bSampleStillInUse = false;
             std::vector< ::gig::Instrument*> instruments =
                 GetInstrumentsCurrentlyUsedOf(pFile, false/*don't lock again*/);
@@ -557,9 +576,10 @@ namespace LinuxSampler { namespace gig {
         }
         // make sure new sample reference is cached
         if (pNewSample) {
-            Lock();
             ::gig::Sample* pSample = (::gig::Sample*) pNewSample;
             ::gig::File* pFile = (::gig::File*) pSample->GetParent();
+            LockGuard fileLock(FileLoadMutex(pFile->GetFileName()));
+            Lock();
             // get all engines that use that same gig::File
             std::set<Engine*> engines = GetEnginesUsing(pFile, false/*don't lock again*/);
             std::set<Engine*>::iterator iter = engines.begin();
@@ -571,6 +591,9 @@ namespace LinuxSampler { namespace gig {
     }
 
     ::gig::Instrument* InstrumentResourceManager::Create(instrument_id_t Key, InstrumentConsumer* pConsumer, void*& pArg) {
+        // libgig is not thread safe, instruments of other .gig files may be loaded meanwhile though
+        LockGuard fileLock(FileLoadMutex(Key.FileName));
+
         // get gig file from internal gig file manager
         ::gig::File* pGig = Gigs.Borrow(Key.FileName, reinterpret_cast<GigConsumer*>(Key.Index)); // conversion kinda hackish :/
 
@@ -595,13 +618,31 @@ namespace LinuxSampler { namespace gig {
 
         uint maxSamplesPerCycle = GetMaxSamplesPerCycle(pConsumer);
 
+        #if CONFIG_PRELOAD_SNAPSHOT
+        if (PreloadSnapshot::IsEnabled()) PreloadSnapshot::AddProvider(&SnapshotProvider);
+        #endif
+
+        #if CONFIG_LAZY_PRELOAD
+        // let the disk threads preload the samples in background
+        ScheduleInitialSamples(pInstrument, maxSamplesPerCycle);
+        #else
+        #if HAVE_PREAD
+        if (SampleDataPrefetcher::PreloadThreadCount() > 0) {
+            dmsg(1,("Reading initial samples..."));
+            PrefetchInitialSamples(pInstrument, Key);
+            dmsg(1,("OK\n"));
+        }
+        #endif
+
         // cache initial samples points (for actually needed samples)
         dmsg(1,("Caching initial samples..."));
         uint iRegion = 0; // just for progress calculation
         ::gig::Region* pRgn = pInstrument->GetFirstRegion();
         while (pRgn) {
-            // we randomly schedule 90% for the .gig file loading and the remaining 10% now for sample caching
-            const float localProgress = 0.9f + 0.1f * (float) iRegion / (float) pInstrument->Regions;
+            // we randomly schedule 90% for the .gig file loading, 5% for
+            // reading the sample data ahead and the remaining 5% now for
+            // sample caching
+            const float localProgress = 0.95f + 0.05f * (float) iRegion / (float) pInstrument->Regions;
             DispatchResourceProgressEvent(Key, localProgress);
 
             if (pRgn->GetSample() && !pRgn->GetSample()->GetCache().Size) {
@@ -616,6 +657,7 @@ namespace LinuxSampler { namespace gig {
             iRegion++;
         }
         dmsg(1,("OK\n"));
+        #endif // CONFIG_LAZY_PRELOAD
         DispatchResourceProgressEvent(Key, 1.0f); // done; notify all consumers about progress 100%
 
         // we need the following for destruction later
@@ -647,15 +689,36 @@ namespace LinuxSampler { namespace gig {
         ::gig::File* gig = pRegInfo->file;
         ::RIFF::File* riff = static_cast< ::RIFF::File*>(pRegInfo->pArg);
         if (gig) {
+            #if CONFIG_LAZY_PRELOAD
+            {
+                LockGuard lock(LazySamplesMutex);
+                UnscheduleLazySample(pSample);
+            }
+            #endif
+            InvalidateStreamedSample(pSample);
+            #if CONFIG_MMAP_STREAMING
+            UnmapSampleData(pSample);
+            #endif
+            #if CONFIG_DIRECT_IO_STREAMING
+            CloseDirectReader(pSample);
+            #endif
             gig->DeleteSample(pSample);
             if (!gig->GetFirstSample()) {
                 dmsg(2,("No more samples in use - freeing gig\n"));
+                Stream::CloseWorkerFiles(gig);
+                DropCacheSource(gig);
                 delete gig;
                 delete riff;
             }
         }
     }
 
+    void InstrumentResourceManager::CollectSamples(::gig::Instrument* pInstrument, std::set< ::gig::Sample*>& samples) {
+        for (::gig::Region* pRgn = pInstrument->GetFirstRegion(); pRgn; pRgn = pInstrument->GetNextRegion())
+            for (uint i = 0; i < pRgn->DimensionRegions; i++)
+                if (pRgn->pDimensionRegions[i]->pSample) samples.insert(pRgn->pDimensionRegions[i]->pSample);
+    }
+
     /**
      * Just a wrapper around the other @c CacheInitialSamples() method.
      *
@@ -696,6 +759,12 @@ namespace LinuxSampler { namespace gig {
         }
         if (!pSample->SamplesTotal) return; // skip zero size samples
 
+        #if CONFIG_LAZY_PRELOAD
+        // disk threads might preload samples meanwhile (see CacheLazySample())
+        LockGuard lock(LazySamplesMutex);
+        UnscheduleLazySample(pSample);
+        #endif
+
         if (pSample->SamplesTotal <= CONFIG_PRELOAD_SAMPLES) {
             // Sample is too short for disk streaming, so we load the whole
             // sample into RAM and place 'pAudioIO->FragmentSize << CONFIG_MAX_PITCH'
@@ -706,22 +775,547 @@ namespace LinuxSampler { namespace gig {
             const uint currentlyCachedSilenceSamples = uint(pSample->GetCache().NullExtensionSize / pSample->FrameSize);
             if (currentlyCachedSilenceSamples < neededSilenceSamples) {
                 dmsg(3,("Caching whole sample (sample name: \"%s\", sample size: %llu)\n", pSample->pInfo->Name.c_str(), (long long)pSample->SamplesTotal));
-                ::gig::buffer_t buf = pSample->LoadSampleDataWithNullSamplesExtension(neededSilenceSamples);
-                dmsg(4,("Cached %llu Bytes, %llu silence bytes.\n", (long long)buf.Size, (long long)buf.NullExtensionSize));
+                CacheSampleData(pSample, pSample->SamplesTotal, neededSilenceSamples);
+                dmsg(4,("Cached %llu Bytes, %llu silence bytes.\n", (long long)pSample->GetCache().Size, (long long)pSample->GetCache().NullExtensionSize));
             }
         }
         else { // we only cache CONFIG_PRELOAD_SAMPLES and stream the other sample points from disk
-            if (!pSample->GetCache().Size) pSample->LoadSampleData(CONFIG_PRELOAD_SAMPLES);
+            if (!pSample->GetCache().Size) CacheSampleData(pSample, CONFIG_PRELOAD_SAMPLES, 0);
+            #if CONFIG_MMAP_STREAMING
+            MapSampleData(pSample, maxSamplesPerCycle);
+            #endif
+            #if CONFIG_DIRECT_IO_STREAMING
+            OpenDirectReader(pSample);
+            #endif
         }
 
         if (!pSample->GetCache().Size) std::cerr << "Unable to cache sample - maybe memory full!" << std::endl << std::flush;
     }
 
+    /**
+     * Loads the first @a SampleCount sample points of the given sample into
+     * its RAM cache, followed by @a NullSamplesCount silence sample points.
+     * The data is taken from the preload snapshot if possible, otherwise
+     * it is read from the .gig file by libgig.
+     */
+    void InstrumentResourceManager::CacheSampleData(::gig::Sample* pSample, ::RIFF::file_offset_t SampleCount, uint NullSamplesCount) {
+        #if CONFIG_PRELOAD_SNAPSHOT
+        if (!LoadSampleDataFromSnapshot(pSample, SampleCount, NullSamplesCount)) {
+            PreloadSnapshot::SetModified();
+            pSample->LoadSampleDataWithNullSamplesExtension(SampleCount, NullSamplesCount);
+        }
+        #else
+        pSample->LoadSampleDataWithNullSamplesExtension(SampleCount, NullSamplesCount);
+        #endif
+    }
+
+    /**
+     * Returns the number identifying the given opened gig file in the
+     * StreamBlockCache (see StreamBlockCache::NewSource()). Called by the
+     * disk threads when launching and prefetching disk streams.
+     */
+    uint64_t InstrumentResourceManager::GetCacheSource(::gig::File* pFile) {
+        LockGuard lock(CacheSourcesMutex);
+        uint64_t& source = CacheSources[pFile];
+        if (!source) source = StreamBlockCache::NewSource();
+        return source;
+    }
+
+    /**
+     * Assigns a new number to the given gig file for the StreamBlockCache,
+     * so no data cached for the file so far is used anymore. Called when the
+     * file was opened and when it was modified by an instrument editor.
+     */
+    void InstrumentResourceManager::RenewCacheSource(::gig::File* pFile) {
+        LockGuard lock(CacheSourcesMutex);
+        uint64_t& source = CacheSources[pFile];
+        if (source) StreamBlockCache::InvalidateFile(source);
+        source = StreamBlockCache::NewSource();
+    }
+
+    /// Drops the blocks of the given sample from the StreamBlockCache.
+    void InstrumentResourceManager::InvalidateStreamedSample(::gig::Sample* pSample) {
+        LockGuard lock(CacheSourcesMutex);
+        std::map< ::gig::File*, uint64_t>::iterator it = CacheSources.find((::gig::File*) pSample->GetParent());
+        if (it != CacheSources.end()) StreamBlockCache::InvalidateSample(it->second, pSample);
+    }
+
+    /// Called right before the given gig file is freed.
+    void InstrumentResourceManager::DropCacheSource(::gig::File* pFile) {
+        LockGuard lock(CacheSourcesMutex);
+        std::map< ::gig::File*, uint64_t>::iterator it = CacheSources.find(pFile);
+        if (it == CacheSources.end()) return;
+        StreamBlockCache::InvalidateFile(it->second);
+        CacheSources.erase(it);
+    }
+
     void InstrumentResourceManager::UncacheInitialSamples(::gig::Sample* pSample) {
         dmsg(1,("Uncaching sample %p\n",(void*)pSample));
+        #if CONFIG_LAZY_PRELOAD
+        LockGuard lock(LazySamplesMutex);
+        UnscheduleLazySample(pSample);
+        #endif
         if (pSample->GetCache().Size) pSample->ReleaseSampleData();
+        InvalidateStreamedSample(pSample);
+        #if CONFIG_MMAP_STREAMING
+        UnmapSampleData(pSample);
+        #endif
+        #if CONFIG_DIRECT_IO_STREAMING
+        CloseDirectReader(pSample);
+        #endif
+    }
+
+#if CONFIG_MMAP_STREAMING || CONFIG_DIRECT_IO_STREAMING || HAVE_PREAD || CONFIG_PRELOAD_SNAPSHOT || CONFIG_LAZY_PRELOAD
+    // gives access to the (protected) wave data chunk of a sample
+    struct SampleDataChunkAccessor : public ::gig::Sample {
+        static ::RIFF::Chunk* GetDataChunk(::gig::Sample* pSample) {
+            return pSample->*(&SampleDataChunkAccessor::pCkData);
+        }
+    };
+#endif
+
+#if CONFIG_PRELOAD_SNAPSHOT || CONFIG_LAZY_PRELOAD
+    // gives access to the (protected) RAM cache of a sample
+    struct SampleCacheAccessor : public ::gig::Sample {
+        static ::gig::buffer_t& GetCache(::gig::Sample* pSample) {
+            return pSample->*(&SampleCacheAccessor::RAMCache);
+        }
+    };
+#endif
+
+#if CONFIG_PRELOAD_SNAPSHOT || CONFIG_LAZY_PRELOAD
+    /**
+     * Replaces the RAM cache of the given sample by the (completely filled)
+     * buffer @a pData, which must have been allocated with new int8_t[]. A
+     * previous RAM cache must have been allocated
+     * with new int8_t[] as well. The size is assigned last, since voices
+     * only start reading a sample's RAM cache once they see it's not empty
+     * anymore.
+     */
+    static void SetSampleCache(::gig::Sample* pSample, int8_t* pData, ::RIFF::file_offset_t Size, ::RIFF::file_offset_t NullExtensionSize) {
+        ::gig::buffer_t& cache = SampleCacheAccessor::GetCache(pSample);
+        if (cache.pStart) delete[] (int8_t*) cache.pStart;
+        cache.pStart            = pData;
+        cache.NullExtensionSize = NullExtensionSize;
+        std::atomic_thread_fence(std::memory_order_release);
+        cache.Size              = Size;
+    }
+#endif
+
+#if CONFIG_PRELOAD_SNAPSHOT
+    /**
+     * Copies the first @a Size bytes of the given sample from the preload
+     * snapshot to @a pDst. The sample's data chunk position in the .gig
+     * file serves as sample ID in the snapshot.
+     *
+     * @returns false if the snapshot has no valid data for this sample
+     */
+    static bool ReadSnapshotData(::gig::Sample* pSample, int8_t* pDst, ::RIFF::file_offset_t Size) {
+        if (!PreloadSnapshot::IsEnabled()) return false;
+        ::RIFF::Chunk* ck = SampleDataChunkAccessor::GetDataChunk(pSample);
+        if (!ck) return false;
+        return PreloadSnapshot::Read(ck->GetFile()->GetFileName(), ck->GetFilePos(), pDst, Size);
     }
 
+    /**
+     * Fills the RAM cache of the given sample the same way as libgig's
+     * LoadSampleDataWithNullSamplesExtension() would do, but with the
+     * data stored in the preload snapshot.
+     *
+     * @returns false if the snapshot has no valid data for this sample
+     */
+    bool InstrumentResourceManager::LoadSampleDataFromSnapshot(::gig::Sample* pSample, ::RIFF::file_offset_t SampleCount, uint NullSamplesCount) {
+        if (!PreloadSnapshot::IsEnabled()) return false;
+        if (SampleCount > pSample->SamplesTotal) SampleCount = pSample->SamplesTotal;
+        const ::RIFF::file_offset_t size = SampleCount * pSample->FrameSize;
+        const ::RIFF::file_offset_t nullExtensionSize = ::RIFF::file_offset_t(NullSamplesCount) * pSample->FrameSize;
+
+        int8_t* pData = new int8_t[size + nullExtensionSize];
+        if (!ReadSnapshotData(pSample, pData, size)) {
+            delete[] pData;
+            return false;
+        }
+        memset(pData + size, 0, nullExtensionSize);
+        SetSampleCache(pSample, pData, size, nullExtensionSize);
+        return true;
+    }
+
+    /**
+     * Only collects the samples to be written while the instrument manager
+     * is locked. Their .gig files are borrowed meanwhile, so the samples are
+     * not freed while the snapshot is written, and each sample's RAM cache
+     * is copied with its file's load mutex locked, which all modifications
+     * of the RAM caches are serialized with.
+     */
+    void InstrumentResourceManager::PreloadSnapshotProvider::WritePreloadSnapshot(PreloadSnapshot::Writer& writer) {
+        GigConsumer* pConsumer = reinterpret_cast<GigConsumer*>(this); // conversion kinda hackish :/
+        std::vector< ::gig::Sample*> samples;
+        std::vector< ::gig::File*> files;
+        parent->Lock();
+        {
+            std::set< ::gig::Sample*> collected; // shared samples are only stored once
+            std::vector< ::gig::Instrument*> instruments = parent->Resources(false/*don't lock again*/);
+            for (size_t i = 0; i < instruments.size(); i++) {
+                ::gig::Instrument* pInstrument = instruments[i];
+                for (::gig::Region* pRgn = pInstrument->GetFirstRegion(); pRgn; pRgn = pInstrument->GetNextRegion()) {
+                    for (int j = -1; j < int(pRgn->DimensionRegions); j++) {
+                        ::gig::Sample* pSample = (j < 0) ? pRgn->GetSample() : pRgn->pDimensionRegions[j]->pSample;
+                        if (!pSample || !pSample->GetCache().Size) continue;
+                        if (collected.insert(pSample).second) samples.push_back(pSample);
+                    }
+                }
+                ::gig::File* pFile = (::gig::File*) pInstrument->GetParent();
+                if (std::find(files.begin(), files.end(), pFile) == files.end()) {
+                    parent->Gigs.Borrow(pFile->GetFileName(), pConsumer);
+                    files.push_back(pFile);
+                }
+            }
+        }
+        parent->Unlock();
+
+        std::vector<int8_t> data;
+        for (size_t i = 0; i < samples.size(); i++) {
+            ::RIFF::Chunk* ck = SampleDataChunkAccessor::GetDataChunk(samples[i]);
+            if (!ck) continue;
+            {
+                ::gig::File* pFile = (::gig::File*) samples[i]->GetParent();
+                LockGuard lock(parent->FileLoadMutex(pFile->GetFileName()));
+                const ::gig::buffer_t& cache = samples[i]->GetCache();
+                const int8_t* pStart = (const int8_t*) cache.pStart;
+                data.assign(pStart, pStart + cache.Size);
+            }
+            if (data.empty()) continue; // uncached meanwhile
+            writer.Add(ck->GetFile()->GetFileName(), ck->GetFilePos(), &data[0], data.size());
+        }
+
+        // same lock order as HandBackInstrument(), the .gig files might be
+        // freed now
+        LockGuard lock(parent->RegionInfoMutex);
+        for (size_t i = 0; i < files.size(); i++)
+            parent->Gigs.HandBack(files[i], pConsumer);
+    }
+#endif // CONFIG_PRELOAD_SNAPSHOT
+
+#if CONFIG_LAZY_PRELOAD
+    // returns the center of the velocity zone of the given dimension region
+    // (or 64 if the region has no velocity dimension)
+    static float VelocityZoneCenter(::gig::Region* pRgn, uint iDimRgn) {
+        uint bitpos = 0;
+        for (uint i = 0; i < pRgn->Dimensions; i++) {
+            const ::gig::dimension_def_t& def = pRgn->pDimensionDefinitions[i];
+            if (def.dimension == ::gig::dimension_velocity && def.zones) {
+                const uint zone = (iDimRgn >> bitpos) & ((1 << def.bits) - 1);
+                return (float(zone) + 0.5f) * 128.f / float(def.zones);
+            }
+            bitpos += def.bits;
+        }
+        return 64.f;
+    }
+
+    /**
+     * Defers preloading the initial sample points of all samples of
+     * @a pInstrument to the disk threads (see CacheLazySample()), so the
+     * instrument is playable right away. Samples of keys closer to the
+     * middle of the keyboard and of medium velocities are preloaded first,
+     * since they are most likely played first. Samples already preloaded
+     * (i.e. shared with another instrument) or available from the preload
+     * snapshot are cached immediately instead.
+     */
+    void InstrumentResourceManager::ScheduleInitialSamples(::gig::Instrument* pInstrument, uint maxSamplesPerCycle) {
+        const int middleKey = 60;
+        for (::gig::Region* pRgn = pInstrument->GetFirstRegion(); pRgn; pRgn = pInstrument->GetNextRegion()) {
+            const float keyDistance =
+                (middleKey < pRgn->KeyRange.low)  ? pRgn->KeyRange.low - middleKey :
+                (middleKey > pRgn->KeyRange.high) ? middleKey - pRgn->KeyRange.high : 0;
+            for (int i = -1; i < int(pRgn->DimensionRegions); i++) {
+                ::gig::Sample* pSample = (i < 0) ? pRgn->GetSample() : pRgn->pDimensionRegions[i]->pSample;
+                if (!pSample || !pSample->SamplesTotal) continue;
+                bool bCacheNow = pSample->GetCache().Size;
+                #if CONFIG_PRELOAD_SNAPSHOT
+                if (!bCacheNow) {
+                    ::RIFF::Chunk* ck = SampleDataChunkAccessor::GetDataChunk(pSample);
+                    uint64_t size = uint64_t(pSample->SamplesTotal);
+                    if (size > CONFIG_PRELOAD_SAMPLES) size = CONFIG_PRELOAD_SAMPLES;
+                    size *= pSample->FrameSize;
+                    bCacheNow = ck && PreloadSnapshot::Contains(ck->GetFile()->GetFileName(), ck->GetFilePos(), size);
+                }
+                #endif
+                if (bCacheNow) {
+                    CacheInitialSamples(pSample, maxSamplesPerCycle);
+                    continue;
+                }
+                const float velocityDistance = (i < 0) ? 0.f : fabsf(VelocityZoneCenter(pRgn, i) - 64.f);
+                LockGuard lock(LazySamplesMutex);
+                ScheduleLazySample(pSample, (keyDistance + velocityDistance) / 64.f, maxSamplesPerCycle);
+            }
+        }
+    }
+
+    /// Adds the given sample to the samples to be preloaded lazily. LazySamplesMutex must be locked by the caller.
+    void InstrumentResourceManager::ScheduleLazySample(::gig::Sample* pSample, float Priority, uint maxSamplesPerCycle) {
+        std::map< ::gig::Sample*, lazy_sample_t>::iterator it = LazySamples.find(pSample);
+        if (it != LazySamples.end()) { // already scheduled (shared by several regions)
+            if (it->second.Priority < Priority) Priority = it->second.Priority;
+            if (it->second.MaxSamplesPerCycle > maxSamplesPerCycle) maxSamplesPerCycle = it->second.MaxSamplesPerCycle;
+            LazySampleQueue.erase(std::make_pair(it->second.Priority, pSample));
+        }
+        lazy_sample_t& sample = LazySamples[pSample];
+        sample.Priority           = Priority;
+        sample.MaxSamplesPerCycle = maxSamplesPerCycle;
+        LazySampleQueue.insert(std::make_pair(Priority, pSample));
+    }
+
+    /// Removes the given sample from the samples to be preloaded lazily (if any). LazySamplesMutex must be locked by the caller.
+    void InstrumentResourceManager::UnscheduleLazySample(::gig::Sample* pSample) {
+        std::map< ::gig::Sample*, lazy_sample_t>::iterator it = LazySamples.find(pSample);
+        if (it == LazySamples.end()) return;
+        LazySampleQueue.erase(std::make_pair(it->second.Priority, pSample));
+        LazySamples.erase(it);
+    }
+
+    /**
+     * Preloads the initial sample points of the scheduled sample with the
+     * highest priority. Called by the disk threads, which are the only
+     * threads reading sample data from the .gig files while instruments are
+     * in use, so this does not interfere with their disk streams.
+     *
+     * The .gig file is read with its file load mutex being locked, since
+     * the loading of another instrument from the same file might move the
+     * file position meanwhile. If that mutex is currently locked, the
+     * sample is left scheduled instead of blocking the disk thread.
+     *
+     * @param pDecompressionBuffer - decompression buffer of the calling disk thread
+     * @returns true if a sample was preloaded, false if there was none left
+     *          or if its file is currently busy
+     */
+    bool InstrumentResourceManager::CacheLazySample(::gig::buffer_t* pDecompressionBuffer) {
+        LockGuard lock(LazySamplesMutex);
+        if (LazySampleQueue.empty()) return false;
+        ::gig::Sample* pSample = LazySampleQueue.begin()->second;
+        ::RIFF::Chunk* ck = SampleDataChunkAccessor::GetDataChunk(pSample);
+        if (!ck) {
+            UnscheduleLazySample(pSample);
+            return true;
+        }
+        // the mutex of the .gig file, the sample data might be stored in an
+        // extension file (.gx01 etc.) though
+        ::gig::File* pFile = (::gig::File*) pSample->GetParent();
+        Mutex& fileLoadMutex = FileLoadMutex(pFile->GetFileName());
+        if (!fileLoadMutex.Trylock()) return false; // try again on next run
+        const uint maxSamplesPerCycle = LazySamples[pSample].MaxSamplesPerCycle;
+        UnscheduleLazySample(pSample);
+        if (!pSample->GetCache().Size) // i.e. not cached meanwhile
+            ReadLazySample(pSample, maxSamplesPerCycle, pDecompressionBuffer);
+        fileLoadMutex.Unlock();
+        return true;
+    }
+
+    /**
+     * Called by CacheLazySample() with LazySamplesMutex and the file load
+     * mutex of the sample's file being locked.
+     */
+    void InstrumentResourceManager::ReadLazySample(::gig::Sample* pSample, uint maxSamplesPerCycle, ::gig::buffer_t* pDecompressionBuffer) {
+        // same as CacheInitialSamples(), but without exposing a partly
+        // filled RAM cache to voices triggered meanwhile
+        const bool bWholeSample = pSample->SamplesTotal <= CONFIG_PRELOAD_SAMPLES;
+        const ::RIFF::file_offset_t frames = bWholeSample ? pSample->SamplesTotal : CONFIG_PRELOAD_SAMPLES;
+        const ::RIFF::file_offset_t silenceFrames = bWholeSample ? (maxSamplesPerCycle << CONFIG_MAX_PITCH) + 6 : 0;
+        const ::RIFF::file_offset_t allocationSize = (frames + silenceFrames) * pSample->FrameSize;
+        int8_t* pData = new int8_t[allocationSize];
+        pSample->SetPos(0);
+        const ::RIFF::file_offset_t size = pSample->Read(pData, frames, pDecompressionBuffer) * pSample->FrameSize;
+        memset(pData + size, 0, allocationSize - size);
+        SetSampleCache(pSample, pData, size, allocationSize - size);
+        dmsg(3,("Lazily cached sample %p (%llu Bytes)\n", (void*)pSample, (long long)pSample->GetCache().Size));
+
+        if (!bWholeSample) {
+            #if CONFIG_MMAP_STREAMING
+            MapSampleData(pSample, maxSamplesPerCycle);
+            #endif
+            #if CONFIG_DIRECT_IO_STREAMING
+            OpenDirectReader(pSample);
+            #endif
+        }
+        #if CONFIG_PRELOAD_SNAPSHOT
+        PreloadSnapshot::SetModified();
+        #endif
+    }
+#endif // CONFIG_LAZY_PRELOAD
+
+#if HAVE_PREAD
+    /**
+     * Reads the sample data which is about to be cached by
+     * CacheInitialSamples() for all samples of @a pInstrument into the
+     * system's page cache; with several threads, in file order and merged to
+     * larger reads. Caching the samples one after another afterwards then
+     * no longer has to wait for the disk for each single sample.
+     */
+    void InstrumentResourceManager::PrefetchInitialSamples(::gig::Instrument* pInstrument, instrument_id_t& Key) {
+        SampleDataPrefetcher prefetcher;
+        std::set< ::gig::Sample*> samples;
+        for (::gig::Region* pRgn = pInstrument->GetFirstRegion(); pRgn; pRgn = pInstrument->GetNextRegion()) {
+            samples.insert(pRgn->GetSample());
+            for (uint i = 0; i < pRgn->DimensionRegions; i++)
+                samples.insert(pRgn->pDimensionRegions[i]->pSample);
+        }
+        for (std::set< ::gig::Sample*>::iterator it = samples.begin(); it != samples.end(); ++it) {
+            ::gig::Sample* pSample = *it;
+            if (!pSample || !pSample->SamplesTotal || pSample->GetCache().Size) continue;
+            ::RIFF::Chunk* ck = SampleDataChunkAccessor::GetDataChunk(pSample);
+            if (!ck) continue;
+            uint64_t size = uint64_t(pSample->SamplesTotal);
+            if (size > CONFIG_PRELOAD_SAMPLES) size = CONFIG_PRELOAD_SAMPLES;
+            size *= pSample->FrameSize;
+            #if CONFIG_PRELOAD_SNAPSHOT
+            // no need to read what is going to be taken from the snapshot
+            if (PreloadSnapshot::Contains(ck->GetFile()->GetFileName(), ck->GetFilePos(), size)) continue;
+            #endif
+            // (compressed data is smaller, so this covers it as well)
+            if (size > ck->GetSize()) size = ck->GetSize();
+            prefetcher.Add(ck->GetFile()->GetFileName(), ck->GetFilePos(), size);
+        }
+
+        progress_callback_arg_t callbackArg;
+        callbackArg.pManager       = this;
+        callbackArg.pInstrumentKey = &Key;
+        prefetcher.Run(
+            SampleDataPrefetcher::PreloadThreadCount(),
+            [](float fProgress, void* pCustom) {
+                progress_callback_arg_t* pArg = static_cast<progress_callback_arg_t*>(pCustom);
+                pArg->pManager->DispatchResourceProgressEvent(*pArg->pInstrumentKey, 0.9f + 0.05f * fProgress);
+            },
+            &callbackArg
+        );
+    }
+#endif // HAVE_PREAD
+
+#if CONFIG_MMAP_STREAMING || CONFIG_DIRECT_IO_STREAMING
+
+    /**
+     * Returns the wave data chunk of the given sample, if its raw wave data
+     * can be used by the synthesis code as is (uncompressed 16 bit or 24 bit
+     * samples), NULL otherwise.
+     */
+    static ::RIFF::Chunk* GetRawSampleDataChunk(::gig::Sample* pSample) {
+        if (pSample->Compressed) return NULL;
+        #if WORDS_BIGENDIAN // 16 bit samples would need endian conversion
+        if (pSample->BitDepth != 24) return NULL;
+        #else
+        if (pSample->BitDepth != 16 && pSample->BitDepth != 24) return NULL;
+        #endif
+
+        ::RIFF::Chunk* ck = SampleDataChunkAccessor::GetDataChunk(pSample);
+        if (!ck) return NULL;
+        if (ck->GetSize() < size_t(pSample->SamplesTotal) * pSample->FrameSize) return NULL;
+        return ck;
+    }
+#endif // CONFIG_MMAP_STREAMING || CONFIG_DIRECT_IO_STREAMING
+
+#if CONFIG_MMAP_STREAMING
+    /**
+     * Maps the wave data of the given sample read-only into memory, so the
+     * disk thread can stream it directly from the mapping. Only uncompressed
+     * 16 bit and 24 bit samples are mapped, all other samples are streamed
+     * through the streams' ring buffers as usual.
+     *
+     * @param pSample - sample to be mapped
+     * @param maxSamplesPerCycle - max. samples per cycle of the audio device
+     *                             (required for the size of the silence
+     *                             following the sample data)
+     */
+    void InstrumentResourceManager::MapSampleData(::gig::Sample* pSample, uint maxSamplesPerCycle) {
+        ::RIFF::Chunk* ck = GetRawSampleDataChunk(pSample);
+        if (!ck) return;
+        const size_t size = size_t(pSample->SamplesTotal) * pSample->FrameSize;
+        const size_t nullExtensionSize = size_t((maxSamplesPerCycle << CONFIG_MAX_PITCH) + 6) * pSample->FrameSize;
+
+        LockGuard lock(MappedSamplesMutex);
+        MappedSample*& pMapping = MappedSamples[pSample];
+        if (pMapping && pMapping->GetNullExtensionSize() >= nullExtensionSize)
+            return; // already mapped
+        // streams might still play from an existing mapping, so it is never
+        // mapped again, but replaced by a new one
+        MappedSample* pNewMapping = new MappedSample;
+        if (!pNewMapping->Map(ck->GetFile()->GetFileName(), ck->GetFilePos(), size, nullExtensionSize)) {
+            dmsg(2,("Could not map sample %p, using ordinary streaming instead\n", (void*)pSample));
+            pNewMapping->Release();
+            if (!pMapping) MappedSamples.erase(pSample);
+            return;
+        }
+        if (pMapping) pMapping->Release();
+        pMapping = pNewMapping;
+    }
+
+    /**
+     * Drops the memory mapping of the given sample's wave data. Streams still
+     * playing from the mapping keep it alive until they are reset.
+     */
+    void InstrumentResourceManager::UnmapSampleData(::gig::Sample* pSample) {
+        LockGuard lock(MappedSamplesMutex);
+        std::map< ::gig::Sample*, MappedSample*>::iterator it = MappedSamples.find(pSample);
+        if (it == MappedSamples.end()) return;
+        it->second->Release();
+        MappedSamples.erase(it);
+    }
+
+    /**
+     * Returns the memory mapping of the given sample's wave data or NULL if
+     * the sample is not mapped. Called by the disk thread when launching a
+     * disk stream. The caller gets a reference to the mapping and has to
+     * call MappedSample::Release() when done with it.
+     */
+    MappedSample* InstrumentResourceManager::AcquireMappedSample(::gig::Sample* pSample) {
+        LockGuard lock(MappedSamplesMutex);
+        std::map< ::gig::Sample*, MappedSample*>::iterator it = MappedSamples.find(pSample);
+        if (it == MappedSamples.end()) return NULL;
+        it->second->Retain();
+        return it->second;
+    }
+#endif // CONFIG_MMAP_STREAMING
+
+#if CONFIG_DIRECT_IO_STREAMING
+    /**
+     * Opens the wave data of the given sample for direct I/O, so the disk
+     * thread can stream it bypassing the system's page cache. Only
+     * uncompressed 16 bit and 24 bit samples are read that way, all other
+     * samples are read by libgig as usual.
+     */
+    void InstrumentResourceManager::OpenDirectReader(::gig::Sample* pSample) {
+        ::RIFF::Chunk* ck = GetRawSampleDataChunk(pSample);
+        if (!ck) return;
+        const size_t size = size_t(pSample->SamplesTotal) * pSample->FrameSize;
+
+        LockGuard lock(DirectSamplesMutex);
+        DirectSampleReader*& pReader = DirectSamples[pSample];
+        if (pReader) return; // already opened
+        pReader = new DirectSampleReader;
+        if (!pReader->Open(ck->GetFile()->GetFileName(), ck->GetFilePos(), size, pSample->FrameSize)) {
+            dmsg(2,("Could not open sample %p for direct I/O, using ordinary streaming instead\n", (void*)pSample));
+            delete pReader;
+            DirectSamples.erase(pSample);
+        }
+    }
+
+    void InstrumentResourceManager::CloseDirectReader(::gig::Sample* pSample) {
+        LockGuard lock(DirectSamplesMutex);
+        std::map< ::gig::Sample*, DirectSampleReader*>::iterator it = DirectSamples.find(pSample);
+        if (it == DirectSamples.end()) return;
+        delete it->second;
+        DirectSamples.erase(it);
+    }
+
+    /**
+     * Returns the direct I/O reader of the given sample's wave data or NULL
+     * if the sample is not read with direct I/O. Called by the disk thread
+     * when launching a disk stream.
+     */
+    DirectSampleReader* InstrumentResourceManager::GetDirectSampleReader(::gig::Sample* pSample) {
+        LockGuard lock(DirectSamplesMutex);
+        std::map< ::gig::Sample*, DirectSampleReader*>::iterator it = DirectSamples.find(pSample);
+        return (it != DirectSamples.end()) ? it->second : NULL;
+    }
+#endif // CONFIG_DIRECT_IO_STREAMING
+
     /**
      * Returns a list with all instruments currently in use, that are part of
      * the given file.
@@ -948,9 +1542,16 @@ namespace LinuxSampler { namespace gig {
 
     ::gig::File* InstrumentResourceManager::GigResourceManager::Create(String Key, GigConsumer* pConsumer, void*& pArg) {
         dmsg(1,("Loading gig file \'%s\'...", Key.c_str()));
+        #if CONFIG_PRELOAD_SNAPSHOT
+        PreloadSnapshot::SourceLoaded(Key);
+        #endif
         ::RIFF::File* pRIFF = new ::RIFF::File(Key);
         ::gig::File* pGig   = new ::gig::File(pRIFF);
         pArg                = pRIFF;
+        // a previously freed file might have had the same address
+        parent->RenewCacheSource(pGig);
+        // decoder threads must not parse the file on their first refill
+        Stream::OpenWorkerFiles(pGig);
         dmsg(1,("OK\n"));
         return pGig;
     }
@@ -989,7 +1590,31 @@ namespace LinuxSampler { namespace gig {
             }
             if (deleteInstrument) pResource->DeleteInstrument(instrument);
         }
+        // forget all data cached for streaming of the samples to be deleted
+        for (::gig::Sample* sample = pResource->GetFirstSample() ;
+             sample ;
+             sample = pResource->GetNextSample())
+        {
+            if (deleteFile || parent->SampleRefCount.find(sample) == parent->SampleRefCount.end()) {
+                #if CONFIG_LAZY_PRELOAD
+                {
+                    // disk threads must not preload it anymore
+                    LockGuard lock(parent->LazySamplesMutex);
+                    parent->UnscheduleLazySample(sample);
+                }
+                #endif
+                parent->InvalidateStreamedSample(sample);
+                #if CONFIG_MMAP_STREAMING
+                parent->UnmapSampleData(sample);
+                #endif
+                #if CONFIG_DIRECT_IO_STREAMING
+                parent->CloseDirectReader(sample);
+                #endif
+            }
+        }
         if (deleteFile) {
+            Stream::CloseWorkerFiles(pResource);
+            parent->DropCacheSource(pResource);
             delete pResource;
             delete (::RIFF::File*) pArg;
         } else {
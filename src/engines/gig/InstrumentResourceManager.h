@@ -38,6 +38,9 @@
 #include "../../drivers/audio/AudioOutputDevice.h"
 #include "../InstrumentManager.h"
 #include "../../common/ArrayList.h"
+#include "../common/MappedSample.h"
+#include "../common/DirectSampleReader.h"
+#include "../common/PreloadSnapshot.h"
 
 //namespace libgig = gig;
 
@@ -67,7 +70,11 @@ namespace LinuxSampler { namespace gig {
      */
     class InstrumentResourceManager : public InstrumentManagerBase< ::gig::File, ::gig::Instrument, ::gig::DimensionRegion, ::gig::Sample>, public InstrumentEditorListener {
         public:
-            InstrumentResourceManager() : Gigs(this) {}
+            InstrumentResourceManager() : Gigs(this)
+#if CONFIG_PRELOAD_SNAPSHOT
+                , SnapshotProvider(this)
+#endif
+            {}
             virtual ~InstrumentResourceManager() {}
             static void OnInstrumentLoadingProgress(::gig::progress_t* pProgress);
 
@@ -87,6 +94,17 @@ namespace LinuxSampler { namespace gig {
             virtual void OnDataStructureChanged(void* pStruct, String sStructType, InstrumentEditor* pSender) OVERRIDE;
             virtual void OnSampleReferenceChanged(void* pOldSample, void* pNewSample, InstrumentEditor* pSender) OVERRIDE;
 
+            uint64_t GetCacheSource(::gig::File* pFile);
+#if CONFIG_MMAP_STREAMING
+            MappedSample* AcquireMappedSample(::gig::Sample* pSample);
+#endif
+#if CONFIG_DIRECT_IO_STREAMING
+            DirectSampleReader* GetDirectSampleReader(::gig::Sample* pSample);
+#endif
+#if CONFIG_LAZY_PRELOAD
+            bool CacheLazySample(::gig::buffer_t* pDecompressionBuffer);
+#endif
+
 #if 0 // currently unused :
             void TrySendNoteOnToEditors(uint8_t Key, uint8_t Velocity, ::gig::Instrument* pInstrument);
             void TrySendNoteOffToEditors(uint8_t Key, uint8_t Velocity, ::gig::Instrument* pInstrument);
@@ -98,10 +116,15 @@ namespace LinuxSampler { namespace gig {
             virtual void               Destroy(::gig::Instrument* pResource, void* pArg) OVERRIDE;
             virtual void               DeleteRegionIfNotUsed(::gig::DimensionRegion* pRegion, region_info_t* pRegInfo) OVERRIDE;
             virtual void               DeleteSampleIfNotUsed(::gig::Sample* pSample, region_info_t* pRegInfo) OVERRIDE;
+            virtual void               CollectSamples(::gig::Instrument* pInstrument, std::set< ::gig::Sample*>& samples) OVERRIDE;
         private:
             void                       CacheInitialSamples(::gig::Sample* pSample, AbstractEngine* pEngine);
             void                       CacheInitialSamples(::gig::Sample* pSample, EngineChannel* pEngineChannel);
             void                       CacheInitialSamples(::gig::Sample* pSample, uint maxSamplesPerCycle);
+            void                       CacheSampleData(::gig::Sample* pSample, ::RIFF::file_offset_t SampleCount, uint NullSamplesCount);
+#if HAVE_PREAD
+            void                       PrefetchInitialSamples(::gig::Instrument* pInstrument, instrument_id_t& Key);
+#endif
 
             typedef ResourceConsumer< ::gig::File> GigConsumer;
 
@@ -118,7 +141,41 @@ namespace LinuxSampler { namespace gig {
                     InstrumentResourceManager* parent;
             } Gigs;
 
+#if CONFIG_PRELOAD_SNAPSHOT
+            class PreloadSnapshotProvider : public PreloadSnapshot::Provider {
+                public:
+                    PreloadSnapshotProvider(InstrumentResourceManager* parent) : parent(parent) {}
+                    virtual void WritePreloadSnapshot(PreloadSnapshot::Writer& writer) OVERRIDE;
+                private:
+                    InstrumentResourceManager* parent;
+            } SnapshotProvider;
+
+            bool LoadSampleDataFromSnapshot(::gig::Sample* pSample, ::RIFF::file_offset_t SampleCount, uint NullSamplesCount);
+#endif
+#if CONFIG_LAZY_PRELOAD
+            struct lazy_sample_t {
+                float Priority; ///< Samples with lower values are preloaded first.
+                uint  MaxSamplesPerCycle;
+            };
+
+            void ScheduleInitialSamples(::gig::Instrument* pInstrument, uint maxSamplesPerCycle);
+            void ScheduleLazySample(::gig::Sample* pSample, float Priority, uint maxSamplesPerCycle);
+            void UnscheduleLazySample(::gig::Sample* pSample);
+            void ReadLazySample(::gig::Sample* pSample, uint maxSamplesPerCycle, ::gig::buffer_t* pDecompressionBuffer);
+#endif
+
             void UncacheInitialSamples(::gig::Sample* pSample);
+            void RenewCacheSource(::gig::File* pFile);
+            void DropCacheSource(::gig::File* pFile);
+            void InvalidateStreamedSample(::gig::Sample* pSample);
+#if CONFIG_MMAP_STREAMING
+            void MapSampleData(::gig::Sample* pSample, uint maxSamplesPerCycle);
+            void UnmapSampleData(::gig::Sample* pSample);
+#endif
+#if CONFIG_DIRECT_IO_STREAMING
+            void OpenDirectReader(::gig::Sample* pSample);
+            void CloseDirectReader(::gig::Sample* pSample);
+#endif
             std::vector< ::gig::Instrument*> GetInstrumentsCurrentlyUsedOf(::gig::File* pFile, bool bLock);
             std::set<EngineChannel*> GetEngineChannelsUsingScriptSourceCode(const String& code, bool bLock);
             std::set<EngineChannel*> GetEngineChannelsUsing(::gig::Instrument* pInstrument, bool bLock);
@@ -135,6 +192,21 @@ namespace LinuxSampler { namespace gig {
             Mutex             suspendedEnginesMutex; ///< protects 'suspendedEngines' set
             std::map< ::gig::Script*,String> pendingScriptUpdates; ///< Used to prepare updates of instrument scripts (value of the map is the original source code of the script before it is modified).
             Mutex                            pendingScriptUpdatesMutex; ///< Protectes 'pendingScriptUpdates'.
+            std::map< ::gig::File*, uint64_t> CacheSources; ///< Identifies the currently opened gig files in the StreamBlockCache.
+            Mutex                             CacheSourcesMutex; ///< Protects 'CacheSources'.
+#if CONFIG_MMAP_STREAMING
+            std::map< ::gig::Sample*, MappedSample*> MappedSamples; ///< Memory mappings of uncompressed samples which are streamed directly from their file.
+            Mutex                                    MappedSamplesMutex; ///< Protects 'MappedSamples'.
+#endif
+#if CONFIG_LAZY_PRELOAD
+            std::map< ::gig::Sample*, lazy_sample_t> LazySamples; ///< Samples whose preloading was deferred to the disk threads.
+            std::set< std::pair<float, ::gig::Sample*> > LazySampleQueue; ///< The samples of 'LazySamples' ordered by their priority.
+            Mutex                                    LazySamplesMutex; ///< Protects 'LazySamples' and 'LazySampleQueue', and serializes modifications of the samples' RAM caches.
+#endif
+#if CONFIG_DIRECT_IO_STREAMING
+            std::map< ::gig::Sample*, DirectSampleReader*> DirectSamples; ///< Direct I/O readers of uncompressed samples which are streamed bypassing the page cache.
+            Mutex                                          DirectSamplesMutex; ///< Protects 'DirectSamples'.
+#endif
     };
 
 }} // namespace LinuxSampler::gig
@@ -24,7 +24,12 @@
  ***************************************************************************/
 
 #include "Stream.h"
+#include "../common/StreamBlockCache.h"
+#include "../common/StreamDecoderPool.h"
 #include "../../common/global_private.h"
+#include "../../common/Mutex.h"
+
+#include <map>
 
 namespace LinuxSampler { namespace gig {
 
@@ -34,13 +39,145 @@ namespace LinuxSampler { namespace gig {
         uint             BufferWrapElements) : LinuxSampler::StreamBase< ::gig::DimensionRegion>(BufferSize, BufferWrapElements)
     {
         this->pDecompressionBuffer = pDecompressionBuffer;
+        this->pDirectReader = NULL;
+        this->CacheSource = 0;
+        this->bDecodeOnWorkers = false;
+    }
+
+    namespace {
+        // decompression buffer of the calling decoder pool worker thread
+        struct WorkerDecompressionBuffer {
+            ::gig::buffer_t buffer;
+            WorkerDecompressionBuffer() {
+                buffer = ::gig::Sample::CreateDecompressionBuffer(CONFIG_STREAM_MAX_REFILL_SIZE);
+            }
+            ~WorkerDecompressionBuffer() {
+                ::gig::Sample::DestroyDecompressionBuffer(buffer);
+            }
+        };
+
+        // gives access to the (protected) wave data chunk of a sample
+        struct SampleDataChunkAccessor : public ::gig::Sample {
+            static ::RIFF::Chunk* GetDataChunk(::gig::Sample* pSample) {
+                return pSample->*(&SampleDataChunkAccessor::pCkData);
+            }
+        };
+
+        typedef std::pair<String, ::RIFF::file_offset_t> sample_location_t; ///< File name and position of a sample's data chunk.
+
+        // .gig file opened separately for one decoder pool worker thread
+        struct worker_file_t {
+            ::RIFF::File* pRIFF;
+            ::gig::File*  pGig;
+            std::map<sample_location_t, ::gig::Sample*> Samples;
+        };
+
+        // key: original .gig file and index of the worker thread
+        typedef std::map<std::pair< ::gig::File*, int>, worker_file_t> WorkerFileMap;
+
+        Mutex            WorkerFilesMutex; // protects WorkerFiles
+        WorkerFileMap    WorkerFiles;
+
+        sample_location_t GetSampleLocation(::gig::Sample* pSample) {
+            ::RIFF::Chunk* ck = SampleDataChunkAccessor::GetDataChunk(pSample);
+            return (ck) ? sample_location_t(ck->GetFile()->GetFileName(), ck->GetFilePos())
+                        : sample_location_t(String(), 0);
+        }
+
+        void CloseWorkerFile(worker_file_t& file) {
+            if (file.pGig) delete file.pGig;
+            if (file.pRIFF) delete file.pRIFF;
+            file.pGig  = NULL;
+            file.pRIFF = NULL;
+            file.Samples.clear();
+        }
+    }
+
+    /**
+     * libgig reads all samples of a .gig file through one file handle, so
+     * each decoder pool worker thread decodes from its own handle of the
+     * .gig file instead. This method opens these handles for @a pFile (if it
+     * contains compressed samples at all and they are not open already). It
+     * must be called when the file was loaded or modified, so the file is
+     * never parsed on the streaming path. Samples not found in the worker
+     * handles are decoded by the disk thread instead.
+     */
+    void Stream::OpenWorkerFiles(::gig::File* pFile) {
+        const int workers = StreamDecoderPool::WorkerCount();
+        if (!workers) return;
+        bool bCompressed = false;
+        for (::gig::Sample* p = pFile->GetFirstSample(); p && !bCompressed; p = pFile->GetNextSample())
+            bCompressed = p->Compressed;
+        if (!bCompressed) return;
+        for (int i = 0; i < workers; i++) {
+            {
+                LockGuard lock(WorkerFilesMutex);
+                if (WorkerFiles.count(std::make_pair(pFile, i))) continue;
+            }
+            // parse the file without blocking the disk threads
+            worker_file_t file;
+            file.pRIFF = NULL;
+            file.pGig  = NULL;
+            try {
+                file.pRIFF = new ::RIFF::File(pFile->GetFileName());
+                file.pGig  = new ::gig::File(file.pRIFF);
+                for (::gig::Sample* p = file.pGig->GetFirstSample(); p; p = file.pGig->GetNextSample())
+                    if (SampleDataChunkAccessor::GetDataChunk(p)) file.Samples[GetSampleLocation(p)] = p;
+            } catch (::RIFF::Exception& e) {
+                std::cerr << "Could not open '" << pFile->GetFileName() << "' for the decoder threads: " << e.Message << std::endl << std::flush;
+                CloseWorkerFile(file);
+                return;
+            }
+            LockGuard lock(WorkerFilesMutex);
+            if (!WorkerFiles.insert(std::make_pair(std::make_pair(pFile, i), file)).second)
+                CloseWorkerFile(file); // opened concurrently by another thread
+        }
+    }
+
+    /**
+     * Closes the handles of the decoder pool worker threads to @a pFile.
+     * Must be called before @a pFile is freed or after it was modified,
+     * while none of its samples are streamed.
+     */
+    void Stream::CloseWorkerFiles(::gig::File* pFile) {
+        LockGuard lock(WorkerFilesMutex);
+        WorkerFileMap::iterator it = WorkerFiles.lower_bound(std::make_pair(pFile, 0));
+        while (it != WorkerFiles.end() && it->first.first == pFile) {
+            CloseWorkerFile(it->second);
+            WorkerFiles.erase(it++);
+        }
+    }
+
+    /**
+     * Returns the counterpart of @a pSample in the worker handle of the
+     * decoder pool worker thread with index @a iWorker, or NULL if there is
+     * none (see OpenWorkerFiles()).
+     */
+    ::gig::Sample* Stream::GetWorkerSample(::gig::Sample* pSample, int iWorker) {
+        ::gig::File* pFile = (::gig::File*) pSample->GetParent();
+        LockGuard lock(WorkerFilesMutex);
+        WorkerFileMap::iterator itFile = WorkerFiles.find(std::make_pair(pFile, iWorker));
+        if (itFile == WorkerFiles.end()) return NULL;
+        std::map<sample_location_t, ::gig::Sample*>::iterator it = itFile->second.Samples.find(GetSampleLocation(pSample));
+        return (it != itFile->second.Samples.end()) ? it->second : NULL;
     }
 
     long Stream::Read(uint8_t* pBuf, long SamplesToRead) {
         ::gig::Sample* pSample = pRegion->pSample;
-        long total_readsamples = 0, readsamples = 0;
+        long total_readsamples = 0;
         bool endofsamplereached;
 
+        // the disk thread's decompression buffer and file handle must not
+        // be used by the decoder pool's worker threads concurrently
+        ::gig::buffer_t* pBuffer = pDecompressionBuffer;
+        ::gig::Sample* pReader = pSample;
+        if (StreamDecoderPool::IsWorkerThread()) {
+            static thread_local WorkerDecompressionBuffer workerBuffer;
+            pBuffer = &workerBuffer.buffer;
+            pReader = GetWorkerSample(pSample, StreamDecoderPool::WorkerIndex());
+            if (!pReader) return 0; // just in case, Launch() checked it already
+        }
+
         // refill the disk stream buffer
         if (this->DoLoop) { // honor looping
             ::gig::playback_state_t pbs;
@@ -48,7 +185,7 @@ namespace LinuxSampler { namespace gig {
             pbs.reverse = PlaybackState.reverse;
             pbs.loop_cycles_left = PlaybackState.loop_cycles_left;
 
-            total_readsamples  = pSample->ReadAndLoop(pBuf, SamplesToRead, &pbs, pRegion, pDecompressionBuffer);
+            total_readsamples  = pReader->ReadAndLoop(pBuf, SamplesToRead, &pbs, pRegion, pBuffer);
             PlaybackState.position = pbs.position;
             PlaybackState.reverse = pbs.reverse;
             PlaybackState.loop_cycles_left = pbs.loop_cycles_left;
@@ -57,16 +194,10 @@ namespace LinuxSampler { namespace gig {
         }
         else { // normal forward playback
 
-            pSample->SetPos(this->SampleOffset); // recover old position
-
-            do {
-                readsamples        = pSample->Read(&pBuf[total_readsamples * pSample->FrameSize], SamplesToRead, pDecompressionBuffer);
-                SamplesToRead     -= readsamples;
-                total_readsamples += readsamples;
-            } while (SamplesToRead && readsamples > 0);
+            total_readsamples = ReadCached(CacheSource, pSample, pBuffer, this->SampleOffset, pBuf, SamplesToRead, pDirectReader, pReader);
 
             // we have to store the position within the sample, because other streams might use the same sample
-            this->SampleOffset = pSample->GetPos();
+            this->SampleOffset += total_readsamples;
 
             endofsamplereached = (SampleOffset >= pSample->SamplesTotal);
             dmsg(5,("Refilled stream %d with %ld (SamplePos: %lu)", this->hThis, total_readsamples, this->SampleOffset));
@@ -79,6 +210,46 @@ namespace LinuxSampler { namespace gig {
         return total_readsamples;
     }
 
+    bool Stream::IsCompressed() {
+        // only worth decoding on the decoder pool if its workers can read the sample
+        return bDecodeOnWorkers;
+    }
+
+    /**
+     * Reads @a FrameCount sample points of @a pSample starting at
+     * @a FrameOffset through the block cache shared by all streams, so that
+     * the same sample data is not read again and again by different streams.
+     * @a Source identifies the sample's file in the cache (see
+     * InstrumentResourceManager::GetCacheSource()).
+     * Data not being cached is read with @a pDirectReader if supplied, by
+     * libgig otherwise (through @a pReader if supplied, which has to be
+     * another instance of the same sample).
+     *
+     * @returns amount of sample points actually read
+     */
+    long Stream::ReadCached(uint64_t Source, ::gig::Sample* pSample, ::gig::buffer_t* pDecompressionBuffer, unsigned long FrameOffset, uint8_t* pDst, long FrameCount, DirectSampleReader* pDirectReader, ::gig::Sample* pReader) {
+        if (!pReader) pReader = pSample;
+        return StreamBlockCache::Read(
+            Source, pSample, pSample->FrameSize,
+            FrameOffset, pDst, FrameCount,
+            [pReader, pDecompressionBuffer, pDirectReader](uint8_t* pDst, unsigned long FrameOffset, long FrameCount) -> long {
+                #if CONFIG_DIRECT_IO_STREAMING
+                if (pDirectReader) {
+                    const long n = pDirectReader->Read(FrameOffset, pDst, FrameCount);
+                    if (n >= 0) return n;
+                }
+                #endif
+                pReader->SetPos(FrameOffset);
+                long total = 0, n;
+                do {
+                    n = pReader->Read(&pDst[total * pReader->FrameSize], FrameCount - total, pDecompressionBuffer);
+                    total += n;
+                } while (total < FrameCount && n > 0);
+                return total;
+            }
+        );
+    }
+
     void Stream::Launch (
         Stream::Handle           hStream,
         reference_t*             pExportReference,
@@ -97,6 +268,10 @@ namespace LinuxSampler { namespace gig {
         playbackState.reverse          = false;
         playbackState.loop_cycles_left = pRgn->pSample->LoopPlayCount;
 
+        pDirectReader    = NULL;
+        CacheSource      = 0;
+        bDecodeOnWorkers = pRgn->pSample->Compressed && GetWorkerSample(pRgn->pSample, 0);
+
         LinuxSampler::StreamBase< ::gig::DimensionRegion>::Launch (
             hStream, pExportReference, pRgn, info, playbackState, SampleOffset, DoLoop
         );
@@ -26,6 +26,7 @@
 #define	__LS_GIG_STREAM_H__
 
 #include "../common/StreamBase.h"
+#include "../common/DirectSampleReader.h"
 
 #if AC_APPLE_UNIVERSAL_BUILD
 # include <libgig/gig.h>
@@ -33,15 +34,33 @@
 # include <gig.h>
 #endif
 
-namespace LinuxSampler { namespace gig {
+namespace LinuxSampler {
+
+    class DirectSampleReader;
+
+namespace gig {
 
     class Stream: public LinuxSampler::StreamBase< ::gig::DimensionRegion> {
         private:
             ::gig::buffer_t* pDecompressionBuffer;
+            DirectSampleReader* pDirectReader; ///< Reads the sample bypassing the page cache (NULL: read by libgig).
+            uint64_t CacheSource; ///< Identifies the sample's file in the StreamBlockCache.
+            bool bDecodeOnWorkers; ///< Whether the sample is compressed and can be read by the decoder pool's worker threads.
 
         public:
             Stream( ::gig::buffer_t* pDecompressionBuffer, uint BufferSize, uint BufferWrapElements);
             virtual long Read(uint8_t* pBuf, long SamplesToRead);
+            virtual bool IsCompressed();
+
+            static long ReadCached(uint64_t Source, ::gig::Sample* pSample, ::gig::buffer_t* pDecompressionBuffer, unsigned long FrameOffset, uint8_t* pDst, long FrameCount, DirectSampleReader* pDirectReader = NULL, ::gig::Sample* pReader = NULL);
+            static void OpenWorkerFiles(::gig::File* pFile);
+            static void CloseWorkerFiles(::gig::File* pFile);
+
+            /// Must be called after Launch() to read the sample through the StreamBlockCache.
+            void ReadCachedAs(uint64_t Source) { CacheSource = Source; }
+
+            /// Must be called after Launch() to read the sample with direct I/O.
+            void ReadDirectFrom(DirectSampleReader* pReader) { pDirectReader = pReader; }
 
             void Launch (
                 Stream::Handle           hStream,
@@ -50,6 +69,9 @@ namespace LinuxSampler { namespace gig {
                 unsigned long            SampleOffset,
                 bool                     DoLoop
             );
+
+        private:
+            static ::gig::Sample* GetWorkerSample(::gig::Sample* pSample, int iWorker);
     };
 
 
@@ -108,6 +108,10 @@ namespace LinuxSampler { namespace sf2 {
             if (!newInstrument) {
                 throw InstrumentManagerException("resource was not created");
             }
+            // free held instruments if the memory budget is exceeded now
+            InstrumentManager::EnforceMemoryBudget();
+            // move its sample data to the NUMA node of our audio device
+            MoveInstrumentToNumaNode();
         }
         catch (InstrumentManagerException e) {
             InstrumentStat = -3;
@@ -130,6 +130,9 @@ namespace LinuxSampler { namespace sf2 {
     }
 
     ::sf2::Preset* InstrumentResourceManager::Create(instrument_id_t Key, InstrumentConsumer* pConsumer, void*& pArg) {
+        // libsf2 is not thread safe, presets of other .sf2 files may be loaded meanwhile though
+        LockGuard fileLock(FileLoadMutex(Key.FileName));
+
         // get sfz file from internal sfz file manager
         ::sf2::File* pSf2 = Sf2s.Borrow(Key.FileName, reinterpret_cast<Sf2Consumer*>(Key.Index)); // conversion kinda hackish :/
 
@@ -197,6 +200,17 @@ namespace LinuxSampler { namespace sf2 {
         }
     }
 
+    void InstrumentResourceManager::CollectSamples(::sf2::Preset* pInstrument, std::set< ::sf2::Sample*>& samples) {
+        for (int i = 0 ; i < pInstrument->GetRegionCount() ; i++) {
+            ::sf2::Instrument* sf2Instr = pInstrument->GetRegion(i)->pInstrument;
+            if (!sf2Instr) continue;
+            for (int j = 0 ; j < sf2Instr->GetRegionCount() ; j++) {
+                ::sf2::Sample* pSample = sf2Instr->GetRegion(j)->GetSample();
+                if (pSample) samples.insert(pSample);
+            }
+        }
+    }
+
 
 
     // internal sfz file manager
@@ -79,6 +79,7 @@ namespace LinuxSampler { namespace sf2 {
             virtual void   Destroy(::sf2::Preset* pResource, void* pArg);
             virtual void   DeleteRegionIfNotUsed(::sf2::Region* pRegion, region_info_t* pRegInfo);
             virtual void   DeleteSampleIfNotUsed(::sf2::Sample* pSample, region_info_t* pRegInfo);
+            virtual void   CollectSamples(::sf2::Preset* pInstrument, std::set< ::sf2::Sample*>& samples);
         private:
             typedef ResourceConsumer< ::sf2::File> Sf2Consumer;
 
@@ -24,6 +24,7 @@
 
 #include "DiskThread.h"
 #include "Stream.h"
+#include "../common/StreamBlockCache.h"
 #include "../../common/global_private.h"
 
 namespace LinuxSampler {
@@ -58,6 +59,34 @@ namespace sfz {
         Stream* pSfzStream = dynamic_cast<Stream*>(pStream);
         if(!pSfzStream) throw Exception("Invalid stream type");
         pSfzStream->Launch(hStream, pExportReference, pRgn, SampleOffset, DoLoop);
+        #if CONFIG_MMAP_STREAMING
+        if (MappedSample* pMapping = pRgn->pSample->AcquireMapping()) {
+            pSfzStream->PlayFromMapping(pMapping); // takes its own reference
+            pMapping->Release();
+        }
+        #endif
+    }
+
+    void DiskThread::PrefetchStream(::sfz::Region* pRgn, unsigned long SampleOffset) {
+        ::sfz::Sample* pSample = pRgn->pSample;
+        if (!pSample || SampleOffset >= (unsigned long) pSample->GetTotalFrameCount()) return;
+        long frames = pSample->GetTotalFrameCount() - SampleOffset;
+        // only up to the end of the cache block the stream starts in, so
+        // exactly one block is read
+        const long blockFrames = StreamBlockCache::BlockFrames(pSample->GetFrameSize());
+        const long blockRest = blockFrames - long(SampleOffset % blockFrames);
+        if (frames > blockRest) frames = blockRest;
+        #if CONFIG_MMAP_STREAMING
+        if (MappedSample* pMapping = pSample->AcquireMapping()) {
+            pMapping->Prefetch(SampleOffset * pSample->GetFrameSize(), size_t(frames) * pSample->GetFrameSize());
+            pMapping->Release();
+            return;
+        }
+        #endif
+        // reading the data once puts it into the stream block cache (if
+        // enabled) and into the system's page cache
+        PrefetchBuffer.resize(size_t(frames) * pSample->GetFrameSize());
+        Stream::ReadCached(pSample, SampleOffset, &PrefetchBuffer[0], frames);
     }
 }} // namespace LinuxSampler::sfz
 
@@ -28,6 +28,7 @@
 #include "../InstrumentManagerBase.h"
 #include "../common/DiskThreadBase.h"
 #include "InstrumentResourceManager.h"
+#include <vector>
 
 namespace LinuxSampler {
     template <>
@@ -48,6 +49,11 @@ namespace sfz {
                 bool                   DoLoop
             );
 
+            virtual void PrefetchStream(::sfz::Region* pRgn, unsigned long SampleOffset);
+
+        private:
+            std::vector<uint8_t> PrefetchBuffer; ///< Scratch buffer for PrefetchStream().
+
         public:
             DiskThread(int MaxStreams, uint BufferWrapElements, InstrumentResourceManager* pInstruments);
             virtual ~DiskThread();
@@ -194,16 +194,34 @@ namespace LinuxSampler { namespace sfz {
         q.search(pChannel->pInstrument);
 
         int i = 0;
+        bool bVoicesLaunched = false;
         while (::sfz::Region* region = q.next()) {
             if (!RegionSuspended(region)) {
                 itNoteOnEvent->Param.Note.pRegion = region;
                 VoiceIterator itNewVoice =
                     LaunchVoice(pChannel, itNoteOnEvent, i, false, true, HandleKeyGroupConflicts);
-                if (itNewVoice)
+                if (itNewVoice) {
                     itNewVoice.moveToEndOf(itNote->pActiveVoices);
+                    bVoicesLaunched = true;
+                }
             }
             i++;
         }
+
+        // warm up the release trigger samples this note will most probably
+        // trigger on note-off (with the same velocity and controller values)
+        if (bVoicesLaunched) {
+            q.trig = TRIGGER_RELEASE;
+            q.search(pChannel->pInstrument);
+            while (::sfz::Region* region = q.peekNext()) {
+                ::sfz::Sample* pSample = region->pSample;
+                if (!pSample || RegionSuspended(region)) continue;
+                PrefetchReleaseTriggerRegion(
+                    pChannel, region, pSample->GetCache().Size / pSample->GetFrameSize(),
+                    pSample->GetTotalFrameCount(), q.key
+                );
+            }
+        }
     }
 
     void Engine::TriggerReleaseVoices (
@@ -30,6 +30,7 @@ namespace LinuxSampler { namespace sfz {
     EngineChannel::EngineChannel() {
         for(int i = 0; i < 128; i++) PressedKeys[i] = false;
         LastKey = LastKeySwitch = -1;
+        pActiveInstrument = NULL;
         AddMidiKeyboardListener(this);
     }
 
@@ -85,6 +86,7 @@ namespace LinuxSampler { namespace sfz {
      */
     void EngineChannel::LoadInstrument() {
         InstrumentResourceManager* pInstrumentManager = dynamic_cast<InstrumentResourceManager*>(pEngine->GetInstrumentManager());
+        LockGuard lock(InstrumentChangeMutex);
 
         // make sure we don't trigger any new notes with an old
         // instrument
@@ -94,6 +96,7 @@ namespace LinuxSampler { namespace sfz {
             // keep the dimension regions and samples that are in use
             pInstrumentManager->HandBackInstrument(cmd.pInstrument, this, cmd.pRegionsInUse);
         }
+        pActiveInstrument = NULL;
         if (cmd.pScript) {
             // give old instrument script back to instrument resource manager
             cmd.pScript->resetAll();
@@ -114,27 +117,12 @@ namespace LinuxSampler { namespace sfz {
             if (!newInstrument) {
                 throw InstrumentManagerException("resource was not created");
             }
+            // free held instruments if the memory budget is exceeded now
+            InstrumentManager::EnforceMemoryBudget();
+            // move its sample data to the NUMA node of our audio device
+            MoveInstrumentToNumaNode();
 
-            // if requested by set_ccN opcode in sfz file, set initial CC values
-            for (std::map<uint8_t,uint8_t>::const_iterator itCC = newInstrument->initialCCValues.begin();
-                 itCC != newInstrument->initialCCValues.end(); ++itCC)
-            {
-                const uint8_t& cc = itCC->first;
-                uint8_t value = itCC->second;
-                if (cc >= CTRL_TABLE_SIZE) continue;
-                if ((cc < 128 || cc == CTRL_TABLE_IDX_AFTERTOUCH) && value > 127) value = 127;
-                ControllerTable[cc] = value;
-            }
-
-            if (newInstrument->scripts.size() > 1) {
-                std::cerr << "WARNING: Executing more than one real-time instrument script slot is not implemented yet!\n";
-            }
-            ::sfz::Script* script = (!newInstrument->scripts.empty()) ? &newInstrument->scripts[0] : NULL;
-            if (script) {
-                String sourceCode = script->GetSourceCode();
-                std::map<String,String> patchVars; //TODO: we need to invent some new sfz opcode(s) for 'patch' script variables
-                LoadInstrumentScript(sourceCode, patchVars);
-            }
+            PrepareInstrument(newInstrument);
         }
         catch (InstrumentManagerException e) {
             InstrumentStat = -3;
@@ -161,19 +149,95 @@ namespace LinuxSampler { namespace sfz {
             throw Exception("sfz::Engine error: Failed to load instrument, cause: Unknown exception while trying to parse sfz file.");
         }
 
+        ActivateInstrument(newInstrument);
+    }
+
+    /**
+     * Switches over to the reloaded version of the current instrument (see
+     * InstrumentResourceManager::Recreate()) the same way LoadInstrument()
+     * switches instruments, so playback is not interrupted: voices still
+     * playing regions of the old instrument keep playing them until they
+     * end, new notes already use the new instrument.
+     *
+     * Called without the instrument manager being locked, so the old
+     * instrument might have been replaced by LoadInstrument() meanwhile.
+     */
+    void EngineChannel::ResourceReplaced(::sfz::Instrument* pOldResource, ::sfz::Instrument* pNewResource) {
+        LockGuard lock(InstrumentChangeMutex);
+        if (pActiveInstrument != pOldResource || !pEngine) return;
+
+        InstrumentChangeCmd< ::sfz::Region, ::sfz::Instrument>& cmd = ChangeInstrument(0);
+        if (cmd.pInstrument) {
+            // the old instrument is destroyed by the instrument manager, but
+            // keep the regions and samples that are in use
+            Engine::instruments.RetainRegions(cmd.pRegionsInUse);
+        }
+        if (cmd.pScript) {
+            // give old instrument script back to instrument resource manager
+            cmd.pScript->resetAll();
+        }
+        cmd.pRegionsInUse->clear();
+
+        DeleteGroupEventLists();
+
+        try {
+            PrepareInstrument(pNewResource);
+        } catch (Exception& e) {
+            std::cerr << "sfz::Engine error: Failed to reload instrument, cause: " << e.Message() << std::endl << std::flush;
+        } catch (...) {
+            std::cerr << "sfz::Engine error: Failed to reload instrument, cause: Unknown exception" << std::endl << std::flush;
+        }
+
+        ActivateInstrument(pNewResource);
+    }
+
+    /**
+     * Applies the initial controller values and loads the instrument script
+     * of the given instrument, which is about to be activated.
+     */
+    void EngineChannel::PrepareInstrument(::sfz::Instrument* pInstrument) {
+        // if requested by set_ccN opcode in sfz file, set initial CC values
+        for (std::map<uint8_t,uint8_t>::const_iterator itCC = pInstrument->initialCCValues.begin();
+             itCC != pInstrument->initialCCValues.end(); ++itCC)
+        {
+            const uint8_t& cc = itCC->first;
+            uint8_t value = itCC->second;
+            if (cc >= CTRL_TABLE_SIZE) continue;
+            if ((cc < 128 || cc == CTRL_TABLE_IDX_AFTERTOUCH) && value > 127) value = 127;
+            ControllerTable[cc] = value;
+        }
+
+        if (pInstrument->scripts.size() > 1) {
+            std::cerr << "WARNING: Executing more than one real-time instrument script slot is not implemented yet!\n";
+        }
+        ::sfz::Script* script = (!pInstrument->scripts.empty()) ? &pInstrument->scripts[0] : NULL;
+        if (script) {
+            String sourceCode = script->GetSourceCode();
+            std::map<String,String> patchVars; //TODO: we need to invent some new sfz opcode(s) for 'patch' script variables
+            LoadInstrumentScript(sourceCode, patchVars);
+        }
+    }
+
+    /**
+     * Lets the audio thread use the given instrument for new notes from now
+     * on. The previous instrument must already have been detached with
+     * ChangeInstrument(0) and the key groups must have been deleted.
+     */
+    void EngineChannel::ActivateInstrument(::sfz::Instrument* pInstrument) {
         // rebuild ActiveKeyGroups map with key groups of current instrument
-        for (std::vector< ::sfz::Region*>::iterator itRegion = newInstrument->regions.begin() ;
-             itRegion != newInstrument->regions.end() ; ++itRegion) {
+        for (std::vector< ::sfz::Region*>::iterator itRegion = pInstrument->regions.begin() ;
+             itRegion != pInstrument->regions.end() ; ++itRegion) {
             AddGroup((*itRegion)->group);
             AddGroup((*itRegion)->off_by);
         }
 
-        InstrumentIdxName = newInstrument->GetName();
+        InstrumentIdxName = pInstrument->GetName();
         InstrumentStat = 100;
+        pActiveInstrument = pInstrument;
 
         {
             InstrumentChangeCmd< ::sfz::Region, ::sfz::Instrument>& cmd =
-                ChangeInstrument(newInstrument);
+                ChangeInstrument(pInstrument);
             if (cmd.pScript) {
                 // give old instrument script back to instrument resource manager
                 cmd.pScript->resetAll();
@@ -41,6 +41,9 @@ namespace LinuxSampler { namespace sfz {
 
             virtual AbstractEngine::Format GetEngineFormat() OVERRIDE;
 
+            // implementation of methods derived from interface class 'InstrumentConsumer'
+            virtual void ResourceReplaced(::sfz::Instrument* pOldResource, ::sfz::Instrument* pNewResource) OVERRIDE;
+
             // methods derived from MidiKeyboardListener
             virtual void PreProcessNoteOn(uint8_t key, uint8_t velocity) OVERRIDE;
             virtual void PostProcessNoteOn(uint8_t key, uint8_t velocity) OVERRIDE;
@@ -60,6 +63,12 @@ namespace LinuxSampler { namespace sfz {
             bool PressedKeys[128];
             int LastKeySwitch;
             int LastKey;
+
+            Mutex InstrumentChangeMutex; ///< serializes LoadInstrument() and ResourceReplaced(), which are called by different threads
+            ::sfz::Instrument* pActiveInstrument; ///< instrument last activated by LoadInstrument() or ResourceReplaced() (protected by InstrumentChangeMutex)
+
+            void PrepareInstrument(::sfz::Instrument* pInstrument);
+            void ActivateInstrument(::sfz::Instrument* pInstrument);
     };
 
 }} // namespace LinuxSampler::sfz
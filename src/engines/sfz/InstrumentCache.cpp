@@ -0,0 +1,935 @@
+/*
+ * Copyright (c) 2020 Christian Schoenebeck
+ *
+ * http://www.linuxsampler.org
+ *
+ * This file is part of LinuxSampler and released under the same terms.
+ * See README file for details.
+ */
+
+#include "InstrumentCache.h"
+
+#if CONFIG_SFZ_CACHE
+
+#include "sfz.h"
+#include "LookupTable.h"
+
+#include <sys/types.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <errno.h>
+#include <limits.h>
+#include <stdio.h>
+#include <string.h>
+#include <map>
+#include <type_traits>
+
+namespace sfz {
+
+    LinuxSampler::Mutex InstrumentCache::DirectoryMutex;
+    std::string         InstrumentCache::Directory;
+
+    static const char CACHE_MAGIC[8] = { 'L', 'S', 'S', 'F', 'Z', 'C', 'A', 'C' };
+    // increase whenever anything serialized below changes (i.e. new opcode members)
+    static const uint32_t CACHE_VERSION = 4;
+
+    // Catches members added to the sfz types below without adding them to
+    // their serialize() function as well (and increasing CACHE_VERSION).
+    // The sizes are the ones of the x86_64 libstdc++ ABI, builds for other
+    // platforms rely on this check being done there.
+    #if defined(__x86_64__) && defined(__GLIBCXX__) && _GLIBCXX_USE_CXX11_ABI
+    static_assert(sizeof(Definition) == 1512, "sfz::Definition changed, update serialize(Definition&) and CACHE_VERSION");
+    static_assert(sizeof(EG) == 352, "sfz::EG changed, update serialize(EG&) and CACHE_VERSION");
+    static_assert(sizeof(LFO) == 848, "sfz::LFO changed, update serialize(LFO&) and CACHE_VERSION");
+    static_assert(sizeof(EqImpl) == 184, "sfz::EqImpl changed, update serialize(EqImpl&) and CACHE_VERSION");
+    static_assert(sizeof(EqSmoothStepImpl) == 472, "sfz::EqSmoothStepImpl changed, update serialize(EqSmoothStepImpl&) and CACHE_VERSION");
+    static_assert(sizeof(EGNode) == 48, "sfz::EGNode changed, update serialize(EGNode&) and CACHE_VERSION");
+    static_assert(sizeof(CC) == 16, "sfz::CC changed, update serialize(CC&) and CACHE_VERSION");
+    #endif
+
+    struct cache_header_t {
+        char     Magic[8];
+        uint32_t Version;
+        uint32_t RegionSize; ///< sizeof(Region) of the sampler which wrote the file.
+    };
+
+    // serializes the composite sfz types member by member with an archive
+    // (InstrumentCache::Reader or InstrumentCache::Writer)
+
+    template<class A> static void serialize(A& a, CC& cc);
+    template<class A> static void serialize(A& a, EGNode& n);
+    template<class A> static void serialize(A& a, EqImpl& eq);
+    template<class A> static void serialize(A& a, EqSmoothStepImpl& eq);
+    template<class A> static void serialize(A& a, EG& eg);
+    template<class A> static void serialize(A& a, LFO& lfo);
+    template<class A> static void serialize(A& a, Curve& c);
+    template<class A> static void serialize(A& a, Definition& d);
+
+    // returns a unique tag for each type T, to tell shared buffers of different types apart
+    template<class T> static const void* typeTag() {
+        static const char tag = 0;
+        return &tag;
+    }
+
+    /// Serializes data into a memory buffer.
+    class InstrumentCache::Writer {
+    public:
+        std::string Data;
+
+        template<class T>
+        typename std::enable_if<std::is_arithmetic<T>::value || std::is_enum<T>::value, Writer&>::type
+        operator&(T& value) {
+            Data.append((const char*) &value, sizeof(T));
+            return *this;
+        }
+
+        template<class T>
+        typename std::enable_if<std::is_class<T>::value, Writer&>::type
+        operator&(T& value) {
+            serialize(*this, value);
+            return *this;
+        }
+
+        Writer& operator&(std::string& s) {
+            uint32_t len = uint32_t(s.size());
+            *this & len;
+            Data.append(s);
+            return *this;
+        }
+
+        template<class T> Writer& operator&(optional<T>& o) {
+            bool initialized = o;
+            *this & initialized;
+            if (initialized) *this & *o;
+            return *this;
+        }
+
+        template<class T> Writer& operator&(std::vector<T>& v) {
+            uint32_t n = uint32_t(v.size());
+            *this & n;
+            for (uint32_t i = 0; i < n; i++) *this & v[i];
+            return *this;
+        }
+
+        template<class T> Writer& operator&(LinuxSampler::ArrayList<T>& list) {
+            uint32_t n = uint32_t(list.size());
+            *this & n;
+            for (uint32_t i = 0; i < n; i++) *this & list[i];
+            return *this;
+        }
+
+        // regions share the buffers of their copy-on-write arrays and lists
+        // with their group (i.e. amp_velcurve, eg), so each buffer is only
+        // written once
+        template<class T> Writer& operator&(Array<T>& array) {
+            if (!writeRepId(array.ptr)) return *this;
+            for (int i = 0; i < 128; i++) *this & array.ptr->a[i];
+            return *this;
+        }
+
+        template<class T> Writer& operator&(List<T>& list) {
+            if (!writeRepId(list.empty() ? NULL : list.ptr)) return *this;
+            return *this & list.ptr->a;
+        }
+
+    private:
+        std::map<const void*,uint32_t> SharedReps; ///< IDs of the shared buffers written so far.
+
+        // writes the ID of buffer @a pRep, returns true if its data has to follow
+        bool writeRepId(const void* pRep) {
+            uint32_t id = 0;
+            if (!pRep) {
+                *this & id;
+                return false;
+            }
+            std::map<const void*,uint32_t>::iterator it = SharedReps.find(pRep);
+            if (it != SharedReps.end()) {
+                *this & it->second;
+                return false;
+            }
+            id = uint32_t(SharedReps.size() + 1);
+            SharedReps[pRep] = id;
+            *this & id;
+            return true;
+        }
+    };
+
+    /// Deserializes data from a memory buffer.
+    class InstrumentCache::Reader {
+    public:
+        Reader(const uint8_t* pData, size_t Size) : pData(pData), Size(Size), Pos(0), bError(false) {}
+
+        ~Reader() {
+            for (size_t i = 0; i < SharedReps.size(); i++)
+                SharedReps[i].Release(SharedReps[i].pRep);
+        }
+
+        template<class T>
+        typename std::enable_if<std::is_arithmetic<T>::value || std::is_enum<T>::value, Reader&>::type
+        operator&(T& value) {
+            if (Size - Pos < sizeof(T)) bError = true;
+            if (bError) return *this;
+            memcpy(&value, pData + Pos, sizeof(T));
+            Pos += sizeof(T);
+            return *this;
+        }
+
+        template<class T>
+        typename std::enable_if<std::is_class<T>::value, Reader&>::type
+        operator&(T& value) {
+            serialize(*this, value);
+            return *this;
+        }
+
+        Reader& operator&(std::string& s) {
+            const uint32_t len = Count(1);
+            if (bError) return *this;
+            s.assign((const char*) pData + Pos, len);
+            Pos += len;
+            return *this;
+        }
+
+        template<class T> Reader& operator&(optional<T>& o) {
+            bool initialized = false;
+            *this & initialized;
+            if (initialized) {
+                T value = T();
+                *this & value;
+                o = value;
+            } else {
+                o = optional<T>::nothing;
+            }
+            return *this;
+        }
+
+        template<class T> Reader& operator&(std::vector<T>& v) {
+            const uint32_t n = Count(1);
+            v.resize(n);
+            for (uint32_t i = 0; i < n && !bError; i++) *this & v[i];
+            return *this;
+        }
+
+        template<class T> Reader& operator&(LinuxSampler::ArrayList<T>& list) {
+            const uint32_t n = Count(1);
+            list.clear();
+            if (!n) return *this;
+            list.resize(n);
+            for (uint32_t i = 0; i < n && !bError; i++) *this & list[i];
+            return *this;
+        }
+
+        template<class T> Reader& operator&(Array<T>& array) {
+            typedef typename Array<T>::Rep Rep;
+            bool bNew;
+            Rep* rep = readRep<Array<T>, Rep>(bNew);
+            if (!rep) return *this;
+            if (bNew) for (int i = 0; i < 128; i++) *this & rep->a[i];
+            rep->refcount++;
+            if (array.ptr) Rep::release(array.ptr);
+            array.ptr = rep;
+            return *this;
+        }
+
+        template<class T> Reader& operator&(List<T>& list) {
+            typedef typename List<T>::Rep Rep;
+            bool bNew;
+            Rep* rep = readRep<List<T>, Rep>(bNew);
+            if (!rep) return *this;
+            if (bNew) *this & rep->a;
+            rep->refcount++;
+            if (list.ptr) Rep::release(list.ptr);
+            list.ptr = rep;
+            return *this;
+        }
+
+        /**
+         * Reads an element count and checks that at least that many
+         * elements of (at least) @a MinElementSize bytes can follow.
+         */
+        uint32_t Count(size_t MinElementSize) {
+            uint32_t n = 0;
+            *this & n;
+            if (!bError && uint64_t(n) * MinElementSize > Size - Pos) bError = true;
+            return bError ? 0 : n;
+        }
+
+        bool Failed() const { return bError; }
+        void SetFailed() { bError = true; }
+
+    private:
+        struct shared_rep_t {
+            void*       pRep;
+            const void* Type;
+            void        (*Release)(void* pRep);
+        };
+
+        template<class Rep> static void releaseRep(void* pRep) {
+            Rep::release((Rep*) pRep);
+        }
+
+        /**
+         * Reads the ID of a shared buffer of container type @a C. Returns
+         * NULL if there is none (or on error), otherwise the buffer, which
+         * is newly created if @a bNew is set (its data follows then).
+         */
+        template<class C, class Rep> Rep* readRep(bool& bNew) {
+            uint32_t id = 0;
+            *this & id;
+            bNew = false;
+            if (bError || !id) return NULL;
+            if (id == SharedReps.size() + 1) { // first use of this buffer, its data follows
+                Rep* rep = new Rep;
+                const shared_rep_t r = { rep, typeTag<C>(), releaseRep<Rep> };
+                SharedReps.push_back(r);
+                bNew = true;
+                return rep;
+            }
+            if (id <= SharedReps.size() && SharedReps[id - 1].Type == typeTag<C>())
+                return (Rep*) SharedReps[id - 1].pRep;
+            bError = true;
+            return NULL;
+        }
+
+        const uint8_t*           pData;
+        size_t                   Size;
+        size_t                   Pos;
+        bool                     bError;
+        std::vector<shared_rep_t> SharedReps; ///< Shared buffers read so far, each holding one reference.
+    };
+
+    template<class A> static void serialize(A& a, CC& cc) {
+        a & cc.Controller & cc.Curve & cc.Influence & cc.Smooth & cc.Step;
+    }
+
+    template<class A> static void serialize(A& a, EGNode& n) {
+        a & n.time;
+        a & n.level;
+        a & n.shape;
+        a & n.curve;
+        a & n.time_oncc;
+        a & n.level_oncc;
+    }
+
+    template<class A> static void serialize(A& a, EqImpl& eq) {
+        a & eq.eq1freq & eq.eq2freq & eq.eq3freq;
+        a & eq.eq1bw & eq.eq2bw & eq.eq3bw;
+        a & eq.eq1gain & eq.eq2gain & eq.eq3gain;
+        a & eq.eq1freq_oncc;
+        a & eq.eq2freq_oncc;
+        a & eq.eq3freq_oncc;
+        a & eq.eq1bw_oncc;
+        a & eq.eq2bw_oncc;
+        a & eq.eq3bw_oncc;
+        a & eq.eq1gain_oncc;
+        a & eq.eq2gain_oncc;
+        a & eq.eq3gain_oncc;
+    }
+
+    template<class A> static void serialize(A& a, EqSmoothStepImpl& eq) {
+        serialize(a, (EqImpl&) eq);
+        a & eq.eq1freq_smoothcc;
+        a & eq.eq2freq_smoothcc;
+        a & eq.eq3freq_smoothcc;
+        a & eq.eq1bw_smoothcc;
+        a & eq.eq2bw_smoothcc;
+        a & eq.eq3bw_smoothcc;
+        a & eq.eq1gain_smoothcc;
+        a & eq.eq2gain_smoothcc;
+        a & eq.eq3gain_smoothcc;
+
+        a & eq.eq1freq_stepcc;
+        a & eq.eq2freq_stepcc;
+        a & eq.eq3freq_stepcc;
+        a & eq.eq1bw_stepcc;
+        a & eq.eq2bw_stepcc;
+        a & eq.eq3bw_stepcc;
+        a & eq.eq1gain_stepcc;
+        a & eq.eq2gain_stepcc;
+        a & eq.eq3gain_stepcc;
+    }
+
+    template<class A> static void serialize(A& a, EG& eg) {
+        serialize(a, (EqImpl&) eg);
+        a & eg.node;
+        a & eg.sustain;
+        a & eg.loop;
+        a & eg.loop_count;
+        a & eg.amplitude;
+        a & eg.volume;
+        a & eg.cutoff;
+        a & eg.pitch;
+        a & eg.resonance;
+        a & eg.pan;
+        a & eg.pan_curve;
+
+        a & eg.amplitude_oncc;
+        a & eg.volume_oncc;
+        a & eg.cutoff_oncc;
+        a & eg.pitch_oncc;
+        a & eg.resonance_oncc;
+        a & eg.pan_oncc;
+        a & eg.pan_curvecc;
+    }
+
+    template<class A> static void serialize(A& a, LFO& lfo) {
+        serialize(a, (EqSmoothStepImpl&) lfo);
+        a & lfo.delay;
+        a & lfo.freq;
+        a & lfo.fade;
+        a & lfo.phase;
+        a & lfo.wave;
+        a & lfo.volume;
+        a & lfo.pitch;
+        a & lfo.cutoff;
+        a & lfo.resonance;
+        a & lfo.pan;
+
+        a & lfo.delay_oncc;
+        a & lfo.freq_oncc;
+        a & lfo.freq_smoothcc;
+        a & lfo.freq_stepcc;
+        a & lfo.fade_oncc;
+        a & lfo.phase_oncc;
+        a & lfo.volume_oncc;
+        a & lfo.volume_smoothcc;
+        a & lfo.volume_stepcc;
+        a & lfo.pitch_oncc;
+        a & lfo.pitch_smoothcc;
+        a & lfo.pitch_stepcc;
+        a & lfo.pan_oncc;
+        a & lfo.pan_smoothcc;
+        a & lfo.pan_stepcc;
+        a & lfo.cutoff_oncc;
+        a & lfo.cutoff_smoothcc;
+        a & lfo.cutoff_stepcc;
+        a & lfo.resonance_oncc;
+        a & lfo.resonance_smoothcc;
+        a & lfo.resonance_stepcc;
+    }
+
+    template<class A> static void serialize(A& a, Curve& c) {
+        for (int i = 0; i < 128; i++) a & c.v[i];
+    }
+
+    // all opcode values of a region, the order has to match the one of
+    // sfz.h, so new members are not forgotten here
+    template<class A> static void serialize(A& a, Definition& d) {
+        a & d.sample;
+
+        a & d.lochan & d.hichan;
+        a & d.lokey & d.hikey;
+        a & d.lovel & d.hivel;
+        a & d.locc & d.hicc;
+        a & d.lobend & d.hibend;
+        a & d.lobpm & d.hibpm;
+        a & d.lochanaft & d.hichanaft;
+        a & d.lopolyaft & d.hipolyaft;
+        a & d.loprog & d.hiprog;
+        a & d.lorand & d.hirand;
+        a & d.lotimer & d.hitimer;
+
+        a & d.seq_length;
+        a & d.seq_position;
+
+        a & d.start_locc & d.start_hicc;
+        a & d.stop_locc & d.stop_hicc;
+
+        a & d.sw_lokey & d.sw_hikey;
+        a & d.sw_last;
+        a & d.sw_down;
+        a & d.sw_up;
+        a & d.sw_previous;
+        a & d.sw_vel;
+
+        a & d.trigger;
+
+        a & d.group;
+        a & d.off_by;
+        a & d.off_mode;
+
+        a & d.on_locc & d.on_hicc;
+
+        a & d.count;
+        a & d.delay & d.delay_random & d.delay_oncc;
+        a & d.delay_beats & d.stop_beats;
+        a & d.delay_samples & d.delay_samples_oncc;
+        a & d.end;
+        a & d.loop_crossfade;
+        a & d.offset & d.offset_random & d.offset_oncc;
+        a & d.loop_mode;
+        a & d.loop_start & d.loop_end;
+        a & d.sync_beats;
+        a & d.sync_offset;
+
+        a & d.volume;
+        a & d.amplitude;
+        a & d.pan;
+        a & d.width;
+        a & d.position;
+        a & d.amp_keytrack & d.amp_keycenter & d.amp_veltrack & d.amp_velcurve & d.amp_random;
+        a & d.rt_decay;
+        a & d.gain_oncc;
+        a & d.xfin_lokey & d.xfin_hikey;
+        a & d.xfout_lokey & d.xfout_hikey;
+        a & d.xf_keycurve;
+        a & d.xfin_lovel & d.xfin_hivel;
+        a & d.xfout_lovel & d.xfout_hivel;
+        a & d.xf_velcurve;
+        a & d.xfin_locc & d.xfin_hicc;
+        a & d.xfout_locc & d.xfout_hicc;
+        a & d.xf_cccurve;
+
+        a & d.transpose;
+        a & d.tune;
+        a & d.pitch_keycenter & d.pitch_keytrack & d.pitch_veltrack & d.pitch_random;
+        a & d.bend_up & d.bend_down & d.bend_step;
+
+        a & d.fil_type & d.fil2_type;
+        a & d.cutoff & d.cutoff2;
+        a & d.cutoff_oncc & d.cutoff2_oncc;
+        a & d.cutoff_smoothcc & d.cutoff2_smoothcc;
+        a & d.cutoff_stepcc & d.cutoff2_stepcc;
+        a & d.cutoff_curvecc & d.cutoff2_curvecc;
+        a & d.cutoff_chanaft & d.cutoff2_chanaft;
+        a & d.cutoff_polyaft & d.cutoff2_polyaft;
+        a & d.resonance & d.resonance2;
+        a & d.resonance_oncc & d.resonance2_oncc;
+        a & d.resonance_smoothcc & d.resonance2_smoothcc;
+        a & d.resonance_stepcc & d.resonance2_stepcc;
+        a & d.resonance_curvecc & d.resonance2_curvecc;
+        a & d.pitch_oncc & d.pitch_stepcc;
+        a & d.pitch_smoothcc & d.pitch_curvecc;
+        a & d.fil_keytrack & d.fil2_keytrack;
+        a & d.fil_keycenter & d.fil2_keycenter;
+        a & d.fil_veltrack & d.fil2_veltrack;
+        a & d.fil_random & d.fil2_random;
+
+        a & d.eq1_freq & d.eq2_freq & d.eq3_freq;
+        a & d.eq1_freq_oncc & d.eq2_freq_oncc & d.eq3_freq_oncc;
+        a & d.eq1_vel2freq & d.eq2_vel2freq & d.eq3_vel2freq;
+        a & d.eq1_bw & d.eq2_bw & d.eq3_bw;
+        a & d.eq1_bw_oncc & d.eq2_bw_oncc & d.eq3_bw_oncc;
+        a & d.eq1_gain & d.eq2_gain & d.eq3_gain;
+        a & d.eq1_gain_oncc & d.eq2_gain_oncc & d.eq3_gain_oncc;
+        a & d.eq1_vel2gain & d.eq2_vel2gain & d.eq3_vel2gain;
+
+        a & d.ampeg_delay & d.ampeg_start & d.ampeg_attack & d.ampeg_hold & d.ampeg_decay;
+        a & d.ampeg_sustain & d.ampeg_release;
+        a & d.ampeg_vel2delay & d.ampeg_vel2attack & d.ampeg_vel2hold & d.ampeg_vel2decay;
+        a & d.ampeg_vel2sustain & d.ampeg_vel2release;
+        a & d.ampeg_delaycc & d.ampeg_startcc & d.ampeg_attackcc & d.ampeg_holdcc;
+        a & d.ampeg_decaycc & d.ampeg_sustaincc & d.ampeg_releasecc;
+        a & d.fileg_delay & d.fileg_start & d.fileg_attack & d.fileg_hold & d.fileg_decay;
+        a & d.fileg_sustain & d.fileg_release;
+        a & d.fileg_vel2delay & d.fileg_vel2attack & d.fileg_vel2hold & d.fileg_vel2decay;
+        a & d.fileg_vel2sustain & d.fileg_vel2release;
+        a & d.fileg_delay_oncc & d.fileg_start_oncc & d.fileg_attack_oncc & d.fileg_hold_oncc;
+        a & d.fileg_decay_oncc & d.fileg_sustain_oncc & d.fileg_release_oncc & d.fileg_depth_oncc;
+        a & d.pitcheg_delay & d.pitcheg_start & d.pitcheg_attack & d.pitcheg_hold;
+        a & d.pitcheg_decay & d.pitcheg_sustain & d.pitcheg_release;
+        a & d.pitcheg_vel2delay & d.pitcheg_vel2attack & d.pitcheg_vel2hold & d.pitcheg_vel2decay;
+        a & d.pitcheg_vel2sustain & d.pitcheg_vel2release;
+        a & d.fileg_depth & d.pitcheg_depth;
+        a & d.pitcheg_delay_oncc & d.pitcheg_start_oncc & d.pitcheg_attack_oncc;
+        a & d.pitcheg_hold_oncc;
+        a & d.pitcheg_decay_oncc & d.pitcheg_sustain_oncc & d.pitcheg_release_oncc;
+        a & d.pitcheg_depth_oncc;
+        a & d.amplfo_delay & d.amplfo_fade & d.amplfo_freq & d.amplfo_depth;
+        a & d.fillfo_delay & d.fillfo_fade & d.fillfo_freq & d.fillfo_depth;
+        a & d.pitchlfo_delay & d.pitchlfo_fade & d.pitchlfo_freq;
+        a & d.pitchlfo_depth;
+
+        a & d.pitchlfo_delay_oncc;
+        a & d.pitchlfo_fade_oncc;
+        a & d.pitchlfo_depthcc;
+        a & d.pitchlfo_freqcc;
+        a & d.fillfo_delay_oncc;
+        a & d.fillfo_fade_oncc;
+        a & d.fillfo_depthcc;
+        a & d.fillfo_freqcc;
+        a & d.amplfo_delay_oncc;
+        a & d.amplfo_fade_oncc;
+        a & d.amplfo_depthcc;
+        a & d.amplfo_freqcc;
+
+        a & d.eg;
+
+        a & d.lfos;
+
+        a & d.volume_oncc;
+        a & d.volume_curvecc;
+        a & d.volume_smoothcc;
+        a & d.volume_stepcc;
+
+        a & d.pan_oncc;
+        a & d.pan_curvecc;
+        a & d.pan_smoothcc;
+        a & d.pan_stepcc;
+    }
+
+    /**
+     * Whether all enum opcode values of @a d are valid enumerators, a cache
+     * file might have been written by a sampler with different enums.
+     */
+    static bool hasValidEnums(const Definition& d) {
+        const int triggers = TRIGGER_ATTACK | TRIGGER_RELEASE | TRIGGER_FIRST | TRIGGER_LEGATO;
+        return (d.trigger & ~triggers) == 0 &&
+               (d.sw_vel == VEL_CURRENT || d.sw_vel == VEL_PREVIOUS) &&
+               (d.off_mode == OFF_FAST || d.off_mode == OFF_NORMAL) &&
+               d.loop_mode >= NO_LOOP && d.loop_mode <= LOOP_UNSET &&
+               (d.xf_keycurve == GAIN || d.xf_keycurve == POWER) &&
+               (d.xf_velcurve == GAIN || d.xf_velcurve == POWER) &&
+               (d.xf_cccurve == GAIN || d.xf_cccurve == POWER) &&
+               d.fil_type >= LPF_1P && d.fil_type <= HPF_6P &&
+               d.fil2_type >= LPF_1P && d.fil2_type <= HPF_6P;
+    }
+
+    void InstrumentCache::SetDirectory(const std::string& Dir) {
+        if (mkdir(Dir.c_str(), 0755) && errno != EEXIST)
+            std::cerr << "Could not create sfz cache directory '" << Dir << "': " << strerror(errno) << std::endl << std::flush;
+        LinuxSampler::LockGuard lock(DirectoryMutex);
+        Directory = Dir;
+    }
+
+    bool InstrumentCache::IsEnabled() {
+        LinuxSampler::LockGuard lock(DirectoryMutex);
+        return !Directory.empty();
+    }
+
+    /// Returns the name of the cache file of sfz file @a File, or an empty string if the cache is disabled.
+    std::string InstrumentCache::CacheFile(const std::string& File) {
+        LinuxSampler::LockGuard lock(DirectoryMutex);
+        if (Directory.empty()) return std::string();
+        uint64_t hash = 14695981039346656037ULL; // FNV-1a
+        for (size_t i = 0; i < File.size(); i++)
+            hash = (hash ^ uint8_t(File[i])) * 1099511628211ULL;
+        char name[32];
+        snprintf(name, sizeof(name), "%016llx.sfzcache", (unsigned long long) hash);
+        return Directory + "/" + name;
+    }
+
+    void InstrumentCache::Serialize(Writer& writer, Instrument* pInstrument) {
+        std::map<const Region*,uint32_t> regionIndex;
+        uint32_t n = uint32_t(pInstrument->regions.size());
+        writer & n;
+        for (uint32_t i = 0; i < n; i++) {
+            Region* pRegion = pInstrument->regions[i];
+            writer & pRegion->id;
+            serialize(writer, (Definition&) *pRegion);
+            regionIndex[pRegion] = i;
+        }
+
+        writer & pInstrument->curves;
+
+        n = uint32_t(pInstrument->scripts.size());
+        writer & n;
+        for (uint32_t i = 0; i < n; i++) {
+            std::string path = pInstrument->scripts[i].m_path.toNativeFSPath();
+            writer & path;
+        }
+
+        n = uint32_t(pInstrument->initialCCValues.size());
+        writer & n;
+        for (std::map<uint8_t,uint8_t>::iterator it = pInstrument->initialCCValues.begin();
+             it != pInstrument->initialCCValues.end(); ++it)
+        {
+            uint8_t cc = it->first;
+            writer & cc & it->second;
+        }
+
+        for (int i = 0; i < 128; i++) {
+            bool key = pInstrument->KeyBindings[i];
+            bool keySwitch = pInstrument->KeySwitchBindings[i];
+            writer & key & keySwitch;
+        }
+
+        // the note-on lookup table, followed by the ones for CC triggered regions
+        for (int t = -1; t < 128; t++) {
+            LookupTable* pTable = (t < 0) ? pInstrument->pLookupTable : pInstrument->pLookupTableCC[t];
+            writer & pTable->dims & pTable->ccs & pTable->filterDims & pTable->filterCcs;
+            const std::vector<int>::size_type nbDimensions = pTable->dims.size() + pTable->ccs.size();
+            for (std::vector<int>::size_type dim = 0; dim < nbDimensions; dim++) {
+                int min, max;
+                pTable->mapArrRange(dim, min, max);
+                for (int i = min; i <= max; i++) writer & pTable->mapArr[dim][i];
+            }
+            writer & pTable->regionArrSize;
+            for (int i = 0; i < pTable->regionArrSize; i++) {
+                LinuxSampler::ArrayList<Region*>& list = pTable->regionArr[i];
+                n = uint32_t(list.size());
+                writer & n;
+                for (uint32_t j = 0; j < n; j++) writer & regionIndex[list[j]];
+            }
+        }
+    }
+
+    bool InstrumentCache::Deserialize(Reader& reader, Instrument* pInstrument) {
+        uint32_t n = reader.Count(sizeof(int));
+        for (uint32_t i = 0; i < n && !reader.Failed(); i++) {
+            Region* pRegion = new Region();
+            pInstrument->regions.push_back(pRegion);
+            pRegion->SetInstrument(pInstrument);
+            reader & pRegion->id;
+            serialize(reader, (Definition&) *pRegion);
+            if (!hasValidEnums(*pRegion)) reader.SetFailed();
+        }
+
+        reader & pInstrument->curves;
+
+        n = reader.Count(sizeof(uint32_t));
+        for (uint32_t i = 0; i < n && !reader.Failed(); i++) {
+            std::string path;
+            reader & path;
+            pInstrument->scripts.push_back(Script(path));
+        }
+
+        n = reader.Count(2);
+        for (uint32_t i = 0; i < n && !reader.Failed(); i++) {
+            uint8_t cc = 0, value = 0;
+            reader & cc & value;
+            pInstrument->initialCCValues[cc] = value;
+        }
+
+        for (int i = 0; i < 128; i++) {
+            bool key = false, keySwitch = false;
+            reader & key & keySwitch;
+            pInstrument->KeyBindings[i] = key;
+            pInstrument->KeySwitchBindings[i] = keySwitch;
+        }
+
+        const int nDimDefs = LookupTable::dimDefCount();
+        const size_t nRegions = pInstrument->regions.size();
+        for (int t = -1; t < 128 && !reader.Failed(); t++) {
+            LookupTable* pTable = new LookupTable;
+            if (t < 0) pInstrument->pLookupTable = pTable;
+            else pInstrument->pLookupTableCC[t] = pTable;
+
+            std::vector<int> dims, ccs, filterDims, filterCcs;
+            reader & dims & ccs & filterDims & filterCcs;
+            for (size_t i = 0; i < dims.size(); i++)
+                if (dims[i] < 0 || dims[i] >= nDimDefs) reader.SetFailed();
+            for (size_t i = 0; i < filterDims.size(); i++)
+                if (filterDims[i] < 0 || filterDims[i] >= nDimDefs) reader.SetFailed();
+            for (size_t i = 0; i < ccs.size(); i++)
+                if (ccs[i] < 0 || ccs[i] > 127) reader.SetFailed();
+            for (size_t i = 0; i < filterCcs.size(); i++)
+                if (filterCcs[i] < 0 || filterCcs[i] > 127) reader.SetFailed();
+            if (reader.Failed()) break;
+
+            pTable->dims = dims;
+            pTable->ccs  = ccs;
+            pTable->filterDims = filterDims;
+            pTable->filterCcs  = filterCcs;
+            pTable->filtered   = !filterDims.empty() || !filterCcs.empty();
+            pTable->triggercc  = t;
+            pTable->createArgs();
+            const std::vector<int>::size_type nbDimensions = dims.size() + ccs.size();
+            pTable->mapArr = new int*[nbDimensions];
+            for (std::vector<int>::size_type dim = 0; dim < nbDimensions; dim++) {
+                int min, max;
+                pTable->mapArrRange(dim, min, max);
+                pTable->mapArr[dim] = new int[max - min + 1]() - min;
+            }
+            for (std::vector<int>::size_type dim = 0; dim < nbDimensions; dim++) {
+                int min, max;
+                pTable->mapArrRange(dim, min, max);
+                for (int i = min; i <= max; i++) reader & pTable->mapArr[dim][i];
+            }
+
+            const uint32_t size = reader.Count(sizeof(uint32_t));
+            if (reader.Failed() || !size || size > INT_MAX) {
+                reader.SetFailed();
+                break;
+            }
+            pTable->regionArrSize = int(size);
+            // make sure that no query can exceed the region array
+            if (!pTable->isValid()) {
+                reader.SetFailed();
+                break;
+            }
+            pTable->regionArr = new LinuxSampler::ArrayList<Region*>[size];
+            for (uint32_t i = 0; i < size && !reader.Failed(); i++) {
+                LinuxSampler::ArrayList<Region*>& list = pTable->regionArr[i];
+                n = reader.Count(sizeof(uint32_t));
+                if (!n) continue;
+                list.resize(n);
+                for (uint32_t j = 0; j < n; j++) {
+                    uint32_t index = 0;
+                    reader & index;
+                    if (index >= nRegions) {
+                        reader.SetFailed();
+                        break;
+                    }
+                    list[j] = pInstrument->regions[index];
+                }
+            }
+        }
+        return !reader.Failed();
+    }
+
+    /// Reverts an instrument filled by Deserialize() to its freshly created state.
+    void InstrumentCache::Clear(Instrument* pInstrument) {
+        for (size_t i = 0; i < pInstrument->regions.size(); i++)
+            delete pInstrument->regions[i];
+        pInstrument->regions.clear();
+        delete pInstrument->pLookupTable;
+        pInstrument->pLookupTable = NULL;
+        for (int i = 0; i < 128; i++) {
+            delete pInstrument->pLookupTableCC[i];
+            pInstrument->pLookupTableCC[i] = NULL;
+        }
+        Curve c;
+        for (int i = 0; i < 128; i++) c.v[i] = i / 127.0f;
+        pInstrument->curves.clear();
+        for (int i = 0; i < 7; i++) pInstrument->curves.add(c);
+        pInstrument->scripts.clear();
+        pInstrument->initialCCValues.clear();
+        pInstrument->KeyBindings.assign(128, false);
+        pInstrument->KeySwitchBindings.assign(128, false);
+    }
+
+    /**
+     * Writes the modification time and size of file @a File, or -1 if it
+     * does not exist. If @a pHash is given, a hash of the file's content is
+     * written to it as well (0 if it does not exist).
+     */
+    static void fileStatus(const std::string& File, int64_t& ModificationTime, int64_t& Size, uint64_t* pHash = NULL) {
+        struct stat st;
+        if (stat(File.c_str(), &st)) {
+            ModificationTime = Size = -1;
+            if (pHash) *pHash = 0;
+            return;
+        }
+        ModificationTime = int64_t(st.st_mtime);
+        Size = int64_t(st.st_size);
+        if (!pHash) return;
+
+        // modification times only have a resolution of one second on some
+        // file systems and can be reset by the user, so the content counts
+        uint64_t hash = 14695981039346656037ULL; // FNV-1a
+        FILE* hFile = fopen(File.c_str(), "rb");
+        if (hFile) {
+            char buf[65536];
+            for (size_t n; (n = fread(buf, 1, sizeof(buf), hFile)) > 0; )
+                for (size_t i = 0; i < n; i++) hash = (hash ^ uint8_t(buf[i])) * 1099511628211ULL;
+            if (ferror(hFile)) hash = 0;
+            fclose(hFile);
+        } else {
+            hash = 0;
+        }
+        *pHash = hash;
+    }
+
+    bool InstrumentCache::Load(const std::string& File, Instrument* pInstrument) {
+        const std::string cacheFile = CacheFile(File);
+        if (cacheFile.empty()) return false;
+
+        FILE* hFile = fopen(cacheFile.c_str(), "rb");
+        if (!hFile) return false;
+        std::vector<uint8_t> data;
+        struct stat st;
+        if (!fstat(fileno(hFile), &st) && size_t(st.st_size) >= sizeof(cache_header_t)) {
+            data.resize(size_t(st.st_size));
+            if (fread(&data[0], data.size(), 1, hFile) != 1) data.clear();
+        }
+        fclose(hFile);
+        if (data.empty()) return false;
+
+        cache_header_t header;
+        memcpy(&header, &data[0], sizeof(header));
+        if (memcmp(header.Magic, CACHE_MAGIC, sizeof(CACHE_MAGIC)) ||
+            header.Version != CACHE_VERSION || header.RegionSize != sizeof(Region))
+        {
+            dmsg(1,("Ignoring outdated sfz cache file '%s'.\n", cacheFile.c_str()));
+            return false;
+        }
+
+        Reader reader(&data[0] + sizeof(header), data.size() - sizeof(header));
+        std::string file;
+        reader & file;
+        if (reader.Failed() || file != File) return false; // hash collision
+
+        // any changed file invalidates the whole cache file
+        const uint32_t nDependencies = reader.Count(sizeof(uint32_t));
+        for (uint32_t i = 0; i < nDependencies && !reader.Failed(); i++) {
+            std::string dependency;
+            int64_t modificationTime = 0, size = 0, currentModificationTime, currentSize;
+            uint64_t hash = 0, currentHash = 0;
+            reader & dependency & modificationTime & size & hash;
+            if (reader.Failed()) break;
+            fileStatus(dependency, currentModificationTime, currentSize);
+            // only hash the content if nothing else changed already
+            if (currentModificationTime == modificationTime && currentSize == size)
+                fileStatus(dependency, currentModificationTime, currentSize, &currentHash);
+            if (currentModificationTime != modificationTime || currentSize != size || currentHash != hash) {
+                dmsg(1,("sfz cache of '%s' outdated, '%s' changed.\n", File.c_str(), dependency.c_str()));
+                return false;
+            }
+        }
+        if (reader.Failed()) return false;
+
+        if (!Deserialize(reader, pInstrument)) {
+            std::cerr << "Ignoring invalid sfz cache file '" << cacheFile << "'." << std::endl << std::flush;
+            Clear(pInstrument);
+            return false;
+        }
+        dmsg(1,("Loaded sfz instrument from cache file '%s'.\n", cacheFile.c_str()));
+        return true;
+    }
+
+    void InstrumentCache::Save(const std::string& File, Instrument* pInstrument, const std::vector<std::string>& Dependencies) {
+        const std::string cacheFile = CacheFile(File);
+        if (cacheFile.empty()) return;
+
+        Writer writer;
+        cache_header_t header;
+        memset(&header, 0, sizeof(header));
+        memcpy(header.Magic, CACHE_MAGIC, sizeof(CACHE_MAGIC));
+        header.Version    = CACHE_VERSION;
+        header.RegionSize = sizeof(Region);
+        writer.Data.append((const char*) &header, sizeof(header));
+
+        std::string file = File;
+        writer & file;
+        uint32_t nDependencies = uint32_t(Dependencies.size());
+        writer & nDependencies;
+        for (uint32_t i = 0; i < nDependencies; i++) {
+            std::string dependency = Dependencies[i];
+            int64_t modificationTime, size;
+            uint64_t hash;
+            fileStatus(dependency, modificationTime, size, &hash);
+            writer & dependency & modificationTime & size & hash;
+        }
+        Serialize(writer, pInstrument);
+
+        // write to a temporary file first, so concurrent loads of the
+        // same file never see a partially written cache file
+        std::string tempFile = cacheFile + ".XXXXXX";
+        const int fd = mkstemp(&tempFile[0]);
+        if (fd < 0) {
+            std::cerr << "Could not create sfz cache file '" << tempFile << "': " << strerror(errno) << std::endl << std::flush;
+            return;
+        }
+        bool bError = false;
+        for (size_t written = 0; written < writer.Data.size(); ) {
+            const ssize_t n = write(fd, writer.Data.data() + written, writer.Data.size() - written);
+            if (n < 0 && errno == EINTR) continue;
+            if (n <= 0) {
+                bError = true;
+                break;
+            }
+            written += size_t(n);
+        }
+        if (close(fd)) bError = true;
+        if (bError || rename(tempFile.c_str(), cacheFile.c_str())) {
+            std::cerr << "Could not write sfz cache file '" << cacheFile << "': " << strerror(errno) << std::endl << std::flush;
+            unlink(tempFile.c_str());
+            return;
+        }
+        dmsg(2,("Wrote sfz cache file '%s' (%lu bytes).\n", cacheFile.c_str(), (unsigned long) writer.Data.size()));
+    }
+
+} // namespace sfz
+
+#endif // CONFIG_SFZ_CACHE
@@ -0,0 +1,93 @@
+/*
+ * Copyright (c) 2020 Christian Schoenebeck
+ *
+ * http://www.linuxsampler.org
+ *
+ * This file is part of LinuxSampler and released under the same terms.
+ * See README file for details.
+ */
+
+#ifndef LS_SFZ_INSTRUMENTCACHE_H
+#define LS_SFZ_INSTRUMENTCACHE_H
+
+#include "../../common/global_private.h"
+
+#if CONFIG_SFZ_CACHE
+
+#include "../../common/Mutex.h"
+#include <string>
+#include <vector>
+
+namespace sfz {
+
+    class Instrument;
+
+    /** @brief Binary cache of parsed sfz instruments.
+     *
+     * Parsing a large sfz instrument means reading and tokenizing all of its
+     * text, expanding its @c \#define variables and @c \#include files,
+     * assigning each opcode to its region and finally building the
+     * instrument's region lookup tables. For sessions with many large sfz
+     * instruments that dominates loading time.
+     *
+     * Once an sfz file was parsed, the fully resolved instrument (all
+     * regions with all their opcode values, curves, scripts, key bindings
+     * and lookup tables) is written to a cache file in the directory set
+     * with SetDirectory(). The next time the same sfz file is loaded, the
+     * instrument is restored from the cache file instead, as long as
+     * neither the sfz file nor any of the files it includes or refers to
+     * as script changed (by modification time, size and content) in the
+     * meantime.
+     *
+     * Cache files are only meant to be used on the same machine and with
+     * the same sampler version they were written with, data is stored in
+     * native byte order and layout. Invalid or outdated cache files are
+     * simply ignored and overwritten.
+     */
+    class InstrumentCache {
+        public:
+            /**
+             * Enables the cache with cache files stored in directory
+             * @a Dir (which is created if it does not exist). Should be
+             * called once on startup, before any instrument is loaded.
+             */
+            static void SetDirectory(const std::string& Dir);
+
+            /// Whether a cache directory was set with SetDirectory().
+            static bool IsEnabled();
+
+            /**
+             * Restores the instrument parsed from sfz file @a File into the
+             * freshly created, empty instrument @a pInstrument.
+             *
+             * @returns false if there is no valid cache file for @a File
+             *          (@a pInstrument is left empty then)
+             */
+            static bool Load(const std::string& File, Instrument* pInstrument);
+
+            /**
+             * Writes the cache file for the instrument @a pInstrument just
+             * parsed from sfz file @a File. @a Dependencies are all files
+             * the parse result depends on (the sfz file itself, included
+             * files and scripts), including ones which did not exist.
+             */
+            static void Save(const std::string& File, Instrument* pInstrument, const std::vector<std::string>& Dependencies);
+
+        private:
+            class Reader;
+            class Writer;
+
+            static LinuxSampler::Mutex DirectoryMutex; ///< Protects Directory.
+            static std::string         Directory;
+
+            static std::string CacheFile(const std::string& File);
+            static void Serialize(Writer& writer, Instrument* pInstrument);
+            static bool Deserialize(Reader& reader, Instrument* pInstrument);
+            static void Clear(Instrument* pInstrument);
+    };
+
+} // namespace sfz
+
+#endif // CONFIG_SFZ_CACHE
+
+#endif // LS_SFZ_INSTRUMENTCACHE_H
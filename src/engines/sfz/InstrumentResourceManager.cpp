@@ -92,6 +92,10 @@ namespace LinuxSampler { namespace sfz {
     }
 
     ::sfz::Instrument* InstrumentResourceManager::Create(instrument_id_t Key, InstrumentConsumer* pConsumer, void*& pArg) {
+        // samples shared with other sfz files are locked one by one (see
+        // CacheInstrumentSamples()), so different sfz files load in parallel
+        LockGuard fileLock(FileLoadMutex(Key.FileName));
+
         // get sfz file from internal sfz file manager
         ::sfz::File* pSfz = Sfzs.Borrow(Key.FileName, reinterpret_cast<SfzConsumer*>(Key.Index)); // conversion kinda hackish :/
 
@@ -109,18 +113,8 @@ namespace LinuxSampler { namespace sfz {
         }
         dmsg(1,("OK\n"));
 
-        // cache initial samples points (for actually needed samples)
-        dmsg(1,("Caching initial samples..."));
-        int regionCount = (int) pInstrument->regions.size();
         uint maxSamplesPerCycle = GetMaxSamplesPerCycle(pConsumer);
-        for (int i = 0 ; i < regionCount ; i++) {
-            float localProgress = (float) i / (float) regionCount;
-            DispatchResourceProgressEvent(Key, localProgress);
-            CacheInitialSamples(pInstrument->regions[i]->GetSample(), maxSamplesPerCycle);
-            //pInstrument->regions[i]->GetSample()->Close();
-        }
-        dmsg(1,("OK\n"));
-        DispatchResourceProgressEvent(Key, 1.0f); // done; notify all consumers about progress 100%
+        CacheInstrumentSamples(Key, pInstrument, maxSamplesPerCycle);
 
         // we need the following for destruction later
         instr_entry_t* pEntry = new instr_entry_t;
@@ -136,10 +130,85 @@ namespace LinuxSampler { namespace sfz {
         return pInstrument;
     }
 
+    /**
+     * Parses the sfz file of the given instrument again while the old
+     * instrument is still played. All sfz files share their samples (see
+     * SfzResourceManager::sampleManager) and the regions of the old
+     * instrument still hold their samples meanwhile, so regions of the
+     * new instrument referring to unchanged sample files get the very
+     * same samples, already cached in RAM. Only samples not used by the
+     * old instrument or modified on disk are loaded.
+     */
+    ::sfz::Instrument* InstrumentResourceManager::Recreate(instrument_id_t Key, InstrumentConsumer* pConsumer, ::sfz::Instrument* pOldResource, void* pOldArg, void*& pArg) {
+        instr_entry_t* pOldEntry = (instr_entry_t*) pOldArg;
+        uint maxSamplesPerCycle = GetMaxSamplesPerCycle(pConsumer);
+        // samples still played can't be cached again with more silence
+        // samples, so the instrument has to be loaded completely again
+        if (pOldEntry->MaxSamplesPerCycle < maxSamplesPerCycle) return NULL;
+
+        LockGuard fileLock(FileLoadMutex(Key.FileName));
+
+        dmsg(1,("Reloading sfz instrument ('%s',%d)...",Key.FileName.c_str(),Key.Index));
+        void* pSfzArg = NULL;
+        ::sfz::File* pSfz = Sfzs.Create(Key.FileName, NULL, pSfzArg);
+        ::sfz::Instrument* pInstrument = pSfz->GetInstrument();
+        dmsg(1,("OK\n"));
+
+        CacheInstrumentSamples(Key, pInstrument, maxSamplesPerCycle);
+
+        // the old sfz file is destroyed along with the old instrument
+        void* pOldSfzArg = NULL;
+        Sfzs.Replace(Key.FileName, pSfz, pSfzArg, pOldSfzArg);
+
+        instr_entry_t* pEntry = new instr_entry_t;
+        pEntry->ID.FileName   = Key.FileName;
+        pEntry->ID.Index      = Key.Index;
+        pEntry->pFile         = pSfz;
+        pEntry->MaxSamplesPerCycle = pOldEntry->MaxSamplesPerCycle;
+
+        pArg = pEntry;
+
+        return pInstrument;
+    }
+
+    void InstrumentResourceManager::CacheInstrumentSamples(instrument_id_t& Key, ::sfz::Instrument* pInstrument, uint maxSamplesPerCycle) {
+        // cache initial samples points (for actually needed samples)
+        dmsg(1,("Caching initial samples..."));
+        int regionCount = (int) pInstrument->regions.size();
+        for (int i = 0 ; i < regionCount ; i++) {
+            float localProgress = (float) i / (float) regionCount;
+            DispatchResourceProgressEvent(Key, localProgress);
+            ::sfz::Sample* pSample = pInstrument->regions[i]->GetSample();
+            if (!pSample) continue;
+            // the sample might be shared with an sfz file loaded concurrently
+            LockGuard sampleLock(FileLoadMutex(pSample->GetFile()));
+            CacheInitialSamples(pSample, maxSamplesPerCycle);
+            #if CONFIG_MMAP_STREAMING
+            // allow streaming the rest of large samples directly from their file
+            if (pSample->GetTotalFrameCount() > CONFIG_PRELOAD_SAMPLES)
+                pSample->MapSampleData((maxSamplesPerCycle << CONFIG_MAX_PITCH) + 6);
+            #endif
+            #if CONFIG_DIRECT_IO_STREAMING
+            // stream the rest of large samples bypassing the page cache
+            if (pSample->GetTotalFrameCount() > CONFIG_PRELOAD_SAMPLES)
+                pSample->OpenDirectReader();
+            #endif
+            //pInstrument->regions[i]->GetSample()->Close();
+        }
+        dmsg(1,("OK\n"));
+        DispatchResourceProgressEvent(Key, 1.0f); // done; notify all consumers about progress 100%
+    }
+
     void InstrumentResourceManager::Destroy(::sfz::Instrument* pResource, void* pArg) {
         instr_entry_t* pEntry = (instr_entry_t*) pArg;
         // we don't need the .sfz file here anymore
-        Sfzs.HandBack(pEntry->pFile, reinterpret_cast<SfzConsumer*>(pEntry->ID.Index)); // conversion kinda hackish :/
+        if (!Sfzs.HandBack(pEntry->pFile, reinterpret_cast<SfzConsumer*>(pEntry->ID.Index))) { // conversion kinda hackish :/
+            // the sfz file was already replaced by the reloaded one (see
+            // Recreate()), regions still played were retained by the
+            // engine channels when they switched over
+            LockGuard lock(RegionInfoMutex);
+            Sfzs.Destroy(pEntry->pFile, NULL);
+        }
         delete pEntry;
     }
 
@@ -158,6 +227,11 @@ namespace LinuxSampler { namespace sfz {
         
     }
 
+    void InstrumentResourceManager::CollectSamples(::sfz::Instrument* pInstrument, std::set<Sample*>& samples) {
+        for (size_t i = 0; i < pInstrument->regions.size(); i++)
+            if (pInstrument->regions[i]->pSample) samples.insert(pInstrument->regions[i]->pSample);
+    }
+
 
 
     // internal sfz file manager
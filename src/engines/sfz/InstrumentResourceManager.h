@@ -76,11 +76,15 @@ namespace LinuxSampler { namespace sfz {
             // implementation of derived abstract methods from 'ResourceManager'
             virtual ::sfz::Instrument* Create(instrument_id_t Key, InstrumentConsumer* pConsumer, void*& pArg);
             virtual void               Destroy(::sfz::Instrument* pResource, void* pArg);
+            virtual ::sfz::Instrument* Recreate(instrument_id_t Key, InstrumentConsumer* pConsumer, ::sfz::Instrument* pOldResource, void* pOldArg, void*& pArg) OVERRIDE;
             virtual void               DeleteRegionIfNotUsed(::sfz::Region* pRegion, region_info_t* pRegInfo);
             virtual void               DeleteSampleIfNotUsed(Sample* pSample, region_info_t* pRegInfo);
+            virtual void               CollectSamples(::sfz::Instrument* pInstrument, std::set<Sample*>& samples);
         private:
             typedef ResourceConsumer< ::sfz::File> SfzConsumer;
 
+            void CacheInstrumentSamples(instrument_id_t& Key, ::sfz::Instrument* pInstrument, uint maxSamplesPerCycle);
+
             class SfzResourceManager : public ResourceManager<String, ::sfz::File> {
                 protected:
                     // implementation of derived abstract methods from 'ResourceManager'
@@ -21,6 +21,7 @@
  ***************************************************************************/
 
 #include "LookupTable.h"
+#include <algorithm>
 #include <cstdio>
 #include <set>
 #include "../../common/global_private.h"
@@ -130,39 +131,230 @@ namespace sfz {
         return regionArr[offset];
     }
 
-    // recursively fills the region array with regions
-    void LookupTable::fillRegionArr(const int* len, Region* region,
-                                    std::vector<int>::size_type dim, int j,
-                                    int triggercc) {
-        if (dim == dims.size() + ccs.size()) {
-            regionArr[j].add(region);
-        } else if (dim < dims.size()) {
+    // gets the range of values of a dimension covered by a region
+    void LookupTable::valueRange(const Region* region,
+                                 std::vector<int>::size_type dim,
+                                 int& lo, int& hi) const {
+        if (dim < dims.size()) {
             int d = dims[dim];
-            int hi = region->*dimDefs[d].hi;
+            lo = region->*dimDefs[d].lo;
+            hi = region->*dimDefs[d].hi;
             // special case for sw_previous
             if (hi == -1) hi = 127;
-            for (int l = mapArr[dim][region->*dimDefs[d].lo] ;
-                 l <= mapArr[dim][hi] ; l++) {
-                fillRegionArr(len, region, dim + 1, j * len[dim] + l,
-                              triggercc);
-            }
         } else {
             int cc = ccs[dim - dims.size()];
-            int lo = region->locc[cc];
-            int hi = region->hicc[cc];
+            lo = region->locc[cc];
+            hi = region->hicc[cc];
             if (cc == triggercc) {
                 lo = std::max(lo, region->on_locc[cc]);
                 hi = std::min(hi, region->on_hicc[cc]);
             }
+        }
+    }
+
+    // recursively fills the lists of the region array with regions
+    void LookupTable::fillRegionArr(const int* len, Region* region,
+                                    std::vector<int>::size_type dim, int j,
+                                    std::vector<std::vector<Region*> >& lists) {
+        if (dim == dims.size() + ccs.size()) {
+            lists[j].push_back(region);
+        } else {
+            int lo;
+            int hi;
+            valueRange(region, dim, lo, hi);
             for (int l = mapArr[dim][lo] ; l <= mapArr[dim][hi] ; l++) {
-                fillRegionArr(len, region, dim + 1, j * len[dim] + l,
-                              triggercc);
+                fillRegionArr(len, region, dim + 1, j * len[dim] + l, lists);
+            }
+        }
+    }
+
+    // Reduces the dimensions of the table to the ones narrowing down
+    // the regions the most, if the region array would exceed
+    // maxDenseSize or maxDenseEntries otherwise. The other dimensions
+    // are moved to filterDims and filterCcs.
+    void LookupTable::selectDims(const std::vector<Region*>& regions,
+                                 int*& len) {
+        const std::vector<int>::size_type nbDimensions = dims.size() + ccs.size();
+        const std::vector<Region*>::size_type nbRegions = regions.size();
+
+        // number of zones covered by each region in each dimension
+        std::vector<std::vector<int> > spans(nbDimensions,
+                                             std::vector<int>(nbRegions));
+        std::vector<double> coverage(nbDimensions);
+        for (std::vector<int>::size_type dim = 0 ; dim < nbDimensions ; dim++) {
+            int64_t total = 0;
+            for (std::vector<Region*>::size_type i = 0 ; i < nbRegions ; i++) {
+                int lo;
+                int hi;
+                valueRange(regions[i], dim, lo, hi);
+                spans[dim][i] = std::max(0, mapArr[dim][hi] - mapArr[dim][lo] + 1);
+                total += spans[dim][i];
+            }
+            // average share of the regions in a zone
+            coverage[dim] = nbRegions ? double(total) / nbRegions / len[dim] : 0;
+        }
+
+        // check whether all dimensions fit
+        int64_t size = 1;
+        int64_t entries = 0;
+        for (std::vector<int>::size_type dim = 0 ; dim < nbDimensions && size <= maxDenseSize ; dim++) {
+            size *= len[dim];
+        }
+        for (std::vector<Region*>::size_type i = 0 ; i < nbRegions && entries <= maxDenseEntries ; i++) {
+            int64_t product = 1;
+            for (std::vector<int>::size_type dim = 0 ; dim < nbDimensions && product <= maxDenseEntries ; dim++) {
+                product *= spans[dim][i];
+            }
+            entries += product;
+        }
+        if (size <= maxDenseSize && entries <= maxDenseEntries) return;
+
+        // add dimensions to the table, the most selective first, as
+        // long as the limits are not exceeded
+        std::vector<std::pair<double, std::vector<int>::size_type> > order;
+        for (std::vector<int>::size_type dim = 0 ; dim < nbDimensions ; dim++) {
+            order.push_back(std::make_pair(coverage[dim], dim));
+        }
+        std::sort(order.begin(), order.end());
+
+        std::vector<bool> selected(nbDimensions, false);
+        std::vector<int64_t> products(nbRegions, 1);
+        size = 1;
+        for (std::vector<int>::size_type k = 0 ; k < nbDimensions ; k++) {
+            std::vector<int>::size_type dim = order[k].second;
+            if (size * len[dim] > maxDenseSize) continue;
+            entries = 0;
+            for (std::vector<Region*>::size_type i = 0 ; i < nbRegions ; i++) {
+                entries += products[i] * spans[dim][i];
+            }
+            if (entries > maxDenseEntries) continue;
+
+            selected[dim] = true;
+            size *= len[dim];
+            for (std::vector<Region*>::size_type i = 0 ; i < nbRegions ; i++) {
+                products[i] *= spans[dim][i];
+            }
+        }
+
+        // keep the selected dimensions and mapping arrays
+        std::vector<int> newDims;
+        std::vector<int> newCcs;
+        int** newMapArr = new int*[nbDimensions];
+        int* newLen = new int[nbDimensions];
+        int n = 0;
+        for (std::vector<int>::size_type dim = 0 ; dim < nbDimensions ; dim++) {
+            if (selected[dim]) {
+                if (dim < dims.size()) newDims.push_back(dims[dim]);
+                else newCcs.push_back(ccs[dim - dims.size()]);
+                newMapArr[n] = mapArr[dim];
+                newLen[n] = len[dim];
+                n++;
+            } else if (dim < dims.size()) {
+                dmsg(2,("filtered dim: %s\n", dimDefs[dims[dim]].str));
+                filterDims.push_back(dims[dim]);
+                delete[] (mapArr[dim] + dimDefs[dims[dim]].min);
+            } else {
+                dmsg(2,("filtered cc: %d\n", ccs[dim - dims.size()]));
+                filterCcs.push_back(ccs[dim - dims.size()]);
+                delete[] mapArr[dim];
+            }
+        }
+        delete[] mapArr;
+        delete[] len;
+        mapArr = newMapArr;
+        len = newLen;
+        dims = newDims;
+        ccs = newCcs;
+        filtered = true;
+    }
+
+    bool LookupTable::matchesFiltered(const Region* region,
+                                      const Query& q) const {
+        for (std::vector<int>::const_iterator d = filterDims.begin() ;
+             d != filterDims.end() ; ++d) {
+            int value = int8_t(q.*dimDefs[*d].qarg);
+            int hi = region->*dimDefs[*d].hi;
+            // special case for sw_previous
+            if (hi == -1) hi = 127;
+            if (value < region->*dimDefs[*d].lo || value > hi) return false;
+        }
+        for (std::vector<int>::const_iterator cc = filterCcs.begin() ;
+             cc != filterCcs.end() ; ++cc) {
+            int lo = region->locc[*cc];
+            int hi = region->hicc[*cc];
+            if (*cc == triggercc) {
+                lo = std::max(lo, region->on_locc[*cc]);
+                hi = std::min(hi, region->on_hicc[*cc]);
+            }
+            if (q.cc[*cc] < lo || q.cc[*cc] > hi) return false;
+        }
+        return true;
+    }
+
+    // creates the qargs and ccargs arrays for the used dimensions
+    void LookupTable::createArgs() {
+        // create and fill the qargs array with pointers to Query
+        // members
+        qargs = new const uint8_t Query::*[dims.size() + 1];
+        for (std::vector<int>::size_type i = 0 ; i < dims.size() ; i++) {
+            dmsg(2,("qargs %d: %s\n", int(i), dimDefs[dims[i]].str));
+            qargs[i] = dimDefs[dims[i]].qarg;
+        }
+        qargs[dims.size()] = 0;
+
+        // copy ccs vector to ccargs array
+        ccargs = new int[ccs.size() + 1];
+        for (std::vector<int>::size_type i = 0 ; i < ccs.size() ; ++i) {
+            dmsg(2,("ccargs %d: %d\n", int(i), ccs[i]));
+            ccargs[i] = ccs[i];
+        }
+        ccargs[ccs.size()] = -1;
+    }
+
+    int LookupTable::dimDefCount() {
+        int n = 0;
+        while (dimDefs[n].lo) n++;
+        return n;
+    }
+
+    // range of valid indexes of the mapping array of a dimension
+    void LookupTable::mapArrRange(std::vector<int>::size_type dim,
+                                  int& min, int& max) const {
+        if (dim < dims.size()) {
+            const DimDef& dimDef = dimDefs[dims[dim]];
+            min = dimDef.min;
+            max = dimDef.max == -1 ? 127 : dimDef.max;
+        } else {
+            min = 0;
+            max = 127;
+        }
+    }
+
+    // checks that no query can access anything outside of the arrays
+    bool LookupTable::isValid() const {
+        // query() adds up one offset of each dimension
+        int64_t maxOffset = 0;
+        for (std::vector<int>::size_type dim = 0 ; dim < dims.size() + ccs.size() ; dim++) {
+            int min;
+            int max;
+            int maxValue = 0;
+            mapArrRange(dim, min, max);
+            for (int i = min ; i <= max ; i++) {
+                if (mapArr[dim][i] < 0) return false;
+                maxValue = std::max(maxValue, mapArr[dim][i]);
             }
+            maxOffset += maxValue;
         }
+        return maxOffset < regionArrSize;
     }
 
+    LookupTable::LookupTable() :
+        mapArr(0), regionArr(0), regionArrSize(0), qargs(0), ccargs(0),
+        filtered(false), triggercc(-1) {
+    }
 
-    LookupTable::LookupTable(const Instrument* instrument, int triggercc) {
+    LookupTable::LookupTable(const Instrument* instrument, int triggercc) :
+        filtered(false), triggercc(triggercc) {
         std::vector<Region*> regions;
 
         // copy the interesting regions
@@ -200,15 +392,6 @@ namespace sfz {
             }
         }
 
-        // create and fill the qargs array with pointers to Query
-        // members
-        qargs = new const uint8_t Query::*[dims.size() + 1];
-        for (std::vector<int>::size_type i = 0 ; i < dims.size() ; i++) {
-            dmsg(2,("qargs %d: %s\n", int(i), dimDefs[dims[i]].str));
-            qargs[i] = dimDefs[dims[i]].qarg;
-        }
-        qargs[dims.size()] = 0;
-
         // find CC dimensions used by the instrument
         for (int cc = 0 ; cc < 128 ; cc++) {
             for (std::vector<Region*>::const_iterator i = regions.begin() ;
@@ -226,19 +409,10 @@ namespace sfz {
             }
         }
 
-        // copy ccs vector to ccargs array
-        ccargs = new int[ccs.size() + 1];
-        for (std::vector<int>::size_type i = 0 ; i < ccs.size() ; ++i) {
-            dmsg(2,("ccargs %d: %d\n", int(i), ccs[i]));
-            ccargs[i] = ccs[i];
-        }
-        ccargs[ccs.size()] = -1;
-
         int nbDimensions = int(dims.size() + ccs.size());
         int* len = new int[nbDimensions];
         mapArr = new int*[nbDimensions];
 
-        int size = 1;
         int dim = 0;
 
         // create and fill the dimension mapping arrays
@@ -250,7 +424,6 @@ namespace sfz {
             mapArr[dim] = new int[max - min + 1] - min;
             len[dim] = fillMapArr(regions, dimDefs[*dimi].lo, dimDefs[*dimi].hi,
                                   min, max, mapArr[dim]);
-            size *= len[dim];
             dim++;
         }
 
@@ -258,20 +431,36 @@ namespace sfz {
              cci != ccs.end() ; ++cci) {
             mapArr[dim] = new int[128];
             len[dim] = fillMapArr(regions, *cci, mapArr[dim], triggercc);
-            size *= len[dim];
             dim++;
         }
 
+        selectDims(regions, len);
+        createArgs();
+
+        nbDimensions = int(dims.size() + ccs.size());
+        int size = 1;
+        for (dim = 0 ; dim < nbDimensions ; dim++) size *= len[dim];
+
 
         dmsg(2,("-------------------------------\n"));
         dmsg(2,("nbDimensions=%d size=%d\n", nbDimensions, size));
 
-        // create and fill the region array
-        regionArr = new LinuxSampler::ArrayList<Region*>[size];
-
+        // create and fill the region array (collecting the lists in
+        // vectors first, as ArrayList::add() copies the whole list)
+        std::vector<std::vector<Region*> > lists(size);
         for (std::vector<Region*>::const_iterator i = regions.begin() ;
              i != regions.end() ; ++i) {
-            fillRegionArr(len, *i, 0, 0, triggercc);
+            fillRegionArr(len, *i, 0, 0, lists);
+        }
+
+        regionArr = new LinuxSampler::ArrayList<Region*>[size];
+        regionArrSize = size;
+        for (int i = 0 ; i < size ; i++) {
+            if (lists[i].empty()) continue;
+            regionArr[i].resize(lists[i].size());
+            for (std::vector<Region*>::size_type j = 0 ; j < lists[i].size() ; j++) {
+                regionArr[i][j] = lists[i][j];
+            }
         }
 
         // multiply the offsets in the mapping arrays so simple
@@ -281,14 +470,7 @@ namespace sfz {
             for (dim = nbDimensions - 2 ; dim >= 0 ; dim--) {
                 int min;
                 int max;
-                if (dim < dims.size()) {
-                    const DimDef& dimDef = dimDefs[dims[dim]];
-                    min = dimDef.min;
-                    max = dimDef.max == -1 ? 127 : dimDef.max;
-                } else {
-                    min = 0;
-                    max = 127;
-                }
+                mapArrRange(dim, min, max);
                 for (int i = min ; i <= max ; i++) mapArr[dim][i] *= c;
                 c *= len[dim];
             }
@@ -45,6 +45,16 @@ namespace sfz {
      * have two integer arrays, each of size 128, one for key number,
      * one for velocity. The region array only needs to be six items
      * big, as there are only 2 * 3 possible zone variations.
+     *
+     * The size of the region array is the product of the zone counts
+     * of all dimensions though, which explodes for instruments using
+     * many dimensions, like lots of controller ranges. So if the
+     * region array would get bigger than maxDenseSize lists, or the
+     * lists would hold more than maxDenseEntries regions in total,
+     * only the dimensions narrowing down the regions the most are
+     * put in the table, as many as fit within those limits. The
+     * lists returned by query() then contain regions not matching the
+     * remaining dimensions, which are sorted out by matches().
      */
     class LookupTable {
     public:
@@ -69,9 +79,32 @@ namespace sfz {
          */
         LinuxSampler::ArrayList<Region*>& query(const Query& q) const;
 
+        /**
+         * Checks a region returned by query() against the dimensions
+         * not covered by the table.
+         *
+         * @param region - region from the list returned by query()
+         * @param q - the same query given to query()
+         * @returns true if the region matches the query in all
+         *          dimensions
+         */
+        bool matches(const Region* region, const Query& q) const {
+            return !filtered || matchesFiltered(region, q);
+        }
+
     private:
+        friend class InstrumentCache;
+
+        // creates an empty table, to be filled by InstrumentCache
+        LookupTable();
+
         struct DimDef;
 
+        // limits of the region array size and of the total size of
+        // its lists, exceeding dimensions are left out of the table
+        static const int maxDenseSize = 1 << 16;
+        static const int maxDenseEntries = 1 << 22;
+
         static const DimDef dimDefs[]; // list of possible dimensions
         std::vector<int> dims; // dimensions used by the instrument
 
@@ -83,6 +116,7 @@ namespace sfz {
 
         // second level array with lists of regions
         LinuxSampler::ArrayList<Region*>* regionArr;
+        int regionArrSize;
 
         // pointers to used dimension arguments in the Query object
         const uint8_t Query::** qargs;
@@ -90,6 +124,13 @@ namespace sfz {
         // array with CCs used by the instrument
         int* ccargs;
 
+        // dimensions and CCs used by the instrument, but not covered
+        // by the table
+        std::vector<int> filterDims;
+        std::vector<int> filterCcs;
+        bool filtered;
+        int triggercc;
+
 
         // helper functions for the constructor
         static int fillMapArr(const std::vector<Region*>& regions,
@@ -98,9 +139,21 @@ namespace sfz {
                               int min, int max, int* a);
         static int fillMapArr(const std::vector<Region*>& regions,
                               int cc, int* a, int triggercc);
+        void valueRange(const Region* region,
+                        std::vector<int>::size_type dim,
+                        int& lo, int& hi) const;
+        void selectDims(const std::vector<Region*>& regions, int*& len);
         void fillRegionArr(const int* len, Region* region,
                            std::vector<int>::size_type dim, int j,
-                           int triggercc);
+                           std::vector<std::vector<Region*> >& lists);
+        void createArgs();
+        bool matchesFiltered(const Region* region, const Query& q) const;
+
+        // helper functions for InstrumentCache
+        static int dimDefCount();
+        void mapArrRange(std::vector<int>::size_type dim,
+                         int& min, int& max) const;
+        bool isValid() const;
     };
 }
 
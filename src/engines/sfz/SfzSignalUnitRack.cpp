@@ -40,7 +40,7 @@ namespace LinuxSampler { namespace sfz {
         return pVoice->GetSampleRate() / CONFIG_DEFAULT_SUBFRAGMENT_SIZE;
     }
     
-    float SfzSignalUnit::GetInfluence(ArrayList< ::sfz::CC>& cc) {
+    float SfzSignalUnit::GetInfluence(const ArrayList< ::sfz::CC>& cc) {
         float f = 0;
         for (int i = 0; i < cc.size(); i++) {
             int val = pVoice->GetControllerValue(cc[i].Controller);
@@ -348,13 +348,13 @@ namespace LinuxSampler { namespace sfz {
     void AmpLFOUnit::Trigger() {
         bActive = true;
         ::sfz::Region* const pRegion = pVoice->pRegion;
-        pLfoInfo->delay  = pRegion->amplfo_delay + GetInfluence(pRegion->amplfo_delay_oncc);
-        pLfoInfo->freq   = pRegion->amplfo_freq;
-        pLfoInfo->fade   = pRegion->amplfo_fade + GetInfluence(pRegion->amplfo_fade_oncc);
-        pLfoInfo->volume = pRegion->amplfo_depth;
+        lfoInfo.delay  = pRegion->amplfo_delay + GetInfluence(pRegion->amplfo_delay_oncc);
+        lfoInfo.freq   = pRegion->amplfo_freq;
+        lfoInfo.fade   = pRegion->amplfo_fade + GetInfluence(pRegion->amplfo_fade_oncc);
+        lfoInfo.volume = pRegion->amplfo_depth;
         
-        if (pLfoInfo->freq <= 0) {
-            if (!pRegion->amplfo_freqcc.empty()) pLfoInfo->freq = 0;
+        if (lfoInfo.freq <= 0) {
+            if (!pRegion->amplfo_freqcc.empty()) lfoInfo.freq = 0;
             else bActive = false;
         }
         
@@ -364,13 +364,13 @@ namespace LinuxSampler { namespace sfz {
     void PitchLFOUnit::Trigger() {
         bActive = true;
         ::sfz::Region* const pRegion = pVoice->pRegion;
-        pLfoInfo->delay = pRegion->pitchlfo_delay + GetInfluence(pRegion->pitchlfo_delay_oncc);
-        pLfoInfo->freq  = pRegion->pitchlfo_freq;
-        pLfoInfo->fade  = pRegion->pitchlfo_fade + GetInfluence(pRegion->pitchlfo_fade_oncc);
-        pLfoInfo->pitch = pRegion->pitchlfo_depth;
+        lfoInfo.delay = pRegion->pitchlfo_delay + GetInfluence(pRegion->pitchlfo_delay_oncc);
+        lfoInfo.freq  = pRegion->pitchlfo_freq;
+        lfoInfo.fade  = pRegion->pitchlfo_fade + GetInfluence(pRegion->pitchlfo_fade_oncc);
+        lfoInfo.pitch = pRegion->pitchlfo_depth;
         
-        if (pLfoInfo->freq <= 0) {
-            if (!pRegion->pitchlfo_freqcc.empty()) pLfoInfo->freq = 0;
+        if (lfoInfo.freq <= 0) {
+            if (!pRegion->pitchlfo_freqcc.empty()) lfoInfo.freq = 0;
             else bActive = false;
         }
         
@@ -380,13 +380,13 @@ namespace LinuxSampler { namespace sfz {
     void FilLFOUnit::Trigger() {
         bActive = true;
         ::sfz::Region* const pRegion = pVoice->pRegion;
-        pLfoInfo->delay  = pRegion->fillfo_delay + GetInfluence(pRegion->fillfo_delay_oncc);
-        pLfoInfo->freq   = pRegion->fillfo_freq;
-        pLfoInfo->fade   = pRegion->fillfo_fade + GetInfluence(pRegion->fillfo_fade_oncc);
-        pLfoInfo->cutoff = pRegion->fillfo_depth;
+        lfoInfo.delay  = pRegion->fillfo_delay + GetInfluence(pRegion->fillfo_delay_oncc);
+        lfoInfo.freq   = pRegion->fillfo_freq;
+        lfoInfo.fade   = pRegion->fillfo_fade + GetInfluence(pRegion->fillfo_fade_oncc);
+        lfoInfo.cutoff = pRegion->fillfo_depth;
         
-        if (pLfoInfo->freq <= 0) {
-            if (!pRegion->fillfo_freqcc.empty()) pLfoInfo->freq = 0;
+        if (lfoInfo.freq <= 0) {
+            if (!pRegion->fillfo_freqcc.empty()) lfoInfo.freq = 0;
             else bActive = false;
         }
         
@@ -428,7 +428,7 @@ namespace LinuxSampler { namespace sfz {
         }
     }
     
-    void CCUnit::SetCCs(ArrayList< ::sfz::CC>& cc) {
+    void CCUnit::SetCCs(const ArrayList< ::sfz::CC>& cc) {
         RemoveAllCCs();
         for (int i = 0; i < cc.size(); i++) {
             if (cc[i].Influence != 0) {
@@ -969,10 +969,8 @@ namespace LinuxSampler { namespace sfz {
         
         // LFO
         for (int i = 0; i < pRegion->lfos.size(); i++) {
-            if (pRegion->lfos[i].freq <= 0) {
-                if (pRegion->lfos[i].freq_oncc.empty()) continue; // Not initialized
-                else pRegion->lfos[i].freq = 0;
-            }
+            // (uninitialized LFOs with freq_oncc got frequency 0 on load)
+            if (pRegion->lfos[i].freq <= 0 && pRegion->lfos[i].freq_oncc.empty()) continue; // Not initialized
             
             if(LFOs.size() < LFOs.capacity()) {
                 LFOv2Unit lfo(this);
@@ -51,7 +51,7 @@ namespace LinuxSampler { namespace sfz {
             }
             
             double GetSampleRate();
-            float  GetInfluence(ArrayList< ::sfz::CC>& cc);
+            float  GetInfluence(const ArrayList< ::sfz::CC>& cc);
     };
     
     
@@ -65,7 +65,7 @@ namespace LinuxSampler { namespace sfz {
             
             void SetCCs(::sfz::Array<int>& pCC);
             void SetCCs(::sfz::Array<float>& pCC);
-            void SetCCs(ArrayList< ::sfz::CC>& cc);
+            void SetCCs(const ArrayList< ::sfz::CC>& cc);
             
             virtual void AddSmoothCC(uint8_t Controller, float Influence, short int Curve, float Smooth, float Step);
             
@@ -146,7 +146,7 @@ namespace LinuxSampler { namespace sfz {
     template <class T>
     class EGUnit: public SfzSignalUnit {
         public:
-            ::sfz::EG* pEGInfo;
+            const ::sfz::EG* pEGInfo;
             T EG;
 
             EGUnit(SfzSignalUnitRack* rack): SfzSignalUnit(rack), pEGInfo(NULL) { }
@@ -278,7 +278,7 @@ namespace LinuxSampler { namespace sfz {
     
     class LFOUnit: public SfzSignalUnit, public CCSignalUnit::Listener {
         public:
-            ::sfz::LFO*  pLfoInfo;
+            const ::sfz::LFO*  pLfoInfo;
             AbstractLfo* pLFO;
             FadeEGUnit   suFadeEG;
             SmoothCCUnit suDepthOnCC;
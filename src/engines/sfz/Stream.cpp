@@ -26,6 +26,7 @@
 
 
 #include "Stream.h"
+#include "../common/StreamBlockCache.h"
 #include "../../common/global_private.h"
 
 namespace LinuxSampler { namespace sfz {
@@ -40,7 +41,7 @@ namespace LinuxSampler { namespace sfz {
 
     long Stream::Read(uint8_t* pBuf, long SamplesToRead) {
         ::sfz::Sample* pSample = pRegion->pSample;
-        long total_readsamples = 0, readsamples = 0;
+        long total_readsamples = 0;
         bool endofsamplereached;
 
         // refill the disk stream buffer
@@ -51,16 +52,10 @@ namespace LinuxSampler { namespace sfz {
         }
         else { // normal forward playback
 
-            pSample->SetPos(this->SampleOffset); // recover old position
-
-            do {
-                readsamples        = pSample->Read(&pBuf[total_readsamples * pSample->GetFrameSize()], SamplesToRead);
-                SamplesToRead     -= readsamples;
-                total_readsamples += readsamples;
-            } while (SamplesToRead && readsamples > 0);
+            total_readsamples = ReadCached(pSample, this->SampleOffset, pBuf, SamplesToRead);
 
             // we have to store the position within the sample, because other streams might use the same sample
-            this->SampleOffset = pSample->GetPos();
+            this->SampleOffset += total_readsamples;
 
             endofsamplereached = (SampleOffset >= pSample->GetTotalFrameCount());
             dmsg(5,("Refilled stream %d with %ld (SamplePos: %lu)", this->hThis, total_readsamples, this->SampleOffset));
@@ -73,6 +68,43 @@ namespace LinuxSampler { namespace sfz {
         return total_readsamples;
     }
 
+    const void* Stream::GetReadSource() {
+        return pRegion->pSample;
+    }
+
+    bool Stream::IsCompressed() {
+        return pRegion->pSample->IsCompressed();
+    }
+
+    /**
+     * Reads @a FrameCount sample points of @a pSample starting at
+     * @a FrameOffset through the block cache shared by all streams, so that
+     * the same sample data is not read again and again by different streams.
+     *
+     * @returns amount of sample points actually read
+     */
+    long Stream::ReadCached(::sfz::Sample* pSample, unsigned long FrameOffset, uint8_t* pDst, long FrameCount) {
+        return StreamBlockCache::Read(
+            pSample->GetCacheSource(), pSample, pSample->GetFrameSize(),
+            FrameOffset, pDst, FrameCount,
+            [pSample](uint8_t* pDst, unsigned long FrameOffset, long FrameCount) -> long {
+                #if CONFIG_DIRECT_IO_STREAMING
+                if (DirectSampleReader* pReader = pSample->GetDirectReader()) {
+                    const long n = pReader->Read(FrameOffset, pDst, FrameCount);
+                    if (n >= 0) return n;
+                }
+                #endif
+                pSample->SetPos(FrameOffset);
+                long total = 0, n;
+                do {
+                    n = pSample->Read(&pDst[total * pSample->GetFrameSize()], FrameCount - total);
+                    total += n;
+                } while (total < FrameCount && n > 0);
+                return total;
+            }
+        );
+    }
+
     void Stream::Kill() {
         if(pRegion) pSampleManager->SetSampleNotInUse(pRegion->pSample, pRegion);
         StreamBase< ::sfz::Region>::Kill();
@@ -35,6 +35,10 @@ namespace LinuxSampler { namespace sfz {
             Stream(uint BufferSize, uint BufferWrapElements, ::sfz::SampleManager* pSampleManager);
             virtual long Read(uint8_t* pBuf, long SamplesToRead);
             virtual void Kill();
+            virtual const void* GetReadSource();
+            virtual bool IsCompressed();
+
+            static long ReadCached(::sfz::Sample* pSample, unsigned long FrameOffset, uint8_t* pDst, long FrameCount);
 
             void Launch (
                 Stream::Handle  hStream,
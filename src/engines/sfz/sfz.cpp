@@ -32,11 +32,20 @@
 #include "../../common/File.h"
 #include "../../common/Path.h"
 #include "LookupTable.h"
+#include "InstrumentCache.h"
 #include "../../common/global_private.h"
 
+#ifndef WIN32
+# include <sys/types.h>
+# include <sys/stat.h>
+# include <sys/mman.h>
+# include <fcntl.h>
+# include <unistd.h>
+#endif
+
 namespace sfz
 {
-    template <typename T> T check(std::string name, T min, T max, T val) {
+    template <typename T> T check(const std::string& name, T min, T max, T val) {
         if (val < min) {
             std::cerr << "sfz: The value of opcode '" << name;
             std::cerr << "' is below the minimum allowed value (min=" << min << "): " << val << std::endl;
@@ -51,21 +60,82 @@ namespace sfz
         return val;
     }
 
+    /**
+     * FNV-1a hash of an opcode name. It is evaluated at compile time for the
+     * case labels of the opcode dispatch in File::push_opcode(), the compiler
+     * thus ensures that the hashes of all supported opcodes are distinct.
+     */
+    static constexpr uint32_t opcodeHash(const char* s, uint32_t hash = 2166136261u) {
+        return (*s) ? opcodeHash(s + 1, (hash ^ uint8_t(*s)) * 16777619u) : hash;
+    }
+
+    static uint32_t opcodeHash(const std::string& s) {
+        uint32_t hash = 2166136261u;
+        for (size_t i = 0; i < s.size(); i++)
+            hash = (hash ^ uint8_t(s[i])) * 16777619u;
+        return hash;
+    }
+
+    // Case label of the opcode dispatch in File::push_opcode(). An unknown
+    // opcode might have the same hash as a supported one, so the name is
+    // compared as well and the switch is left on mismatch.
+    #define OPCODE(var, name) \
+        case opcodeHash(name): if (var != name) break;
+    #define OPCODE_ALIAS(var, name, alias) \
+        case opcodeHash(name): case opcodeHash(alias): if (var != name && var != alias) break;
+
     Sample* SampleManager::FindSample(std::string samplePath, uint offset, int end) {
+        LinuxSampler::LockGuard lock(mutex);
         std::map<Sample*, std::set<Region*> >::iterator it = sampleMap.begin();
         for (; it != sampleMap.end(); it++) {
             if (it->first->GetFile() == samplePath) {
                 /* Because the start of the sample is cached in RAM we treat
                  * same sample with different offset as different samples
                  * // TODO: Ignore offset when the whole sample is cached in RAM?
+                 * A sample file modified on disk in the meantime is loaded
+                 * again as well, instead of reusing its outdated RAM cache.
                  */
-                if (it->first->Offset == offset && it->first->End == end) return it->first;
+                if (it->first->Offset == offset && it->first->End == end && !it->first->IsModified()) return it->first;
             }
         }
 
         return NULL;
     }
 
+    /**
+     * Returns the sample for the given sample file, offset and end, which
+     * is shared by all regions using it, and adds @a pConsumer as consumer
+     * of it. The sample is created if there is none yet.
+     */
+    Sample* SampleManager::AcquireSample(std::string samplePath, uint offset, int end, Region* pConsumer) {
+        {
+            LinuxSampler::LockGuard lock(mutex);
+            Sample* pSample = FindSample(samplePath, offset, end);
+            if (pSample) {
+                AddSampleConsumer(pSample, pConsumer);
+                return pSample;
+            }
+        }
+        // opening the sample file takes a while, so other instruments
+        // being loaded concurrently are not blocked meanwhile
+        Sample* pNew = new Sample(samplePath, false, offset, end);
+        LinuxSampler::LockGuard lock(mutex);
+        Sample* pSample = FindSample(samplePath, offset, end);
+        if (pSample) delete pNew; // created by another thread meanwhile
+        else pSample = pNew;
+        AddSampleConsumer(pSample, pConsumer);
+        return pSample;
+    }
+
+    /// Removes @a pConsumer as consumer of @a pSample and frees the sample if it has no consumers anymore.
+    void SampleManager::ReleaseSample(Sample* pSample, Region* pConsumer) {
+        LinuxSampler::LockGuard lock(mutex);
+        RemoveSampleConsumer(pSample, pConsumer);
+        if (HasSampleConsumers(pSample)) return;
+        RemoveSample(pSample);
+        delete pSample;
+    }
+
     /////////////////////////////////////////////////////////////
     // class Script
 
@@ -139,25 +209,35 @@ namespace sfz
     {
         if (pSample == NULL && create && sample != "*silence") {
             uint i = offset ? *offset : 0;
-            Sample* sf = GetInstrument()->GetSampleManager()->FindSample(sample, i, end);
-            if (sf != NULL) pSample = sf; // Reuse already created sample
-            else pSample = new Sample(sample, false, i, end);
-            GetInstrument()->GetSampleManager()->AddSampleConsumer(pSample, this);
+            // reuses an already created sample if possible
+            pSample = GetInstrument()->GetSampleManager()->AcquireSample(sample, i, end, this);
         }
         return pSample;
     }
 
     void Region::DestroySampleIfNotUsed() {
         if (pSample == NULL) return;
-        GetInstrument()->GetSampleManager()->RemoveSampleConsumer(pSample, this);
-        if (!GetInstrument()->GetSampleManager()->HasSampleConsumers(pSample)) {
-            GetInstrument()->GetSampleManager()->RemoveSample(pSample);
-            delete pSample;
-            pSample = NULL;
-        }
+        GetInstrument()->GetSampleManager()->ReleaseSample(pSample, this);
+        pSample = NULL;
     }
 
     bool Region::OnKey(const Query& q) {
+        if (!MatchesQuery(q))
+            return false;
+
+        // seq_position has to be checked last, so we know that we
+        // increment the right counter
+        bool is_triggered = (seq_counter == seq_position);
+        seq_counter = (seq_counter % seq_length) + 1;
+
+        return is_triggered;
+    }
+
+    bool Region::WouldTriggerOnKey(const Query& q) const {
+        return MatchesQuery(q) && seq_counter == seq_position;
+    }
+
+    bool Region::MatchesQuery(const Query& q) const {
         // As the region comes from a LookupTable search on the query,
         // the following parameters are not checked here: chan, key,
         // vel, chanaft, polyaft, prog, sw_previous, cc. They are all
@@ -180,14 +260,6 @@ namespace sfz
             ((trigger & q.trig) != 0)
         );
 
-        if (!is_triggered)
-            return false;
-
-        // seq_position has to be checked last, so we know that we
-        // increment the right counter
-        is_triggered = (seq_counter == seq_position);
-        seq_counter = (seq_counter % seq_length) + 1;
-
         return is_triggered;
     }
 
@@ -223,6 +295,7 @@ namespace sfz
         this->name = name;
         this->pSampleManager = pSampleManager ? pSampleManager : this;
         pLookupTable = 0;
+        for (int i = 0; i < 128; i++) pLookupTableCC[i] = 0;
         
         // The first 6 curves are defined internally (actually 7 with the one at index 0)
         Curve c;
@@ -244,18 +317,33 @@ namespace sfz
     }
 
     void Query::search(const Instrument* pInstrument) {
-        pRegionList = &pInstrument->pLookupTable->query(*this);
+        pLookupTable = pInstrument->pLookupTable;
+        pRegionList = &pLookupTable->query(*this);
         regionIndex = 0;
     }
 
     void Query::search(const Instrument* pInstrument, int triggercc) {
-        pRegionList = &pInstrument->pLookupTableCC[triggercc]->query(*this);
+        pLookupTable = pInstrument->pLookupTableCC[triggercc];
+        pRegionList = &pLookupTable->query(*this);
         regionIndex = 0;
     }
 
     Region* Query::next() {
         for ( ; regionIndex < pRegionList->size() ; regionIndex++) {
-            if ((*pRegionList)[regionIndex]->OnKey(*this)) {
+            // the lookup table has to be checked first, as OnKey()
+            // advances the round robin counters
+            if (pLookupTable->matches((*pRegionList)[regionIndex], *this) &&
+                (*pRegionList)[regionIndex]->OnKey(*this)) {
+                return (*pRegionList)[regionIndex++];
+            }
+        }
+        return 0;
+    }
+
+    Region* Query::peekNext() {
+        for ( ; regionIndex < pRegionList->size() ; regionIndex++) {
+            if (pLookupTable->matches((*pRegionList)[regionIndex], *this) &&
+                (*pRegionList)[regionIndex]->WouldTriggerOnKey(*this)) {
                 return (*pRegionList)[regionIndex++];
             }
         }
@@ -892,6 +980,67 @@ namespace sfz
     /////////////////////////////////////////////////////////////
     // class File
 
+    /**
+     * Content of an .sfz file to be parsed. The file is memory mapped if
+     * possible, so the parser can scan it in place in one pass, instead of
+     * copying each line and each token.
+     */
+    class SourceFile {
+    public:
+        SourceFile(const std::string& file) : pData(NULL), size(0), mapped(false) {
+            #ifndef WIN32
+            const int fd = open(file.c_str(), O_RDONLY);
+            if (fd >= 0) {
+                struct stat st;
+                if (!fstat(fd, &st) && st.st_size > 0) {
+                    void* p = mmap(NULL, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+                    if (p != MAP_FAILED) {
+                        pData  = (const char*) p;
+                        size   = st.st_size;
+                        mapped = true;
+                        #ifdef MADV_SEQUENTIAL
+                        madvise(p, size, MADV_SEQUENTIAL);
+                        #endif
+                    }
+                }
+                close(fd);
+                if (mapped) return;
+            }
+            #endif
+            std::ifstream fs(file.c_str());
+            std::stringstream ss;
+            ss << fs.rdbuf();
+            buffer = ss.str();
+            pData = buffer.data();
+            size  = buffer.size();
+        }
+
+        ~SourceFile() {
+            #ifndef WIN32
+            if (mapped) munmap((void*) pData, size);
+            #endif
+        }
+
+        const char* begin() const { return pData; }
+        const char* end() const { return pData + size; }
+
+    private:
+        const char* pData;
+        size_t size;
+        bool mapped;
+        std::string buffer; ///< File content if it could not be mapped.
+    };
+
+    static inline bool isSpace(char c) {
+        return isspace((unsigned char) c);
+    }
+
+    /// Whether the text from @a pBegin to @a pEnd starts with @a prefix.
+    static inline bool startsWith(const char* pBegin, const char* pEnd, const char* prefix) {
+        const size_t n = strlen(prefix);
+        return size_t(pEnd - pBegin) >= n && !memcmp(pBegin, prefix, n);
+    }
+
     const std::string File::MACRO_NAME_CHARS = "abcdefghijklmnopqrstuvwxyzABCDEFGHIJKLMNOPQRSTUVWXYZ0123456789_";
     const std::string File::MACRO_VALUE_CHARS = "abcdefghijklmnopqrstuvwxyzABCDEFGHIJKLMNOPQRSTUVWXYZ0123456789_. /\\";
 
@@ -907,6 +1056,10 @@ namespace sfz
         _current_containers.push(defaultGlobalContainer);
         pCurDef = defaultGlobalContainer;
 
+        #if CONFIG_SFZ_CACHE
+        if (InstrumentCache::Load(file, _instrument)) return;
+        #endif
+
         parseFile(file,pSampleManager);
 
         std::set<float*> velcurves;
@@ -1043,52 +1196,65 @@ namespace sfz
             copyStepValues(r->resonance2_stepcc, r->resonance2_oncc);
             r->resonance2_stepcc.clear();
             
+            // EGs and LFOs are usually shared with other regions, only
+            // make them the region's own ones if there is anything to move
             for (int j = 0; j < r->eg.size(); j++) {
-                copyCurves(r->eg[j].pan_curvecc, r->eg[j].pan_oncc);
-                r->eg[j].pan_curvecc.clear();
+                if (r->eg[j].pan_curvecc.empty()) continue;
+                EG& eg = r->eg.at(j);
+                copyCurves(eg.pan_curvecc, eg.pan_oncc);
+                eg.pan_curvecc.clear();
             }
             
             for (int j = 0; j < r->lfos.size(); j++) {
-                r->lfos[j].copySmoothValues();
-                r->lfos[j].copyStepValues();
+                if (r->lfos[j].freq < 0 && !r->lfos[j].freq_oncc.empty()) {
+                    r->lfos.at(j).freq = 0;
+                }
+                if (!r->lfos[j].HasSmoothStepValues()) continue;
+                LFO& lfo = r->lfos.at(j);
+                lfo.copySmoothValues();
+                lfo.copyStepValues();
                 
-                copySmoothValues(r->lfos[j].volume_smoothcc, r->lfos[j].volume_oncc);
-                r->lfos[j].volume_smoothcc.clear();
+                copySmoothValues(lfo.volume_smoothcc, lfo.volume_oncc);
+                lfo.volume_smoothcc.clear();
                 
-                copyStepValues(r->lfos[j].volume_stepcc, r->lfos[j].volume_oncc);
-                r->lfos[j].volume_stepcc.clear();
+                copyStepValues(lfo.volume_stepcc, lfo.volume_oncc);
+                lfo.volume_stepcc.clear();
                 
-                copySmoothValues(r->lfos[j].freq_smoothcc, r->lfos[j].freq_oncc);
-                r->lfos[j].freq_smoothcc.clear();
+                copySmoothValues(lfo.freq_smoothcc, lfo.freq_oncc);
+                lfo.freq_smoothcc.clear();
                 
-                copyStepValues(r->lfos[j].freq_stepcc, r->lfos[j].freq_oncc);
-                r->lfos[j].freq_stepcc.clear();
+                copyStepValues(lfo.freq_stepcc, lfo.freq_oncc);
+                lfo.freq_stepcc.clear();
                 
-                copySmoothValues(r->lfos[j].pitch_smoothcc, r->lfos[j].pitch_oncc);
-                r->lfos[j].pitch_smoothcc.clear();
+                copySmoothValues(lfo.pitch_smoothcc, lfo.pitch_oncc);
+                lfo.pitch_smoothcc.clear();
                 
-                copyStepValues(r->lfos[j].pitch_stepcc, r->lfos[j].pitch_oncc);
-                r->lfos[j].pitch_stepcc.clear();
+                copyStepValues(lfo.pitch_stepcc, lfo.pitch_oncc);
+                lfo.pitch_stepcc.clear();
                 
-                copySmoothValues(r->lfos[j].pan_smoothcc, r->lfos[j].pan_oncc);
-                r->lfos[j].pan_smoothcc.clear();
+                copySmoothValues(lfo.pan_smoothcc, lfo.pan_oncc);
+                lfo.pan_smoothcc.clear();
                 
-                copyStepValues(r->lfos[j].pan_stepcc, r->lfos[j].pan_oncc);
-                r->lfos[j].pan_stepcc.clear();
+                copyStepValues(lfo.pan_stepcc, lfo.pan_oncc);
+                lfo.pan_stepcc.clear();
                 
-                copySmoothValues(r->lfos[j].cutoff_smoothcc, r->lfos[j].cutoff_oncc);
-                r->lfos[j].cutoff_smoothcc.clear();
+                copySmoothValues(lfo.cutoff_smoothcc, lfo.cutoff_oncc);
+                lfo.cutoff_smoothcc.clear();
                 
-                copyStepValues(r->lfos[j].cutoff_stepcc, r->lfos[j].cutoff_oncc);
-                r->lfos[j].cutoff_stepcc.clear();
+                copyStepValues(lfo.cutoff_stepcc, lfo.cutoff_oncc);
+                lfo.cutoff_stepcc.clear();
                 
-                copySmoothValues(r->lfos[j].resonance_smoothcc, r->lfos[j].resonance_oncc);
-                r->lfos[j].resonance_smoothcc.clear();
+                copySmoothValues(lfo.resonance_smoothcc, lfo.resonance_oncc);
+                lfo.resonance_smoothcc.clear();
                 
-                copyStepValues(r->lfos[j].resonance_stepcc, r->lfos[j].resonance_oncc);
-                r->lfos[j].resonance_stepcc.clear();
+                copyStepValues(lfo.resonance_stepcc, lfo.resonance_oncc);
+                lfo.resonance_stepcc.clear();
             }
         }
+
+        #if CONFIG_SFZ_CACHE
+        InstrumentCache::Save(file, _instrument, dependencies);
+        #endif
     }
 
     void File::parseFile(std::string file, SampleManager* pSampleManager){
@@ -1096,22 +1262,30 @@ namespace sfz
         token_type_t token_type = (token_type_t) -1;
         std::string token_string;
 
-        std::ifstream fs(file.c_str());
+        dependencies.push_back(file);
+        SourceFile source(file);
         currentDir = LinuxSampler::Path::stripLastName(file);
-        std::string token;
-        std::string line;
         currentLine = 0;
 
-        while (std::getline(fs, line))
+        const char* pNextLine;
+        for (const char* pLine = source.begin(); pLine < source.end(); pLine = pNextLine)
         {
             currentLine++;
+            const char* pEnd = (const char*) memchr(pLine, '\n', source.end() - pLine);
+            if (!pEnd) pEnd = source.end();
+            pNextLine = (pEnd < source.end()) ? pEnd + 1 : pEnd;
+
             // COMMENT
-            std::string::size_type slash_index = line.find("//");
-            if (slash_index != std::string::npos)
-                line.resize(slash_index);
+            for (const char* p = pLine; (p = (const char*) memchr(p, '/', pEnd - p)) && p + 1 < pEnd; p++) {
+                if (p[1] == '/') {
+                    pEnd = p;
+                    break;
+                }
+            }
 
             // #include
-            if (line.find("#include ") == 0) {
+            if (startsWith(pLine, pEnd, "#include ")) {
+                std::string line(pLine, pEnd);
                 size_t fname_start = line.find("\"");
                 if (fname_start == std::string::npos) continue;
 
@@ -1131,9 +1305,9 @@ namespace sfz
                 continue;
             }
             // #define
-            else if (line.find("#define") == 0)
+            else if (startsWith(pLine, pEnd, "#define"))
             {
-                
+                std::string line(pLine, pEnd);
                 size_t varname_start = line.find_first_not_of("\t ", std::strlen("#define"));
                 size_t varname_end = line.find_first_of("\t ", varname_start + 1);
                 size_t value_start = line.find_first_not_of("\t ", varname_end + 1);
@@ -1181,7 +1355,8 @@ namespace sfz
                 continue;
             }
             // script=path/to/scriptfile
-            else if (line.find("script") == 0) {
+            else if (startsWith(pLine, pEnd, "script")) {
+                std::string line(pLine, pEnd);
                 size_t eq = line.find_first_of("=");
                 if (eq == std::string::npos) {
                     std::cerr << "sfz error: opcode 'script' misses '=' character\n";
@@ -1195,6 +1370,7 @@ namespace sfz
                 LinuxSampler::Path path = LinuxSampler::Path::fromUnknownFS(value);
                 if (!currentDir.empty() && !path.isAbsolute())
                     path = LinuxSampler::Path::fromUnknownFS(currentDir) + path;
+                dependencies.push_back(path.toNativeFSPath());
                 LinuxSampler::File file(path);
                 if (!file.Exist()) {
                     std::cerr << "sfz error: script file '" << value << "' does not exist\n";
@@ -1211,19 +1387,23 @@ namespace sfz
             }
 
             // DEFINITION
-            std::stringstream linestream(line);
+            const char* p = pLine;
+            while (p < pEnd && isSpace(*p)) p++;
             int spaces = 0;
-            while (linestream >> token)
+            while (p < pEnd)
             {
-                linestream >> std::noskipws;
-                if (token[0] == '<') {
-                    std::string::size_type p = token.find('>', 1);
-                    if (p != std::string::npos && p < (token.size() - 1)) {
-                        linestream.seekg(p + 1 - token.size(), std::stringstream::cur);
-                        token.erase(p + 1);
+                const char* pToken = p;
+                while (p < pEnd && !isSpace(*p)) p++;
+                size_t length = p - pToken;
+                if (pToken[0] == '<') {
+                    const char* q = (const char*) memchr(pToken + 1, '>', length - 1);
+                    if (q && q < pToken + length - 1) {
+                        p = q + 1;
+                        length = p - pToken;
                     }
                 }
-                if (token[0] == '<' && token[token.size()-1] == '>')
+                const bool isHeader = pToken[0] == '<' && pToken[length - 1] == '>';
+                if (isHeader || memchr(pToken, '=', length))
                 {
                     // HEAD
                     if (!token_string.empty())
@@ -1237,39 +1417,19 @@ namespace sfz
                             push_opcode(token_string);
                             break;
                         }
-                        token_string.erase();
                     }
-                    token_string.append(token);
-                    token_type = HEADER;
-                }
-                else if (token.find('=') != std::string::npos)
-                {
-                    // HEAD
-                    if (!token_string.empty())
-                    {
-                        switch (token_type)
-                        {
-                        case HEADER:
-                            push_header(token_string);
-                            break;
-                        case OPCODE:
-                            push_opcode(token_string);
-                            break;
-                        }
-                        token_string.erase();
-                    }
-                    token_string.append(token);
-                    token_type = OPCODE;
+                    token_string.assign(pToken, length);
+                    token_type = isHeader ? HEADER : OPCODE;
                 }
                 else
                 {
                     // TAIL
                     token_string.append(spaces, ' ');
-                    token_string.append(token);
+                    token_string.append(pToken, length);
                 }
                 spaces = 0;
-                while (isspace(linestream.peek())) {
-                    linestream.ignore();
+                while (p < pEnd && isSpace(*p)) {
+                    p++;
                     spaces++;
                 }
             }
@@ -1337,10 +1497,41 @@ namespace sfz
         }
     }
     
+    void File::copyCurves(List<CC>& curves, List<CC>& dest) {
+        for (int i = 0; i < curves.size(); i++) {
+            for (int j = 0; j < dest.size(); j++) {
+                if (curves[i].Controller == dest[j].Controller) {
+                    dest.at(j).Curve = curves[i].Curve;
+                }
+            }
+        }
+    }
+    
+    void File::copySmoothValues(List<CC>& smooths, List<CC>& dest) {
+        for (int i = 0; i < smooths.size(); i++) {
+            for (int j = 0; j < dest.size(); j++) {
+                if (smooths[i].Controller == dest[j].Controller) {
+                    dest.at(j).Smooth = smooths[i].Smooth;
+                }
+            }
+        }
+    }
+    
+    void File::copyStepValues(List<CC>& steps, List<CC>& dest) {
+        for (int i = 0; i < steps.size(); i++) {
+            for (int j = 0; j < dest.size(); j++) {
+                if (steps[i].Controller == dest[j].Controller) {
+                    dest.at(j).Step = steps[i].Step;
+                }
+            }
+        }
+    }
+    
     int File::ToInt(const std::string& s) throw(LinuxSampler::Exception) {
         int i;
-        std::istringstream iss(s);
-        if(!(iss >> i)) {
+        numberStream.clear();
+        numberStream.str(s);
+        if(!(numberStream >> i)) {
             std::ostringstream oss;
             oss << "Line " << currentLine << ": Expected an integer";
             throw LinuxSampler::Exception(oss.str());
@@ -1350,8 +1541,9 @@ namespace sfz
 
     float File::ToFloat(const std::string& s) throw(LinuxSampler::Exception) {
         float i;
-        std::istringstream iss(s);
-        if(!(iss >> i)) {
+        numberStream.clear();
+        numberStream.str(s);
+        if(!(numberStream >> i)) {
             std::ostringstream oss;
             oss << "Line " << currentLine << ": Expected a floating-point number";
             throw LinuxSampler::Exception(oss.str());
@@ -1360,7 +1552,7 @@ namespace sfz
     }
 
     void
-    File::push_header(std::string token)
+    File::push_header(const std::string& token)
     {
         if (token == "<global>" ||
             token == "<master>" ||
@@ -1432,7 +1624,7 @@ namespace sfz
     }
 
     void
-    File::push_opcode(std::string token)
+    File::push_opcode(const std::string& token)
     {
 #ifndef _MSC_VER
         if (_current_section == UNKNOWN)
@@ -1478,8 +1670,10 @@ namespace sfz
             return;
         }
 
+        switch (opcodeHash(key))
+        {
         // sample definition
-        if ("sample" == key)
+        OPCODE(key, "sample")
         {
             // handle built-in sample types ...
             if (value == "*silence") {
@@ -1505,7 +1699,7 @@ namespace sfz
         }
 
         // control header directives
-        else if ("default_path" == key)
+        OPCODE(key, "default_path")
         {
             switch (_current_section)
             {
@@ -1517,7 +1711,7 @@ namespace sfz
             }
             return;
         }
-        else if ("octave_offset" == key)
+        OPCODE(key, "octave_offset")
         {
             switch (_current_section)
             {
@@ -1529,7 +1723,7 @@ namespace sfz
             }
             return;
         }
-        else if ("note_offset" == key)
+        OPCODE(key, "note_offset")
         {
             switch (_current_section)
             {
@@ -1543,131 +1737,139 @@ namespace sfz
         }
 
         // input controls
-        else if ("lochan" == key) pCurDef->lochan = ToInt(value);
-        else if ("hichan" == key) pCurDef->hichan = ToInt(value);
-        else if ("lokey"  == key) pCurDef->lokey  = parseKey(value);
-        else if ("hikey"  == key) pCurDef->hikey  = parseKey(value);
-        else if ("key" == key)
+        OPCODE(key, "lochan") pCurDef->lochan = ToInt(value); return;
+        OPCODE(key, "hichan") pCurDef->hichan = ToInt(value); return;
+        OPCODE(key, "lokey") pCurDef->lokey  = parseKey(value); return;
+        OPCODE(key, "hikey") pCurDef->hikey  = parseKey(value); return;
+        OPCODE(key, "key")
         {
             pCurDef->lokey = pCurDef->hikey = pCurDef->pitch_keycenter = parseKey(value);
+            return;
         }
-        else if ("lovel"  == key) pCurDef->lovel = ToInt(value);
-        else if ("hivel"  == key) pCurDef->hivel = ToInt(value);
-        else if ("lobend" == key) pCurDef->lobend = ToInt(value);
-        else if ("hibend" == key) pCurDef->hibend = ToInt(value);
-        else if ("lobpm"  == key) pCurDef->lobpm = ToFloat(value);
-        else if ("hibpm"  == key) pCurDef->hibpm = ToFloat(value);
-        else if ("lochanaft" == key) pCurDef->lochanaft = ToInt(value);
-        else if ("hichanaft" == key) pCurDef->hichanaft = ToInt(value);
-        else if ("lopolyaft" == key) pCurDef->lopolyaft = ToInt(value);
-        else if ("hipolyaft" == key) pCurDef->hipolyaft = ToInt(value);
-        else if ("loprog"  == key) pCurDef->loprog = ToInt(value);
-        else if ("hiprog"  == key) pCurDef->hiprog = ToInt(value);
-        else if ("lorand"  == key) pCurDef->lorand = ToFloat(value);
-        else if ("hirand"  == key) pCurDef->hirand = ToFloat(value);
-        else if ("lotimer" == key) pCurDef->lotimer = ToFloat(value);
-        else if ("hitimer" == key) pCurDef->hitimer = ToFloat(value);
-        else if ("seq_length"   == key) pCurDef->seq_length = ToInt(value);
-        else if ("seq_position" == key) pCurDef->seq_position = ToInt(value);
-        else if ("sw_lokey" == key) pCurDef->sw_lokey = parseKey(value);
-        else if ("sw_hikey" == key) pCurDef->sw_hikey = parseKey(value);
-        else if ("sw_last"  == key) pCurDef->sw_last = parseKey(value);
-        else if ("sw_down"  == key) pCurDef->sw_down = parseKey(value);
-        else if ("sw_up"    == key) pCurDef->sw_up = parseKey(value);
-        else if ("sw_previous" == key) pCurDef->sw_previous = parseKey(value);
-        else if ("sw_vel" == key)
+        OPCODE(key, "lovel") pCurDef->lovel = ToInt(value); return;
+        OPCODE(key, "hivel") pCurDef->hivel = ToInt(value); return;
+        OPCODE(key, "lobend") pCurDef->lobend = ToInt(value); return;
+        OPCODE(key, "hibend") pCurDef->hibend = ToInt(value); return;
+        OPCODE(key, "lobpm") pCurDef->lobpm = ToFloat(value); return;
+        OPCODE(key, "hibpm") pCurDef->hibpm = ToFloat(value); return;
+        OPCODE(key, "lochanaft") pCurDef->lochanaft = ToInt(value); return;
+        OPCODE(key, "hichanaft") pCurDef->hichanaft = ToInt(value); return;
+        OPCODE(key, "lopolyaft") pCurDef->lopolyaft = ToInt(value); return;
+        OPCODE(key, "hipolyaft") pCurDef->hipolyaft = ToInt(value); return;
+        OPCODE(key, "loprog") pCurDef->loprog = ToInt(value); return;
+        OPCODE(key, "hiprog") pCurDef->hiprog = ToInt(value); return;
+        OPCODE(key, "lorand") pCurDef->lorand = ToFloat(value); return;
+        OPCODE(key, "hirand") pCurDef->hirand = ToFloat(value); return;
+        OPCODE(key, "lotimer") pCurDef->lotimer = ToFloat(value); return;
+        OPCODE(key, "hitimer") pCurDef->hitimer = ToFloat(value); return;
+        OPCODE(key, "seq_length") pCurDef->seq_length = ToInt(value); return;
+        OPCODE(key, "seq_position") pCurDef->seq_position = ToInt(value); return;
+        OPCODE(key, "sw_lokey") pCurDef->sw_lokey = parseKey(value); return;
+        OPCODE(key, "sw_hikey") pCurDef->sw_hikey = parseKey(value); return;
+        OPCODE(key, "sw_last") pCurDef->sw_last = parseKey(value); return;
+        OPCODE(key, "sw_down") pCurDef->sw_down = parseKey(value); return;
+        OPCODE(key, "sw_up") pCurDef->sw_up = parseKey(value); return;
+        OPCODE(key, "sw_previous") pCurDef->sw_previous = parseKey(value); return;
+        OPCODE(key, "sw_vel")
         {
             if (value == "current") pCurDef->sw_vel = VEL_CURRENT;
             else if (value == "previous") pCurDef->sw_vel = VEL_PREVIOUS;
+            return;
         }
-        else if ("trigger" == key)
+        OPCODE(key, "trigger")
         {
             if (value == "attack") pCurDef->trigger = TRIGGER_ATTACK;
             else if (value == "release") pCurDef->trigger = TRIGGER_RELEASE;
             else if (value == "first")   pCurDef->trigger = TRIGGER_FIRST;
             else if (value == "legato")  pCurDef->trigger = TRIGGER_LEGATO;
+            return;
         }
-        else if ("group"  == key) pCurDef->group = ToInt(value);
-        else if ("off_by" == key || "offby" == key) pCurDef->off_by = ToInt(value);
-        else if ("off_mode" == key || "offmode" == key)
+        OPCODE(key, "group") pCurDef->group = ToInt(value); return;
+        OPCODE_ALIAS(key, "off_by", "offby") pCurDef->off_by = ToInt(value); return;
+        OPCODE_ALIAS(key, "off_mode", "offmode")
         {
             if (value == "fast")  pCurDef->off_mode = OFF_FAST;
             else if (value == "normal") pCurDef->off_mode = OFF_NORMAL;
+            return;
         }
 
         // sample player
-        else if ("count" == key) { pCurDef->count = ToInt(value); pCurDef->loop_mode = ONE_SHOT; }
-        else if ("delay" == key) pCurDef->delay = ToFloat(value);
-        else if ("delay_random"   == key) pCurDef->delay_random = ToFloat(value);
-        else if ("delay_beats"    == key) pCurDef->delay_beats = ToInt(value);
-        else if ("stop_beats"     == key) pCurDef->stop_beats = ToInt(value);
-        else if ("delay_samples"  == key) pCurDef->delay_samples = ToInt(value);
-        else if ("end"            == key) pCurDef->end = ToInt(value);
-        else if ("loop_crossfade" == key) pCurDef->loop_crossfade = ToFloat(value);
-        else if ("offset_random"  == key) pCurDef->offset_random = ToInt(value);
-        else if ("loop_mode" == key || "loopmode" == key)
+        OPCODE(key, "count") { pCurDef->count = ToInt(value); pCurDef->loop_mode = ONE_SHOT; } return;
+        OPCODE(key, "delay") pCurDef->delay = ToFloat(value); return;
+        OPCODE(key, "delay_random") pCurDef->delay_random = ToFloat(value); return;
+        OPCODE(key, "delay_beats") pCurDef->delay_beats = ToInt(value); return;
+        OPCODE(key, "stop_beats") pCurDef->stop_beats = ToInt(value); return;
+        OPCODE(key, "delay_samples") pCurDef->delay_samples = ToInt(value); return;
+        OPCODE(key, "end") pCurDef->end = ToInt(value); return;
+        OPCODE(key, "loop_crossfade") pCurDef->loop_crossfade = ToFloat(value); return;
+        OPCODE(key, "offset_random") pCurDef->offset_random = ToInt(value); return;
+        OPCODE_ALIAS(key, "loop_mode", "loopmode")
         {
             if (value == "no_loop") pCurDef->loop_mode = NO_LOOP;
             else if (value == "one_shot") pCurDef->loop_mode = ONE_SHOT;
             else if (value == "loop_continuous") pCurDef->loop_mode = LOOP_CONTINUOUS;
             else if (value == "loop_sustain") pCurDef->loop_mode = LOOP_SUSTAIN;
+            return;
         }
-        else if ("loop_start" == key) pCurDef->loop_start = ToInt(value);
-        else if ("loopstart" == key) pCurDef->loop_start = ToInt(value); // nonstandard
-        else if ("loop_end" == key) pCurDef->loop_end = ToInt(value);
-        else if ("loopend" == key) pCurDef->loop_end = ToInt(value); // nonstandard
-        else if ("offset" == key) pCurDef->offset = ToInt(value);
-        else if ("sync_beats" == key) pCurDef->sync_beats = ToInt(value);
-        else if ("sync_offset" == key) pCurDef->sync_offset = ToInt(value);
+        OPCODE(key, "loop_start") pCurDef->loop_start = ToInt(value); return;
+        OPCODE(key, "loopstart") pCurDef->loop_start = ToInt(value); return; // nonstandard
+        OPCODE(key, "loop_end") pCurDef->loop_end = ToInt(value); return;
+        OPCODE(key, "loopend") pCurDef->loop_end = ToInt(value); return; // nonstandard
+        OPCODE(key, "offset") pCurDef->offset = ToInt(value); return;
+        OPCODE(key, "sync_beats") pCurDef->sync_beats = ToInt(value); return;
+        OPCODE(key, "sync_offset") pCurDef->sync_offset = ToInt(value); return;
 
         // amplifier
-        else if ("volume"   == key) pCurDef->volume = ToFloat(value);
-        else if ("amplitude" == key) pCurDef->amplitude = ToFloat(value);
-        else if ("pan"      == key) pCurDef->pan = ToFloat(value);
-        else if ("width"    == key) pCurDef->width = ToFloat(value);
-        else if ("position" == key) pCurDef->position = ToFloat(value);
-        else if ("amp_keytrack"  == key) pCurDef->amp_keytrack = ToFloat(value);
-        else if ("amp_keycenter" == key) pCurDef->amp_keycenter = parseKey(value);
-        else if ("amp_veltrack"  == key) pCurDef->amp_veltrack = ToFloat(value);
-        else if ("amp_random"  == key) pCurDef->amp_random = ToFloat(value);
-        else if ("rt_decay" == key || "rtdecay" == key) pCurDef->rt_decay = ToFloat(value);
-        else if ("xfin_lokey"  == key) pCurDef->xfin_lokey = parseKey(value);
-        else if ("xfin_hikey"  == key) pCurDef->xfin_hikey = parseKey(value);
-        else if ("xfout_lokey" == key) pCurDef->xfout_lokey = parseKey(value);
-        else if ("xfout_hikey" == key) pCurDef->xfout_hikey = parseKey(value);
-        else if ("xf_keycurve" == key)
+        OPCODE(key, "volume") pCurDef->volume = ToFloat(value); return;
+        OPCODE(key, "amplitude") pCurDef->amplitude = ToFloat(value); return;
+        OPCODE(key, "pan") pCurDef->pan = ToFloat(value); return;
+        OPCODE(key, "width") pCurDef->width = ToFloat(value); return;
+        OPCODE(key, "position") pCurDef->position = ToFloat(value); return;
+        OPCODE(key, "amp_keytrack") pCurDef->amp_keytrack = ToFloat(value); return;
+        OPCODE(key, "amp_keycenter") pCurDef->amp_keycenter = parseKey(value); return;
+        OPCODE(key, "amp_veltrack") pCurDef->amp_veltrack = ToFloat(value); return;
+        OPCODE(key, "amp_random") pCurDef->amp_random = ToFloat(value); return;
+        OPCODE_ALIAS(key, "rt_decay", "rtdecay") pCurDef->rt_decay = ToFloat(value); return;
+        OPCODE(key, "xfin_lokey") pCurDef->xfin_lokey = parseKey(value); return;
+        OPCODE(key, "xfin_hikey") pCurDef->xfin_hikey = parseKey(value); return;
+        OPCODE(key, "xfout_lokey") pCurDef->xfout_lokey = parseKey(value); return;
+        OPCODE(key, "xfout_hikey") pCurDef->xfout_hikey = parseKey(value); return;
+        OPCODE(key, "xf_keycurve")
         {
             if (value == "gain") pCurDef->xf_keycurve = GAIN;
             else if (value == "power") pCurDef->xf_keycurve = POWER;
+            return;
         }
-        else if ("xfin_lovel"  == key) pCurDef->xfin_lovel = ToInt(value);
-        else if ("xfin_hivel"  == key) pCurDef->xfin_hivel = ToInt(value);
-        else if ("xfout_lovel" == key) pCurDef->xfout_lovel = ToInt(value);
-        else if ("xfout_hivel" == key) pCurDef->xfout_hivel = ToInt(value);
-        else if ("xf_velcurve" == key)
+        OPCODE(key, "xfin_lovel") pCurDef->xfin_lovel = ToInt(value); return;
+        OPCODE(key, "xfin_hivel") pCurDef->xfin_hivel = ToInt(value); return;
+        OPCODE(key, "xfout_lovel") pCurDef->xfout_lovel = ToInt(value); return;
+        OPCODE(key, "xfout_hivel") pCurDef->xfout_hivel = ToInt(value); return;
+        OPCODE(key, "xf_velcurve")
         {
             if (value == "gain") pCurDef->xf_velcurve = GAIN;
             else if (value == "power") pCurDef->xf_velcurve = POWER;
+            return;
         }
-        else if ("xf_cccurve" == key)
+        OPCODE(key, "xf_cccurve")
         {
             if (value == "gain") pCurDef->xf_cccurve = GAIN;
             else if (value == "power") pCurDef->xf_cccurve = POWER;
+            return;
         }
 
         // pitch
-        else if ("transpose" == key) pCurDef->transpose = ToInt(value);
-        else if ("tune" == key) pCurDef->tune = ToInt(value);
-        else if ("pitch_keycenter" == key) pCurDef->pitch_keycenter = parseKey(value);
-        else if ("pitch_keytrack" == key) pCurDef->pitch_keytrack = ToInt(value);
-        else if ("pitch_veltrack" == key) pCurDef->pitch_veltrack = ToInt(value);
-        else if ("pitch_random" == key) pCurDef->pitch_random = ToInt(value);
-        else if ("bend_up" == key || "bendup" == key) pCurDef->bend_up = ToInt(value);
-        else if ("bend_down" == key || "benddown" == key) pCurDef->bend_down = ToInt(value);
-        else if ("bend_step" == key || "bendstep" == key) pCurDef->bend_step = ToInt(value);
+        OPCODE(key, "transpose") pCurDef->transpose = ToInt(value); return;
+        OPCODE(key, "tune") pCurDef->tune = ToInt(value); return;
+        OPCODE(key, "pitch_keycenter") pCurDef->pitch_keycenter = parseKey(value); return;
+        OPCODE(key, "pitch_keytrack") pCurDef->pitch_keytrack = ToInt(value); return;
+        OPCODE(key, "pitch_veltrack") pCurDef->pitch_veltrack = ToInt(value); return;
+        OPCODE(key, "pitch_random") pCurDef->pitch_random = ToInt(value); return;
+        OPCODE_ALIAS(key, "bend_up", "bendup") pCurDef->bend_up = ToInt(value); return;
+        OPCODE_ALIAS(key, "bend_down", "benddown") pCurDef->bend_down = ToInt(value); return;
+        OPCODE_ALIAS(key, "bend_step", "bendstep") pCurDef->bend_step = ToInt(value); return;
 
         // filter
-        else if ("fil_type" == key || "filtype" == key)
+        OPCODE_ALIAS(key, "fil_type", "filtype")
         {
             if (value == "lpf_1p") pCurDef->fil_type = LPF_1P;
             else if (value == "hpf_1p") pCurDef->fil_type = HPF_1P;
@@ -1683,8 +1885,9 @@ namespace sfz
             else if (value == "hpf_4p") pCurDef->fil_type = HPF_4P;
             else if (value == "lpf_6p") pCurDef->fil_type = LPF_6P;
             else if (value == "hpf_6p") pCurDef->fil_type = HPF_6P;
+            return;
         }
-        else if ("fil2_type" == key)
+        OPCODE(key, "fil2_type")
         {
             if (value == "lpf_1p") pCurDef->fil2_type = LPF_1P;
             else if (value == "hpf_1p") pCurDef->fil2_type = HPF_1P;
@@ -1700,44 +1903,113 @@ namespace sfz
             else if (value == "hpf_4p") pCurDef->fil2_type = HPF_4P;
             else if (value == "lpf_6p") pCurDef->fil2_type = LPF_6P;
             else if (value == "hpf_6p") pCurDef->fil2_type = HPF_6P;
+            return;
         }
-        else if ("cutoff"  == key) pCurDef->cutoff = ToFloat(value);
-        else if ("cutoff2" == key) pCurDef->cutoff2 = ToFloat(value);
-        else if ("cutoff_chanaft"  == key) {
+        OPCODE(key, "cutoff") pCurDef->cutoff = ToFloat(value); return;
+        OPCODE(key, "cutoff2") pCurDef->cutoff2 = ToFloat(value); return;
+        OPCODE(key, "cutoff_chanaft")
+        {
             pCurDef->cutoff_chanaft = check(key, -9600, 9600, ToInt(value));
             pCurDef->cutoff_oncc.add( CC(128, check(key, -9600, 9600, ToInt(value))) );
-        } else if ("cutoff2_chanaft" == key) pCurDef->cutoff2_chanaft = ToInt(value);
-        else if ("cutoff_polyaft"  == key) pCurDef->cutoff_polyaft = ToInt(value);
-        else if ("cutoff2_polyaft" == key) pCurDef->cutoff2_polyaft = ToInt(value);
-        else if ("resonance"  == key) pCurDef->resonance = ToFloat(value);
-        else if ("resonance2" == key) pCurDef->resonance2 = ToFloat(value);
-        else if ("fil_keytrack"   == key) pCurDef->fil_keytrack = ToInt(value);
-        else if ("fil2_keytrack"  == key) pCurDef->fil2_keytrack = ToInt(value);
-        else if ("fil_keycenter"  == key) pCurDef->fil_keycenter = parseKey(value);
-        else if ("fil2_keycenter" == key) pCurDef->fil2_keycenter = parseKey(value);
-        else if ("fil_veltrack"   == key) pCurDef->fil_veltrack = ToInt(value);
-        else if ("fil2_veltrack"  == key) pCurDef->fil2_veltrack = ToInt(value);
-        else if ("fil_random"     == key) pCurDef->fil_random = ToInt(value);
-        else if ("fil2_random"    == key) pCurDef->fil2_random = ToInt(value);
+            return;
+        }
+        OPCODE(key, "cutoff2_chanaft") pCurDef->cutoff2_chanaft = ToInt(value); return;
+        OPCODE(key, "cutoff_polyaft") pCurDef->cutoff_polyaft = ToInt(value); return;
+        OPCODE(key, "cutoff2_polyaft") pCurDef->cutoff2_polyaft = ToInt(value); return;
+        OPCODE(key, "resonance") pCurDef->resonance = ToFloat(value); return;
+        OPCODE(key, "resonance2") pCurDef->resonance2 = ToFloat(value); return;
+        OPCODE(key, "fil_keytrack") pCurDef->fil_keytrack = ToInt(value); return;
+        OPCODE(key, "fil2_keytrack") pCurDef->fil2_keytrack = ToInt(value); return;
+        OPCODE(key, "fil_keycenter") pCurDef->fil_keycenter = parseKey(value); return;
+        OPCODE(key, "fil2_keycenter") pCurDef->fil2_keycenter = parseKey(value); return;
+        OPCODE(key, "fil_veltrack") pCurDef->fil_veltrack = ToInt(value); return;
+        OPCODE(key, "fil2_veltrack") pCurDef->fil2_veltrack = ToInt(value); return;
+        OPCODE(key, "fil_random") pCurDef->fil_random = ToInt(value); return;
+        OPCODE(key, "fil2_random") pCurDef->fil2_random = ToInt(value); return;
 
         // per voice equalizer
-        else if ("eq1_freq" == key) pCurDef->eq1_freq = ToFloat(value);
-        else if ("eq2_freq" == key) pCurDef->eq2_freq = ToFloat(value);
-        else if ("eq3_freq" == key) pCurDef->eq3_freq = ToFloat(value);
-        else if ("eq1_vel2freq" == key) pCurDef->eq1_vel2freq = ToFloat(value);
-        else if ("eq2_vel2freq" == key) pCurDef->eq2_vel2freq = ToFloat(value);
-        else if ("eq3_vel2freq" == key) pCurDef->eq3_vel2freq = ToFloat(value);
-        else if ("eq1_bw" == key) pCurDef->eq1_bw = ToFloat(value);
-        else if ("eq2_bw" == key) pCurDef->eq2_bw = ToFloat(value);
-        else if ("eq3_bw" == key) pCurDef->eq3_bw = ToFloat(value);
-        else if ("eq1_gain" == key) pCurDef->eq1_gain = ToFloat(value);
-        else if ("eq2_gain" == key) pCurDef->eq2_gain = ToFloat(value);
-        else if ("eq3_gain" == key) pCurDef->eq3_gain = ToFloat(value);
-        else if ("eq1_vel2gain" == key) pCurDef->eq1_vel2gain = ToFloat(value);
-        else if ("eq2_vel2gain" == key) pCurDef->eq2_vel2gain = ToFloat(value);
-        else if ("eq3_vel2gain" == key) pCurDef->eq3_vel2gain = ToFloat(value);
-
-        else if (sscanf(key.c_str(), "amp_velcurve_%d", &x)) {
+        OPCODE(key, "eq1_freq") pCurDef->eq1_freq = ToFloat(value); return;
+        OPCODE(key, "eq2_freq") pCurDef->eq2_freq = ToFloat(value); return;
+        OPCODE(key, "eq3_freq") pCurDef->eq3_freq = ToFloat(value); return;
+        OPCODE(key, "eq1_vel2freq") pCurDef->eq1_vel2freq = ToFloat(value); return;
+        OPCODE(key, "eq2_vel2freq") pCurDef->eq2_vel2freq = ToFloat(value); return;
+        OPCODE(key, "eq3_vel2freq") pCurDef->eq3_vel2freq = ToFloat(value); return;
+        OPCODE(key, "eq1_bw") pCurDef->eq1_bw = ToFloat(value); return;
+        OPCODE(key, "eq2_bw") pCurDef->eq2_bw = ToFloat(value); return;
+        OPCODE(key, "eq3_bw") pCurDef->eq3_bw = ToFloat(value); return;
+        OPCODE(key, "eq1_gain") pCurDef->eq1_gain = ToFloat(value); return;
+        OPCODE(key, "eq2_gain") pCurDef->eq2_gain = ToFloat(value); return;
+        OPCODE(key, "eq3_gain") pCurDef->eq3_gain = ToFloat(value); return;
+        OPCODE(key, "eq1_vel2gain") pCurDef->eq1_vel2gain = ToFloat(value); return;
+        OPCODE(key, "eq2_vel2gain") pCurDef->eq2_vel2gain = ToFloat(value); return;
+        OPCODE(key, "eq3_vel2gain") pCurDef->eq3_vel2gain = ToFloat(value); return;
+
+        // v1 envelope generators
+        OPCODE(key, "ampeg_delay") pCurDef->ampeg_delay = ToFloat(value); return;
+        OPCODE(key, "ampeg_start") pCurDef->ampeg_start = ToFloat(value); return;
+        OPCODE(key, "ampeg_attack") pCurDef->ampeg_attack = ToFloat(value); return;
+        OPCODE(key, "ampeg_hold") pCurDef->ampeg_hold = ToFloat(value); return;
+        OPCODE(key, "ampeg_decay") pCurDef->ampeg_decay = ToFloat(value); return;
+        OPCODE(key, "ampeg_sustain") pCurDef->ampeg_sustain = ToFloat(value); return;
+        OPCODE(key, "ampeg_release") pCurDef->ampeg_release = ToFloat(value); return;
+        OPCODE(key, "ampeg_vel2delay") pCurDef->ampeg_vel2delay = ToFloat(value); return;
+        OPCODE(key, "ampeg_vel2attack") pCurDef->ampeg_vel2attack = ToFloat(value); return;
+        OPCODE(key, "ampeg_vel2hold") pCurDef->ampeg_vel2hold = ToFloat(value); return;
+        OPCODE(key, "ampeg_vel2decay") pCurDef->ampeg_vel2decay = ToFloat(value); return;
+        OPCODE(key, "ampeg_vel2sustain") pCurDef->ampeg_vel2sustain = ToFloat(value); return;
+        OPCODE(key, "ampeg_vel2release") pCurDef->ampeg_vel2release = ToFloat(value); return;
+        OPCODE(key, "fileg_delay") pCurDef->fileg_delay = ToFloat(value); return;
+        OPCODE(key, "fileg_start") pCurDef->fileg_start = ToFloat(value); return;
+        OPCODE(key, "fileg_attack") pCurDef->fileg_attack = ToFloat(value); return;
+        OPCODE(key, "fileg_hold") pCurDef->fileg_hold = ToFloat(value); return;
+        OPCODE(key, "fileg_decay") pCurDef->fileg_decay = ToFloat(value); return;
+        OPCODE(key, "fileg_sustain") pCurDef->fileg_sustain = ToFloat(value); return;
+        OPCODE(key, "fileg_release") pCurDef->fileg_release = ToFloat(value); return;
+        OPCODE(key, "fileg_depth") pCurDef->fileg_depth = check(key, -12000, 12000, ToInt(value)); return;
+        OPCODE(key, "fileg_vel2delay") pCurDef->fileg_vel2delay = check(key, -100.0f, 100.0f, ToFloat(value)); return;
+        OPCODE(key, "fileg_vel2attack") pCurDef->fileg_vel2attack = ToFloat(value); return;
+        OPCODE(key, "fileg_vel2hold") pCurDef->fileg_vel2hold = ToFloat(value); return;
+        OPCODE(key, "fileg_vel2decay") pCurDef->fileg_vel2decay = ToFloat(value); return;
+        OPCODE(key, "fileg_vel2sustain") pCurDef->fileg_vel2sustain = ToFloat(value); return;
+        OPCODE(key, "fileg_vel2release") pCurDef->fileg_vel2release = ToFloat(value); return;
+        OPCODE(key, "pitcheg_delay") pCurDef->pitcheg_delay = ToFloat(value); return;
+        OPCODE(key, "pitcheg_start") pCurDef->pitcheg_start = ToFloat(value); return;
+        OPCODE(key, "pitcheg_attack") pCurDef->pitcheg_attack = ToFloat(value); return;
+        OPCODE(key, "pitcheg_hold") pCurDef->pitcheg_hold = ToFloat(value); return;
+        OPCODE(key, "pitcheg_decay") pCurDef->pitcheg_decay = ToFloat(value); return;
+        OPCODE(key, "pitcheg_sustain") pCurDef->pitcheg_sustain = ToFloat(value); return;
+        OPCODE(key, "pitcheg_release") pCurDef->pitcheg_release = ToFloat(value); return;
+        OPCODE(key, "pitcheg_depth") pCurDef->pitcheg_depth = check(key, -12000, 12000, ToInt(value)); return;
+        OPCODE(key, "pitcheg_vel2delay") pCurDef->pitcheg_vel2delay = check(key, -100.0f, 100.0f, ToFloat(value)); return;
+        OPCODE(key, "pitcheg_vel2attack") pCurDef->pitcheg_vel2attack = ToFloat(value); return;
+        OPCODE(key, "pitcheg_vel2hold") pCurDef->pitcheg_vel2hold = ToFloat(value); return;
+        OPCODE(key, "pitcheg_vel2decay") pCurDef->pitcheg_vel2decay = ToFloat(value); return;
+        OPCODE(key, "pitcheg_vel2sustain") pCurDef->pitcheg_vel2sustain = ToFloat(value); return;
+        OPCODE(key, "pitcheg_vel2release") pCurDef->pitcheg_vel2release = ToFloat(value); return;
+        
+
+        // v1 LFO
+        OPCODE(key, "amplfo_delay") pCurDef->amplfo_delay = ToFloat(value); return;
+        OPCODE(key, "amplfo_fade") pCurDef->amplfo_fade = ToFloat(value); return;
+        OPCODE(key, "amplfo_freq") pCurDef->amplfo_freq = ToFloat(value); return;
+        OPCODE(key, "amplfo_freqchanaft") pCurDef->amplfo_freqcc.add( CC(128, check(key, -200.0f, 200.0f, ToFloat(value))) ); return;
+        OPCODE(key, "amplfo_depth") pCurDef->amplfo_depth = ToFloat(value); return;
+        OPCODE(key, "amplfo_depthchanaft") pCurDef->amplfo_depthcc.add( CC(128, check(key, -10.0f, 10.0f, ToFloat(value))) ); return;
+        OPCODE(key, "fillfo_delay") pCurDef->fillfo_delay = ToFloat(value); return;
+        OPCODE(key, "fillfo_fade") pCurDef->fillfo_fade = ToFloat(value); return;
+        OPCODE(key, "fillfo_freq") pCurDef->fillfo_freq = ToFloat(value); return;
+        OPCODE(key, "fillfo_freqchanaft") pCurDef->fillfo_freqcc.add( CC(128, check(key, -200.0f, 200.0f, ToFloat(value))) ); return;
+        OPCODE(key, "fillfo_depth") pCurDef->fillfo_depth = ToFloat(value); return;
+        OPCODE(key, "fillfo_depthchanaft") pCurDef->fillfo_depthcc.add( CC(128, check(key, -1200, 1200, ToInt(value))) ); return;
+        OPCODE(key, "pitchlfo_delay") pCurDef->pitchlfo_delay = ToFloat(value); return;
+        OPCODE(key, "pitchlfo_fade") pCurDef->pitchlfo_fade = ToFloat(value); return;
+        OPCODE(key, "pitchlfo_freq") pCurDef->pitchlfo_freq = ToFloat(value); return;
+        OPCODE(key, "pitchlfo_freqchanaft") pCurDef->pitchlfo_freqcc.add( CC(128, check(key, -200.0f, 200.0f, ToFloat(value))) ); return;
+        OPCODE(key, "pitchlfo_depth") pCurDef->pitchlfo_depth = ToInt(value); return;
+        OPCODE(key, "pitchlfo_depthchanaft") pCurDef->pitchlfo_depthcc.add( CC(128, check(key, -1200, 1200, ToInt(value))) ); return;
+        }
+
+        if (sscanf(key.c_str(), "amp_velcurve_%d", &x)) {
             pCurDef->amp_velcurve.set(x, ToFloat(value));
         }
         
@@ -1793,71 +2065,6 @@ namespace sfz
             else std::cerr << "The opcode '" << key << "' is unsupported by libsfz!" << std::endl;
         }
 
-        // v1 envelope generators
-        else if ("ampeg_delay"   == key) pCurDef->ampeg_delay = ToFloat(value);
-        else if ("ampeg_start"   == key) pCurDef->ampeg_start = ToFloat(value);
-        else if ("ampeg_attack"   == key) pCurDef->ampeg_attack = ToFloat(value);
-        else if ("ampeg_hold"   == key) pCurDef->ampeg_hold = ToFloat(value);
-        else if ("ampeg_decay"   == key) pCurDef->ampeg_decay = ToFloat(value);
-        else if ("ampeg_sustain"   == key) pCurDef->ampeg_sustain = ToFloat(value);
-        else if ("ampeg_release" == key) pCurDef->ampeg_release = ToFloat(value);
-        else if ("ampeg_vel2delay" == key) pCurDef->ampeg_vel2delay = ToFloat(value);
-        else if ("ampeg_vel2attack" == key) pCurDef->ampeg_vel2attack = ToFloat(value);
-        else if ("ampeg_vel2hold" == key) pCurDef->ampeg_vel2hold = ToFloat(value);
-        else if ("ampeg_vel2decay" == key) pCurDef->ampeg_vel2decay = ToFloat(value);
-        else if ("ampeg_vel2sustain" == key) pCurDef->ampeg_vel2sustain = ToFloat(value);
-        else if ("ampeg_vel2release" == key) pCurDef->ampeg_vel2release = ToFloat(value);
-        else if ("fileg_delay"   == key) pCurDef->fileg_delay = ToFloat(value);
-        else if ("fileg_start"   == key) pCurDef->fileg_start = ToFloat(value);
-        else if ("fileg_attack"   == key) pCurDef->fileg_attack = ToFloat(value);
-        else if ("fileg_hold"   == key) pCurDef->fileg_hold = ToFloat(value);
-        else if ("fileg_decay"   == key) pCurDef->fileg_decay = ToFloat(value);
-        else if ("fileg_sustain"   == key) pCurDef->fileg_sustain = ToFloat(value);
-        else if ("fileg_release"   == key) pCurDef->fileg_release = ToFloat(value);
-        else if ("fileg_depth"   == key) pCurDef->fileg_depth = check(key, -12000, 12000, ToInt(value));
-        else if ("fileg_vel2delay"   == key) pCurDef->fileg_vel2delay = check(key, -100.0f, 100.0f, ToFloat(value));
-        else if ("fileg_vel2attack"  == key) pCurDef->fileg_vel2attack = ToFloat(value);
-        else if ("fileg_vel2hold"    == key) pCurDef->fileg_vel2hold = ToFloat(value);
-        else if ("fileg_vel2decay"   == key) pCurDef->fileg_vel2decay = ToFloat(value);
-        else if ("fileg_vel2sustain" == key) pCurDef->fileg_vel2sustain = ToFloat(value);
-        else if ("fileg_vel2release" == key) pCurDef->fileg_vel2release = ToFloat(value);
-        else if ("pitcheg_delay"   == key) pCurDef->pitcheg_delay = ToFloat(value);
-        else if ("pitcheg_start"   == key) pCurDef->pitcheg_start = ToFloat(value);
-        else if ("pitcheg_attack"  == key) pCurDef->pitcheg_attack = ToFloat(value);
-        else if ("pitcheg_hold"    == key) pCurDef->pitcheg_hold = ToFloat(value);
-        else if ("pitcheg_decay"   == key) pCurDef->pitcheg_decay = ToFloat(value);
-        else if ("pitcheg_sustain" == key) pCurDef->pitcheg_sustain = ToFloat(value);
-        else if ("pitcheg_release" == key) pCurDef->pitcheg_release = ToFloat(value);
-        else if ("pitcheg_depth"   == key) pCurDef->pitcheg_depth = check(key, -12000, 12000, ToInt(value));
-        else if ("pitcheg_vel2delay"   == key) pCurDef->pitcheg_vel2delay = check(key, -100.0f, 100.0f, ToFloat(value));
-        else if ("pitcheg_vel2attack"  == key) pCurDef->pitcheg_vel2attack = ToFloat(value);
-        else if ("pitcheg_vel2hold"    == key) pCurDef->pitcheg_vel2hold = ToFloat(value);
-        else if ("pitcheg_vel2decay"   == key) pCurDef->pitcheg_vel2decay = ToFloat(value);
-        else if ("pitcheg_vel2sustain" == key) pCurDef->pitcheg_vel2sustain = ToFloat(value);
-        else if ("pitcheg_vel2release" == key) pCurDef->pitcheg_vel2release = ToFloat(value);
-        
-
-        // v1 LFO
-        else if ("amplfo_delay" == key) pCurDef->amplfo_delay = ToFloat(value);
-        else if ("amplfo_fade" == key) pCurDef->amplfo_fade = ToFloat(value);
-        else if ("amplfo_freq" == key) pCurDef->amplfo_freq = ToFloat(value);
-        else if ("amplfo_freqchanaft" == key) pCurDef->amplfo_freqcc.add( CC(128, check(key, -200.0f, 200.0f, ToFloat(value))) );
-        else if ("amplfo_depth" == key) pCurDef->amplfo_depth = ToFloat(value);
-        else if ("amplfo_depthchanaft" == key) pCurDef->amplfo_depthcc.add( CC(128, check(key, -10.0f, 10.0f, ToFloat(value))) );
-        else if ("fillfo_delay" == key) pCurDef->fillfo_delay = ToFloat(value);
-        else if ("fillfo_fade" == key) pCurDef->fillfo_fade = ToFloat(value);
-        else if ("fillfo_freq" == key) pCurDef->fillfo_freq = ToFloat(value);
-        else if ("fillfo_freqchanaft" == key) pCurDef->fillfo_freqcc.add( CC(128, check(key, -200.0f, 200.0f, ToFloat(value))) );
-        else if ("fillfo_depth" == key) pCurDef->fillfo_depth = ToFloat(value);
-        else if ("fillfo_depthchanaft" == key) pCurDef->fillfo_depthcc.add( CC(128, check(key, -1200, 1200, ToInt(value))) );
-        else if ("pitchlfo_delay" == key) pCurDef->pitchlfo_delay = ToFloat(value);
-        else if ("pitchlfo_fade" == key) pCurDef->pitchlfo_fade = ToFloat(value);
-        else if ("pitchlfo_freq" == key) pCurDef->pitchlfo_freq = ToFloat(value);
-        else if ("pitchlfo_freqchanaft" == key) pCurDef->pitchlfo_freqcc.add( CC(128, check(key, -200.0f, 200.0f, ToFloat(value))) );
-        else if ("pitchlfo_depth" == key) pCurDef->pitchlfo_depth = ToInt(value);
-        else if ("pitchlfo_depthchanaft" == key) pCurDef->pitchlfo_depthcc.add( CC(128, check(key, -1200, 1200, ToInt(value))) );
-        
-        
         // v2 LFO
         else if (sscanf(key.c_str(), "lfo%d%n", &x, &y)) {
             const char* s = key.c_str() + y;
@@ -1961,112 +2168,118 @@ namespace sfz
                 std::cerr << "' is an invalid MIDI controller number." << std::endl;
             }
 
+            switch (opcodeHash(key_cc))
+            {
             // input controls
-            if ("lo" == key_cc) pCurDef->locc.set(num_cc, ToInt(value));
-            else if ("hi" == key_cc) pCurDef->hicc.set(num_cc, ToInt(value));
-            else if ("start_lo" == key_cc) pCurDef->start_locc.set(num_cc, ToInt(value));
-            else if ("start_hi" == key_cc) pCurDef->start_hicc.set(num_cc, ToInt(value));
-            else if ("stop_lo" == key_cc) pCurDef->stop_locc.set(num_cc, ToInt(value));
-            else if ("stop_hi" == key_cc) pCurDef->stop_hicc.set(num_cc, ToInt(value));
-            else if ("on_lo" == key_cc) pCurDef->on_locc.set(num_cc, ToInt(value));
-            else if ("on_hi" == key_cc) pCurDef->on_hicc.set(num_cc, ToInt(value));
+            OPCODE(key_cc, "lo") pCurDef->locc.set(num_cc, ToInt(value)); return;
+            OPCODE(key_cc, "hi") pCurDef->hicc.set(num_cc, ToInt(value)); return;
+            OPCODE(key_cc, "start_lo") pCurDef->start_locc.set(num_cc, ToInt(value)); return;
+            OPCODE(key_cc, "start_hi") pCurDef->start_hicc.set(num_cc, ToInt(value)); return;
+            OPCODE(key_cc, "stop_lo") pCurDef->stop_locc.set(num_cc, ToInt(value)); return;
+            OPCODE(key_cc, "stop_hi") pCurDef->stop_hicc.set(num_cc, ToInt(value)); return;
+            OPCODE(key_cc, "on_lo") pCurDef->on_locc.set(num_cc, ToInt(value)); return;
+            OPCODE(key_cc, "on_hi") pCurDef->on_hicc.set(num_cc, ToInt(value)); return;
 
             // sample player
-            else if ("delay" == key_cc) pCurDef->delay_oncc.set(num_cc, ToFloat(value));
-            else if ("delay_samples" == key_cc) pCurDef->delay_samples_oncc.set(num_cc, ToInt(value));
-            else if ("offset" == key_cc) pCurDef->offset_oncc.set(num_cc, ToInt(value));
+            OPCODE(key_cc, "delay") pCurDef->delay_oncc.set(num_cc, ToFloat(value)); return;
+            OPCODE(key_cc, "delay_samples") pCurDef->delay_samples_oncc.set(num_cc, ToInt(value)); return;
+            OPCODE(key_cc, "offset") pCurDef->offset_oncc.set(num_cc, ToInt(value)); return;
 
             // amplifier
-            else if ("gain"  == key_cc || "gain_" == key_cc) pCurDef->gain_oncc.set(num_cc, ToFloat(value));
-            else if ("xfin_lo"  == key_cc) pCurDef->xfin_locc.set(num_cc, ToInt(value));
-            else if ("xfin_hi"  == key_cc) pCurDef->xfin_hicc.set(num_cc, ToInt(value));
-            else if ("xfout_lo" == key_cc) pCurDef->xfout_locc.set(num_cc, ToInt(value));
-            else if ("xfout_hi" == key_cc) pCurDef->xfout_hicc.set(num_cc, ToInt(value));
+            OPCODE_ALIAS(key_cc, "gain", "gain_") pCurDef->gain_oncc.set(num_cc, ToFloat(value)); return;
+            OPCODE(key_cc, "xfin_lo") pCurDef->xfin_locc.set(num_cc, ToInt(value)); return;
+            OPCODE(key_cc, "xfin_hi") pCurDef->xfin_hicc.set(num_cc, ToInt(value)); return;
+            OPCODE(key_cc, "xfout_lo") pCurDef->xfout_locc.set(num_cc, ToInt(value)); return;
+            OPCODE(key_cc, "xfout_hi") pCurDef->xfout_hicc.set(num_cc, ToInt(value)); return;
             
             // pitch
-            else if ("pitch" == key_cc) pCurDef->pitch_oncc.add( CC(num_cc, check(key, -9600, 9600, ToInt(value))) );
-            else if ("pitch_smooth" == key_cc) pCurDef->pitch_smoothcc.add( CC(num_cc, 0, -1, check(key, 0.0f, 100000.0f /* max? */, ToFloat(value))) );
-            else if ("pitch_curve" == key_cc) pCurDef->pitch_curvecc.add( CC(num_cc, 0, check(key, 0, 30000, ToInt(value))) );
-            else if ("pitch_step" == key_cc) pCurDef->pitch_stepcc.add( CC(num_cc, 0, -1, 0, check(key, 0, 1200, ToInt(value))) );
+            OPCODE(key_cc, "pitch") pCurDef->pitch_oncc.add( CC(num_cc, check(key, -9600, 9600, ToInt(value))) ); return;
+            OPCODE(key_cc, "pitch_smooth") pCurDef->pitch_smoothcc.add( CC(num_cc, 0, -1, check(key, 0.0f, 100000.0f /* max? */, ToFloat(value))) ); return;
+            OPCODE(key_cc, "pitch_curve") pCurDef->pitch_curvecc.add( CC(num_cc, 0, check(key, 0, 30000, ToInt(value))) ); return;
+            OPCODE(key_cc, "pitch_step") pCurDef->pitch_stepcc.add( CC(num_cc, 0, -1, 0, check(key, 0, 1200, ToInt(value))) ); return;
 
             // filter
-            else if ("cutoff"  == key_cc || "cutoff_" == key_cc) {
+            OPCODE_ALIAS(key_cc, "cutoff", "cutoff_")
+            {
                 pCurDef->cutoff_oncc.add( CC(num_cc, check(key, -9600, 9600, ToInt(value))) );
-            } else if ("cutoff2" == key_cc) pCurDef->cutoff2_oncc.add( CC(num_cc, check(key, -9600, 9600, ToInt(value))) );
-            else if ("cutoff_smooth"  == key_cc) pCurDef->cutoff_smoothcc.add( CC(num_cc, 0, -1, check(key, 0.0f, 100000.0f /* max? */, ToFloat(value))) );
-            else if ("cutoff2_smooth" == key_cc) pCurDef->cutoff2_smoothcc.add( CC(num_cc, 0, -1, check(key, 0.0f, 100000.0f /* max? */, ToFloat(value))) );
-            else if ("cutoff_step"  == key_cc) pCurDef->cutoff_stepcc.add( CC(num_cc, 0, -1, 0, check(key, -1200, 1200, ToInt(value))) );
-            else if ("cutoff2_step" == key_cc) pCurDef->cutoff2_stepcc.add( CC(num_cc, 0, -1, 0, check(key, -1200, 1200, ToInt(value))) );
-            else if ("cutoff_curve" == key_cc) pCurDef->cutoff_curvecc.add( CC(num_cc, 0, check(key, 0, 30000, ToInt(value))) );
-            else if ("cutoff2_curve" == key_cc) pCurDef->cutoff2_curvecc.add( CC(num_cc, 0, check(key, 0, 30000, ToInt(value))) );
-            else if ("resonance" == key_cc) pCurDef->resonance_oncc.add( CC(num_cc, check(key, 0.0f, 40.0f, ToFloat(value))) );
-            else if ("resonance2" == key_cc) pCurDef->resonance2_oncc.add( CC(num_cc, check(key, 0.0f, 40.0f, ToFloat(value))) );
-            else if ("resonance_smooth" == key_cc) pCurDef->resonance_smoothcc.add( CC(num_cc, 0, -1, check(key, 0, 100000 /* max? */, ToInt(value))) );
-            else if ("resonance2_smooth" == key_cc) pCurDef->resonance2_smoothcc.add( CC(num_cc, 0, -1, check(key, 0, 100000 /* max? */, ToInt(value))) );
-            else if ("resonance_step" == key_cc) pCurDef->resonance_stepcc.add( CC(num_cc, 0, -1, 0, check(key, 0.0f, 40.0f, ToFloat(value))) );
-            else if ("resonance2_step" == key_cc) pCurDef->resonance2_stepcc.add( CC(num_cc, 0, -1, 0, check(key, 0.0f, 40.0f, ToFloat(value))) );
-            else if ("resonance_curve" == key_cc) pCurDef->resonance_curvecc.add( CC(num_cc, 0.0f, check(key, 0, 30000, ToInt(value))) );
-            else if ("resonance2_curve" == key_cc) pCurDef->resonance2_curvecc.add( CC(num_cc, 0.0f, check(key, 0, 30000, ToInt(value))) );
+                return;
+            }
+            OPCODE(key_cc, "cutoff2") pCurDef->cutoff2_oncc.add( CC(num_cc, check(key, -9600, 9600, ToInt(value))) ); return;
+            OPCODE(key_cc, "cutoff_smooth") pCurDef->cutoff_smoothcc.add( CC(num_cc, 0, -1, check(key, 0.0f, 100000.0f /* max? */, ToFloat(value))) ); return;
+            OPCODE(key_cc, "cutoff2_smooth") pCurDef->cutoff2_smoothcc.add( CC(num_cc, 0, -1, check(key, 0.0f, 100000.0f /* max? */, ToFloat(value))) ); return;
+            OPCODE(key_cc, "cutoff_step") pCurDef->cutoff_stepcc.add( CC(num_cc, 0, -1, 0, check(key, -1200, 1200, ToInt(value))) ); return;
+            OPCODE(key_cc, "cutoff2_step") pCurDef->cutoff2_stepcc.add( CC(num_cc, 0, -1, 0, check(key, -1200, 1200, ToInt(value))) ); return;
+            OPCODE(key_cc, "cutoff_curve") pCurDef->cutoff_curvecc.add( CC(num_cc, 0, check(key, 0, 30000, ToInt(value))) ); return;
+            OPCODE(key_cc, "cutoff2_curve") pCurDef->cutoff2_curvecc.add( CC(num_cc, 0, check(key, 0, 30000, ToInt(value))) ); return;
+            OPCODE(key_cc, "resonance") pCurDef->resonance_oncc.add( CC(num_cc, check(key, 0.0f, 40.0f, ToFloat(value))) ); return;
+            OPCODE(key_cc, "resonance2") pCurDef->resonance2_oncc.add( CC(num_cc, check(key, 0.0f, 40.0f, ToFloat(value))) ); return;
+            OPCODE(key_cc, "resonance_smooth") pCurDef->resonance_smoothcc.add( CC(num_cc, 0, -1, check(key, 0, 100000 /* max? */, ToInt(value))) ); return;
+            OPCODE(key_cc, "resonance2_smooth") pCurDef->resonance2_smoothcc.add( CC(num_cc, 0, -1, check(key, 0, 100000 /* max? */, ToInt(value))) ); return;
+            OPCODE(key_cc, "resonance_step") pCurDef->resonance_stepcc.add( CC(num_cc, 0, -1, 0, check(key, 0.0f, 40.0f, ToFloat(value))) ); return;
+            OPCODE(key_cc, "resonance2_step") pCurDef->resonance2_stepcc.add( CC(num_cc, 0, -1, 0, check(key, 0.0f, 40.0f, ToFloat(value))) ); return;
+            OPCODE(key_cc, "resonance_curve") pCurDef->resonance_curvecc.add( CC(num_cc, 0.0f, check(key, 0, 30000, ToInt(value))) ); return;
+            OPCODE(key_cc, "resonance2_curve") pCurDef->resonance2_curvecc.add( CC(num_cc, 0.0f, check(key, 0, 30000, ToInt(value))) ); return;
 
             // per voice equalizer
-            else if ("eq1_freq" == key_cc) pCurDef->eq1_freq_oncc.set(num_cc, ToInt(value));
-            else if ("eq2_freq" == key_cc) pCurDef->eq2_freq_oncc.set(num_cc, ToInt(value));
-            else if ("eq3_freq" == key_cc) pCurDef->eq3_freq_oncc.set(num_cc, ToInt(value));
-            else if ("eq1_bw" == key_cc) pCurDef->eq1_bw_oncc.set(num_cc, ToInt(value));
-            else if ("eq2_bw" == key_cc) pCurDef->eq2_bw_oncc.set(num_cc, ToInt(value));
-            else if ("eq3_bw" == key_cc) pCurDef->eq3_bw_oncc.set(num_cc, ToInt(value));
-            else if ("eq1_gain" == key_cc) pCurDef->eq1_gain_oncc.set(num_cc, ToInt(value));
-            else if ("eq2_gain" == key_cc) pCurDef->eq2_gain_oncc.set(num_cc, ToInt(value));
-            else if ("eq3_gain" == key_cc) pCurDef->eq3_gain_oncc.set(num_cc, ToInt(value));
+            OPCODE(key_cc, "eq1_freq") pCurDef->eq1_freq_oncc.set(num_cc, ToInt(value)); return;
+            OPCODE(key_cc, "eq2_freq") pCurDef->eq2_freq_oncc.set(num_cc, ToInt(value)); return;
+            OPCODE(key_cc, "eq3_freq") pCurDef->eq3_freq_oncc.set(num_cc, ToInt(value)); return;
+            OPCODE(key_cc, "eq1_bw") pCurDef->eq1_bw_oncc.set(num_cc, ToInt(value)); return;
+            OPCODE(key_cc, "eq2_bw") pCurDef->eq2_bw_oncc.set(num_cc, ToInt(value)); return;
+            OPCODE(key_cc, "eq3_bw") pCurDef->eq3_bw_oncc.set(num_cc, ToInt(value)); return;
+            OPCODE(key_cc, "eq1_gain") pCurDef->eq1_gain_oncc.set(num_cc, ToInt(value)); return;
+            OPCODE(key_cc, "eq2_gain") pCurDef->eq2_gain_oncc.set(num_cc, ToInt(value)); return;
+            OPCODE(key_cc, "eq3_gain") pCurDef->eq3_gain_oncc.set(num_cc, ToInt(value)); return;
             
-            else if ("ampeg_delay"   == key_cc) pCurDef->ampeg_delaycc.add( CC(num_cc, check(key, -100.0f, 100.0f, ToFloat(value))) );
-            else if ("ampeg_start"   == key_cc) pCurDef->ampeg_startcc.add( CC(num_cc, check(key, -100.0f, 100.0f, ToFloat(value))) );
-            else if ("ampeg_attack"  == key_cc) pCurDef->ampeg_attackcc.add( CC(num_cc, check(key, -100.0f, 100.0f, ToFloat(value))) );
-            else if ("ampeg_hold"    == key_cc) pCurDef->ampeg_holdcc.add( CC(num_cc, check(key, -100.0f, 100.0f, ToFloat(value))) );
-            else if ("ampeg_decay"   == key_cc) pCurDef->ampeg_decaycc.add( CC(num_cc, check(key, -100.0f, 100.0f, ToFloat(value))) );
-            else if ("ampeg_sustain" == key_cc) pCurDef->ampeg_sustaincc.add( CC(num_cc, check(key, -100.0f, 100.0f, ToFloat(value))) );
-            else if ("ampeg_release" == key_cc) pCurDef->ampeg_releasecc.add( CC(num_cc, check(key, -100.0f, 100.0f, ToFloat(value))) );
+            OPCODE(key_cc, "ampeg_delay") pCurDef->ampeg_delaycc.add( CC(num_cc, check(key, -100.0f, 100.0f, ToFloat(value))) ); return;
+            OPCODE(key_cc, "ampeg_start") pCurDef->ampeg_startcc.add( CC(num_cc, check(key, -100.0f, 100.0f, ToFloat(value))) ); return;
+            OPCODE(key_cc, "ampeg_attack") pCurDef->ampeg_attackcc.add( CC(num_cc, check(key, -100.0f, 100.0f, ToFloat(value))) ); return;
+            OPCODE(key_cc, "ampeg_hold") pCurDef->ampeg_holdcc.add( CC(num_cc, check(key, -100.0f, 100.0f, ToFloat(value))) ); return;
+            OPCODE(key_cc, "ampeg_decay") pCurDef->ampeg_decaycc.add( CC(num_cc, check(key, -100.0f, 100.0f, ToFloat(value))) ); return;
+            OPCODE(key_cc, "ampeg_sustain") pCurDef->ampeg_sustaincc.add( CC(num_cc, check(key, -100.0f, 100.0f, ToFloat(value))) ); return;
+            OPCODE(key_cc, "ampeg_release") pCurDef->ampeg_releasecc.add( CC(num_cc, check(key, -100.0f, 100.0f, ToFloat(value))) ); return;
             
-            else if ("fileg_delay"   == key_cc) pCurDef->fileg_delay_oncc.add( CC(num_cc, check(key, -100.0f, 100.0f, ToFloat(value))) );
-            else if ("fileg_start"   == key_cc) pCurDef->fileg_start_oncc.add( CC(num_cc, check(key, -100.0f, 100.0f, ToFloat(value))) );
-            else if ("fileg_attack"  == key_cc) pCurDef->fileg_attack_oncc.add( CC(num_cc, check(key, -100.0f, 100.0f, ToFloat(value))) );
-            else if ("fileg_hold"    == key_cc) pCurDef->fileg_hold_oncc.add( CC(num_cc, check(key, -100.0f, 100.0f, ToFloat(value))) );
-            else if ("fileg_decay"   == key_cc) pCurDef->fileg_decay_oncc.add( CC(num_cc, check(key, -100.0f, 100.0f, ToFloat(value))) );
-            else if ("fileg_sustain" == key_cc) pCurDef->fileg_sustain_oncc.add( CC(num_cc, check(key, -100.0f, 100.0f, ToFloat(value))) );
-            else if ("fileg_release" == key_cc) pCurDef->fileg_release_oncc.add( CC(num_cc, check(key, -100.0f, 100.0f, ToFloat(value))) );
-            else if ("fileg_depth"   == key_cc) pCurDef->fileg_depth_oncc.add( CC(num_cc, check(key, -12000, 12000, ToInt(value))) );
+            OPCODE(key_cc, "fileg_delay") pCurDef->fileg_delay_oncc.add( CC(num_cc, check(key, -100.0f, 100.0f, ToFloat(value))) ); return;
+            OPCODE(key_cc, "fileg_start") pCurDef->fileg_start_oncc.add( CC(num_cc, check(key, -100.0f, 100.0f, ToFloat(value))) ); return;
+            OPCODE(key_cc, "fileg_attack") pCurDef->fileg_attack_oncc.add( CC(num_cc, check(key, -100.0f, 100.0f, ToFloat(value))) ); return;
+            OPCODE(key_cc, "fileg_hold") pCurDef->fileg_hold_oncc.add( CC(num_cc, check(key, -100.0f, 100.0f, ToFloat(value))) ); return;
+            OPCODE(key_cc, "fileg_decay") pCurDef->fileg_decay_oncc.add( CC(num_cc, check(key, -100.0f, 100.0f, ToFloat(value))) ); return;
+            OPCODE(key_cc, "fileg_sustain") pCurDef->fileg_sustain_oncc.add( CC(num_cc, check(key, -100.0f, 100.0f, ToFloat(value))) ); return;
+            OPCODE(key_cc, "fileg_release") pCurDef->fileg_release_oncc.add( CC(num_cc, check(key, -100.0f, 100.0f, ToFloat(value))) ); return;
+            OPCODE(key_cc, "fileg_depth") pCurDef->fileg_depth_oncc.add( CC(num_cc, check(key, -12000, 12000, ToInt(value))) ); return;
             
-            else if ("pitcheg_delay"   == key_cc) pCurDef->pitcheg_delay_oncc.add( CC(num_cc, check(key, -100.0f, 100.0f, ToFloat(value))) );
-            else if ("pitcheg_start"   == key_cc) pCurDef->pitcheg_start_oncc.add( CC(num_cc, check(key, -100.0f, 100.0f, ToFloat(value))) );
-            else if ("pitcheg_attack"  == key_cc) pCurDef->pitcheg_attack_oncc.add( CC(num_cc, check(key, -100.0f, 100.0f, ToFloat(value))) );
-            else if ("pitcheg_hold"    == key_cc) pCurDef->pitcheg_hold_oncc.add( CC(num_cc, check(key, -100.0f, 100.0f, ToFloat(value))) );
-            else if ("pitcheg_decay"   == key_cc) pCurDef->pitcheg_decay_oncc.add( CC(num_cc, check(key, -100.0f, 100.0f, ToFloat(value))) );
-            else if ("pitcheg_sustain" == key_cc) pCurDef->pitcheg_sustain_oncc.add( CC(num_cc, check(key, -100.0f, 100.0f, ToFloat(value))) );
-            else if ("pitcheg_release" == key_cc) pCurDef->pitcheg_release_oncc.add( CC(num_cc, check(key, -100.0f, 100.0f, ToFloat(value))) );
-            else if ("pitcheg_depth"   == key_cc) pCurDef->pitcheg_depth_oncc.add( CC(num_cc, check(key, -12000, 12000, ToInt(value))) );
+            OPCODE(key_cc, "pitcheg_delay") pCurDef->pitcheg_delay_oncc.add( CC(num_cc, check(key, -100.0f, 100.0f, ToFloat(value))) ); return;
+            OPCODE(key_cc, "pitcheg_start") pCurDef->pitcheg_start_oncc.add( CC(num_cc, check(key, -100.0f, 100.0f, ToFloat(value))) ); return;
+            OPCODE(key_cc, "pitcheg_attack") pCurDef->pitcheg_attack_oncc.add( CC(num_cc, check(key, -100.0f, 100.0f, ToFloat(value))) ); return;
+            OPCODE(key_cc, "pitcheg_hold") pCurDef->pitcheg_hold_oncc.add( CC(num_cc, check(key, -100.0f, 100.0f, ToFloat(value))) ); return;
+            OPCODE(key_cc, "pitcheg_decay") pCurDef->pitcheg_decay_oncc.add( CC(num_cc, check(key, -100.0f, 100.0f, ToFloat(value))) ); return;
+            OPCODE(key_cc, "pitcheg_sustain") pCurDef->pitcheg_sustain_oncc.add( CC(num_cc, check(key, -100.0f, 100.0f, ToFloat(value))) ); return;
+            OPCODE(key_cc, "pitcheg_release") pCurDef->pitcheg_release_oncc.add( CC(num_cc, check(key, -100.0f, 100.0f, ToFloat(value))) ); return;
+            OPCODE(key_cc, "pitcheg_depth") pCurDef->pitcheg_depth_oncc.add( CC(num_cc, check(key, -12000, 12000, ToInt(value))) ); return;
             
-            else if ("pitchlfo_delay" == key_cc) pCurDef->pitchlfo_delay_oncc.add( CC(num_cc, check(key, 0.0f, 100.0f, ToFloat(value))) );
-            else if ("pitchlfo_fade" == key_cc) pCurDef->pitchlfo_fade_oncc.add( CC(num_cc, check(key, 0.0f, 100.0f, ToFloat(value))) );
-            else if ("pitchlfo_depth" == key_cc) pCurDef->pitchlfo_depthcc.add( CC(num_cc, check(key, -1200, 1200, ToInt(value))) );
-            else if ("pitchlfo_freq" == key_cc) pCurDef->pitchlfo_freqcc.add( CC(num_cc, check(key, -200.0f, 200.0f, ToFloat(value))) );
-            else if ("fillfo_delay" == key_cc) pCurDef->fillfo_delay_oncc.add( CC(num_cc, check(key, 0.0f, 100.0f, ToFloat(value))) );
-            else if ("fillfo_fade" == key_cc) pCurDef->fillfo_fade_oncc.add( CC(num_cc, check(key, 0.0f, 100.0f, ToFloat(value))) );
-            else if ("fillfo_depth" == key_cc) pCurDef->fillfo_depthcc.add( CC(num_cc, check(key, -1200, 1200, ToInt(value))) );
-            else if ("fillfo_freq" == key_cc) pCurDef->fillfo_freqcc.add( CC(num_cc, check(key, -200.0f, 200.0f, ToFloat(value))) );
-            else if ("amplfo_delay" == key_cc) pCurDef->amplfo_delay_oncc.add( CC(num_cc, check(key, 0.0f, 100.0f, ToFloat(value))) );
-            else if ("amplfo_fade" == key_cc) pCurDef->amplfo_fade_oncc.add( CC(num_cc, check(key, 0.0f, 100.0f, ToFloat(value))) );
-            else if ("amplfo_depth" == key_cc) pCurDef->amplfo_depthcc.add( CC(num_cc, check(key, -10.0f, 10.0f, ToFloat(value))) );
-            else if ("amplfo_freq" == key_cc) pCurDef->amplfo_freqcc.add( CC(num_cc, check(key, -200.0f, 200.0f, ToFloat(value))) );
-            else if ("volume" == key_cc) pCurDef->volume_oncc.add( CC(num_cc, check(key, -144.0f, 100.0f, ToFloat(value))) );
-            else if ("volume_curve" == key_cc) pCurDef->volume_curvecc.add( CC(num_cc, 0, check(key, 0, 30000, ToInt(value))) );
-            else if ("volume_smooth" == key_cc) pCurDef->volume_smoothcc.add( CC(num_cc, 0, -1, check(key, 0.0f, 100000.0f /* max? */, ToFloat(value))) );
-            else if ("volume_step" == key_cc) pCurDef->volume_stepcc.add( CC(num_cc, 0, -1, 0, check(key, -20.0f, 20.0f, ToFloat(value))) );
-            else if ("pan" == key_cc) pCurDef->pan_oncc.add( CC(num_cc, check(key, -200.0f, 200.0f, ToFloat(value))) );
-            else if ("pan_curve" == key_cc) pCurDef->pan_curvecc.add( CC(num_cc, 0, check(key, 0, 30000, ToInt(value))) );
-            else if ("pan_smooth" == key_cc) pCurDef->pan_smoothcc.add( CC(num_cc, 0, -1, check(key, 0.0f, 100000.0f /* max? */, ToFloat(value))) );
-            else if ("pan_step" == key_cc) pCurDef->pan_stepcc.add( CC(num_cc, 0, -1, 0, check(key, -100.0f, 100.0f, ToFloat(value))) );
-            else if ("set_" == key_cc) _instrument->initialCCValues[num_cc] = (num_cc < 128) ? check(key, 0, 127, ToInt(value)) : ToInt(value);
-            else std::cerr << "The opcode '" << key << "' is unsupported by libsfz!" << std::endl;
+            OPCODE(key_cc, "pitchlfo_delay") pCurDef->pitchlfo_delay_oncc.add( CC(num_cc, check(key, 0.0f, 100.0f, ToFloat(value))) ); return;
+            OPCODE(key_cc, "pitchlfo_fade") pCurDef->pitchlfo_fade_oncc.add( CC(num_cc, check(key, 0.0f, 100.0f, ToFloat(value))) ); return;
+            OPCODE(key_cc, "pitchlfo_depth") pCurDef->pitchlfo_depthcc.add( CC(num_cc, check(key, -1200, 1200, ToInt(value))) ); return;
+            OPCODE(key_cc, "pitchlfo_freq") pCurDef->pitchlfo_freqcc.add( CC(num_cc, check(key, -200.0f, 200.0f, ToFloat(value))) ); return;
+            OPCODE(key_cc, "fillfo_delay") pCurDef->fillfo_delay_oncc.add( CC(num_cc, check(key, 0.0f, 100.0f, ToFloat(value))) ); return;
+            OPCODE(key_cc, "fillfo_fade") pCurDef->fillfo_fade_oncc.add( CC(num_cc, check(key, 0.0f, 100.0f, ToFloat(value))) ); return;
+            OPCODE(key_cc, "fillfo_depth") pCurDef->fillfo_depthcc.add( CC(num_cc, check(key, -1200, 1200, ToInt(value))) ); return;
+            OPCODE(key_cc, "fillfo_freq") pCurDef->fillfo_freqcc.add( CC(num_cc, check(key, -200.0f, 200.0f, ToFloat(value))) ); return;
+            OPCODE(key_cc, "amplfo_delay") pCurDef->amplfo_delay_oncc.add( CC(num_cc, check(key, 0.0f, 100.0f, ToFloat(value))) ); return;
+            OPCODE(key_cc, "amplfo_fade") pCurDef->amplfo_fade_oncc.add( CC(num_cc, check(key, 0.0f, 100.0f, ToFloat(value))) ); return;
+            OPCODE(key_cc, "amplfo_depth") pCurDef->amplfo_depthcc.add( CC(num_cc, check(key, -10.0f, 10.0f, ToFloat(value))) ); return;
+            OPCODE(key_cc, "amplfo_freq") pCurDef->amplfo_freqcc.add( CC(num_cc, check(key, -200.0f, 200.0f, ToFloat(value))) ); return;
+            OPCODE(key_cc, "volume") pCurDef->volume_oncc.add( CC(num_cc, check(key, -144.0f, 100.0f, ToFloat(value))) ); return;
+            OPCODE(key_cc, "volume_curve") pCurDef->volume_curvecc.add( CC(num_cc, 0, check(key, 0, 30000, ToInt(value))) ); return;
+            OPCODE(key_cc, "volume_smooth") pCurDef->volume_smoothcc.add( CC(num_cc, 0, -1, check(key, 0.0f, 100000.0f /* max? */, ToFloat(value))) ); return;
+            OPCODE(key_cc, "volume_step") pCurDef->volume_stepcc.add( CC(num_cc, 0, -1, 0, check(key, -20.0f, 20.0f, ToFloat(value))) ); return;
+            OPCODE(key_cc, "pan") pCurDef->pan_oncc.add( CC(num_cc, check(key, -200.0f, 200.0f, ToFloat(value))) ); return;
+            OPCODE(key_cc, "pan_curve") pCurDef->pan_curvecc.add( CC(num_cc, 0, check(key, 0, 30000, ToInt(value))) ); return;
+            OPCODE(key_cc, "pan_smooth") pCurDef->pan_smoothcc.add( CC(num_cc, 0, -1, check(key, 0.0f, 100000.0f /* max? */, ToFloat(value))) ); return;
+            OPCODE(key_cc, "pan_step") pCurDef->pan_stepcc.add( CC(num_cc, 0, -1, 0, check(key, -100.0f, 100.0f, ToFloat(value))) ); return;
+            OPCODE(key_cc, "set_") _instrument->initialCCValues[num_cc] = (num_cc < 128) ? check(key, 0, 127, ToInt(value)) : ToInt(value); return;
+            }
+            std::cerr << "The opcode '" << key << "' is unsupported by libsfz!" << std::endl;
         }
 
         else {
@@ -2196,6 +2409,16 @@ namespace sfz
         resonance_stepcc   = lfo.resonance_stepcc;
     }
     
+    bool LFO::HasSmoothStepValues() const {
+        return EqSmoothStepImpl::HasSmoothStepValues() ||
+               !freq_smoothcc.empty() || !freq_stepcc.empty() ||
+               !volume_smoothcc.empty() || !volume_stepcc.empty() ||
+               !pitch_smoothcc.empty() || !pitch_stepcc.empty() ||
+               !pan_smoothcc.empty() || !pan_stepcc.empty() ||
+               !cutoff_smoothcc.empty() || !cutoff_stepcc.empty() ||
+               !resonance_smoothcc.empty() || !resonance_stepcc.empty();
+    }
+    
     EqImpl::EqImpl() {
         eq1freq = eq2freq = eq3freq = 0;
         eq1bw = eq2bw = eq3bw = 0;
@@ -2224,7 +2447,7 @@ namespace sfz
         eq3gain_oncc = eq.eq3gain_oncc;
     }
     
-    bool EqImpl::HasEq() {
+    bool EqImpl::HasEq() const {
         return eq1freq || eq2freq || eq3freq || eq1bw || eq2bw || eq3bw ||
                eq1gain || eq2gain || eq3gain || !eq1gain_oncc.empty() ||
                !eq2gain_oncc.empty() || !eq3gain_oncc.empty() ||
@@ -2256,6 +2479,15 @@ namespace sfz
         eq3gain_stepcc = eq.eq3gain_stepcc;
     }
     
+    bool EqSmoothStepImpl::HasSmoothStepValues() const {
+        return !eq1freq_smoothcc.empty() || !eq2freq_smoothcc.empty() || !eq3freq_smoothcc.empty() ||
+               !eq1bw_smoothcc.empty() || !eq2bw_smoothcc.empty() || !eq3bw_smoothcc.empty() ||
+               !eq1gain_smoothcc.empty() || !eq2gain_smoothcc.empty() || !eq3gain_smoothcc.empty() ||
+               !eq1freq_stepcc.empty() || !eq2freq_stepcc.empty() || !eq3freq_stepcc.empty() ||
+               !eq1bw_stepcc.empty() || !eq2bw_stepcc.empty() || !eq3bw_stepcc.empty() ||
+               !eq1gain_stepcc.empty() || !eq2gain_stepcc.empty() || !eq3gain_stepcc.empty();
+    }
+    
     void EqSmoothStepImpl::copySmoothValues() {
         File::copySmoothValues(eq1freq_smoothcc, eq1freq_oncc);
         eq1freq_smoothcc.clear();
@@ -2318,7 +2550,7 @@ namespace sfz
         while (pCurDef->eg.size() <= x) {
             pCurDef->eg.add(EG());
         }
-        return pCurDef->eg[x];
+        return pCurDef->eg.at(x);
     }
 
     EGNode& File::egnode(int x, int y) {
@@ -2333,7 +2565,7 @@ namespace sfz
         while (pCurDef->lfos.size() <= x) {
             pCurDef->lfos.add(LFO());
         }
-        return pCurDef->lfos[x];
+        return pCurDef->lfos.at(x);
     }
 
 } // !namespace sfz
@@ -29,6 +29,7 @@
 #include <vector>
 #include <stack>
 #include <string>
+#include <sstream>
 #include <stdexcept>
 
 #include "../common/SampleFile.h"
@@ -55,6 +56,7 @@ namespace sfz
     class File;
     class LookupTable;
     class SampleManager;
+    class InstrumentCache;
 
     class Exception : public LinuxSampler::Exception {
     public:
@@ -132,6 +134,8 @@ namespace sfz
             String     GetSourceCode(); ///< Reads the script's source code from its script file and returns the entire source code as String.
         private:
             LinuxSampler::Path m_path;
+
+            friend class InstrumentCache;
     };
 
     // Enumerations
@@ -150,6 +154,8 @@ namespace sfz
     class SampleManager : public LinuxSampler::SampleManager<Sample, Region> {
     public:
         Sample* FindSample(std::string samplePath, uint offset, int end);
+        Sample* AcquireSample(std::string samplePath, uint offset, int end, Region* pConsumer);
+        void ReleaseSample(Sample* pSample, Region* pConsumer);
 
     protected:
         virtual void OnSampleInUse(Sample* pSample) OVERRIDE {
@@ -241,7 +247,7 @@ namespace sfz
         
         EqImpl(const EqImpl& eq) { Copy(eq); }
         void Copy(const EqImpl& eq);
-        bool HasEq();
+        bool HasEq() const;
     };
     
     class EqSmoothStepImpl: public EqImpl {
@@ -270,6 +276,7 @@ namespace sfz
         EqSmoothStepImpl(const EqSmoothStepImpl& eq) { Copy(eq); }
         
         void Copy(const EqSmoothStepImpl& eq);
+        bool HasSmoothStepValues() const;
         void copySmoothValues();
         void copyStepValues();
     };
@@ -343,6 +350,7 @@ namespace sfz
         LFO(const LFO& lfo) { Copy(lfo); }
         void operator=(const LFO& lfo) { Copy(lfo); }
         void Copy(const LFO& lfo);
+        bool HasSmoothStepValues() const;
     };
 
     // Fixed size array with copy-on-write semantics
@@ -359,9 +367,11 @@ namespace sfz
                 if (!--rep->refcount) delete rep;
             }
         } *ptr;
+
+        friend class InstrumentCache;
     public:
         Array() : ptr(0) { }
-        ~Array() { Rep::release(ptr); }
+        ~Array() { if (ptr) Rep::release(ptr); }
 
         Array& operator=(const Array& array) {
             if (this != &array) {
@@ -386,10 +396,85 @@ namespace sfz
         }
     };
 
+    // Variable size list with copy-on-write semantics, so regions share the
+    // lists they inherit from their groups as long as they don't modify them
+    template<class T>
+    class List
+    {
+    private:
+        struct Rep {
+            int refcount;
+            LinuxSampler::ArrayList<T> a;
+
+            Rep() : refcount(1) { }
+            static void release(Rep* rep) {
+                if (!--rep->refcount) delete rep;
+            }
+        } *ptr;
+
+        // makes sure this list's buffer isn't shared with other lists
+        void detach() {
+            if (!ptr) {
+                ptr = new Rep;
+            } else if (ptr->refcount > 1) {
+                Rep* newptr = new Rep;
+                newptr->a = ptr->a;
+                Rep::release(ptr);
+                ptr = newptr;
+            }
+        }
+
+        static const LinuxSampler::ArrayList<T>& emptyList() {
+            static const LinuxSampler::ArrayList<T> empty;
+            return empty;
+        }
+
+        friend class InstrumentCache;
+    public:
+        List() : ptr(0) { }
+        List(const List& list) : ptr(list.ptr) { if (ptr) ptr->refcount++; }
+        ~List() { if (ptr) Rep::release(ptr); }
+
+        List& operator=(const List& list) {
+            if (ptr != list.ptr) {
+                if (list.ptr) list.ptr->refcount++;
+                if (ptr) Rep::release(ptr);
+                ptr = list.ptr;
+            }
+            return *this;
+        }
+
+        ssize_t size() const { return ptr ? ptr->a.size() : 0; }
+        bool empty() const { return !ptr || ptr->a.empty(); }
+
+        const T& operator[](ssize_t i) const { return ptr->a[i]; }
+
+        // modifiable element, the list gets its own buffer first
+        T& at(ssize_t i) {
+            detach();
+            return ptr->a[i];
+        }
+
+        void add(const T& element) {
+            detach();
+            ptr->a.add(element);
+        }
+
+        void clear() {
+            if (ptr) Rep::release(ptr);
+            ptr = 0;
+        }
+
+        operator const LinuxSampler::ArrayList<T>&() const {
+            return ptr ? ptr->a : emptyList();
+        }
+    };
+
     /////////////////////////////////////////////////////////////
     // class Definition
 
-    // Base definition used by groups and regions
+    // Base definition used by groups and regions. When adding members, add
+    // them to InstrumentCache.cpp as well.
     class Definition
     {
     public:
@@ -474,19 +559,19 @@ namespace sfz
         // filter
         filter_t fil_type; filter_t fil2_type;
         optional<float> cutoff; optional<float> cutoff2;
-        LinuxSampler::ArrayList<CC> cutoff_oncc, cutoff2_oncc;
-        LinuxSampler::ArrayList<CC> cutoff_smoothcc, cutoff2_smoothcc;
-        LinuxSampler::ArrayList<CC> cutoff_stepcc, cutoff2_stepcc;
-        LinuxSampler::ArrayList<CC> cutoff_curvecc, cutoff2_curvecc;
+        List<CC> cutoff_oncc, cutoff2_oncc;
+        List<CC> cutoff_smoothcc, cutoff2_smoothcc;
+        List<CC> cutoff_stepcc, cutoff2_stepcc;
+        List<CC> cutoff_curvecc, cutoff2_curvecc;
         int cutoff_chanaft; int cutoff2_chanaft;
         int cutoff_polyaft; int cutoff2_polyaft;
         float resonance; float resonance2;
-        LinuxSampler::ArrayList<CC> resonance_oncc, resonance2_oncc;
-        LinuxSampler::ArrayList<CC> resonance_smoothcc, resonance2_smoothcc;
-        LinuxSampler::ArrayList<CC> resonance_stepcc, resonance2_stepcc;
-        LinuxSampler::ArrayList<CC> resonance_curvecc, resonance2_curvecc;
-        LinuxSampler::ArrayList<CC> pitch_oncc, pitch_stepcc;
-        LinuxSampler::ArrayList<CC> pitch_smoothcc, pitch_curvecc;
+        List<CC> resonance_oncc, resonance2_oncc;
+        List<CC> resonance_smoothcc, resonance2_smoothcc;
+        List<CC> resonance_stepcc, resonance2_stepcc;
+        List<CC> resonance_curvecc, resonance2_curvecc;
+        List<CC> pitch_oncc, pitch_stepcc;
+        List<CC> pitch_smoothcc, pitch_curvecc;
         int fil_keytrack; int fil2_keytrack;
         int fil_keycenter; int fil2_keycenter;
         int fil_veltrack; int fil2_veltrack;
@@ -505,50 +590,50 @@ namespace sfz
         //Deprecated (from version 1)
         float ampeg_delay, ampeg_start, ampeg_attack, ampeg_hold, ampeg_decay, ampeg_sustain, ampeg_release;
         float ampeg_vel2delay, ampeg_vel2attack, ampeg_vel2hold, ampeg_vel2decay, ampeg_vel2sustain, ampeg_vel2release;
-        LinuxSampler::ArrayList<CC> ampeg_delaycc, ampeg_startcc, ampeg_attackcc, ampeg_holdcc;
-        LinuxSampler::ArrayList<CC> ampeg_decaycc, ampeg_sustaincc, ampeg_releasecc;
+        List<CC> ampeg_delaycc, ampeg_startcc, ampeg_attackcc, ampeg_holdcc;
+        List<CC> ampeg_decaycc, ampeg_sustaincc, ampeg_releasecc;
         float fileg_delay, fileg_start, fileg_attack, fileg_hold, fileg_decay, fileg_sustain, fileg_release;
         float fileg_vel2delay, fileg_vel2attack, fileg_vel2hold, fileg_vel2decay, fileg_vel2sustain, fileg_vel2release;
-        LinuxSampler::ArrayList<CC> fileg_delay_oncc, fileg_start_oncc, fileg_attack_oncc, fileg_hold_oncc;
-        LinuxSampler::ArrayList<CC> fileg_decay_oncc, fileg_sustain_oncc, fileg_release_oncc, fileg_depth_oncc;
+        List<CC> fileg_delay_oncc, fileg_start_oncc, fileg_attack_oncc, fileg_hold_oncc;
+        List<CC> fileg_decay_oncc, fileg_sustain_oncc, fileg_release_oncc, fileg_depth_oncc;
         float pitcheg_delay, pitcheg_start, pitcheg_attack, pitcheg_hold, pitcheg_decay, pitcheg_sustain, pitcheg_release;
         float pitcheg_vel2delay, pitcheg_vel2attack, pitcheg_vel2hold, pitcheg_vel2decay, pitcheg_vel2sustain, pitcheg_vel2release;
         int   fileg_depth, pitcheg_depth;
-        LinuxSampler::ArrayList<CC> pitcheg_delay_oncc, pitcheg_start_oncc, pitcheg_attack_oncc, pitcheg_hold_oncc;
-        LinuxSampler::ArrayList<CC> pitcheg_decay_oncc, pitcheg_sustain_oncc, pitcheg_release_oncc, pitcheg_depth_oncc;
+        List<CC> pitcheg_delay_oncc, pitcheg_start_oncc, pitcheg_attack_oncc, pitcheg_hold_oncc;
+        List<CC> pitcheg_decay_oncc, pitcheg_sustain_oncc, pitcheg_release_oncc, pitcheg_depth_oncc;
         float amplfo_delay, amplfo_fade, amplfo_freq, amplfo_depth;
         float fillfo_delay, fillfo_fade, fillfo_freq, fillfo_depth;
         float pitchlfo_delay, pitchlfo_fade, pitchlfo_freq;
         int pitchlfo_depth;
         
-        LinuxSampler::ArrayList<CC> pitchlfo_delay_oncc; // 0 to 100 seconds
-        LinuxSampler::ArrayList<CC> pitchlfo_fade_oncc; // 0 to 100 seconds
-        LinuxSampler::ArrayList<CC> pitchlfo_depthcc; // -1200 to 1200 cents
-        LinuxSampler::ArrayList<CC> pitchlfo_freqcc; // 0 to 20 Hz
-        LinuxSampler::ArrayList<CC> fillfo_delay_oncc; // 0 to 100 seconds
-        LinuxSampler::ArrayList<CC> fillfo_fade_oncc; // 0 to 100 seconds
-        LinuxSampler::ArrayList<CC> fillfo_depthcc;  // -1200 to 1200 cents
-        LinuxSampler::ArrayList<CC> fillfo_freqcc;   // 0 to 20 Hz
-        LinuxSampler::ArrayList<CC> amplfo_delay_oncc; // 0 to 100 seconds
-        LinuxSampler::ArrayList<CC> amplfo_fade_oncc; // 0 to 100 seconds
-        LinuxSampler::ArrayList<CC> amplfo_depthcc;  // -10 to 10 dB
-        LinuxSampler::ArrayList<CC> amplfo_freqcc;   // 0 to 20 Hz
+        List<CC> pitchlfo_delay_oncc; // 0 to 100 seconds
+        List<CC> pitchlfo_fade_oncc; // 0 to 100 seconds
+        List<CC> pitchlfo_depthcc; // -1200 to 1200 cents
+        List<CC> pitchlfo_freqcc; // 0 to 20 Hz
+        List<CC> fillfo_delay_oncc; // 0 to 100 seconds
+        List<CC> fillfo_fade_oncc; // 0 to 100 seconds
+        List<CC> fillfo_depthcc;  // -1200 to 1200 cents
+        List<CC> fillfo_freqcc;   // 0 to 20 Hz
+        List<CC> amplfo_delay_oncc; // 0 to 100 seconds
+        List<CC> amplfo_fade_oncc; // 0 to 100 seconds
+        List<CC> amplfo_depthcc;  // -10 to 10 dB
+        List<CC> amplfo_freqcc;   // 0 to 20 Hz
 
         // envelope generators
-        LinuxSampler::ArrayList<EG> eg;
+        List<EG> eg;
 
         // low frequency oscillators
-        LinuxSampler::ArrayList<LFO> lfos;
+        List<LFO> lfos;
         
-        LinuxSampler::ArrayList<CC> volume_oncc;
-        LinuxSampler::ArrayList<CC> volume_curvecc; // used only as temporary buffer during the parsing - values are then moved to volume_oncc
-        LinuxSampler::ArrayList<CC> volume_smoothcc; // used only as temporary buffer during the parsing - values are then moved to volume_oncc
-        LinuxSampler::ArrayList<CC> volume_stepcc; // used only as temporary buffer during the parsing - values are then moved to volume_oncc
+        List<CC> volume_oncc;
+        List<CC> volume_curvecc; // used only as temporary buffer during the parsing - values are then moved to volume_oncc
+        List<CC> volume_smoothcc; // used only as temporary buffer during the parsing - values are then moved to volume_oncc
+        List<CC> volume_stepcc; // used only as temporary buffer during the parsing - values are then moved to volume_oncc
         
-        LinuxSampler::ArrayList<CC> pan_oncc; // -100 to 100 %
-        LinuxSampler::ArrayList<CC> pan_curvecc; // used only as temporary buffer during the parsing - values are then moved to pan_oncc
-        LinuxSampler::ArrayList<CC> pan_smoothcc; // used only as temporary buffer during the parsing - values are then moved to pan_oncc
-        LinuxSampler::ArrayList<CC> pan_stepcc; // used only as temporary buffer during the parsing - values are then moved to pan_oncc
+        List<CC> pan_oncc; // -100 to 100 %
+        List<CC> pan_curvecc; // used only as temporary buffer during the parsing - values are then moved to pan_oncc
+        List<CC> pan_smoothcc; // used only as temporary buffer during the parsing - values are then moved to pan_oncc
+        List<CC> pan_stepcc; // used only as temporary buffer during the parsing - values are then moved to pan_oncc
     };
 
     class Query {
@@ -572,7 +657,12 @@ namespace sfz
         void search(const Instrument* pInstrument);
         void search(const Instrument* pInstrument, int triggercc);
         Region* next();
+        /// Like next(), but without advancing the round robin (seq_position)
+        /// counters of the regions, so it can be used to predict which
+        /// regions an equal query would trigger later on.
+        Region* peekNext();
     private:
+        const LookupTable* pLookupTable;
         LinuxSampler::ArrayList<Region*>* pRegionList;
         int regionIndex;
     };
@@ -605,6 +695,9 @@ namespace sfz
         /// assumed to come from a search in the lookup table.
         bool OnKey(const Query& q);
 
+        /// Same as OnKey(), but without advancing the round robin counter.
+        bool WouldTriggerOnKey(const Query& q) const;
+
         /// Return an articulation for the current state
         Articulation* GetArticulation(int bend, uint8_t bpm, uint8_t chanaft, uint8_t polyaft, uint8_t* cc);
 
@@ -614,6 +707,8 @@ namespace sfz
     private:
         Instrument* pInstrument;
         int seq_counter;
+
+        bool MatchesQuery(const Query& q) const;
     };
     
     class Curve {
@@ -650,6 +745,7 @@ namespace sfz
 
         friend class File;
         friend class Query;
+        friend class InstrumentCache;
 
     private:
         std::string name;
@@ -692,6 +788,9 @@ namespace sfz
         static void copyCurves(LinuxSampler::ArrayList<CC>& curves, LinuxSampler::ArrayList<CC>& dest);
         static void copySmoothValues(LinuxSampler::ArrayList<CC>& smooths, LinuxSampler::ArrayList<CC>& dest);
         static void copyStepValues(LinuxSampler::ArrayList<CC>& steps, LinuxSampler::ArrayList<CC>& dest);
+        static void copyCurves(List<CC>& curves, List<CC>& dest);
+        static void copySmoothValues(List<CC>& smooths, List<CC>& dest);
+        static void copyStepValues(List<CC>& steps, List<CC>& dest);
         
         /// Load an existing SFZ file
         File(std::string file, SampleManager* pSampleManager = NULL);
@@ -702,8 +801,8 @@ namespace sfz
         Instrument* GetInstrument();
 
     private:
-        void  push_header(std::string token);
-        void  push_opcode(std::string token);
+        void  push_header(const std::string& token);
+        void  push_opcode(const std::string& token);
         int parseKey(const std::string& value);
         EG& eg(int x);
         EGNode& egnode(int x, int y);
@@ -711,9 +810,12 @@ namespace sfz
         
         int   ToInt(const std::string& s) throw(LinuxSampler::Exception);
         float ToFloat(const std::string& s) throw(LinuxSampler::Exception);
+        std::istringstream numberStream; ///< Reused by ToInt() and ToFloat(), constructing a stream for each value is expensive.
 
         int currentLine;
         std::string currentDir;
+        /// All files the parse result depends on (the sfz file, included files and scripts).
+        std::vector<std::string> dependencies;
         /// Pointer to the Instrument belonging to this file
         Instrument* _instrument;
 
@@ -47,6 +47,8 @@
 #include "common/stacktrace.h"
 #include "common/Features.h"
 #include "common/atomic.h"
+#include "engines/common/PreloadSnapshot.h"
+#include "engines/sfz/InstrumentCache.h"
 
 using namespace LinuxSampler;
 
@@ -353,6 +355,8 @@ void parse_options(int argc, char **argv) {
             {"lscp-port",required_argument,0,0},
             {"stacktrace",no_argument,0,0},
             {"exec-after-init",required_argument,0,0},
+            {"preload-snapshot",required_argument,0,0},
+            {"sfz-cache",required_argument,0,0},
             {0,0,0,0}
         };
 
@@ -379,6 +383,10 @@ void parse_options(int argc, char **argv) {
                     printf("--stacktrace                automatically shows stacktrace if crashes\n");
                     printf("                            (broken on most systems at the moment)\n");
                     printf("--exec-after-init           executes a command after initialization\n");
+                    printf("--preload-snapshot          file storing preloaded sample data for\n");
+                    printf("                            faster restarts\n");
+                    printf("--sfz-cache                 directory storing parsed sfz instruments\n");
+                    printf("                            for faster loading\n");
                     exit(EXIT_SUCCESS);
                     break;
                 case 1: // --version
@@ -477,6 +485,24 @@ void parse_options(int argc, char **argv) {
                 case 10: // --exec-after-init
                     ExecAfterInit = optarg;
                     break;
+                case 11: // --preload-snapshot
+#if CONFIG_PRELOAD_SNAPSHOT
+                    PreloadSnapshot::SetFile(optarg);
+#else
+                    std::cerr << "LinuxSampler was not build with ";
+                    std::cerr << "preload snapshot support!\n";
+                    exit(EXIT_FAILURE);
+#endif
+                    break;
+                case 12: // --sfz-cache
+#if CONFIG_SFZ_CACHE
+                    ::sfz::InstrumentCache::SetDirectory(optarg);
+#else
+                    std::cerr << "LinuxSampler was not build with ";
+                    std::cerr << "sfz cache support!\n";
+                    exit(EXIT_FAILURE);
+#endif
+                    break;
             }
         }
     }
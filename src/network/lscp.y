@@ -202,9 +202,10 @@ void yyerror(void* x, const char* s) {
 %type <Char> char char_base alpha_char digit digit_oct digit_hex escape_seq escape_seq_octal escape_seq_hex
 %type <Dotnum> real dotnum volume_value boolean control_value
 %type <Number> number sampler_channel instrument_index fx_send_id audio_channel_index device_index effect_index effect_instance effect_chain chain_pos input_control midi_input_channel_index midi_input_port_index midi_map midi_bank midi_prog midi_ctrl
-%type <String> string string_escaped text text_escaped text_escaped_base stringval stringval_escaped digits param_val_list param_val query_val filename module effect_system db_path map_name entry_name fx_send_name effect_name engine_name line statement command add_instruction create_instruction destroy_instruction get_instruction list_instruction load_instruction send_instruction set_chan_instruction load_instr_args load_engine_args audio_output_type_name midi_input_type_name remove_instruction unmap_instruction set_instruction subscribe_event unsubscribe_event map_instruction reset_instruction clear_instruction find_instruction move_instruction copy_instruction scan_mode edit_instruction format_instruction append_instruction insert_instruction
+%type <String> string string_escaped text text_escaped text_escaped_base stringval stringval_escaped digits param_val_list param_val query_val filename module effect_system db_path map_name entry_name fx_send_name effect_name engine_name line statement command add_instruction create_instruction destroy_instruction get_instruction list_instruction load_instruction send_instruction set_chan_instruction load_instr_args load_engine_args audio_output_type_name midi_input_type_name remove_instruction unmap_instruction set_instruction subscribe_event unsubscribe_event map_instruction reset_instruction clear_instruction find_instruction move_instruction copy_instruction scan_mode edit_instruction format_instruction append_instruction insert_instruction reload_instruction
 %type <FillResponse> buffer_size_type
 %type <KeyValList> key_val_list query_val_list
+%type <ProgList> midi_prog_list
 %type <LoadMode> instr_load_mode
 %type <Bool> modal_arg
 %type <UniversalPath> path path_base path_prefix path_body
@@ -257,6 +258,7 @@ command               :  ADD SP add_instruction                { $$ = $3;
                       |  SUBSCRIBE SP subscribe_event          { $$ = $3;                                                }
                       |  UNSUBSCRIBE SP unsubscribe_event      { $$ = $3;                                                }
                       |  RESET SP reset_instruction            { $$ = $3;                                                }
+                      |  RELOAD SP reload_instruction          { $$ = $3;                                                }
                       |  CLEAR SP clear_instruction            { $$ = $3;                                                }
                       |  FIND SP find_instruction              { $$ = $3;                                                }
                       |  MOVE SP move_instruction              { $$ = $3;                                                }
@@ -297,6 +299,7 @@ subscribe_event       :  AUDIO_OUTPUT_DEVICE_COUNT             { $$ = LSCPSERVER
                       |  VOICE_COUNT                           { $$ = LSCPSERVER->SubscribeNotification(LSCPEvent::event_voice_count);          }
                       |  STREAM_COUNT                          { $$ = LSCPSERVER->SubscribeNotification(LSCPEvent::event_stream_count);         }
                       |  BUFFER_FILL                           { $$ = LSCPSERVER->SubscribeNotification(LSCPEvent::event_buffer_fill);          }
+                      |  DISK_STATISTICS                       { $$ = LSCPSERVER->SubscribeNotification(LSCPEvent::event_disk_statistics);      }
                       |  CHANNEL_INFO                          { $$ = LSCPSERVER->SubscribeNotification(LSCPEvent::event_channel_info);         }
                       |  FX_SEND_COUNT                         { $$ = LSCPSERVER->SubscribeNotification(LSCPEvent::event_fx_send_count);        }
                       |  FX_SEND_INFO                          { $$ = LSCPSERVER->SubscribeNotification(LSCPEvent::event_fx_send_info);         }
@@ -329,6 +332,7 @@ unsubscribe_event     :  AUDIO_OUTPUT_DEVICE_COUNT             { $$ = LSCPSERVER
                       |  VOICE_COUNT                           { $$ = LSCPSERVER->UnsubscribeNotification(LSCPEvent::event_voice_count);          }
                       |  STREAM_COUNT                          { $$ = LSCPSERVER->UnsubscribeNotification(LSCPEvent::event_stream_count);         }
                       |  BUFFER_FILL                           { $$ = LSCPSERVER->UnsubscribeNotification(LSCPEvent::event_buffer_fill);          }
+                      |  DISK_STATISTICS                       { $$ = LSCPSERVER->UnsubscribeNotification(LSCPEvent::event_disk_statistics);      }
                       |  CHANNEL_INFO                          { $$ = LSCPSERVER->UnsubscribeNotification(LSCPEvent::event_channel_info);         }
                       |  FX_SEND_COUNT                         { $$ = LSCPSERVER->UnsubscribeNotification(LSCPEvent::event_fx_send_count);        }
                       |  FX_SEND_INFO                          { $$ = LSCPSERVER->UnsubscribeNotification(LSCPEvent::event_fx_send_info);         }
@@ -402,6 +406,7 @@ get_instruction       :  AVAILABLE_ENGINES
                       |  CHANNEL SP INFO SP sampler_channel                                         { $$ = LSCPSERVER->GetChannelInfo($5);                             }
                       |  CHANNEL SP BUFFER_FILL SP buffer_size_type SP sampler_channel              { $$ = LSCPSERVER->GetBufferFill($5, $7);                          }
                       |  CHANNEL SP STREAM_COUNT SP sampler_channel                                 { $$ = LSCPSERVER->GetStreamCount($5);                             }
+                      |  CHANNEL SP DISK_STATISTICS SP sampler_channel                              { $$ = LSCPSERVER->GetDiskStatistics($5);                          }
                       |  CHANNEL SP VOICE_COUNT SP sampler_channel                                  { $$ = LSCPSERVER->GetVoiceCount($5);                              }
                       |  ENGINE SP INFO SP engine_name                                              { $$ = LSCPSERVER->GetEngineInfo($5);                              }
                       |  SERVER SP INFO                                                             { $$ = LSCPSERVER->GetServerInfo();                                }
@@ -425,6 +430,11 @@ get_instruction       :  AVAILABLE_ENGINES
                       |  VOLUME                                                                     { $$ = LSCPSERVER->GetGlobalVolume();                              }
                       |  VOICES                                                                     { $$ = LSCPSERVER->GetGlobalMaxVoices();                           }
                       |  STREAMS                                                                    { $$ = LSCPSERVER->GetGlobalMaxStreams();                          }
+                      |  STREAM_CACHE                                                               { $$ = LSCPSERVER->GetGlobalStreamCacheSize();                     }
+                      |  STREAM_CACHE SP INFO                                                       { $$ = LSCPSERVER->GetGlobalStreamCacheInfo();                     }
+                      |  INSTRUMENT_MEMORY                                                          { $$ = LSCPSERVER->GetGlobalInstrumentMemoryBudget();              }
+                      |  INSTRUMENT_MEMORY SP INFO                                                  { $$ = LSCPSERVER->GetGlobalInstrumentMemoryInfo();                }
+                      |  PROGRAM_PREFETCH                                                           { $$ = LSCPSERVER->GetGlobalProgramPrefetch();                     }
                       |  FILE SP INSTRUMENTS SP filename                                            { $$ = LSCPSERVER->GetFileInstruments($5);                         }
                       |  FILE SP INSTRUMENT SP INFO SP filename SP instrument_index                 { $$ = LSCPSERVER->GetFileInstrumentInfo($7,$9);                   }
                       ;
@@ -437,6 +447,8 @@ set_instruction       :  AUDIO_OUTPUT_DEVICE_PARAMETER SP number SP string '=' p
                       |  EFFECT_INSTANCE_INPUT_CONTROL SP VALUE SP effect_instance SP input_control SP control_value  { $$ = LSCPSERVER->SetEffectInstanceInputControlValue($5, $7, $9); }
                       |  CHANNEL SP set_chan_instruction                                                  { $$ = $3;                                                         }
                       |  MIDI_INSTRUMENT_MAP SP NAME SP midi_map SP map_name                              { $$ = LSCPSERVER->SetMidiInstrumentMapName($5, $7);               }
+                      |  MIDI_INSTRUMENT_MAP SP SETLIST SP midi_map SP midi_prog_list                     { $$ = LSCPSERVER->SetMidiInstrumentMapSetlist($5, $7);            }
+                      |  MIDI_INSTRUMENT_MAP SP SETLIST SP midi_map SP NONE                               { $$ = LSCPSERVER->SetMidiInstrumentMapSetlist($5, MidiProgList()); }
                       |  FX_SEND SP NAME SP sampler_channel SP fx_send_id SP fx_send_name                 { $$ = LSCPSERVER->SetFxSendName($5,$7,$9);                        }
                       |  FX_SEND SP AUDIO_OUTPUT_CHANNEL SP sampler_channel SP fx_send_id SP audio_channel_index SP audio_channel_index  { $$ = LSCPSERVER->SetFxSendAudioOutputChannel($5,$7,$9,$11); }
                       |  FX_SEND SP MIDI_CONTROLLER SP sampler_channel SP fx_send_id SP midi_ctrl         { $$ = LSCPSERVER->SetFxSendMidiController($5,$7,$9);              }
@@ -454,6 +466,9 @@ set_instruction       :  AUDIO_OUTPUT_DEVICE_PARAMETER SP number SP string '=' p
                       |  VOLUME SP volume_value                                                           { $$ = LSCPSERVER->SetGlobalVolume($3);                            }
                       |  VOICES SP number                                                                 { $$ = LSCPSERVER->SetGlobalMaxVoices($3);                         }
                       |  STREAMS SP number                                                                { $$ = LSCPSERVER->SetGlobalMaxStreams($3);                        }
+                      |  STREAM_CACHE SP number                                                           { $$ = LSCPSERVER->SetGlobalStreamCacheSize($3);                   }
+                      |  INSTRUMENT_MEMORY SP number                                                      { $$ = LSCPSERVER->SetGlobalInstrumentMemoryBudget($3);            }
+                      |  PROGRAM_PREFETCH SP number                                                       { $$ = LSCPSERVER->SetGlobalProgramPrefetch($3);                   }
                       ;
 
 create_instruction    :  AUDIO_OUTPUT_DEVICE SP string SP key_val_list  { $$ = LSCPSERVER->CreateAudioOutputDevice($3,$5); }
@@ -473,6 +488,9 @@ clear_instruction     :  MIDI_INSTRUMENTS SP midi_map   { $$ = LSCPSERVER->Clear
                       |  MIDI_INSTRUMENTS SP ALL        { $$ = LSCPSERVER->ClearAllMidiInstrumentMappings(); }
                       ;
 
+reload_instruction    :  INSTRUMENTS SP filename       { $$ = LSCPSERVER->ReloadInstruments($3); }
+                      ;
+
 find_instruction      :  DB_INSTRUMENTS SP NON_RECURSIVE SP db_path SP query_val_list              { $$ = LSCPSERVER->FindDbInstruments($5,$7, false);           }
                       |  DB_INSTRUMENTS SP db_path SP query_val_list                               { $$ = LSCPSERVER->FindDbInstruments($3,$5, true);            }
                       |  DB_INSTRUMENT_DIRECTORIES SP NON_RECURSIVE SP db_path SP query_val_list   { $$ = LSCPSERVER->FindDbInstrumentDirectories($5,$7, false); }
@@ -605,6 +623,10 @@ midi_bank                 :  number
 midi_prog                 :  number
                           ;
 
+midi_prog_list            :  midi_bank SP midi_prog                     { $$ = MidiProgList(); $$.push_back(std::make_pair($1, $3)); }
+                          |  midi_prog_list ',' midi_bank SP midi_prog  { $$ = $1; $$.push_back(std::make_pair($3, $5)); }
+                          ;
+
 midi_ctrl                 :  number
                           ;
 
@@ -1045,6 +1067,9 @@ BUFFER_FILL          :  'B''U''F''F''E''R''_''F''I''L''L'
 STREAM_COUNT         :  'S''T''R''E''A''M''_''C''O''U''N''T'
                      ;
 
+DISK_STATISTICS      :  'D''I''S''K''_''S''T''A''T''I''S''T''I''C''S'
+                     ;
+
 VOICE_COUNT          :  'V''O''I''C''E''_''C''O''U''N''T'
                      ;
 
@@ -1258,6 +1283,18 @@ VOICES                :  'V''O''I''C''E''S'
 STREAMS               :  'S''T''R''E''A''M''S'
                       ;
 
+STREAM_CACHE          :  'S''T''R''E''A''M''_''C''A''C''H''E'
+                      ;
+
+INSTRUMENT_MEMORY     :  'I''N''S''T''R''U''M''E''N''T''_''M''E''M''O''R''Y'
+                      ;
+
+PROGRAM_PREFETCH      :  'P''R''O''G''R''A''M''_''P''R''E''F''E''T''C''H'
+                      ;
+
+SETLIST               :  'S''E''T''L''I''S''T'
+                      ;
+
 BYTES                 :  'B''Y''T''E''S'
                       ;
 
@@ -1279,6 +1316,9 @@ MIDI_DATA             :  'M''I''D''I''_''D''A''T''A'
 RESET                 :  'R''E''S''E''T'
                       ;
 
+RELOAD                :  'R''E''L''O''A''D'
+                      ;
+
 MISCELLANEOUS         :  'M''I''S''C''E''L''L''A''N''E''O''U''S'
                       ;
 
@@ -71,7 +71,8 @@ class LSCPEvent {
                     event_fx_instance_count,
                     event_fx_instance_info,
                     event_send_fx_chain_count,
-                    event_send_fx_chain_info
+                    event_send_fx_chain_info,
+                    event_disk_statistics
 	    };
 
 	    /* This constructor will do type lookup based on name
@@ -37,6 +37,7 @@
 #include <string>
 #include <stdint.h>
 #include <set>
+#include <vector>
 
 #include "../common/global_private.h"
 #include "../common/Path.h"
@@ -63,6 +64,11 @@ enum fill_response_t {
     fill_response_percentage  ///< The returned values are meant in percentage.
 };
 
+/**
+ * List of (MIDI bank, MIDI program) pairs.
+ */
+typedef std::vector< std::pair<unsigned int, unsigned int> > MidiProgList;
+
 /**
  * Semantic value of the lookahead symbol.
  *
@@ -83,6 +89,7 @@ struct _YYSTYPE {
     };
     std::string                       String;
     std::map<std::string,std::string> KeyValList;
+    MidiProgList                      ProgList;
     Path                              UniversalPath;
 };
 #define YYSTYPE _YYSTYPE
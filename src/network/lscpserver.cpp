@@ -25,6 +25,7 @@
 #include <string>
 
 #include "../common/File.h"
+#include "../common/HugePages.h"
 #include "lscpserver.h"
 #include "lscpresultset.h"
 #include "lscpevent.h"
@@ -43,6 +44,8 @@ typedef unsigned long in_addr_t;
 
 #include "../engines/EngineFactory.h"
 #include "../engines/EngineChannelFactory.h"
+#include "../engines/common/StreamBlockCache.h"
+#include "../engines/common/SharedSampleCache.h"
 #include "../drivers/audio/AudioOutputDeviceFactory.h"
 #include "../drivers/midi/MidiInputDeviceFactory.h"
 #include "../effects/EffectFactory.h"
@@ -146,6 +149,7 @@ LSCPServer::LSCPServer(Sampler* pSampler, long int addr, short int port) : Threa
     LSCPEvent::RegisterEvent(LSCPEvent::event_fx_instance_info, "EFFECT_INSTANCE_INFO");
     LSCPEvent::RegisterEvent(LSCPEvent::event_send_fx_chain_count, "SEND_EFFECT_CHAIN_COUNT");
     LSCPEvent::RegisterEvent(LSCPEvent::event_send_fx_chain_info, "SEND_EFFECT_CHAIN_INFO");
+    LSCPEvent::RegisterEvent(LSCPEvent::event_disk_statistics, "DISK_STATISTICS");
     hSocket = -1;
 }
 
@@ -304,6 +308,41 @@ void LSCPServer::EventHandler::BufferFillChanged(int ChannelId, String FillData)
     LSCPServer::SendLSCPNotify(LSCPEvent(LSCPEvent::event_buffer_fill, ChannelId, FillData));
 }
 
+/**
+ * Returns field names and values of the given disk streaming statistics,
+ * as used by "GET CHANNEL DISK_STATISTICS" and the DISK_STATISTICS event.
+ */
+static std::vector< std::pair<String,String> > DiskStatisticsFields(const disk_stream_statistics_t& stats) {
+    String latencies;
+    for (int i = 0; i < disk_stream_statistics_t::READ_LATENCY_BUCKETS; i++)
+        latencies += (i ? "," : "") + ToString(stats.ReadLatency[i]);
+    String fills;
+    for (int i = 0; i < disk_stream_statistics_t::MIN_FILL_BUCKETS; i++)
+        fills += (i ? "," : "") + ToString(stats.MinFill[i]);
+
+    std::vector< std::pair<String,String> > fields;
+    fields.push_back(std::make_pair("READS", ToString(stats.Reads)));
+    fields.push_back(std::make_pair("BYTES_READ", ToString(stats.BytesRead)));
+    fields.push_back(std::make_pair("BYTES_PER_SECOND", ToString(stats.BytesPerSecond)));
+    fields.push_back(std::make_pair("MAX_READ_LATENCY", ToString(stats.MaxReadLatency)));
+    fields.push_back(std::make_pair("READ_LATENCY_HISTOGRAM", latencies));
+    fields.push_back(std::make_pair("MIN_FILL_HISTOGRAM", fills));
+    fields.push_back(std::make_pair("LATE_STREAMS", ToString(stats.LateStreams)));
+    fields.push_back(std::make_pair("UNDERRUNS", ToString(stats.Underruns)));
+    fields.push_back(std::make_pair("KILLED", ToString(stats.KilledStreams)));
+    return fields;
+}
+
+void LSCPServer::EventHandler::DiskStatisticsChanged(int ChannelId, const disk_stream_statistics_t& Statistics) {
+    String s;
+    std::vector< std::pair<String,String> > fields = DiskStatisticsFields(Statistics);
+    for (size_t i = 0; i < fields.size(); i++) {
+        if (i) s += " ";
+        s += fields[i].first + "=" + fields[i].second;
+    }
+    LSCPServer::SendLSCPNotify(LSCPEvent(LSCPEvent::event_disk_statistics, ChannelId, s));
+}
+
 void LSCPServer::EventHandler::TotalVoiceCountChanged(int NewCount) {
     LSCPServer::SendLSCPNotify(LSCPEvent(LSCPEvent::event_total_voice_count, NewCount));
 }
@@ -353,6 +392,7 @@ void LSCPServer::RemoveListeners() {
     pSampler->RemoveVoiceCountListener(&eventHandler);
     pSampler->RemoveStreamCountListener(&eventHandler);
     pSampler->RemoveBufferFillListener(&eventHandler);
+    pSampler->RemoveDiskStatisticsListener(&eventHandler);
     pSampler->RemoveTotalStreamCountListener(&eventHandler);
     pSampler->RemoveTotalVoiceCountListener(&eventHandler);
     pSampler->RemoveFxSendCountListener(&eventHandler);
@@ -430,6 +470,7 @@ int LSCPServer::Main() {
     pSampler->AddVoiceCountListener(&eventHandler);
     pSampler->AddStreamCountListener(&eventHandler);
     pSampler->AddBufferFillListener(&eventHandler);
+    pSampler->AddDiskStatisticsListener(&eventHandler);
     pSampler->AddTotalStreamCountListener(&eventHandler);
     pSampler->AddTotalVoiceCountListener(&eventHandler);
     pSampler->AddFxSendCountListener(&eventHandler);
@@ -1328,6 +1369,29 @@ String LSCPServer::GetStreamCount(uint uiSamplerChannel) {
     return result.Produce();
 }
 
+/**
+ * Will be called by the parser to get the disk streaming statistics (read
+ * latencies, throughput, buffer fills and late streams) of the engine of a
+ * particular sampler channel.
+ */
+String LSCPServer::GetDiskStatistics(uint uiSamplerChannel) {
+    dmsg(2,("LSCPServer: GetDiskStatistics(SamplerChannel=%d)\n", uiSamplerChannel));
+    LSCPResultSet result;
+    try {
+        EngineChannel* pEngineChannel = GetEngineChannel(uiSamplerChannel);
+        Engine* pEngine = pEngineChannel->GetEngine();
+        if (!pEngine) throw Exception("No audio output device connected to sampler channel");
+        if (!pEngine->DiskStreamSupported()) throw Exception("Engine of sampler channel does not support disk streaming");
+        std::vector< std::pair<String,String> > fields = DiskStatisticsFields(pEngine->DiskStreamStatistics());
+        for (size_t i = 0; i < fields.size(); i++)
+            result.Add(fields[i].first, fields[i].second);
+    }
+    catch (Exception& e) {
+         result.Error(e);
+    }
+    return result.Produce();
+}
+
 /**
  * Will be called by the parser to get the buffer fill states of all disk
  * streams on a particular sampler channel.
@@ -2310,6 +2374,7 @@ String LSCPServer::GetMidiInstrumentMapping(uint MidiMapID, uint MidiBank, uint
         result.Add("INSTRUMENT_FILE", instrumentFileName);
         result.Add("INSTRUMENT_NR", (int) entry.InstrumentIndex);
         String instrumentName;
+        uint64_t memoryUsage = 0;
         Engine* pEngine = EngineFactory::Create(entry.EngineName);
         if (pEngine) {
             if (pEngine->GetInstrumentManager()) {
@@ -2317,6 +2382,7 @@ String LSCPServer::GetMidiInstrumentMapping(uint MidiMapID, uint MidiBank, uint
                 instrID.FileName = entry.InstrumentFile;
                 instrID.Index    = entry.InstrumentIndex;
                 instrumentName = pEngine->GetInstrumentManager()->GetInstrumentName(instrID);
+                memoryUsage    = pEngine->GetInstrumentManager()->GetMemoryUsage(instrID);
             }
             EngineFactory::Destroy(pEngine);
         }
@@ -2335,6 +2401,7 @@ String LSCPServer::GetMidiInstrumentMapping(uint MidiMapID, uint MidiBank, uint
                 throw Exception("entry reflects invalid LOAD_MODE, consider this as a bug!");
         }
         result.Add("VOLUME", entry.Volume);
+        result.Add("MEMORY_USAGE", ToString(memoryUsage));
     } catch (Exception e) {
         result.Error(e);
     }
@@ -2476,6 +2543,14 @@ String LSCPServer::GetMidiInstrumentMap(uint MidiMapID) {
     try {
         result.Add("NAME", _escapeLscpResponse(MidiInstrumentMapper::MapName(MidiMapID)));
         result.Add("DEFAULT", MidiInstrumentMapper::GetDefaultMap() == MidiMapID);
+        std::vector<midi_prog_index_t> setlist = MidiInstrumentMapper::GetSetlist(MidiMapID);
+        String sSetlist;
+        for (size_t i = 0; i < setlist.size(); i++) {
+            if (sSetlist != "") sSetlist += ",";
+            int Bank = (int(setlist[i].midi_bank_msb) << 7) | int(setlist[i].midi_bank_lsb);
+            sSetlist += ToString(Bank) + " " + ToString(int(setlist[i].midi_prog));
+        }
+        result.Add("SETLIST", (sSetlist != "") ? sSetlist : "NONE");
     } catch (Exception e) {
         result.Error(e);
     }
@@ -2493,6 +2568,34 @@ String LSCPServer::SetMidiInstrumentMapName(uint MidiMapID, String NewName) {
     return result.Produce();
 }
 
+/**
+ * Will be called by the parser to assign the (MIDI bank, MIDI program)
+ * pairs of the entries of the given MIDI instrument map, which shall be
+ * loaded in advance whenever a MIDI program change selected an entry.
+ */
+String LSCPServer::SetMidiInstrumentMapSetlist(uint MidiMapID, const MidiProgList& Setlist) {
+    dmsg(2,("LSCPServer: SetMidiInstrumentMapSetlist()\n"));
+    LSCPResultSet result;
+    try {
+        std::vector<midi_prog_index_t> setlist;
+        for (size_t i = 0; i < Setlist.size(); i++) {
+            const uint MidiBank = Setlist[i].first;
+            const uint MidiProg = Setlist[i].second;
+            if (MidiBank > 16383) throw Exception("MIDI bank out of range");
+            if (MidiProg > 127) throw Exception("MIDI program out of range");
+            midi_prog_index_t idx;
+            idx.midi_bank_msb = (MidiBank >> 7) & 0x7f;
+            idx.midi_bank_lsb = MidiBank & 0x7f;
+            idx.midi_prog     = MidiProg;
+            setlist.push_back(idx);
+        }
+        MidiInstrumentMapper::SetSetlist(MidiMapID, setlist);
+    } catch (Exception& e) {
+        result.Error(e);
+    }
+    return result.Produce();
+}
+
 /**
  * Set the MIDI instrument map the given sampler channel shall use for
  * handling MIDI program change messages. There are the following two
@@ -3349,6 +3452,137 @@ String LSCPServer::SetGlobalMaxStreams(int iStreams) {
     return result.Produce();
 }
 
+/**
+ * Will be called by the parser to return the RAM budget (in MB) of the
+ * block cache shared by all disk streams.
+ */
+String LSCPServer::GetGlobalStreamCacheSize() {
+    dmsg(2,("LSCPServer: GetGlobalStreamCacheSize()\n"));
+    LSCPResultSet result;
+    result.Add(int(pSampler->GetGlobalStreamCacheSize() / (1024 * 1024)));
+    return result.Produce();
+}
+
+/**
+ * Will be called by the parser to set the RAM budget (in MB) of the block
+ * cache shared by all disk streams.
+ */
+String LSCPServer::SetGlobalStreamCacheSize(int iMegaBytes) {
+    dmsg(2,("LSCPServer: SetGlobalStreamCacheSize(%d)\n", iMegaBytes));
+    LSCPResultSet result;
+    try {
+        if (iMegaBytes < 0) throw Exception("Stream cache size may not be negative");
+        pSampler->SetGlobalStreamCacheSize(size_t(iMegaBytes) * 1024 * 1024);
+        LSCPServer::SendLSCPNotify(
+            LSCPEvent(LSCPEvent::event_global_info, "STREAM_CACHE", iMegaBytes)
+        );
+    } catch (Exception& e) {
+        result.Error(e);
+    }
+    return result.Produce();
+}
+
+/**
+ * Will be called by the parser to return usage statistics of the block cache
+ * shared by all disk streams.
+ */
+String LSCPServer::GetGlobalStreamCacheInfo() {
+    dmsg(2,("LSCPServer: GetGlobalStreamCacheInfo()\n"));
+    LSCPResultSet result;
+    const StreamBlockCache::statistics_t stats = StreamBlockCache::GetStatistics();
+    const uint64_t reads = stats.Hits + stats.Misses;
+    result.Add("SIZE", int(stats.Budget / (1024 * 1024)));
+    result.Add("USAGE", ToString(stats.Usage));
+    result.Add("BLOCKS", ToString(stats.Blocks));
+    result.Add("HITS", ToString(stats.Hits));
+    result.Add("MISSES", ToString(stats.Misses));
+    result.Add("HIT_RATE", (reads) ? float(double(stats.Hits) / double(reads) * 100.0) : 0.f);
+    return result.Produce();
+}
+
+/**
+ * Will be called by the parser to return the RAM budget (in MB) for the
+ * cached sample data of all loaded instruments.
+ */
+String LSCPServer::GetGlobalInstrumentMemoryBudget() {
+    dmsg(2,("LSCPServer: GetGlobalInstrumentMemoryBudget()\n"));
+    LSCPResultSet result;
+    result.Add(int(pSampler->GetGlobalInstrumentMemoryBudget() / (1024 * 1024)));
+    return result.Produce();
+}
+
+/**
+ * Will be called by the parser to set the RAM budget (in MB) for the cached
+ * sample data of all loaded instruments.
+ */
+String LSCPServer::SetGlobalInstrumentMemoryBudget(int iMegaBytes) {
+    dmsg(2,("LSCPServer: SetGlobalInstrumentMemoryBudget(%d)\n", iMegaBytes));
+    LSCPResultSet result;
+    try {
+        if (iMegaBytes < 0) throw Exception("Instrument memory budget may not be negative");
+        pSampler->SetGlobalInstrumentMemoryBudget(uint64_t(iMegaBytes) * 1024 * 1024);
+        LSCPServer::SendLSCPNotify(
+            LSCPEvent(LSCPEvent::event_global_info, "INSTRUMENT_MEMORY", iMegaBytes)
+        );
+    } catch (Exception& e) {
+        result.Error(e);
+    }
+    return result.Produce();
+}
+
+/**
+ * Will be called by the parser to return how much RAM is occupied by the
+ * cached sample data of all loaded instruments.
+ */
+String LSCPServer::GetGlobalInstrumentMemoryInfo() {
+    dmsg(2,("LSCPServer: GetGlobalInstrumentMemoryInfo()\n"));
+    LSCPResultSet result;
+    result.Add("BUDGET", int(InstrumentManager::GetMemoryBudget() / (1024 * 1024)));
+    result.Add("USAGE", ToString(InstrumentManager::GetGlobalMemoryUsage()));
+    result.Add("EVICTIONS", ToString(InstrumentManager::GetEvictionCount()));
+#if CONFIG_SAMPLE_CACHE_DEDUP
+    result.Add("SHARED", ToString(SharedSampleCache::GetStatistics().SavedBytes));
+#else
+    result.Add("SHARED", 0);
+#endif
+#if CONFIG_HUGE_PAGES
+    result.Add("HUGE_PAGES", ToString(HugePages::GetStatistics().HugePageBytes));
+#else
+    result.Add("HUGE_PAGES", 0);
+#endif
+    return result.Produce();
+}
+
+/**
+ * Will be called by the parser to return how many neighbouring MIDI
+ * instrument map entries are loaded in advance on MIDI program changes.
+ */
+String LSCPServer::GetGlobalProgramPrefetch() {
+    dmsg(2,("LSCPServer: GetGlobalProgramPrefetch()\n"));
+    LSCPResultSet result;
+    result.Add(MidiInstrumentMapper::GetPrefetchCount());
+    return result.Produce();
+}
+
+/**
+ * Will be called by the parser to set how many neighbouring MIDI instrument
+ * map entries (on each side) are loaded in advance on MIDI program changes.
+ */
+String LSCPServer::SetGlobalProgramPrefetch(int iEntries) {
+    dmsg(2,("LSCPServer: SetGlobalProgramPrefetch(%d)\n", iEntries));
+    LSCPResultSet result;
+    try {
+        if (iEntries < 0) throw Exception("Program prefetch may not be negative");
+        MidiInstrumentMapper::SetPrefetchCount(iEntries);
+        LSCPServer::SendLSCPNotify(
+            LSCPEvent(LSCPEvent::event_global_info, "PROGRAM_PREFETCH", iEntries)
+        );
+    } catch (Exception& e) {
+        result.Error(e);
+    }
+    return result.Produce();
+}
+
 String LSCPServer::GetGlobalVolume() {
     LSCPResultSet result;
     result.Add(ToString(GLOBAL_VOLUME)); // see common/global.cpp
@@ -3520,6 +3754,22 @@ String LSCPServer::GetFileInstrumentInfo(String Filename, uint InstrumentID) {
     return result.Produce();
 }
 
+/**
+ * Will be called by method parser to reload all currently loaded instruments
+ * of the given instrument file from disk.
+ */
+String LSCPServer::ReloadInstruments(String Filename) {
+    dmsg(2,("LSCPServer: ReloadInstruments(Filename=%s)\n", Filename.c_str()));
+    LSCPResultSet result;
+    try {
+        if (!InstrumentManager::ReloadInstruments(Filename))
+            throw Exception("No instrument of file '" + Filename + "' is currently loaded");
+    } catch (Exception& e) {
+        result.Error(e);
+    }
+    return result.Produce();
+}
+
 void LSCPServer::VerifyFile(String Filename) {
     #if WIN32
     WIN32_FIND_DATA win32FileAttributeData;
@@ -96,6 +96,7 @@ class LSCPServer : public Thread {
         String GetChannelInfo(uint uiSamplerChannel);
         String GetVoiceCount(uint uiSamplerChannel);
         String GetStreamCount(uint uiSamplerChannel);
+        String GetDiskStatistics(uint uiSamplerChannel);
         String GetBufferFill(fill_response_t ResponseType, uint uiSamplerChannel);
         String GetAvailableAudioOutputDrivers();
         String ListAvailableAudioOutputDrivers();
@@ -161,6 +162,7 @@ class LSCPServer : public Thread {
         String ListMidiInstrumentMaps();
         String GetMidiInstrumentMap(uint MidiMapID);
         String SetMidiInstrumentMapName(uint MidiMapID, String NewName);
+        String SetMidiInstrumentMapSetlist(uint MidiMapID, const MidiProgList& Setlist);
         String SetChannelMap(uint uiSamplerChannel, int MidiMapID);
         String CreateFxSend(uint uiSamplerChannel, uint MidiCtrl, String Name = "");
         String DestroyFxSend(uint uiSamplerChannel, uint FxSendID);
@@ -230,11 +232,20 @@ class LSCPServer : public Thread {
         String SetGlobalMaxVoices(int iVoices);
         String GetGlobalMaxStreams();
         String SetGlobalMaxStreams(int iStreams);
+        String GetGlobalStreamCacheSize();
+        String SetGlobalStreamCacheSize(int iMegaBytes);
+        String GetGlobalStreamCacheInfo();
+        String GetGlobalInstrumentMemoryBudget();
+        String SetGlobalInstrumentMemoryBudget(int iMegaBytes);
+        String GetGlobalInstrumentMemoryInfo();
+        String GetGlobalProgramPrefetch();
+        String SetGlobalProgramPrefetch(int iEntries);
         String GetGlobalVolume();
         String SetGlobalVolume(double dVolume);
         String GetFileInstruments(String Filename);
         String ListFileInstruments(String Filename);
         String GetFileInstrumentInfo(String Filename, uint InstrumentID);
+        String ReloadInstruments(String Filename);
         String SendChannelMidiData(String MidiMsg, uint uiSamplerChannel, uint Arg1, uint Arg2);
         String SubscribeNotification(LSCPEvent::event_t);
         String UnsubscribeNotification(LSCPEvent::event_t);
@@ -310,6 +321,7 @@ class LSCPServer : public Thread {
             public MidiInstrumentInfoListener, public MidiInstrumentMapCountListener,
             public MidiInstrumentMapInfoListener, public FxSendCountListener,
             public VoiceCountListener, public StreamCountListener, public BufferFillListener,
+            public DiskStatisticsListener,
             public TotalStreamCountListener, public TotalVoiceCountListener,
             public EngineChangeListener, public MidiPortCountListener {
 
@@ -429,6 +441,14 @@ class LSCPServer : public Thread {
                  */
                 virtual void BufferFillChanged(int ChannelId, String FillData);
 
+                /**
+                 * Invoked periodically with the latest disk streaming
+                 * statistics of the specified sampler channel.
+                 * @param ChannelId The numerical ID of the sampler channel.
+                 * @param Statistics The disk streaming statistics of the channel's engine.
+                 */
+                virtual void DiskStatisticsChanged(int ChannelId, const disk_stream_statistics_t& Statistics);
+
                 /**
                  * Invoked when the total number of active voices is changed.
                  * @param NewCount The new number of active voices.
@@ -0,0 +1,123 @@
+#include "GigDimRegionCacheTest.h"
+
+#include <iostream>
+
+CPPUNIT_TEST_SUITE_REGISTRATION(GigDimRegionCacheTest);
+
+using namespace std;
+
+// dimensions of the test regions
+#define MODWHEEL_DIM 0
+#define LAYER_DIM    1
+#define VELOCITY_DIM 2
+
+static void AddDimension(::gig::Region* pRegion, ::gig::dimension_t Dimension, int Bits) {
+    ::gig::dimension_def_t def;
+    def.dimension = Dimension;
+    def.bits      = Bits;
+    def.zones     = 1 << Bits;
+    pRegion->AddDimension(&def);
+}
+
+// Sets the upper limit of the mod wheel zones of all dimension regions of @a pRegion.
+static void SetModWheelZones(::gig::Region* pRegion, uint8_t Zone0UpperLimit) {
+    for (int i = 0; i < 256; i++) {
+        ::gig::DimensionRegion* pDimRgn = pRegion->pDimensionRegions[i];
+        if (!pDimRgn) continue;
+        pDimRgn->DimensionUpperLimits[MODWHEEL_DIM] = (i & 1) ? 127 : Zone0UpperLimit;
+    }
+}
+
+static ::gig::Region* AddRegion(::gig::Instrument* pInstrument, uint8_t Zone0UpperLimit) {
+    ::gig::Region* pRegion = pInstrument->AddRegion();
+    AddDimension(pRegion, ::gig::dimension_modwheel, 1);
+    AddDimension(pRegion, ::gig::dimension_layer, 1);
+    AddDimension(pRegion, ::gig::dimension_velocity, 1);
+    SetModWheelZones(pRegion, Zone0UpperLimit);
+    return pRegion;
+}
+
+// Returns the dimension region index for the given dimension values.
+static int Lookup(LinuxSampler::gig::DimRegionCache& cache, ::gig::Region* pRegion, uint ModWheel, uint Layer = 0, uint Velocity = 100, int Epoch = 0) {
+    uint values[8] = { 0 };
+    values[MODWHEEL_DIM] = ModWheel;
+    values[LAYER_DIM]    = Layer;
+    values[VELOCITY_DIM] = Velocity;
+    return cache.GetIndex(60, pRegion, values, Epoch);
+}
+
+void GigDimRegionCacheTest::setUp() {
+    pFile = new ::gig::File;
+    ::gig::Instrument* pInstrument = pFile->AddInstrument();
+    pRegionA = AddRegion(pInstrument, 63);
+    pRegionB = AddRegion(pInstrument, 31);
+}
+
+void GigDimRegionCacheTest::tearDown() {
+    delete pFile;
+}
+
+void GigDimRegionCacheTest::printTestSuiteName() {
+    cout << "\b \nRunning gig DimRegionCache Tests: " << flush;
+}
+
+// Check that the cached lookups select the same dimension regions as libgig.
+void GigDimRegionCacheTest::testSameAsLibgig() {
+    LinuxSampler::gig::DimRegionCache cache;
+    for (uint layer = 0; layer < 2; layer++) {
+        for (uint velocity = 1; velocity < 128; velocity += 7) {
+            for (uint modwheel = 0; modwheel < 128; modwheel++) {
+                uint values[8] = { 0 };
+                values[MODWHEEL_DIM] = modwheel;
+                values[LAYER_DIM]    = layer;
+                values[VELOCITY_DIM] = velocity;
+                const int expected = pRegionA->GetDimensionRegionIndexByValue(values);
+                CPPUNIT_ASSERT(expected >= 0);
+                CPPUNIT_ASSERT(cache.GetIndex(60, pRegionA, values, 0) == expected);
+                CPPUNIT_ASSERT(cache.GetIndex(60, pRegionA, values, 0) == expected); // cached
+            }
+        }
+    }
+}
+
+// Check that a changed controller value leads to a new lookup, without the cache being reset.
+void GigDimRegionCacheTest::testControllerChange() {
+    LinuxSampler::gig::DimRegionCache cache;
+    const int low  = Lookup(cache, pRegionA, 10);
+    const int high = Lookup(cache, pRegionA, 100);
+    CPPUNIT_ASSERT((low & 1) == 0);
+    CPPUNIT_ASSERT((high & 1) == 1);
+    CPPUNIT_ASSERT(Lookup(cache, pRegionA, 10) == low);
+    // the layer is not cached, but taken from the current value
+    CPPUNIT_ASSERT(Lookup(cache, pRegionA, 10, 1) == (low | 2));
+}
+
+// Check that lookups made before the region was modified are only used until the epoch changes.
+void GigDimRegionCacheTest::testEpoch() {
+    LinuxSampler::gig::DimRegionCache cache;
+    const int before = Lookup(cache, pRegionA, 50, 0, 100, 1);
+    CPPUNIT_ASSERT((before & 1) == 0);
+
+    SetModWheelZones(pRegionA, 31); // i.e. by an instrument editor
+    CPPUNIT_ASSERT(Lookup(cache, pRegionA, 50, 0, 100, 1) == before); // stale
+    const int after = Lookup(cache, pRegionA, 50, 0, 100, 2);
+    CPPUNIT_ASSERT((after & 1) == 1);
+    CPPUNIT_ASSERT(Lookup(cache, pRegionA, 50, 0, 100, 2) == after);
+}
+
+// Check that a lookup made for another region of the same key is not used.
+void GigDimRegionCacheTest::testRegionChange() {
+    LinuxSampler::gig::DimRegionCache cache;
+    CPPUNIT_ASSERT((Lookup(cache, pRegionA, 50) & 1) == 0);
+    CPPUNIT_ASSERT((Lookup(cache, pRegionB, 50) & 1) == 1);
+    CPPUNIT_ASSERT((Lookup(cache, pRegionA, 50) & 1) == 0);
+}
+
+// Check that Reset() drops all lookups made so far.
+void GigDimRegionCacheTest::testReset() {
+    LinuxSampler::gig::DimRegionCache cache;
+    CPPUNIT_ASSERT((Lookup(cache, pRegionA, 50) & 1) == 0);
+    SetModWheelZones(pRegionA, 31);
+    cache.Reset();
+    CPPUNIT_ASSERT((Lookup(cache, pRegionA, 50) & 1) == 1);
+}
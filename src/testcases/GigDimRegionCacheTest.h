@@ -0,0 +1,43 @@
+#ifndef __LS_GIGDIMREGIONCACHETEST_H__
+#define __LS_GIGDIMREGIONCACHETEST_H__
+
+#include <cppunit/TestFixture.h>
+#include <cppunit/extensions/HelperMacros.h>
+
+#include "../common/global_private.h"
+
+// the gig DimRegionCache class we want to test
+#include "../engines/gig/DimRegionCache.h"
+
+using namespace LinuxSampler;
+
+class GigDimRegionCacheTest : public CppUnit::TestFixture {
+
+    CPPUNIT_TEST_SUITE(GigDimRegionCacheTest);
+    CPPUNIT_TEST(printTestSuiteName);
+    CPPUNIT_TEST(testSameAsLibgig);
+    CPPUNIT_TEST(testControllerChange);
+    CPPUNIT_TEST(testEpoch);
+    CPPUNIT_TEST(testRegionChange);
+    CPPUNIT_TEST(testReset);
+    CPPUNIT_TEST_SUITE_END();
+
+    private:
+        ::gig::File*   pFile;    ///< in-memory file of the regions, created by setUp()
+        ::gig::Region* pRegionA; ///< region with a mod wheel, a layer and a velocity dimension
+        ::gig::Region* pRegionB; ///< like region A, but with different mod wheel zones
+
+    public:
+        void setUp();
+        void tearDown();
+
+        void printTestSuiteName();
+
+        void testSameAsLibgig();
+        void testControllerChange();
+        void testEpoch();
+        void testRegionChange();
+        void testReset();
+};
+
+#endif // __LS_GIGDIMREGIONCACHETEST_H__
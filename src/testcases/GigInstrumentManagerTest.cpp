@@ -0,0 +1,140 @@
+#include "GigInstrumentManagerTest.h"
+
+#include <iostream>
+#include <vector>
+#include <stdlib.h>
+#include <unistd.h>
+
+CPPUNIT_TEST_SUITE_REGISTRATION(GigInstrumentManagerTest);
+
+using namespace std;
+
+// sample points of the long sample, which is streamed from disk
+#define LONG_SAMPLE_FRAMES  (CONFIG_PRELOAD_SAMPLES + 1000)
+// sample points of the short sample, which is completely cached in RAM
+#define SHORT_SAMPLE_FRAMES 100
+
+static ::gig::Sample* AddSample(::gig::File& file, ::gig::file_offset_t Frames) {
+    ::gig::Sample* pSample = file.AddSample();
+    pSample->Channels         = 1;
+    pSample->BitDepth         = 16;
+    pSample->FrameSize        = 2;
+    pSample->SamplesPerSecond = 44100;
+    pSample->Resize(Frames);
+    return pSample;
+}
+
+static void AddRegion(::gig::Instrument* pInstrument, ::gig::Sample* pSample, uint8_t LowKey, uint8_t HighKey) {
+    ::gig::Region* pRegion = pInstrument->AddRegion();
+    pRegion->SetSample(pSample);
+    pRegion->SetKeyRange(LowKey, HighKey);
+    pRegion->pDimensionRegions[0]->pSample = pSample;
+}
+
+static void WriteSample(::gig::Sample* pSample, ::gig::file_offset_t Frames) {
+    std::vector<int16_t> data(Frames);
+    for (size_t i = 0; i < data.size(); i++) data[i] = int16_t(i);
+    pSample->Write(&data[0], Frames);
+}
+
+// returns the first sample of the instrument with the given amount of sample points
+static ::gig::Sample* FindSample(::gig::Instrument* pInstrument, ::gig::file_offset_t Frames) {
+    for (::gig::Region* pRgn = pInstrument->GetFirstRegion(); pRgn; pRgn = pInstrument->GetNextRegion())
+        if (pRgn->GetSample() && pRgn->GetSample()->SamplesTotal == Frames) return pRgn->GetSample();
+    return NULL;
+}
+
+// writes an instrument with one sample to be streamed and one short sample
+void GigInstrumentManagerTest::setUp() {
+    char path[] = "/tmp/linuxsamplertestXXXXXX";
+    int fd = mkstemp(path);
+    CPPUNIT_ASSERT(fd >= 0);
+    close(fd);
+    FileName = path;
+
+    ::gig::File file;
+    ::gig::Sample* pLong  = AddSample(file, LONG_SAMPLE_FRAMES);
+    ::gig::Sample* pShort = AddSample(file, SHORT_SAMPLE_FRAMES);
+    ::gig::Instrument* pInstrument = file.AddInstrument();
+    AddRegion(pInstrument, pLong, 0, 63);
+    AddRegion(pInstrument, pShort, 64, 127);
+    file.Save(FileName);
+    // sample data can only be written after the file structure was saved
+    WriteSample(pLong, LONG_SAMPLE_FRAMES);
+    WriteSample(pShort, SHORT_SAMPLE_FRAMES);
+}
+
+void GigInstrumentManagerTest::tearDown() {
+    if (!FileName.empty()) unlink(FileName.c_str());
+}
+
+void GigInstrumentManagerTest::printTestSuiteName() {
+    cout << "\b \nRunning gig InstrumentManager Tests: " << flush;
+}
+
+// Check that an instrument is loaded and freed again by switching its mode.
+void GigInstrumentManagerTest::testLoadAndUnload() {
+    Manager manager;
+    InstrumentManager::instrument_id_t id;
+    id.FileName = FileName;
+    id.Index    = 0;
+    manager.SetMode(id, InstrumentManager::PERSISTENT);
+    std::vector< ::gig::Instrument*> instruments = manager.LoadedInstruments();
+    CPPUNIT_ASSERT(instruments.size() == 1);
+    #if !CONFIG_LAZY_PRELOAD
+    CPPUNIT_ASSERT(FindSample(instruments[0], LONG_SAMPLE_FRAMES)->GetCache().Size);
+    CPPUNIT_ASSERT(FindSample(instruments[0], SHORT_SAMPLE_FRAMES)->GetCache().Size);
+    #endif
+    manager.SetMode(id, InstrumentManager::ON_DEMAND);
+    CPPUNIT_ASSERT(manager.LoadedInstruments().empty());
+}
+
+#if CONFIG_LAZY_PRELOAD
+
+// Check that the samples of a loaded instrument are preloaded one by one afterwards.
+void GigInstrumentManagerTest::testLazyPreload() {
+    Manager manager;
+    InstrumentManager::instrument_id_t id;
+    id.FileName = FileName;
+    id.Index    = 0;
+    manager.SetMode(id, InstrumentManager::PERSISTENT);
+    std::vector< ::gig::Instrument*> instruments = manager.LoadedInstruments();
+    CPPUNIT_ASSERT(instruments.size() == 1);
+    ::gig::Sample* pLong  = FindSample(instruments[0], LONG_SAMPLE_FRAMES);
+    ::gig::Sample* pShort = FindSample(instruments[0], SHORT_SAMPLE_FRAMES);
+    CPPUNIT_ASSERT(pLong && pShort);
+    CPPUNIT_ASSERT(!pLong->GetCache().Size);
+    CPPUNIT_ASSERT(!pShort->GetCache().Size);
+
+    // what a disk thread does
+    ::gig::buffer_t decompressionBuffer = ::gig::Sample::CreateDecompressionBuffer(CONFIG_STREAM_MAX_REFILL_SIZE);
+    CPPUNIT_ASSERT(manager.CacheLazySample(&decompressionBuffer));
+    CPPUNIT_ASSERT(manager.CacheLazySample(&decompressionBuffer));
+    CPPUNIT_ASSERT(!manager.CacheLazySample(&decompressionBuffer)); // nothing left
+    ::gig::Sample::DestroyDecompressionBuffer(decompressionBuffer);
+
+    CPPUNIT_ASSERT(pLong->GetCache().Size == CONFIG_PRELOAD_SAMPLES * pLong->FrameSize);
+    CPPUNIT_ASSERT(pShort->GetCache().Size == SHORT_SAMPLE_FRAMES * pShort->FrameSize);
+    CPPUNIT_ASSERT(pShort->GetCache().NullExtensionSize > 0);
+    CPPUNIT_ASSERT(((int16_t*)pLong->GetCache().pStart)[1000] == 1000);
+
+    manager.SetMode(id, InstrumentManager::ON_DEMAND);
+    CPPUNIT_ASSERT(manager.LoadedInstruments().empty());
+}
+
+// Check that samples of an instrument freed before they were preloaded are not preloaded anymore.
+void GigInstrumentManagerTest::testUnloadWhileScheduled() {
+    Manager manager;
+    InstrumentManager::instrument_id_t id;
+    id.FileName = FileName;
+    id.Index    = 0;
+    manager.SetMode(id, InstrumentManager::PERSISTENT);
+    manager.SetMode(id, InstrumentManager::ON_DEMAND);
+    CPPUNIT_ASSERT(manager.LoadedInstruments().empty());
+
+    ::gig::buffer_t decompressionBuffer = ::gig::Sample::CreateDecompressionBuffer(CONFIG_STREAM_MAX_REFILL_SIZE);
+    CPPUNIT_ASSERT(!manager.CacheLazySample(&decompressionBuffer)); // the samples are gone
+    ::gig::Sample::DestroyDecompressionBuffer(decompressionBuffer);
+}
+
+#endif // CONFIG_LAZY_PRELOAD
@@ -0,0 +1,48 @@
+#ifndef __LS_GIGINSTRUMENTMANAGERTEST_H__
+#define __LS_GIGINSTRUMENTMANAGERTEST_H__
+
+#include <cppunit/TestFixture.h>
+#include <cppunit/extensions/HelperMacros.h>
+
+#include "../common/global_private.h"
+
+// the gig instrument manager we want to test
+#include "../engines/gig/InstrumentResourceManager.h"
+
+using namespace LinuxSampler;
+
+class GigInstrumentManagerTest : public CppUnit::TestFixture {
+
+    CPPUNIT_TEST_SUITE(GigInstrumentManagerTest);
+    CPPUNIT_TEST(printTestSuiteName);
+    CPPUNIT_TEST(testLoadAndUnload);
+#if CONFIG_LAZY_PRELOAD
+    CPPUNIT_TEST(testLazyPreload);
+    CPPUNIT_TEST(testUnloadWhileScheduled);
+#endif
+    CPPUNIT_TEST_SUITE_END();
+
+    public:
+        // gives access to the instruments loaded by the manager
+        class Manager : public LinuxSampler::gig::InstrumentResourceManager {
+            public:
+                std::vector< ::gig::Instrument*> LoadedInstruments() { return Resources(true); }
+        };
+
+    private:
+        String FileName; ///< temporary .gig file written by setUp()
+
+    public:
+        void setUp();
+        void tearDown();
+
+        void printTestSuiteName();
+
+        void testLoadAndUnload();
+#if CONFIG_LAZY_PRELOAD
+        void testLazyPreload();
+        void testUnloadWhileScheduled();
+#endif
+};
+
+#endif // __LS_GIGINSTRUMENTMANAGERTEST_H__
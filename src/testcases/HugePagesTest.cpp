@@ -0,0 +1,91 @@
+#include "HugePagesTest.h"
+
+#include <iostream>
+#include <vector>
+#include <string.h>
+
+CPPUNIT_TEST_SUITE_REGISTRATION(HugePagesTest);
+
+using namespace std;
+
+void HugePagesTest::printTestSuiteName() {
+    cout << "\b \nRunning HugePages Tests: " << flush;
+}
+
+#if CONFIG_HUGE_PAGES
+
+// Check that buffers are aligned to cache lines, don't overlap and are given back to the system once all of them are freed.
+void HugePagesTest::testAllocateAligned() {
+    const uint64_t before = HugePages::GetStatistics().Bytes;
+    std::vector<int8_t*> buffers;
+    for (int i = 0; i < 100; i++) {
+        int8_t* p = HugePages::Allocate(1000 + i);
+        CPPUNIT_ASSERT(p != NULL);
+        CPPUNIT_ASSERT(size_t(p) % 64 == 0);
+        memset(p, i, 1000 + i);
+        buffers.push_back(p);
+    }
+    for (int i = 0; i < 100; i++)
+        for (int k = 0; k < 1000 + i; k++)
+            CPPUNIT_ASSERT(buffers[i][k] == int8_t(i));
+    CPPUNIT_ASSERT(HugePages::GetStatistics().Bytes > before);
+    for (size_t i = 0; i < buffers.size(); i++) HugePages::Free(buffers[i]);
+    CPPUNIT_ASSERT(HugePages::GetStatistics().Bytes == before);
+}
+
+// Check that a freed buffer's range is handed out again for a buffer of the same size.
+void HugePagesTest::testFreedRangeReused() {
+    int8_t* pA = HugePages::Allocate(4096);
+    int8_t* pB = HugePages::Allocate(4096);
+    int8_t* pC = HugePages::Allocate(4096);
+    HugePages::Free(pB);
+    int8_t* pD = HugePages::Allocate(4096);
+    CPPUNIT_ASSERT(pD == pB);
+    HugePages::Free(pA);
+    HugePages::Free(pC);
+    HugePages::Free(pD);
+}
+
+// Check that neighbouring freed ranges are merged, so that a larger buffer fits into them.
+void HugePagesTest::testFreedRangesCoalesced() {
+    int8_t* pA = HugePages::Allocate(4096);
+    int8_t* pB = HugePages::Allocate(4096);
+    int8_t* pC = HugePages::Allocate(4096);
+    int8_t* pD = HugePages::Allocate(4096);
+    CPPUNIT_ASSERT(pB == pA + 4096 && pC == pB + 4096);
+    HugePages::Free(pC);
+    HugePages::Free(pA);
+    HugePages::Free(pB); // merges with both neighbours
+    int8_t* pE = HugePages::Allocate(3 * 4096);
+    CPPUNIT_ASSERT(pE == pA);
+    HugePages::Free(pE);
+    HugePages::Free(pD);
+}
+
+// Check that large buffers get their own mapping, aligned to huge pages.
+void HugePagesTest::testLargeBuffer() {
+    const uint64_t before = HugePages::GetStatistics().Bytes;
+    const size_t size = 16 * 1024 * 1024;
+    int8_t* p = HugePages::Allocate(size);
+    CPPUNIT_ASSERT(p != NULL);
+    CPPUNIT_ASSERT(size_t(p) % (2 * 1024 * 1024) == 0);
+    memset(p, 1, size);
+    CPPUNIT_ASSERT(HugePages::GetStatistics().Bytes == before + size);
+    HugePages::Free(p);
+    CPPUNIT_ASSERT(HugePages::GetStatistics().Bytes == before);
+}
+
+// Check that mapped regions are rounded up to huge pages and accounted until unmapped.
+void HugePagesTest::testMap() {
+    const HugePages::statistics_t before = HugePages::GetStatistics();
+    uint8_t* p = HugePages::Map(1000);
+    CPPUNIT_ASSERT(p != NULL);
+    CPPUNIT_ASSERT(size_t(p) % (2 * 1024 * 1024) == 0);
+    const HugePages::statistics_t stats = HugePages::GetStatistics();
+    CPPUNIT_ASSERT(stats.Bytes == before.Bytes + 2 * 1024 * 1024);
+    CPPUNIT_ASSERT(stats.HugePageBytes <= stats.Bytes);
+    HugePages::Unmap(p);
+    CPPUNIT_ASSERT(HugePages::GetStatistics().Bytes == before.Bytes);
+}
+
+#endif // CONFIG_HUGE_PAGES
@@ -0,0 +1,39 @@
+#ifndef __LS_HUGEPAGESTEST_H__
+#define __LS_HUGEPAGESTEST_H__
+
+#include <cppunit/TestFixture.h>
+#include <cppunit/extensions/HelperMacros.h>
+
+#include "../common/global_private.h"
+
+// the HugePages class we want to test
+#include "../common/HugePages.h"
+
+using namespace LinuxSampler;
+
+class HugePagesTest : public CppUnit::TestFixture {
+
+    CPPUNIT_TEST_SUITE(HugePagesTest);
+    CPPUNIT_TEST(printTestSuiteName);
+#if CONFIG_HUGE_PAGES
+    CPPUNIT_TEST(testAllocateAligned);
+    CPPUNIT_TEST(testFreedRangeReused);
+    CPPUNIT_TEST(testFreedRangesCoalesced);
+    CPPUNIT_TEST(testLargeBuffer);
+    CPPUNIT_TEST(testMap);
+#endif
+    CPPUNIT_TEST_SUITE_END();
+
+    public:
+        void printTestSuiteName();
+
+#if CONFIG_HUGE_PAGES
+        void testAllocateAligned();
+        void testFreedRangeReused();
+        void testFreedRangesCoalesced();
+        void testLargeBuffer();
+        void testMap();
+#endif
+};
+
+#endif // __LS_HUGEPAGESTEST_H__
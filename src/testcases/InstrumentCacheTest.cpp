@@ -0,0 +1,175 @@
+#include "InstrumentCacheTest.h"
+
+#include <iostream>
+#include <stdio.h>
+#include <stdlib.h>
+#include <dirent.h>
+#include <unistd.h>
+#include <utime.h>
+#include <sys/stat.h>
+
+CPPUNIT_TEST_SUITE_REGISTRATION(InstrumentCacheTest);
+
+using namespace std;
+
+static void WriteFile(const std::string& File, const char* pText) {
+    FILE* f = fopen(File.c_str(), "wb");
+    CPPUNIT_ASSERT(f != NULL);
+    fputs(pText, f);
+    fclose(f);
+}
+
+// Removes all files of directory @a Dir and the directory itself.
+static void RemoveDir(const std::string& Dir) {
+    DIR* d = opendir(Dir.c_str());
+    if (!d) return;
+    while (struct dirent* e = readdir(d)) {
+        const std::string name = e->d_name;
+        if (name != "." && name != "..") unlink((Dir + "/" + name).c_str());
+    }
+    closedir(d);
+    rmdir(Dir.c_str());
+}
+
+#if CONFIG_SFZ_CACHE
+
+// Returns the (absolute) sample file names of all regions triggered by the given note-on.
+static std::string Triggered(sfz::Instrument* pInstrument, uint8_t Key, uint8_t Velocity) {
+    uint8_t cc[129] = {};
+    bool sw[128] = {};
+    sfz::Query q;
+    q.chan        = 1;
+    q.key         = Key;
+    q.vel         = Velocity;
+    q.bend        = 0;
+    q.bpm         = 0;
+    q.chanaft     = 0;
+    q.polyaft     = 0;
+    q.prog        = 0;
+    q.rand        = 0;
+    q.cc          = cc;
+    q.timer       = 0;
+    q.sw          = sw;
+    q.last_sw_key = 0;
+    q.prev_sw_key = 0;
+    q.trig        = TRIGGER_ATTACK | TRIGGER_FIRST;
+    q.search(pInstrument);
+    std::string samples;
+    while (sfz::Region* pRegion = q.peekNext()) samples += pRegion->sample + ";";
+    return samples;
+}
+
+// Asserts that both instruments are equal as far as the engine is concerned.
+static void AssertEqual(sfz::Instrument* pA, sfz::Instrument* pB) {
+    CPPUNIT_ASSERT(pA->regions.size() == pB->regions.size());
+    for (size_t i = 0; i < pA->regions.size(); i++) {
+        sfz::Region* a = pA->regions[i];
+        sfz::Region* b = pB->regions[i];
+        CPPUNIT_ASSERT(a->sample == b->sample);
+        CPPUNIT_ASSERT(a->lokey == b->lokey && a->hikey == b->hikey);
+        CPPUNIT_ASSERT(a->lovel == b->lovel && a->hivel == b->hivel);
+        CPPUNIT_ASSERT(a->pitch_keycenter == b->pitch_keycenter);
+        CPPUNIT_ASSERT(a->volume == b->volume);
+        CPPUNIT_ASSERT(a->trigger == b->trigger);
+        CPPUNIT_ASSERT(a->loop_mode == b->loop_mode);
+        CPPUNIT_ASSERT(a->fil_type == b->fil_type);
+        CPPUNIT_ASSERT(a->cutoff == b->cutoff);
+        CPPUNIT_ASSERT(a->ampeg_release == b->ampeg_release);
+        CPPUNIT_ASSERT(a->group == b->group && a->off_by == b->off_by);
+        for (int v = 0; v < 128; v++) CPPUNIT_ASSERT(a->amp_velcurve[v] == b->amp_velcurve[v]);
+    }
+    CPPUNIT_ASSERT(pA->initialCCValues == pB->initialCCValues);
+    for (int key = 0; key < 128; key++) {
+        CPPUNIT_ASSERT(pA->HasKeyBinding(key) == pB->HasKeyBinding(key));
+        CPPUNIT_ASSERT(pA->HasKeySwitchBinding(key) == pB->HasKeySwitchBinding(key));
+        for (int vel = 1; vel < 128; vel += 42)
+            CPPUNIT_ASSERT(Triggered(pA, key, vel) == Triggered(pB, key, vel));
+    }
+}
+
+#endif // CONFIG_SFZ_CACHE
+
+void InstrumentCacheTest::setUp() {
+    char dir[] = "/tmp/linuxsamplertestXXXXXX";
+    CPPUNIT_ASSERT(mkdtemp(dir) != NULL);
+    Dir         = dir;
+    CacheDir    = Dir + "/cache";
+    SfzFile     = Dir + "/test.sfz";
+    IncludeFile = Dir + "/include.sfz";
+    WriteFile(IncludeFile,
+        "<region> sample=c.wav lokey=73 hikey=80 fil_type=hpf_2p cutoff=500\n"
+    );
+    WriteFile(SfzFile,
+        "<control> set_cc7=100\n"
+        "#define $KEY 60\n"
+        "<global> ampeg_release=0.5\n"
+        "<group> lokey=48 hikey=72 loop_mode=one_shot group=1 off_by=2\n"
+        "<region> sample=a.wav lovel=1 hivel=63 pitch_keycenter=$KEY volume=-3 amp_velcurve_64=0.25\n"
+        "<region> sample=b.wav lovel=64 hivel=127 pitch_keycenter=$KEY\n"
+        "#include \"include.sfz\"\n"
+        "<group> sw_lokey=24 sw_hikey=25 sw_last=24 trigger=release group=2\n"
+        "<region> sample=d.wav key=50\n"
+    );
+}
+
+void InstrumentCacheTest::tearDown() {
+    RemoveDir(CacheDir);
+    RemoveDir(Dir);
+}
+
+void InstrumentCacheTest::printTestSuiteName() {
+    cout << "\b \nRunning sfz InstrumentCache Tests: " << flush;
+}
+
+#if CONFIG_SFZ_CACHE
+
+// Check that an instrument restored from the cache file equals the one parsed from the sfz file.
+void InstrumentCacheTest::testRoundTrip() {
+    sfz::InstrumentCache::SetDirectory(CacheDir);
+    sfz::File parsed(SfzFile); // parses and writes the cache file
+    sfz::Instrument* pCached = new sfz::Instrument;
+    CPPUNIT_ASSERT(sfz::InstrumentCache::Load(SfzFile, pCached));
+    AssertEqual(parsed.GetInstrument(), pCached);
+    CPPUNIT_ASSERT(Triggered(pCached, 75, 100) == Dir + "/c.wav;");
+    CPPUNIT_ASSERT(Triggered(pCached, 60, 100) == Dir + "/b.wav;");
+    CPPUNIT_ASSERT(Triggered(pCached, 60, 10) == Dir + "/a.wav;");
+    delete pCached;
+    sfz::File loaded(SfzFile); // restored from the cache file
+    AssertEqual(parsed.GetInstrument(), loaded.GetInstrument());
+}
+
+// Check that the cache file is not used anymore once an included file changed.
+void InstrumentCacheTest::testIncludeChanged() {
+    sfz::InstrumentCache::SetDirectory(CacheDir);
+    { sfz::File parsed(SfzFile); }
+    sfz::Instrument* pCached = new sfz::Instrument;
+    CPPUNIT_ASSERT(sfz::InstrumentCache::Load(SfzFile, pCached));
+    delete pCached;
+
+    WriteFile(IncludeFile, "<region> sample=e.wav lokey=73 hikey=80\n");
+    pCached = new sfz::Instrument;
+    CPPUNIT_ASSERT(!sfz::InstrumentCache::Load(SfzFile, pCached));
+    CPPUNIT_ASSERT(pCached->regions.empty());
+    delete pCached;
+    sfz::File parsed(SfzFile);
+    CPPUNIT_ASSERT(Triggered(parsed.GetInstrument(), 75, 100) == Dir + "/e.wav;");
+}
+
+// Check that a changed sfz file is detected even if its size and modification time did not change.
+void InstrumentCacheTest::testSameSizeAndTimeChanged() {
+    sfz::InstrumentCache::SetDirectory(CacheDir);
+    struct stat st;
+    CPPUNIT_ASSERT(!stat(IncludeFile.c_str(), &st));
+    { sfz::File parsed(SfzFile); }
+
+    WriteFile(IncludeFile, "<region> sample=f.wav lokey=73 hikey=80 fil_type=hpf_2p cutoff=500\n");
+    struct utimbuf times;
+    times.actime  = st.st_atime;
+    times.modtime = st.st_mtime;
+    CPPUNIT_ASSERT(!utime(IncludeFile.c_str(), &times));
+    sfz::Instrument* pCached = new sfz::Instrument;
+    CPPUNIT_ASSERT(!sfz::InstrumentCache::Load(SfzFile, pCached));
+    delete pCached;
+}
+
+#endif // CONFIG_SFZ_CACHE
@@ -0,0 +1,43 @@
+#ifndef __LS_INSTRUMENTCACHETEST_H__
+#define __LS_INSTRUMENTCACHETEST_H__
+
+#include <cppunit/TestFixture.h>
+#include <cppunit/extensions/HelperMacros.h>
+
+#include "../common/global_private.h"
+
+// the sfz InstrumentCache class we want to test
+#include "../engines/sfz/sfz.h"
+#include "../engines/sfz/InstrumentCache.h"
+
+class InstrumentCacheTest : public CppUnit::TestFixture {
+
+    CPPUNIT_TEST_SUITE(InstrumentCacheTest);
+    CPPUNIT_TEST(printTestSuiteName);
+#if CONFIG_SFZ_CACHE
+    CPPUNIT_TEST(testRoundTrip);
+    CPPUNIT_TEST(testIncludeChanged);
+    CPPUNIT_TEST(testSameSizeAndTimeChanged);
+#endif
+    CPPUNIT_TEST_SUITE_END();
+
+    private:
+        std::string Dir;         ///< temporary directory of the test's files
+        std::string SfzFile;     ///< temporary sfz file written by setUp()
+        std::string IncludeFile; ///< file #included by SfzFile
+        std::string CacheDir;    ///< cache directory (the cache stays enabled after the tests)
+
+    public:
+        void setUp();
+        void tearDown();
+
+        void printTestSuiteName();
+
+#if CONFIG_SFZ_CACHE
+        void testRoundTrip();
+        void testIncludeChanged();
+        void testSameSizeAndTimeChanged();
+#endif
+};
+
+#endif // __LS_INSTRUMENTCACHETEST_H__
@@ -0,0 +1,99 @@
+#include "PreloadSnapshotTest.h"
+
+#include <iostream>
+#include <vector>
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+
+CPPUNIT_TEST_SUITE_REGISTRATION(PreloadSnapshotTest);
+
+using namespace std;
+
+// size of the preload data written for one sample
+#define DATA_SIZE 1000
+
+static String TempFile() {
+    char path[] = "/tmp/linuxsamplertestXXXXXX";
+    int fd = mkstemp(path);
+    CPPUNIT_ASSERT(fd >= 0);
+    close(fd);
+    return path;
+}
+
+static void AppendToFile(const String& File, const char* pText) {
+    FILE* f = fopen(File.c_str(), "ab");
+    CPPUNIT_ASSERT(f != NULL);
+    fputs(pText, f);
+    fclose(f);
+}
+
+static std::vector<char> SampleData() {
+    std::vector<char> data(DATA_SIZE);
+    for (size_t i = 0; i < data.size(); i++) data[i] = char(i * 7);
+    return data;
+}
+
+void PreloadSnapshotTest::setUp() {
+    SourceFile   = TempFile();
+    SnapshotFile = TempFile();
+    unlink(SnapshotFile.c_str()); // no snapshot yet
+    AppendToFile(SourceFile, "instrument");
+}
+
+void PreloadSnapshotTest::tearDown() {
+    #if CONFIG_PRELOAD_SNAPSHOT
+    PreloadSnapshot::SetFile(String());
+    #endif
+    unlink(SourceFile.c_str());
+    unlink(SnapshotFile.c_str());
+}
+
+void PreloadSnapshotTest::printTestSuiteName() {
+    cout << "\b \nRunning PreloadSnapshot Tests: " << flush;
+}
+
+#if CONFIG_PRELOAD_SNAPSHOT
+
+// writes a snapshot with the sample data of SampleData() for sample 42 of the given file and maps it
+static void WriteSnapshot(const String& SnapshotFile, const String& SourceFile) {
+    std::vector<char> data = SampleData();
+    PreloadSnapshot::Writer writer;
+    CPPUNIT_ASSERT(writer.Open(SnapshotFile));
+    writer.Add(SourceFile, 42, &data[0], data.size());
+    CPPUNIT_ASSERT(writer.Close());
+    PreloadSnapshot::SetFile(SnapshotFile); // as on next start
+}
+
+// Check that the data written for a sample is read again from the snapshot.
+void PreloadSnapshotTest::testWriteAndRead() {
+    PreloadSnapshot::SetFile(SnapshotFile);
+    PreloadSnapshot::SourceLoaded(SourceFile);
+    WriteSnapshot(SnapshotFile, SourceFile);
+    CPPUNIT_ASSERT(PreloadSnapshot::Contains(SourceFile, 42, DATA_SIZE));
+    CPPUNIT_ASSERT(!PreloadSnapshot::Contains(SourceFile, 42, DATA_SIZE - 1));
+    CPPUNIT_ASSERT(!PreloadSnapshot::Contains(SourceFile, 43, DATA_SIZE));
+    std::vector<char> data(DATA_SIZE);
+    CPPUNIT_ASSERT(PreloadSnapshot::Read(SourceFile, 42, &data[0], DATA_SIZE));
+    CPPUNIT_ASSERT(data == SampleData());
+}
+
+// Check that data of an instrument file modified after it was loaded is ignored, even if the snapshot was written afterwards.
+void PreloadSnapshotTest::testSourceModifiedWhileLoaded() {
+    PreloadSnapshot::SetFile(SnapshotFile);
+    PreloadSnapshot::SourceLoaded(SourceFile);
+    AppendToFile(SourceFile, " modified");
+    WriteSnapshot(SnapshotFile, SourceFile);
+    CPPUNIT_ASSERT(!PreloadSnapshot::Contains(SourceFile, 42, DATA_SIZE));
+    std::vector<char> data(DATA_SIZE);
+    CPPUNIT_ASSERT(!PreloadSnapshot::Read(SourceFile, 42, &data[0], DATA_SIZE));
+}
+
+// Check that no data is stored for instrument files not reported by SourceLoaded().
+void PreloadSnapshotTest::testSourceNotLoaded() {
+    PreloadSnapshot::SetFile(SnapshotFile);
+    WriteSnapshot(SnapshotFile, SourceFile);
+    CPPUNIT_ASSERT(!PreloadSnapshot::Contains(SourceFile, 42, DATA_SIZE));
+}
+
+#endif // CONFIG_PRELOAD_SNAPSHOT
@@ -0,0 +1,42 @@
+#ifndef __LS_PRELOADSNAPSHOTTEST_H__
+#define __LS_PRELOADSNAPSHOTTEST_H__
+
+#include <cppunit/TestFixture.h>
+#include <cppunit/extensions/HelperMacros.h>
+
+#include "../common/global_private.h"
+
+// the PreloadSnapshot class we want to test
+#include "../engines/common/PreloadSnapshot.h"
+
+using namespace LinuxSampler;
+
+class PreloadSnapshotTest : public CppUnit::TestFixture {
+
+    CPPUNIT_TEST_SUITE(PreloadSnapshotTest);
+    CPPUNIT_TEST(printTestSuiteName);
+#if CONFIG_PRELOAD_SNAPSHOT
+    CPPUNIT_TEST(testWriteAndRead);
+    CPPUNIT_TEST(testSourceModifiedWhileLoaded);
+    CPPUNIT_TEST(testSourceNotLoaded);
+#endif
+    CPPUNIT_TEST_SUITE_END();
+
+    private:
+        String SourceFile;   ///< temporary instrument file written by setUp()
+        String SnapshotFile; ///< temporary snapshot file
+
+    public:
+        void setUp();
+        void tearDown();
+
+        void printTestSuiteName();
+
+#if CONFIG_PRELOAD_SNAPSHOT
+        void testWriteAndRead();
+        void testSourceModifiedWhileLoaded();
+        void testSourceNotLoaded();
+#endif
+};
+
+#endif // __LS_PRELOADSNAPSHOTTEST_H__
@@ -0,0 +1,258 @@
+#include "ResourceManagerTest.h"
+
+#include <iostream>
+
+CPPUNIT_TEST_SUITE_REGISTRATION(ResourceManagerTest);
+
+using namespace std;
+
+// how long the tests wait at most for another thread (in 10ms steps)
+#define TIMEOUT_STEPS 200
+
+
+// Manager
+
+ResourceManagerTest::Manager::Manager() :
+    created(0), destroyed(0), blocked(0), bBlock(false), bSideBySide(false)
+{
+}
+
+// Waits until the given amount of Create() / Recreate() calls are held up.
+bool ResourceManagerTest::Manager::WaitUntilBlocked(int Calls) {
+    for (int i = 0; i < TIMEOUT_STEPS; i++) {
+        if (blocked >= Calls) return true;
+        usleep(10000);
+    }
+    return false;
+}
+
+// Lets held up Create() / Recreate() calls (and future ones) complete.
+void ResourceManagerTest::Manager::Release() {
+    bBlock = false;
+}
+
+void ResourceManagerTest::Manager::Block() {
+    if (!bBlock) return;
+    blocked++;
+    while (bBlock) usleep(1000);
+    blocked--;
+}
+
+ResourceManagerTest::resource_t* ResourceManagerTest::Manager::Create(int Key, ResourceConsumer<resource_t>* pConsumer, void*& pArg) {
+    Block();
+    resource_t* pResource = new resource_t;
+    pResource->key        = Key;
+    pResource->generation = ++created;
+    return pResource;
+}
+
+void ResourceManagerTest::Manager::Destroy(resource_t* pResource, void* pArg) {
+    destroyed++;
+    delete pResource;
+}
+
+ResourceManagerTest::resource_t* ResourceManagerTest::Manager::Recreate(int Key, ResourceConsumer<resource_t>* pConsumer, resource_t* pOldResource, void* pOldArg, void*& pArg) {
+    if (!bSideBySide) return NULL;
+    return Create(Key, pConsumer, pArg);
+}
+
+
+// Consumer
+
+ResourceManagerTest::Consumer::Consumer(Manager* pManager) :
+    pManager(pManager), pResource(NULL), bManagerLockedOnReplace(false)
+{
+}
+
+void ResourceManagerTest::Consumer::ResourceToBeUpdated(resource_t* pResource, void*& pUpdateArg) {
+    this->pResource = NULL;
+}
+
+void ResourceManagerTest::Consumer::ResourceUpdated(resource_t* pOldResource, resource_t* pNewResource, void* pUpdateArg) {
+    pResource = pNewResource;
+}
+
+void ResourceManagerTest::Consumer::ResourceReplaced(resource_t* pOldResource, resource_t* pNewResource) {
+    // a real consumer locks its own mutexes here, which it might hold while
+    // calling into the manager from another thread, so check whether
+    // another thread can use the manager meanwhile (without waiting for it
+    // here, which would dead lock if the manager was locked)
+    std::shared_ptr< std::atomic<bool> > pDone(new std::atomic<bool>(false));
+    Manager* pMgr = pManager;
+    std::thread probe([pMgr, pDone]() {
+        pMgr->Entries();
+        *pDone = true;
+    });
+    for (int i = 0; i < TIMEOUT_STEPS && !*pDone; i++) usleep(10000);
+    bManagerLockedOnReplace = !*pDone;
+    if (bManagerLockedOnReplace) probe.detach(); // would dead lock
+    else probe.join();
+    pResource = pNewResource;
+}
+
+
+// ResourceManagerTest
+
+void ResourceManagerTest::printTestSuiteName() {
+    cout << "\b \nRunning ResourceManager Tests: " << flush;
+}
+
+// Check that all consumers borrowing the same key share one resource, which is destroyed after the last one handed it back.
+void ResourceManagerTest::testBorrowAndHandBack() {
+    Manager manager;
+    Consumer a(&manager), b(&manager);
+    resource_t* pA = manager.Borrow(1, &a);
+    resource_t* pB = manager.Borrow(1, &b);
+    CPPUNIT_ASSERT(pA != NULL);
+    CPPUNIT_ASSERT(pA == pB);
+    CPPUNIT_ASSERT(manager.created == 1);
+    CPPUNIT_ASSERT(manager.HandBack(pA, &a));
+    CPPUNIT_ASSERT(manager.destroyed == 0);
+    CPPUNIT_ASSERT(manager.HandBack(pB, &b));
+    CPPUNIT_ASSERT(manager.destroyed == 1);
+    CPPUNIT_ASSERT(manager.Entries().empty());
+    CPPUNIT_ASSERT(!manager.HandBack(pA, &a));
+}
+
+// Check that consumers are switched over to a resource recreated side by side without the manager being locked.
+void ResourceManagerTest::testReplaceWithoutLock() {
+    Manager manager;
+    manager.bSideBySide = true;
+    Consumer a(&manager), b(&manager);
+    a.pResource = manager.Borrow(1, &a);
+    b.pResource = manager.Borrow(1, &b);
+    resource_t* pOld = a.pResource;
+    manager.Update(pOld, NULL);
+    CPPUNIT_ASSERT(!a.bManagerLockedOnReplace);
+    CPPUNIT_ASSERT(!b.bManagerLockedOnReplace);
+    CPPUNIT_ASSERT(a.pResource != NULL);
+    CPPUNIT_ASSERT(a.pResource->generation == 2);
+    CPPUNIT_ASSERT(b.pResource == a.pResource);
+    CPPUNIT_ASSERT(manager.destroyed == 1); // the old resource
+    // the old resource may still be handed back while consumers switch over,
+    // later on only the new one is known
+    CPPUNIT_ASSERT(!manager.HandBack(pOld, &a));
+    CPPUNIT_ASSERT(manager.HandBack(a.pResource, &a));
+    CPPUNIT_ASSERT(manager.HandBack(b.pResource, &b));
+    CPPUNIT_ASSERT(manager.destroyed == 2);
+    CPPUNIT_ASSERT(manager.Entries().empty());
+}
+
+// Check that a consumer borrowing a resource which is being created waits for it, while the manager can be used meanwhile.
+void ResourceManagerTest::testBorrowWaitsForCreation() {
+    Manager manager;
+    manager.bBlock = true;
+    Consumer a(&manager), b(&manager);
+    std::atomic<bool> bBorrowedB(false);
+    std::thread threadA([&]() { a.pResource = manager.Borrow(1, &a); });
+    CPPUNIT_ASSERT(manager.WaitUntilBlocked());
+    std::thread threadB([&]() { b.pResource = manager.Borrow(1, &b); bBorrowedB = true; });
+    usleep(100000); // wait 100ms
+    CPPUNIT_ASSERT(!bBorrowedB);
+    CPPUNIT_ASSERT(manager.Entries().size() == 1); // not blocked by the creation
+    CPPUNIT_ASSERT(!manager.IsCreated(1));
+    manager.Release();
+    threadA.join();
+    threadB.join();
+    CPPUNIT_ASSERT(a.pResource != NULL);
+    CPPUNIT_ASSERT(a.pResource == b.pResource);
+    CPPUNIT_ASSERT(manager.created == 1);
+    CPPUNIT_ASSERT(manager.HandBack(a.pResource, &a));
+    CPPUNIT_ASSERT(manager.HandBack(b.pResource, &b));
+    CPPUNIT_ASSERT(manager.destroyed == 1);
+}
+
+// Check that a consumer borrowing a resource while it is being recreated side by side gets the new resource.
+void ResourceManagerTest::testBorrowDuringUpdate() {
+    Manager manager;
+    manager.bSideBySide = true;
+    Consumer a(&manager), b(&manager);
+    a.pResource = manager.Borrow(1, &a);
+    manager.bBlock = true;
+    std::thread update([&]() { manager.Update(a.pResource, NULL); });
+    CPPUNIT_ASSERT(manager.WaitUntilBlocked());
+    std::thread borrow([&]() { b.pResource = manager.Borrow(1, &b); });
+    usleep(100000); // wait 100ms
+    manager.Release();
+    update.join();
+    borrow.join();
+    CPPUNIT_ASSERT(b.pResource != NULL);
+    CPPUNIT_ASSERT(b.pResource->generation == 2);
+    CPPUNIT_ASSERT(a.pResource == b.pResource);
+    CPPUNIT_ASSERT(manager.destroyed == 1);
+    CPPUNIT_ASSERT(manager.HandBack(a.pResource, &a));
+    CPPUNIT_ASSERT(manager.HandBack(b.pResource, &b));
+    CPPUNIT_ASSERT(manager.destroyed == 2);
+    CPPUNIT_ASSERT(manager.Entries().empty());
+}
+
+// Check that a resource whose last consumer left while it was recreated side by side is destroyed afterwards.
+void ResourceManagerTest::testHandBackDuringUpdate() {
+    Manager manager;
+    manager.bSideBySide = true;
+    Consumer a(&manager);
+    resource_t* pOld = manager.Borrow(1, &a);
+    manager.bBlock = true;
+    std::thread update([&]() { manager.Update(pOld, NULL); });
+    CPPUNIT_ASSERT(manager.WaitUntilBlocked());
+    CPPUNIT_ASSERT(manager.HandBack(pOld, &a));
+    CPPUNIT_ASSERT(manager.destroyed == 0); // still being recreated
+    manager.Release();
+    update.join();
+    CPPUNIT_ASSERT(manager.created == 2);
+    CPPUNIT_ASSERT(manager.destroyed == 2);
+    CPPUNIT_ASSERT(manager.Entries().empty());
+}
+
+// Check the same if the resource is destroyed and created again by Update().
+void ResourceManagerTest::testHandBackDuringRecreation() {
+    Manager manager;
+    Consumer a(&manager);
+    resource_t* pOld = a.pResource = manager.Borrow(1, &a);
+    manager.bBlock = true;
+    std::thread update([&]() { manager.Update(pOld, NULL); });
+    CPPUNIT_ASSERT(manager.WaitUntilBlocked());
+    CPPUNIT_ASSERT(manager.destroyed == 1);
+    CPPUNIT_ASSERT(a.pResource == NULL); // informed about the update
+    CPPUNIT_ASSERT(manager.HandBack(pOld, &a));
+    manager.Release();
+    update.join();
+    CPPUNIT_ASSERT(a.pResource == NULL); // not informed anymore
+    CPPUNIT_ASSERT(manager.created == 2);
+    CPPUNIT_ASSERT(manager.destroyed == 2);
+    CPPUNIT_ASSERT(manager.Entries().empty());
+}
+
+// Check that a prefetched resource is kept without consumer until it was borrowed and handed back.
+void ResourceManagerTest::testPrefetch() {
+    Manager manager;
+    Consumer a(&manager);
+    CPPUNIT_ASSERT(manager.Prefetch(1));
+    CPPUNIT_ASSERT(!manager.Prefetch(1)); // already created
+    CPPUNIT_ASSERT(manager.created == 1);
+    CPPUNIT_ASSERT(manager.IsCreated(1));
+    a.pResource = manager.Borrow(1, &a);
+    CPPUNIT_ASSERT(a.pResource != NULL);
+    CPPUNIT_ASSERT(manager.created == 1); // the prefetched one
+    CPPUNIT_ASSERT(manager.HandBack(a.pResource, &a));
+    CPPUNIT_ASSERT(manager.destroyed == 1);
+    CPPUNIT_ASSERT(manager.Entries().empty());
+}
+
+// Check that DiscardPrefetched() only destroys prefetched resources which have not been borrowed yet.
+void ResourceManagerTest::testDiscardPrefetched() {
+    Manager manager;
+    Consumer a(&manager);
+    CPPUNIT_ASSERT(manager.Prefetch(1));
+    CPPUNIT_ASSERT(manager.Prefetch(2));
+    a.pResource = manager.Borrow(2, &a);
+    CPPUNIT_ASSERT(!manager.DiscardPrefetched(2)); // in use
+    CPPUNIT_ASSERT(!manager.DiscardPrefetched(3)); // unknown
+    CPPUNIT_ASSERT(manager.DiscardPrefetched(1));
+    CPPUNIT_ASSERT(manager.destroyed == 1);
+    CPPUNIT_ASSERT(!manager.IsCreated(1));
+    CPPUNIT_ASSERT(manager.IsCreated(2));
+    CPPUNIT_ASSERT(manager.HandBack(a.pResource, &a));
+    CPPUNIT_ASSERT(manager.destroyed == 2);
+    CPPUNIT_ASSERT(manager.Entries().empty());
+}
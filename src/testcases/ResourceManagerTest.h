@@ -0,0 +1,87 @@
+#ifndef __LS_RESOURCEMANAGERTEST_H__
+#define __LS_RESOURCEMANAGERTEST_H__
+
+#include <cppunit/TestFixture.h>
+#include <cppunit/extensions/HelperMacros.h>
+
+#include <atomic>
+#include <memory>
+#include <thread>
+
+// needed for usleep() calls
+#include <unistd.h>
+
+#include "../common/global.h"
+
+// the ResourceManager class template we want to test
+#include "../common/ResourceManager.h"
+
+using namespace LinuxSampler;
+
+class ResourceManagerTest : public CppUnit::TestFixture {
+
+    CPPUNIT_TEST_SUITE(ResourceManagerTest);
+    CPPUNIT_TEST(printTestSuiteName);
+    CPPUNIT_TEST(testBorrowAndHandBack);
+    CPPUNIT_TEST(testReplaceWithoutLock);
+    CPPUNIT_TEST(testBorrowWaitsForCreation);
+    CPPUNIT_TEST(testBorrowDuringUpdate);
+    CPPUNIT_TEST(testHandBackDuringUpdate);
+    CPPUNIT_TEST(testHandBackDuringRecreation);
+    CPPUNIT_TEST(testPrefetch);
+    CPPUNIT_TEST(testDiscardPrefetched);
+    CPPUNIT_TEST_SUITE_END();
+
+    public:
+        struct resource_t {
+            int key;
+            int generation; ///< Create() / Recreate() call which created the resource
+        };
+
+        // manager whose resource creation can be held up by the test
+        class Manager : public ResourceManager<int, resource_t> {
+            public:
+                std::atomic<int>  created;   ///< amount of resources created so far
+                std::atomic<int>  destroyed; ///< amount of resources destroyed so far
+                std::atomic<int>  blocked;   ///< amount of Create() / Recreate() calls currently held up
+                std::atomic<bool> bBlock;    ///< whether Create() / Recreate() shall wait until Release() is called
+                std::atomic<bool> bSideBySide; ///< whether Recreate() shall create the updated resource
+
+                Manager();
+                bool WaitUntilBlocked(int Calls = 1);
+                void Release();
+            protected:
+                resource_t* Create(int Key, ResourceConsumer<resource_t>* pConsumer, void*& pArg) OVERRIDE;
+                void Destroy(resource_t* pResource, void* pArg) OVERRIDE;
+                resource_t* Recreate(int Key, ResourceConsumer<resource_t>* pConsumer, resource_t* pOldResource, void* pOldArg, void*& pArg) OVERRIDE;
+                void OnBorrow(resource_t* pResource, ResourceConsumer<resource_t>* pConsumer, void*& pArg) OVERRIDE {}
+            private:
+                void Block();
+        };
+
+        class Consumer : public ResourceConsumer<resource_t> {
+            public:
+                Manager*    pManager;
+                resource_t* pResource;
+                bool        bManagerLockedOnReplace; ///< whether the manager was locked while ResourceReplaced() was called
+
+                Consumer(Manager* pManager);
+                void ResourceToBeUpdated(resource_t* pResource, void*& pUpdateArg) OVERRIDE;
+                void ResourceUpdated(resource_t* pOldResource, resource_t* pNewResource, void* pUpdateArg) OVERRIDE;
+                void ResourceReplaced(resource_t* pOldResource, resource_t* pNewResource) OVERRIDE;
+                void OnResourceProgress(float fProgress) OVERRIDE {}
+        };
+
+        void printTestSuiteName();
+
+        void testBorrowAndHandBack();
+        void testReplaceWithoutLock();
+        void testBorrowWaitsForCreation();
+        void testBorrowDuringUpdate();
+        void testHandBackDuringUpdate();
+        void testHandBackDuringRecreation();
+        void testPrefetch();
+        void testDiscardPrefetched();
+};
+
+#endif // __LS_RESOURCEMANAGERTEST_H__
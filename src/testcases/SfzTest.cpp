@@ -0,0 +1,353 @@
+#include "SfzTest.h"
+
+#include <iostream>
+#include <stdio.h>
+#include <stdlib.h>
+#include <dirent.h>
+#include <unistd.h>
+#include <set>
+#include <algorithm>
+
+CPPUNIT_TEST_SUITE_REGISTRATION(SfzTest);
+
+using namespace std;
+
+// Removes all files of directory @a Dir and the directory itself.
+static void RemoveDir(const std::string& Dir) {
+    DIR* d = opendir(Dir.c_str());
+    if (!d) return;
+    while (struct dirent* e = readdir(d)) {
+        const std::string name = e->d_name;
+        if (name != "." && name != "..") unlink((Dir + "/" + name).c_str());
+    }
+    closedir(d);
+    rmdir(Dir.c_str());
+}
+
+// Writes sfz file @a Name into the test's directory and returns its path.
+std::string SfzTest::WriteSfz(const std::string& Name, const std::string& Text) {
+    const std::string path = Dir + "/" + Name;
+    FILE* f = fopen(path.c_str(), "wb");
+    CPPUNIT_ASSERT(f != NULL);
+    fputs(Text.c_str(), f);
+    fclose(f);
+    return path;
+}
+
+// Returns the region playing sample file @a Name (relative to the sfz file).
+static sfz::Region* RegionOf(sfz::Instrument* pInstrument, const std::string& Dir, const std::string& Name) {
+    for (size_t i = 0; i < pInstrument->regions.size(); i++)
+        if (pInstrument->regions[i]->sample == Dir + "/" + Name)
+            return pInstrument->regions[i];
+    return NULL;
+}
+
+// Whether both lists share the same buffer.
+template<class T>
+static bool Shared(const sfz::List<T>& a, const sfz::List<T>& b) {
+    return &(const LinuxSampler::ArrayList<T>&) a == &(const LinuxSampler::ArrayList<T>&) b;
+}
+
+// Simple deterministic pseudo random numbers, so failures are reproducible.
+static int Random(unsigned int& Seed) {
+    Seed = Seed * 1103515245u + 12345u;
+    return int((Seed >> 16) & 0x7fff);
+}
+
+// Whether @a pRegion matches key, velocity and controller values of @a q, checked without lookup table.
+static bool Matches(const sfz::Region* pRegion, const sfz::Query& q) {
+    if (q.key < pRegion->lokey || q.key > pRegion->hikey) return false;
+    if (q.vel < pRegion->lovel || q.vel > pRegion->hivel) return false;
+    for (int cc = 0; cc < 128; cc++)
+        if (q.cc[cc] < pRegion->locc[cc] || q.cc[cc] > pRegion->hicc[cc]) return false;
+    return true;
+}
+
+// Asserts that the lookup table of @a pInstrument finds exactly the regions matching random note-on queries.
+static void AssertLookupMatches(sfz::Instrument* pInstrument, unsigned int Seed, int Queries) {
+    uint8_t cc[129] = {};
+    bool sw[128] = {};
+    sfz::Query q;
+    q.chan        = 1;
+    q.bend        = 0;
+    q.bpm         = 0;
+    q.chanaft     = 0;
+    q.polyaft     = 0;
+    q.prog        = 0;
+    q.rand        = 0;
+    q.cc          = cc;
+    q.timer       = 0;
+    q.sw          = sw;
+    q.last_sw_key = 0;
+    q.prev_sw_key = 0;
+    q.trig        = TRIGGER_ATTACK | TRIGGER_FIRST;
+    for (int i = 0; i < Queries; i++) {
+        q.key = Random(Seed) % 128;
+        q.vel = 1 + Random(Seed) % 127;
+        for (int c = 0; c < 128; c++) cc[c] = Random(Seed) % 128;
+
+        std::set<sfz::Region*> expected, found;
+        for (size_t r = 0; r < pInstrument->regions.size(); r++)
+            if (Matches(pInstrument->regions[r], q)) expected.insert(pInstrument->regions[r]);
+        q.search(pInstrument);
+        while (sfz::Region* pRegion = q.peekNext()) {
+            CPPUNIT_ASSERT(!found.count(pRegion)); // each region only once
+            found.insert(pRegion);
+        }
+        CPPUNIT_ASSERT(found == expected);
+    }
+}
+
+void SfzTest::setUp() {
+    char dir[] = "/tmp/linuxsamplertestXXXXXX";
+    CPPUNIT_ASSERT(mkdtemp(dir) != NULL);
+    Dir = dir;
+}
+
+void SfzTest::tearDown() {
+    RemoveDir(Dir);
+}
+
+void SfzTest::printTestSuiteName() {
+    cout << "\b \nRunning sfz Tests: " << flush;
+}
+
+// Check that opcodes (exact ones and ones with numbers in their names) are assigned to the right fields.
+void SfzTest::testOpcodes() {
+    sfz::File file(WriteSfz("opcodes.sfz",
+        "<region> sample=a.wav lokey=60 hikey=62 pitch_keycenter=61 lovel=10 hivel=20\n"
+        "  tune=-5 volume=-3.5 loop_mode=loop_continuous trigger=release\n"
+        "  fil_type=hpf_2p cutoff=500 ampeg_release=0.8 group=3 off_by=4\n"
+        "<region> sample=b.wav key=c#4 cutoff_cc74=2400 volume_oncc7=6\n"
+        "  eg1_time1=0.5 eg1_level1=1 lfo2_freq=3 lfo2_volume=2 seq_length=2 seq_position=2\n"
+    ));
+    sfz::Instrument* pInstrument = file.GetInstrument();
+    CPPUNIT_ASSERT(pInstrument->regions.size() == 2);
+
+    sfz::Region* a = RegionOf(pInstrument, Dir, "a.wav");
+    CPPUNIT_ASSERT(a != NULL);
+    CPPUNIT_ASSERT(a->lokey == 60 && a->hikey == 62);
+    CPPUNIT_ASSERT(a->pitch_keycenter == 61);
+    CPPUNIT_ASSERT(a->lovel == 10 && a->hivel == 20);
+    CPPUNIT_ASSERT(a->tune == -5);
+    CPPUNIT_ASSERT(a->volume == -3.5f);
+    CPPUNIT_ASSERT(a->loop_mode == sfz::LOOP_CONTINUOUS);
+    CPPUNIT_ASSERT(a->trigger == TRIGGER_RELEASE);
+    CPPUNIT_ASSERT(a->fil_type == sfz::HPF_2P);
+    CPPUNIT_ASSERT(*a->cutoff == 500.0f);
+    CPPUNIT_ASSERT(a->ampeg_release == 0.8f);
+    CPPUNIT_ASSERT(a->group == 3 && a->off_by == 4);
+
+    sfz::Region* b = RegionOf(pInstrument, Dir, "b.wav");
+    CPPUNIT_ASSERT(b != NULL);
+    CPPUNIT_ASSERT(b->lokey == 61 && b->hikey == 61 && b->pitch_keycenter == 61);
+    CPPUNIT_ASSERT(b->cutoff_oncc.size() == 1);
+    CPPUNIT_ASSERT(b->cutoff_oncc[0].Controller == 74);
+    CPPUNIT_ASSERT(b->cutoff_oncc[0].Influence == 2400.0f);
+    CPPUNIT_ASSERT(b->volume_oncc.size() == 1);
+    CPPUNIT_ASSERT(b->volume_oncc[0].Controller == 7);
+    CPPUNIT_ASSERT(b->volume_oncc[0].Influence == 6.0f);
+    CPPUNIT_ASSERT(b->eg.size() == 2); // eg1 is the second one
+    CPPUNIT_ASSERT(b->eg[1].node.size() == 2);
+    CPPUNIT_ASSERT(b->eg[1].node[1].time == 0.5f);
+    CPPUNIT_ASSERT(b->eg[1].node[1].level == 1.0f);
+    CPPUNIT_ASSERT(b->lfos.size() == 3);
+    CPPUNIT_ASSERT(b->lfos[2].freq == 3.0f);
+    CPPUNIT_ASSERT(b->lfos[2].volume == 2.0f);
+    CPPUNIT_ASSERT(b->seq_length == 2 && b->seq_position == 2);
+}
+
+// Check that regions inherit the opcodes of their global, master and group sections and can override them.
+void SfzTest::testInheritance() {
+    sfz::File file(WriteSfz("inherit.sfz",
+        "<global> ampeg_release=2 volume=-1\n"
+        "<master> tune=7\n"
+        "<group> lokey=40 hikey=50 volume=-6\n"
+        "<region> sample=a.wav\n"
+        "<region> sample=b.wav volume=0 hikey=45\n"
+        "<group> lokey=51 hikey=60\n"
+        "<region> sample=c.wav\n"
+    ));
+    sfz::Instrument* pInstrument = file.GetInstrument();
+    CPPUNIT_ASSERT(pInstrument->regions.size() == 3);
+
+    sfz::Region* a = RegionOf(pInstrument, Dir, "a.wav");
+    sfz::Region* b = RegionOf(pInstrument, Dir, "b.wav");
+    sfz::Region* c = RegionOf(pInstrument, Dir, "c.wav");
+    CPPUNIT_ASSERT(a && b && c);
+    CPPUNIT_ASSERT(a->lokey == 40 && a->hikey == 50);
+    CPPUNIT_ASSERT(a->volume == -6.0f);
+    CPPUNIT_ASSERT(a->ampeg_release == 2.0f);
+    CPPUNIT_ASSERT(a->tune == 7);
+    CPPUNIT_ASSERT(b->lokey == 40 && b->hikey == 45);
+    CPPUNIT_ASSERT(b->volume == 0.0f);
+    CPPUNIT_ASSERT(c->lokey == 51 && c->hikey == 60);
+    CPPUNIT_ASSERT(c->volume == -1.0f); // from <global>, the group did not set it
+    CPPUNIT_ASSERT(c->tune == 7);
+}
+
+// Check that #define'd variables are substituted, #include'd files are read and comments are skipped.
+void SfzTest::testDefinesAndIncludes() {
+    WriteSfz("common.sfz",
+        "// shared settings\n"
+        "fil_type=lpf_2p cutoff=$CUTOFF\n"
+    );
+    sfz::File file(WriteSfz("main.sfz",
+        "// generated by SfzTest\n"
+        "#define $CUTOFF 8000\n"
+        "#define $KEY 64\n"
+        "<group> lovel=1 hivel=64 // first layer\n"
+        "#include \"common.sfz\"\n"
+        "<region> sample=a.wav key=$KEY // a comment with sample=x.wav key=1\n"
+        "<group> lovel=65 hivel=127\n"
+        "<region> sample=b.wav key=$KEY\n"
+    ));
+    sfz::Instrument* pInstrument = file.GetInstrument();
+    CPPUNIT_ASSERT(pInstrument->regions.size() == 2);
+
+    sfz::Region* a = RegionOf(pInstrument, Dir, "a.wav");
+    sfz::Region* b = RegionOf(pInstrument, Dir, "b.wav");
+    CPPUNIT_ASSERT(a && b);
+    CPPUNIT_ASSERT(a->lokey == 64 && a->hikey == 64);
+    CPPUNIT_ASSERT(a->lovel == 1 && a->hivel == 64);
+    CPPUNIT_ASSERT(a->fil_type == sfz::LPF_2P);
+    CPPUNIT_ASSERT(*a->cutoff == 8000.0f);
+    CPPUNIT_ASSERT(b->lokey == 64);
+    CPPUNIT_ASSERT(b->lovel == 65 && b->hivel == 127);
+    CPPUNIT_ASSERT(!b->cutoff); // the included opcodes only belong to the first group
+}
+
+// Check a large generated instrument like the one of benchmarks/sfzparse.
+void SfzTest::testLargeInstrument() {
+    WriteSfz("common.sfz",
+        "ampeg_attack=0.001 ampeg_decay=0.4 ampeg_sustain=$SUSTAIN ampeg_release=0.8\n"
+        "fil_type=lpf_2p cutoff=8000 resonance=2 fil_veltrack=2400\n"
+    );
+    std::string text = "#define $SUSTAIN 70\n#define $VOLCC 7\n";
+    char line[256];
+    for (int i = 0; i < 1024; i++) {
+        const int key = i % 128, layer = i / 128;
+        if (!key) {
+            snprintf(line, sizeof(line), "<group> lovel=%d hivel=%d\n#include \"common.sfz\"\nvolume_oncc$VOLCC=6\n",
+                     layer * 16, layer * 16 + 15);
+            text += line;
+        }
+        snprintf(line, sizeof(line), "<region> sample=l%d/n%03d.wav key=%d tune=%d loop_start=%d loop_end=%d\n",
+                 layer, key, key, (i % 21) - 10, 1000 + i, 50000 + i);
+        text += line;
+    }
+    sfz::File file(WriteSfz("large.sfz", text));
+    sfz::Instrument* pInstrument = file.GetInstrument();
+    CPPUNIT_ASSERT(pInstrument->regions.size() == 1024);
+    for (int i = 0; i < 1024; i++) {
+        const int key = i % 128, layer = i / 128;
+        char name[32];
+        snprintf(name, sizeof(name), "l%d/n%03d.wav", layer, key);
+        sfz::Region* r = RegionOf(pInstrument, Dir, name);
+        CPPUNIT_ASSERT(r != NULL);
+        CPPUNIT_ASSERT(r->lokey == key && r->hikey == key);
+        CPPUNIT_ASSERT(r->lovel == layer * 16 && r->hivel == layer * 16 + 15);
+        CPPUNIT_ASSERT(r->tune == (i % 21) - 10);
+        CPPUNIT_ASSERT(*r->loop_start == 1000 + i && *r->loop_end == 50000 + i);
+        CPPUNIT_ASSERT(r->ampeg_sustain == 70.0f);
+        CPPUNIT_ASSERT(*r->cutoff == 8000.0f);
+        CPPUNIT_ASSERT(r->volume_oncc.size() == 1 && r->volume_oncc[0].Controller == 7);
+    }
+}
+
+// Check that the lookup table finds the right regions of an instrument with key, velocity and controller zones.
+void SfzTest::testLookupTable() {
+    std::string text;
+    char line[256];
+    for (int i = 0; i < 64; i++) {
+        snprintf(line, sizeof(line), "<region> sample=%d.wav lokey=%d hikey=%d lovel=%d hivel=%d locc1=%d hicc1=%d\n",
+                 i, (i % 8) * 16, std::min((i % 8) * 16 + 20, 127), (i / 8) * 16, (i / 8) * 16 + 15,
+                 (i % 3) * 40, (i % 3) * 40 + 47);
+        text += line;
+    }
+    sfz::File file(WriteSfz("lookup.sfz", text));
+    AssertLookupMatches(file.GetInstrument(), 1, 2000);
+}
+
+// Check the same for an instrument with so many controller zones that the lookup table cannot cover all of them.
+void SfzTest::testLookupTableFiltered() {
+    unsigned int seed = 2;
+    std::string text;
+    char line[256];
+    for (int i = 0; i < 300; i++) {
+        snprintf(line, sizeof(line), "<region> sample=%d.wav lokey=%d hikey=%d", i, (i % 4) * 32, (i % 4) * 32 + 31);
+        text += line;
+        // overlapping random ranges of 6 controllers with about 100 zones
+        // each, way too many combinations for covering all in the table
+        for (int cc = 20; cc < 26; cc++) {
+            const int lo = Random(seed) % 64;
+            const int hi = 64 + Random(seed) % 64;
+            snprintf(line, sizeof(line), " locc%d=%d hicc%d=%d", cc, lo, cc, hi);
+            text += line;
+        }
+        text += "\n";
+    }
+    sfz::File file(WriteSfz("filtered.sfz", text));
+    AssertLookupMatches(file.GetInstrument(), 3, 2000);
+}
+
+// Check that copies of a list share its buffer until one of them is modified.
+void SfzTest::testListCopyOnWrite() {
+    sfz::List<int> a;
+    CPPUNIT_ASSERT(a.empty() && a.size() == 0);
+    a.add(1);
+    a.add(2);
+    sfz::List<int> b(a);
+    sfz::List<int> c;
+    c = a;
+    CPPUNIT_ASSERT(Shared(a, b) && Shared(a, c));
+
+    b.add(3);
+    CPPUNIT_ASSERT(!Shared(a, b) && Shared(a, c));
+    CPPUNIT_ASSERT(a.size() == 2 && b.size() == 3);
+    CPPUNIT_ASSERT(b[0] == 1 && b[1] == 2 && b[2] == 3);
+
+    c.at(0) = 5;
+    CPPUNIT_ASSERT(!Shared(a, c));
+    CPPUNIT_ASSERT(a[0] == 1 && c[0] == 5 && c[1] == 2);
+
+    c = a;
+    c = c;
+    CPPUNIT_ASSERT(Shared(a, c));
+    c.clear();
+    CPPUNIT_ASSERT(c.empty());
+    CPPUNIT_ASSERT(a.size() == 2 && a[0] == 1 && a[1] == 2);
+
+    sfz::List<int> d(c); // copy of an empty list
+    CPPUNIT_ASSERT(d.empty());
+    d.add(7);
+    CPPUNIT_ASSERT(c.empty() && d.size() == 1);
+}
+
+// Check that regions share the lists, EGs and LFOs inherited from their group until they modify them.
+void SfzTest::testRegionsShareLists() {
+    sfz::File file(WriteSfz("share.sfz",
+        "<group> cutoff_cc74=2400 eg1_time1=0.5 eg1_level1=1 lfo1_freq=3\n"
+        "<region> sample=a.wav\n"
+        "<region> sample=b.wav\n"
+        "<region> sample=c.wav cutoff_cc1=100 lfo1_freq=5\n"
+    ));
+    sfz::Instrument* pInstrument = file.GetInstrument();
+    sfz::Region* a = RegionOf(pInstrument, Dir, "a.wav");
+    sfz::Region* b = RegionOf(pInstrument, Dir, "b.wav");
+    sfz::Region* c = RegionOf(pInstrument, Dir, "c.wav");
+    CPPUNIT_ASSERT(a && b && c);
+
+    CPPUNIT_ASSERT(Shared(a->cutoff_oncc, b->cutoff_oncc));
+    CPPUNIT_ASSERT(Shared(a->eg, b->eg));
+    CPPUNIT_ASSERT(Shared(a->lfos, b->lfos));
+    CPPUNIT_ASSERT(Shared(a->eg, c->eg));
+
+    CPPUNIT_ASSERT(!Shared(a->cutoff_oncc, c->cutoff_oncc));
+    CPPUNIT_ASSERT(!Shared(a->lfos, c->lfos));
+    CPPUNIT_ASSERT(a->cutoff_oncc.size() == 1 && a->cutoff_oncc[0].Controller == 74);
+    CPPUNIT_ASSERT(c->cutoff_oncc.size() == 2);
+    CPPUNIT_ASSERT(c->cutoff_oncc[0].Controller == 74 && c->cutoff_oncc[1].Controller == 1);
+    CPPUNIT_ASSERT(a->lfos[1].freq == 3.0f && c->lfos[1].freq == 5.0f);
+    CPPUNIT_ASSERT(c->eg[1].node[1].time == 0.5f);
+}
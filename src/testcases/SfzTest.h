@@ -0,0 +1,49 @@
+#ifndef __LS_SFZTEST_H__
+#define __LS_SFZTEST_H__
+
+#include <cppunit/TestFixture.h>
+#include <cppunit/extensions/HelperMacros.h>
+
+#include <string>
+
+#include "../common/global_private.h"
+
+// the sfz parser we want to test
+#include "../engines/sfz/sfz.h"
+
+class SfzTest : public CppUnit::TestFixture {
+
+    CPPUNIT_TEST_SUITE(SfzTest);
+    CPPUNIT_TEST(printTestSuiteName);
+    CPPUNIT_TEST(testOpcodes);
+    CPPUNIT_TEST(testInheritance);
+    CPPUNIT_TEST(testDefinesAndIncludes);
+    CPPUNIT_TEST(testLargeInstrument);
+    CPPUNIT_TEST(testLookupTable);
+    CPPUNIT_TEST(testLookupTableFiltered);
+    CPPUNIT_TEST(testListCopyOnWrite);
+    CPPUNIT_TEST(testRegionsShareLists);
+    CPPUNIT_TEST_SUITE_END();
+
+    private:
+        std::string Dir; ///< temporary directory of the test's sfz files
+
+        std::string WriteSfz(const std::string& Name, const std::string& Text);
+
+    public:
+        void setUp();
+        void tearDown();
+
+        void printTestSuiteName();
+
+        void testOpcodes();
+        void testInheritance();
+        void testDefinesAndIncludes();
+        void testLargeInstrument();
+        void testLookupTable();
+        void testLookupTableFiltered();
+        void testListCopyOnWrite();
+        void testRegionsShareLists();
+};
+
+#endif // __LS_SFZTEST_H__
@@ -0,0 +1,94 @@
+#include "SharedSampleCacheTest.h"
+
+#include <iostream>
+#include <vector>
+#include <string.h>
+
+CPPUNIT_TEST_SUITE_REGISTRATION(SharedSampleCacheTest);
+
+using namespace std;
+
+// size of the sample data used by the tests
+#define DATA_SIZE 100000
+
+#if CONFIG_SAMPLE_CACHE_DEDUP
+
+// Returns DATA_SIZE bytes of sample data followed by NullExtensionSize bytes of silence.
+static std::vector<int8_t> SampleData(int Seed, size_t NullExtensionSize) {
+    std::vector<int8_t> data(DATA_SIZE + NullExtensionSize, 0);
+    for (size_t i = 0; i < DATA_SIZE; i++) data[i] = int8_t(i * Seed + Seed);
+    return data;
+}
+
+#endif
+
+void SharedSampleCacheTest::printTestSuiteName() {
+    cout << "\b \nRunning SharedSampleCache Tests: " << flush;
+}
+
+#if CONFIG_SAMPLE_CACHE_DEDUP
+
+// Check that samples of identical content get the same buffer, which is a copy owned by SharedSampleCache and freed after the last sample released it.
+void SharedSampleCacheTest::testIdenticalContentShared() {
+    const SharedSampleCache::statistics_t before = SharedSampleCache::GetStatistics();
+    std::vector<int8_t> a = SampleData(3, 64);
+    std::vector<int8_t> b = SampleData(3, 64);
+    int8_t* pA = SharedSampleCache::Share(&a[0], DATA_SIZE, 64);
+    int8_t* pB = SharedSampleCache::Share(&b[0], DATA_SIZE, 64);
+    CPPUNIT_ASSERT(pA != NULL);
+    CPPUNIT_ASSERT(pA == pB);
+    CPPUNIT_ASSERT(pA != &a[0] && pA != &b[0]); // never the caller's buffer
+    CPPUNIT_ASSERT(!memcmp(pA, &a[0], a.size()));
+
+    SharedSampleCache::statistics_t stats = SharedSampleCache::GetStatistics();
+    CPPUNIT_ASSERT(stats.Buffers    == before.Buffers + 1);
+    CPPUNIT_ASSERT(stats.References == before.References + 2);
+    CPPUNIT_ASSERT(stats.Bytes      == before.Bytes + DATA_SIZE + 64);
+    CPPUNIT_ASSERT(stats.SavedBytes == before.SavedBytes + DATA_SIZE + 64);
+
+    CPPUNIT_ASSERT(SharedSampleCache::Release(pA));
+    stats = SharedSampleCache::GetStatistics();
+    CPPUNIT_ASSERT(stats.Buffers    == before.Buffers + 1); // still used
+    CPPUNIT_ASSERT(stats.SavedBytes == before.SavedBytes);
+    CPPUNIT_ASSERT(SharedSampleCache::Release(pB));
+    stats = SharedSampleCache::GetStatistics();
+    CPPUNIT_ASSERT(stats.Buffers == before.Buffers);
+    CPPUNIT_ASSERT(stats.Bytes   == before.Bytes);
+    CPPUNIT_ASSERT(!SharedSampleCache::Release(pA)); // freed meanwhile
+}
+
+// Check that samples differing in a single byte are never merged, even if their fingerprints collide.
+void SharedSampleCacheTest::testDifferentContentNotShared() {
+    std::vector<int8_t> a = SampleData(5, 0);
+    std::vector<int8_t> b = a;
+    b[DATA_SIZE / 2 + 1]++; // most likely not part of the fingerprint
+    int8_t* pA = SharedSampleCache::Share(&a[0], DATA_SIZE, 0);
+    int8_t* pB = SharedSampleCache::Share(&b[0], DATA_SIZE, 0);
+    CPPUNIT_ASSERT(pA != pB);
+    CPPUNIT_ASSERT(!memcmp(pA, &a[0], DATA_SIZE));
+    CPPUNIT_ASSERT(!memcmp(pB, &b[0], DATA_SIZE));
+    CPPUNIT_ASSERT(SharedSampleCache::Release(pA));
+    CPPUNIT_ASSERT(SharedSampleCache::Release(pB));
+}
+
+// Check that identical sample data followed by a different amount of silence is not merged.
+void SharedSampleCacheTest::testDifferentSilenceNotShared() {
+    std::vector<int8_t> a = SampleData(7, 0);
+    std::vector<int8_t> b = SampleData(7, 128);
+    int8_t* pA = SharedSampleCache::Share(&a[0], DATA_SIZE, 0);
+    int8_t* pB = SharedSampleCache::Share(&b[0], DATA_SIZE, 128);
+    CPPUNIT_ASSERT(pA != pB);
+    for (size_t i = DATA_SIZE; i < b.size(); i++) CPPUNIT_ASSERT(pB[i] == 0);
+    CPPUNIT_ASSERT(SharedSampleCache::Release(pA));
+    CPPUNIT_ASSERT(SharedSampleCache::Release(pB));
+}
+
+// Check that buffers not allocated by SharedSampleCache are left alone by Release().
+void SharedSampleCacheTest::testReleaseUnknownBuffer() {
+    int8_t* pOwn = new int8_t[16];
+    CPPUNIT_ASSERT(!SharedSampleCache::Release(pOwn));
+    CPPUNIT_ASSERT(!SharedSampleCache::Release(NULL));
+    delete[] pOwn;
+}
+
+#endif // CONFIG_SAMPLE_CACHE_DEDUP
@@ -0,0 +1,37 @@
+#ifndef __LS_SHAREDSAMPLECACHETEST_H__
+#define __LS_SHAREDSAMPLECACHETEST_H__
+
+#include <cppunit/TestFixture.h>
+#include <cppunit/extensions/HelperMacros.h>
+
+#include "../common/global_private.h"
+
+// the SharedSampleCache class we want to test
+#include "../engines/common/SharedSampleCache.h"
+
+using namespace LinuxSampler;
+
+class SharedSampleCacheTest : public CppUnit::TestFixture {
+
+    CPPUNIT_TEST_SUITE(SharedSampleCacheTest);
+    CPPUNIT_TEST(printTestSuiteName);
+#if CONFIG_SAMPLE_CACHE_DEDUP
+    CPPUNIT_TEST(testIdenticalContentShared);
+    CPPUNIT_TEST(testDifferentContentNotShared);
+    CPPUNIT_TEST(testDifferentSilenceNotShared);
+    CPPUNIT_TEST(testReleaseUnknownBuffer);
+#endif
+    CPPUNIT_TEST_SUITE_END();
+
+    public:
+        void printTestSuiteName();
+
+#if CONFIG_SAMPLE_CACHE_DEDUP
+        void testIdenticalContentShared();
+        void testDifferentContentNotShared();
+        void testDifferentSilenceNotShared();
+        void testReleaseUnknownBuffer();
+#endif
+};
+
+#endif // __LS_SHAREDSAMPLECACHETEST_H__
@@ -0,0 +1,226 @@
+#include "StreamBlockCacheTest.h"
+
+#include <iostream>
+#include <string.h>
+
+CPPUNIT_TEST_SUITE_REGISTRATION(StreamBlockCacheTest);
+
+using namespace std;
+
+// all test samples use 32 bit frames
+#define FRAME_SIZE 4
+
+// cache budget used by the tests, that is 16 blocks
+#define BUDGET (16 * StreamBlockCache::BLOCK_SIZE)
+
+// files the test samples belong to
+static const uint64_t file = StreamBlockCache::NewSource(), otherFile = StreamBlockCache::NewSource();
+
+static const long blockFrames = StreamBlockCache::BlockFrames(FRAME_SIZE);
+
+
+// sample_t
+
+StreamBlockCacheTest::sample_t::sample_t(int Seed, long TotalFrames) :
+    Seed(Seed), TotalFrames(TotalFrames), Reads(0)
+{
+}
+
+// Generates the frames instead of reading them and records the read.
+long StreamBlockCacheTest::sample_t::Read(uint8_t* pDst, unsigned long FrameOffset, long FrameCount) {
+    Reads++;
+    Offsets.push_back(FrameOffset);
+    Lengths.push_back(FrameCount);
+    long n = 0;
+    for (unsigned long i = FrameOffset; long(i) < TotalFrames && n < FrameCount; i++, n++) {
+        const uint32_t value = uint32_t(Seed) * 1000003u + uint32_t(i);
+        memcpy(&pDst[n * FRAME_SIZE], &value, FRAME_SIZE);
+    }
+    return n;
+}
+
+// Whether @a Data contains the frames of this sample starting at @a FrameOffset.
+bool StreamBlockCacheTest::sample_t::Check(const std::vector<uint8_t>& Data, unsigned long FrameOffset, long FrameCount) const {
+    for (long i = 0; i < FrameCount; i++) {
+        uint32_t value;
+        memcpy(&value, &Data[i * FRAME_SIZE], FRAME_SIZE);
+        if (value != uint32_t(Seed) * 1000003u + uint32_t(FrameOffset + i)) return false;
+    }
+    return true;
+}
+
+// Reads the given frames of @a sample through the cache.
+static long read(uint64_t Source, StreamBlockCacheTest::sample_t& sample, unsigned long FrameOffset, long FrameCount, std::vector<uint8_t>& Data) {
+    Data.assign(size_t(FrameCount) * FRAME_SIZE, 0);
+    return StreamBlockCache::Read(
+        Source, &sample, FRAME_SIZE, FrameOffset, &Data[0], FrameCount,
+        [&sample](uint8_t* pDst, unsigned long FrameOffset, long FrameCount) -> long {
+            return sample.Read(pDst, FrameOffset, FrameCount);
+        }
+    );
+}
+
+
+// StreamBlockCacheTest
+
+void StreamBlockCacheTest::setUp() {
+    OldBudget = StreamBlockCache::GetBudget();
+    StreamBlockCache::SetBudget(BUDGET);
+    StreamBlockCache::Clear();
+    StreamBlockCache::ResetStatistics();
+}
+
+void StreamBlockCacheTest::tearDown() {
+    StreamBlockCache::Clear();
+    StreamBlockCache::SetBudget(OldBudget);
+}
+
+void StreamBlockCacheTest::printTestSuiteName() {
+    cout << "\b \nRunning StreamBlockCache Tests: " << flush;
+}
+
+// Check that data is read from the sample once and served from the cache afterwards.
+void StreamBlockCacheTest::testMissThenHit() {
+    sample_t sample(1, 10 * blockFrames);
+    std::vector<uint8_t> data;
+    CPPUNIT_ASSERT(read(file, sample, 100, 1000, data) == 1000);
+    CPPUNIT_ASSERT(sample.Check(data, 100, 1000));
+    CPPUNIT_ASSERT(sample.Reads == 1);
+    CPPUNIT_ASSERT(read(file, sample, 100, 1000, data) == 1000);
+    CPPUNIT_ASSERT(sample.Check(data, 100, 1000));
+    CPPUNIT_ASSERT(read(file, sample, 0, blockFrames, data) == blockFrames);
+    CPPUNIT_ASSERT(sample.Check(data, 0, blockFrames));
+    CPPUNIT_ASSERT(sample.Reads == 1);
+    StreamBlockCache::statistics_t stats = StreamBlockCache::GetStatistics();
+    CPPUNIT_ASSERT(stats.Budget == BUDGET);
+    CPPUNIT_ASSERT(stats.Blocks == 1);
+    CPPUNIT_ASSERT(stats.Usage == StreamBlockCache::BLOCK_SIZE);
+    CPPUNIT_ASSERT(stats.Misses == 1);
+    CPPUNIT_ASSERT(stats.Hits == 2);
+}
+
+// Check that the sample is only read in whole blocks, even if a read spans several blocks at an arbitrary position.
+void StreamBlockCacheTest::testReadsAlignedToBlocks() {
+    sample_t sample(2, 10 * blockFrames);
+    std::vector<uint8_t> data;
+    CPPUNIT_ASSERT(read(file, sample, blockFrames - 10, blockFrames + 20, data) == blockFrames + 20);
+    CPPUNIT_ASSERT(sample.Check(data, blockFrames - 10, blockFrames + 20));
+    CPPUNIT_ASSERT(sample.Reads == 3);
+    for (int i = 0; i < sample.Reads; i++) {
+        CPPUNIT_ASSERT(sample.Offsets[i] == (unsigned long)(i * blockFrames));
+        CPPUNIT_ASSERT(sample.Lengths[i] == blockFrames);
+    }
+}
+
+// Check that reads beyond the end of the sample are truncated and the sample's last, partial block is cached as well.
+void StreamBlockCacheTest::testEndOfSample() {
+    sample_t sample(3, blockFrames + 100);
+    std::vector<uint8_t> data;
+    CPPUNIT_ASSERT(read(file, sample, blockFrames + 50, 1000, data) == 50);
+    CPPUNIT_ASSERT(sample.Check(data, blockFrames + 50, 50));
+    CPPUNIT_ASSERT(read(file, sample, blockFrames, 1000, data) == 100);
+    CPPUNIT_ASSERT(sample.Check(data, blockFrames, 100));
+    CPPUNIT_ASSERT(read(file, sample, blockFrames + 100, 1000, data) == 0);
+    CPPUNIT_ASSERT(sample.Reads == 1);
+}
+
+// Check that the cache does not exceed its budget and evicts the least recently used blocks.
+void StreamBlockCacheTest::testEviction() {
+    sample_t sample(4, 32 * blockFrames);
+    std::vector<uint8_t> data;
+    for (int i = 0; i < 32; i++)
+        CPPUNIT_ASSERT(read(file, sample, i * blockFrames, blockFrames, data) == blockFrames);
+    CPPUNIT_ASSERT(sample.Reads == 32);
+    StreamBlockCache::statistics_t stats = StreamBlockCache::GetStatistics();
+    CPPUNIT_ASSERT(stats.Blocks == 16);
+    CPPUNIT_ASSERT(stats.Usage <= BUDGET);
+    // the most recently read block is still cached ...
+    CPPUNIT_ASSERT(read(file, sample, 31 * blockFrames, blockFrames, data) == blockFrames);
+    CPPUNIT_ASSERT(sample.Check(data, 31 * blockFrames, blockFrames));
+    CPPUNIT_ASSERT(sample.Reads == 32);
+    // ... the first one is not
+    CPPUNIT_ASSERT(read(file, sample, 0, blockFrames, data) == blockFrames);
+    CPPUNIT_ASSERT(sample.Check(data, 0, blockFrames));
+    CPPUNIT_ASSERT(sample.Reads == 33);
+}
+
+// Check that invalidating a sample drops its blocks, but not the ones of other samples.
+void StreamBlockCacheTest::testInvalidateSample() {
+    sample_t a(5, 4 * blockFrames), b(6, 4 * blockFrames);
+    std::vector<uint8_t> data;
+    read(file, a, 0, 4 * blockFrames, data);
+    read(file, b, 0, 4 * blockFrames, data);
+    CPPUNIT_ASSERT(a.Reads == 4 && b.Reads == 4);
+    StreamBlockCache::InvalidateSample(file, &a);
+    CPPUNIT_ASSERT(StreamBlockCache::GetStatistics().Blocks == 4);
+    read(file, a, 0, 4 * blockFrames, data);
+    CPPUNIT_ASSERT(a.Check(data, 0, 4 * blockFrames));
+    read(file, b, 0, 4 * blockFrames, data);
+    CPPUNIT_ASSERT(b.Check(data, 0, 4 * blockFrames));
+    CPPUNIT_ASSERT(a.Reads == 8);
+    CPPUNIT_ASSERT(b.Reads == 4);
+}
+
+// Check that invalidating a file drops the blocks of all its samples, but not the ones of other files.
+void StreamBlockCacheTest::testInvalidateFile() {
+    sample_t a(7, 2 * blockFrames), b(8, 2 * blockFrames), c(9, 2 * blockFrames);
+    std::vector<uint8_t> data;
+    read(file, a, 0, 2 * blockFrames, data);
+    read(file, b, 0, 2 * blockFrames, data);
+    read(otherFile, c, 0, 2 * blockFrames, data);
+    StreamBlockCache::InvalidateFile(file);
+    CPPUNIT_ASSERT(StreamBlockCache::GetStatistics().Blocks == 2);
+    read(file, a, 0, 2 * blockFrames, data);
+    read(file, b, 0, 2 * blockFrames, data);
+    read(otherFile, c, 0, 2 * blockFrames, data);
+    CPPUNIT_ASSERT(a.Reads == 4);
+    CPPUNIT_ASSERT(b.Reads == 4);
+    CPPUNIT_ASSERT(c.Reads == 2);
+}
+
+// Check that blocks of a file are never used for another file, even if the sample object is the same (i.e. a freed sample's address was reused).
+void StreamBlockCacheTest::testNewSource() {
+    const uint64_t source = StreamBlockCache::NewSource();
+    CPPUNIT_ASSERT(source != 0 && source != file && source != otherFile);
+    CPPUNIT_ASSERT(StreamBlockCache::NewSource() != source);
+    sample_t sample(12, 2 * blockFrames);
+    std::vector<uint8_t> data;
+    read(source, sample, 0, 2 * blockFrames, data);
+    // same object, different data as if it was another sample now
+    sample.Seed = 13;
+    const uint64_t reopened = StreamBlockCache::NewSource();
+    CPPUNIT_ASSERT(read(reopened, sample, 0, 2 * blockFrames, data) == 2 * blockFrames);
+    CPPUNIT_ASSERT(sample.Check(data, 0, 2 * blockFrames));
+    CPPUNIT_ASSERT(sample.Reads == 4);
+}
+
+// Check that reducing the budget drops blocks and that the cache keeps working afterwards.
+void StreamBlockCacheTest::testShrinkBudget() {
+    sample_t sample(10, 16 * blockFrames);
+    std::vector<uint8_t> data;
+    read(file, sample, 0, 16 * blockFrames, data);
+    CPPUNIT_ASSERT(StreamBlockCache::GetStatistics().Blocks == 16);
+    StreamBlockCache::SetBudget(BUDGET / 2);
+    StreamBlockCache::statistics_t stats = StreamBlockCache::GetStatistics();
+    CPPUNIT_ASSERT(stats.Budget == BUDGET / 2);
+    CPPUNIT_ASSERT(stats.Blocks == 8);
+    CPPUNIT_ASSERT(read(file, sample, 0, 16 * blockFrames, data) == 16 * blockFrames);
+    CPPUNIT_ASSERT(sample.Check(data, 0, 16 * blockFrames));
+    CPPUNIT_ASSERT(StreamBlockCache::GetStatistics().Blocks == 8);
+}
+
+// Check that with a budget of zero the sample is read directly, exactly as requested.
+void StreamBlockCacheTest::testDisabled() {
+    StreamBlockCache::SetBudget(0);
+    sample_t sample(11, 4 * blockFrames);
+    std::vector<uint8_t> data;
+    CPPUNIT_ASSERT(read(file, sample, 100, 1000, data) == 1000);
+    CPPUNIT_ASSERT(sample.Check(data, 100, 1000));
+    CPPUNIT_ASSERT(read(file, sample, 100, 1000, data) == 1000);
+    CPPUNIT_ASSERT(sample.Reads == 2);
+    CPPUNIT_ASSERT(sample.Offsets[1] == 100);
+    CPPUNIT_ASSERT(sample.Lengths[1] == 1000);
+    StreamBlockCache::statistics_t stats = StreamBlockCache::GetStatistics();
+    CPPUNIT_ASSERT(stats.Blocks == 0);
+    CPPUNIT_ASSERT(stats.Hits == 0 && stats.Misses == 0);
+}
@@ -0,0 +1,63 @@
+#ifndef __LS_STREAMBLOCKCACHETEST_H__
+#define __LS_STREAMBLOCKCACHETEST_H__
+
+#include <cppunit/TestFixture.h>
+#include <cppunit/extensions/HelperMacros.h>
+
+#include <vector>
+
+#include "../common/global_private.h"
+
+// the StreamBlockCache class we want to test
+#include "../engines/common/StreamBlockCache.h"
+
+using namespace LinuxSampler;
+
+class StreamBlockCacheTest : public CppUnit::TestFixture {
+
+    CPPUNIT_TEST_SUITE(StreamBlockCacheTest);
+    CPPUNIT_TEST(printTestSuiteName);
+    CPPUNIT_TEST(testMissThenHit);
+    CPPUNIT_TEST(testReadsAlignedToBlocks);
+    CPPUNIT_TEST(testEndOfSample);
+    CPPUNIT_TEST(testEviction);
+    CPPUNIT_TEST(testInvalidateSample);
+    CPPUNIT_TEST(testInvalidateFile);
+    CPPUNIT_TEST(testNewSource);
+    CPPUNIT_TEST(testShrinkBudget);
+    CPPUNIT_TEST(testDisabled);
+    CPPUNIT_TEST_SUITE_END();
+
+    public:
+        // sample whose data is generated instead of being read from disk
+        struct sample_t {
+            int                        Seed;
+            long                       TotalFrames;
+            int                        Reads;   ///< amount of reads so far
+            std::vector<unsigned long> Offsets; ///< positions of all reads so far
+            std::vector<long>          Lengths; ///< lengths of all reads so far
+
+            sample_t(int Seed, long TotalFrames);
+            long Read(uint8_t* pDst, unsigned long FrameOffset, long FrameCount);
+            bool Check(const std::vector<uint8_t>& Data, unsigned long FrameOffset, long FrameCount) const;
+        };
+
+        size_t OldBudget; ///< budget before the test, restored by tearDown()
+
+        void setUp();
+        void tearDown();
+
+        void printTestSuiteName();
+
+        void testMissThenHit();
+        void testReadsAlignedToBlocks();
+        void testEndOfSample();
+        void testEviction();
+        void testInvalidateSample();
+        void testInvalidateFile();
+        void testNewSource();
+        void testShrinkBudget();
+        void testDisabled();
+};
+
+#endif // __LS_STREAMBLOCKCACHETEST_H__
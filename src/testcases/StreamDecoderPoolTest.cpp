@@ -0,0 +1,124 @@
+#include "StreamDecoderPoolTest.h"
+
+#include <iostream>
+#include <vector>
+#include <unistd.h>
+
+CPPUNIT_TEST_SUITE_REGISTRATION(StreamDecoderPoolTest);
+
+using namespace std;
+
+StreamDecoderPoolTest::TestStream::TestStream(source_t* pSource, int Delay) :
+    Stream(0, 0), pSource(pSource), Delay(Delay)
+{
+}
+
+int StreamDecoderPoolTest::TestStream::ReadAhead(unsigned long SampleCount) {
+    if (pSource->busy++) pSource->concurrent = true;
+    {
+        LockGuard lock(ThreadsMutex);
+        Threads.insert(std::this_thread::get_id());
+    }
+    usleep(Delay);
+    pSource->busy--;
+    return int(SampleCount);
+}
+
+static StreamDecoderPool::job_t Job(Stream* pStream, bool Decode, int ReadAmount = 100) {
+    StreamDecoderPool::job_t job = {};
+    job.pStream    = pStream;
+    job.ReadAmount = ReadAmount;
+    job.pSource    = pStream->GetReadSource();
+    job.Decode     = Decode;
+    job.Read       = -1;
+    return job;
+}
+
+// the pool is used like a disk thread would use it
+void StreamDecoderPoolTest::setUp() {
+    StreamDecoderPool::Acquire();
+}
+
+void StreamDecoderPoolTest::tearDown() {
+    StreamDecoderPool::Release();
+}
+
+void StreamDecoderPoolTest::printTestSuiteName() {
+    cout << "\b \nRunning StreamDecoderPool Tests: " << flush;
+}
+
+// Check that all refills are executed with their result stored to the respective job, no matter whether they need decoding.
+void StreamDecoderPoolTest::testAllJobsExecuted() {
+    source_t sources[4];
+    std::vector<TestStream*> streams;
+    std::vector<StreamDecoderPool::job_t> jobs;
+    for (int i = 0; i < 12; i++) {
+        streams.push_back(new TestStream(&sources[i % 4], 1000));
+        jobs.push_back(Job(streams.back(), i % 3 != 0, 100 + i));
+    }
+    StreamDecoderPool::Run(&jobs[0], int(jobs.size()));
+    for (size_t i = 0; i < jobs.size(); i++) {
+        CPPUNIT_ASSERT(jobs[i].Read == jobs[i].ReadAmount);
+        CPPUNIT_ASSERT(!static_cast<TestStream*>(jobs[i].pStream)->Threads.empty());
+    }
+    for (size_t i = 0; i < streams.size(); i++) delete streams[i];
+}
+
+// Check that refills of the same read source are never executed concurrently.
+void StreamDecoderPoolTest::testSameSourceNotConcurrent() {
+    source_t sources[2];
+    std::vector<TestStream*> streams;
+    std::vector<StreamDecoderPool::job_t> jobs;
+    for (int i = 0; i < 8; i++) {
+        streams.push_back(new TestStream(&sources[i % 2], 5000));
+        jobs.push_back(Job(streams.back(), true));
+    }
+    StreamDecoderPool::Run(&jobs[0], int(jobs.size()));
+    CPPUNIT_ASSERT(!sources[0].concurrent);
+    CPPUNIT_ASSERT(!sources[1].concurrent);
+    for (size_t i = 0; i < jobs.size(); i++)
+        CPPUNIT_ASSERT(jobs[i].Read == jobs[i].ReadAmount);
+    for (size_t i = 0; i < streams.size(); i++) delete streams[i];
+}
+
+// Check that refills which don't require decoding are executed by the calling (disk) thread.
+void StreamDecoderPoolTest::testRawJobsOnCallingThread() {
+    source_t sources[4];
+    std::vector<TestStream*> streams;
+    std::vector<StreamDecoderPool::job_t> jobs;
+    for (int i = 0; i < 4; i++) {
+        streams.push_back(new TestStream(&sources[i], 1000));
+        jobs.push_back(Job(streams.back(), i >= 2));
+    }
+    StreamDecoderPool::Run(&jobs[0], int(jobs.size()));
+    for (size_t i = 0; i < jobs.size(); i++) {
+        if (jobs[i].Decode) continue;
+        TestStream* pStream = static_cast<TestStream*>(jobs[i].pStream);
+        CPPUNIT_ASSERT(pStream->Threads.size() == 1);
+        CPPUNIT_ASSERT(*pStream->Threads.begin() == std::this_thread::get_id());
+    }
+    for (size_t i = 0; i < streams.size(); i++) delete streams[i];
+}
+
+// Check that refills of different read sources are decoded by several threads at the same time.
+void StreamDecoderPoolTest::testDecodedInParallel() {
+    if (!StreamDecoderPool::WorkerCount()) return; // decoding on the calling thread only
+    const int count = 4;
+    const int delay = 50000; // 50ms
+    source_t sources[count];
+    std::vector<TestStream*> streams;
+    std::vector<StreamDecoderPool::job_t> jobs;
+    for (int i = 0; i < count; i++) {
+        streams.push_back(new TestStream(&sources[i], delay));
+        jobs.push_back(Job(streams.back(), true));
+    }
+    const uint64_t start = DiskStatistics::Now();
+    StreamDecoderPool::Run(&jobs[0], int(jobs.size()));
+    const uint64_t duration = DiskStatistics::Now() - start;
+    std::set<std::thread::id> threads;
+    for (size_t i = 0; i < streams.size(); i++)
+        threads.insert(streams[i]->Threads.begin(), streams[i]->Threads.end());
+    CPPUNIT_ASSERT(threads.size() > 1);
+    CPPUNIT_ASSERT(duration < uint64_t(count * delay));
+    for (size_t i = 0; i < streams.size(); i++) delete streams[i];
+}
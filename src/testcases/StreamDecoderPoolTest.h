@@ -0,0 +1,66 @@
+#ifndef __LS_STREAMDECODERPOOLTEST_H__
+#define __LS_STREAMDECODERPOOLTEST_H__
+
+#include <cppunit/TestFixture.h>
+#include <cppunit/extensions/HelperMacros.h>
+
+#include <atomic>
+#include <set>
+#include <thread>
+
+#include "../common/global_private.h"
+#include "../common/Mutex.h"
+
+// the StreamDecoderPool class we want to test
+#include "../engines/common/StreamDecoderPool.h"
+#include "../engines/common/DiskStatistics.h"
+
+using namespace LinuxSampler;
+
+class StreamDecoderPoolTest : public CppUnit::TestFixture {
+
+    CPPUNIT_TEST_SUITE(StreamDecoderPoolTest);
+    CPPUNIT_TEST(printTestSuiteName);
+    CPPUNIT_TEST(testAllJobsExecuted);
+    CPPUNIT_TEST(testSameSourceNotConcurrent);
+    CPPUNIT_TEST(testRawJobsOnCallingThread);
+    CPPUNIT_TEST(testDecodedInParallel);
+    CPPUNIT_TEST_SUITE_END();
+
+    public:
+        // decoder state shared by the streams of one read source
+        struct source_t {
+            std::atomic<int>  busy;       ///< amount of refills currently reading from this source
+            std::atomic<bool> concurrent; ///< whether this source was ever read by two refills at the same time
+            source_t() : busy(0), concurrent(false) {}
+        };
+
+        // stream whose refills just take some time and record the threads executing them
+        class TestStream : public Stream {
+            public:
+                source_t*            pSource;
+                int                  Delay;   ///< duration of each refill in microseconds
+                Mutex                ThreadsMutex;
+                std::set<std::thread::id> Threads; ///< threads which refilled this stream
+
+                TestStream(source_t* pSource, int Delay);
+                int ReadAhead(unsigned long SampleCount) OVERRIDE;
+                void WriteSilence(unsigned long SilenceSampleWords) OVERRIDE {}
+                const void* GetReadSource() OVERRIDE { return pSource; }
+            protected:
+                long Read(uint8_t* pBuf, long SamplesToRead) OVERRIDE { return 0; }
+                void Reset() OVERRIDE {}
+        };
+
+        void setUp();
+        void tearDown();
+
+        void printTestSuiteName();
+
+        void testAllJobsExecuted();
+        void testSameSourceNotConcurrent();
+        void testRawJobsOnCallingThread();
+        void testDecodedInParallel();
+};
+
+#endif // __LS_STREAMDECODERPOOLTEST_H__